@@ -134,7 +134,7 @@ def run_gwas_analysis(
         dataset_id: Dataset ID to analyze
         user_id: User identifier (for authorization)
         phenotype_column: Name of phenotype column to analyze
-        analysis_type: Type of analysis ('linear', 'logistic', 'chi_square')
+        analysis_type: Type of analysis ('linear', 'logistic', 'chi_square', 'tdt', 'sib_tdt')
         covariates: List of covariate column names (optional)
         maf_threshold: Minimum minor allele frequency (default: 0.01)
         num_threads: Number of CPU threads (default: 4)
@@ -149,7 +149,7 @@ def run_gwas_analysis(
         except ValueError:
             return {
                 "success": False,
-                "error": f"Invalid analysis type: {analysis_type}. Must be 'linear', 'logistic', or 'chi_square'",
+                "error": f"Invalid analysis type: {analysis_type}. Must be 'linear', 'logistic', 'chi_square', 'tdt' or 'sib_tdt'",
             }
 
         # Create job
@@ -140,6 +140,15 @@ class Settings:
     
     use_cpp_engine: bool = _get_bool("USE_CPP_ENGINE", "compute.cpp_engine.use_cpp", True)
     parallel_dna_threshold: int = _get_int("PARALLEL_DNA_THRESHOLD", "compute.cpp_engine.parallel_dna_threshold", 1_000_000)
+    gwas_reference_fasta: str = _get_str("GWAS_REFERENCE_FASTA", "compute.gwas.reference_fasta", "")
+    liftover_chain_dir: str = _get_str("LIFTOVER_CHAIN_DIR", "compute.gwas.liftover_chain_dir", "data/liftover")
+    sumstats_dir: str = _get_str("SUMSTATS_DIR", "compute.gwas.sumstats_dir", "data/sumstats")
+    # Threads shared by the CPU-heavy genomics analyses (0 = min(CPUs, 4))
+    analysis_pool_workers: int = _get_int("ANALYSIS_POOL_WORKERS", "compute.gwas.analysis_pool_workers", 0)
+
+    # Prometheus /metrics listener, separate from the public API (port 0 disables it)
+    metrics_host: str = _get_str("METRICS_HOST", "observability.metrics.host", "127.0.0.1")
+    metrics_port: int = _get_int("METRICS_PORT", "observability.metrics.port", 9464)
 
     # External Services
     hygraph_endpoint: str = _get_str("HYGRAPH_ENDPOINT", "cms.hygraph.endpoint", "")
@@ -65,6 +65,7 @@ class CollectionName(Enum):
     GWAS_DATASETS = "gwas_datasets"
     GWAS_JOBS = "gwas_jobs"
     GWAS_RESULTS = "gwas_results"
+    GWAS_RESULT_ASSOCIATIONS = "gwas_result_associations"
 
 
 class IndexConfig:
@@ -704,6 +705,13 @@ class IndexConfig:
                     "name": "created_at_idx"
                 },
             ],
+            CollectionName.GWAS_RESULT_ASSOCIATIONS: [
+                {
+                    "keys": [("job_id", 1), ("chunk", 1)],
+                    "name": "job_chunk_compound_idx",
+                    "unique": True
+                },
+            ],
         }
 
 
@@ -0,0 +1,544 @@
+"""
+Metrics
+=======
+In-process metrics exposed in the Prometheus text format.
+
+Recording is cheap and lock-free: every thread writes to its own shard
+(plain dicts keyed by label values), and shards are only summed when the
+registry is scraped. Shards of threads that have exited are folded into a
+single retired shard at scrape time, so thread churn does not grow the
+shard list. Latency histograms use HDR-style log-linear buckets
+(four sub-buckets per power of two), which keeps relative error under 25%
+from 50 µs to several minutes with a fixed, small bucket count.
+
+State that already lives elsewhere (cache hit counts, queue depth, thread
+pool usage, allocator statistics) is read by collectors at scrape time
+rather than mirrored on every operation.
+
+Long-running processes serve :func:`render` on ``/metrics`` from a separate
+local listener (:func:`start_http_server`), never on the public API;
+processes that live for a single request (engine invocations) call
+:func:`append_snapshot` to append the change since their previous snapshot
+to a metrics file instead.
+"""
+
+from __future__ import annotations
+
+import gc
+import logging
+import os
+import sys
+import threading
+import time
+import weakref
+from bisect import bisect_left
+from contextlib import contextmanager
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Callable, Dict, Iterable, Iterator, List, Optional, Sequence, Tuple
+
+logger = logging.getLogger(__name__)
+
+LabelValues = Tuple[str, ...]
+Sample = Tuple[str, Dict[str, str], float]
+
+_SUB_BUCKETS = 4
+
+
+def hdr_buckets(lowest: float = 5e-5, highest: float = 300.0) -> List[float]:
+    """Log-linear bucket bounds: ``_SUB_BUCKETS`` linear steps per power of two."""
+    bounds: List[float] = []
+    base = lowest
+    while base < highest:
+        for step in range(_SUB_BUCKETS):
+            bounds.append(base * (1.0 + step / _SUB_BUCKETS))
+        base *= 2.0
+    bounds.append(base)
+    return bounds
+
+
+DEFAULT_LATENCY_BUCKETS = hdr_buckets()
+
+
+def _format_value(value: float) -> str:
+    if value == int(value) and abs(value) < 1e15:
+        return str(int(value))
+    return repr(float(value))
+
+
+def _escape(value: str) -> str:
+    return value.replace("\\", "\\\\").replace("\n", "\\n").replace('"', '\\"')
+
+
+def _format_labels(labels: Dict[str, str]) -> str:
+    if not labels:
+        return ""
+    return "{" + ",".join(f'{key}="{_escape(str(value))}"' for key, value in labels.items()) + "}"
+
+
+class _Metric:
+    """Common bookkeeping for per-thread sharded metrics."""
+
+    kind = "untyped"
+
+    def __init__(self, name: str, documentation: str, labelnames: Sequence[str] = ()):
+        self.name = name
+        self.documentation = documentation
+        self.labelnames = tuple(labelnames)
+        self._local = threading.local()
+        # (owning thread, shard); shards of exited threads fold into _retired
+        self._shards: List[Tuple[weakref.ref, dict]] = []
+        self._retired: dict = {}
+        self._shards_lock = threading.Lock()
+
+    @property
+    def family_name(self) -> str:
+        return self.name
+
+    def _shard(self) -> dict:
+        shard = getattr(self._local, "shard", None)
+        if shard is None:
+            shard = self._local.shard = {}
+            with self._shards_lock:
+                self._shards.append((weakref.ref(threading.current_thread()), shard))
+        return shard
+
+    def _key(self, labels: Dict[str, str]) -> LabelValues:
+        if set(labels) != set(self.labelnames):
+            raise ValueError(f"{self.name} expects labels {self.labelnames}, got {tuple(labels)}")
+        return tuple(str(labels[name]) for name in self.labelnames)
+
+    def _fold(self, target: dict, shard: dict) -> None:
+        for key, value in shard.items():
+            target[key] = target.get(key, 0.0) + value
+
+    def _snapshot(self) -> List[dict]:
+        with self._shards_lock:
+            live = []
+            for owner, shard in self._shards:
+                thread = owner()
+                if thread is not None and thread.is_alive():
+                    live.append((owner, shard))
+                else:
+                    # The thread can no longer write to its shard
+                    self._fold(self._retired, shard)
+            self._shards = live
+            return [dict(self._retired)] + [dict(shard) for _, shard in live]
+
+    def samples(self) -> Iterable[Sample]:
+        raise NotImplementedError
+
+
+class Counter(_Metric):
+    """Monotonically increasing count, summed over threads on scrape."""
+
+    kind = "counter"
+
+    @property
+    def family_name(self) -> str:
+        return f"{self.name}_total"
+
+    def inc(self, amount: float = 1.0, **labels: str) -> None:
+        shard = self._shard()
+        key = self._key(labels)
+        shard[key] = shard.get(key, 0.0) + amount
+
+    def samples(self) -> Iterable[Sample]:
+        totals: Dict[LabelValues, float] = {}
+        for shard in self._snapshot():
+            for key, value in shard.items():
+                totals[key] = totals.get(key, 0.0) + value
+        for key, value in sorted(totals.items()):
+            yield f"{self.name}_total", dict(zip(self.labelnames, key)), value
+
+
+class Gauge(_Metric):
+    """Value that goes up and down; increments from all threads are summed."""
+
+    kind = "gauge"
+
+    def inc(self, amount: float = 1.0, **labels: str) -> None:
+        shard = self._shard()
+        key = self._key(labels)
+        shard[key] = shard.get(key, 0.0) + amount
+
+    def dec(self, amount: float = 1.0, **labels: str) -> None:
+        self.inc(-amount, **labels)
+
+    @contextmanager
+    def track_inprogress(self, **labels: str) -> Iterator[None]:
+        self.inc(**labels)
+        try:
+            yield
+        finally:
+            self.dec(**labels)
+
+    def samples(self) -> Iterable[Sample]:
+        totals: Dict[LabelValues, float] = {}
+        for shard in self._snapshot():
+            for key, value in shard.items():
+                totals[key] = totals.get(key, 0.0) + value
+        for key, value in sorted(totals.items()):
+            yield self.name, dict(zip(self.labelnames, key)), value
+
+
+class Histogram(_Metric):
+    """Cumulative-bucket histogram with HDR-style default latency buckets."""
+
+    kind = "histogram"
+
+    def __init__(
+        self,
+        name: str,
+        documentation: str,
+        labelnames: Sequence[str] = (),
+        buckets: Optional[Sequence[float]] = None,
+    ):
+        super().__init__(name, documentation, labelnames)
+        self.buckets = list(buckets or DEFAULT_LATENCY_BUCKETS)
+
+    def observe(self, value: float, **labels: str) -> None:
+        shard = self._shard()
+        key = self._key(labels)
+        entry = shard.get(key)
+        if entry is None:
+            # [per-bucket counts..., +Inf count, sum]
+            entry = shard[key] = [0] * (len(self.buckets) + 1) + [0.0]
+        entry[bisect_left(self.buckets, value)] += 1
+        entry[-1] += value
+
+    def _fold(self, target: dict, shard: dict) -> None:
+        for key, entry in shard.items():
+            merged = target.get(key)
+            # New lists, so snapshots already handed out are never mutated
+            target[key] = list(entry) if merged is None else [a + b for a, b in zip(merged, entry)]
+
+    @contextmanager
+    def time(self, **labels: str) -> Iterator[None]:
+        start = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.observe(time.perf_counter() - start, **labels)
+
+    def samples(self) -> Iterable[Sample]:
+        width = len(self.buckets) + 2
+        totals: Dict[LabelValues, List[float]] = {}
+        for shard in self._snapshot():
+            for key, entry in shard.items():
+                merged = totals.setdefault(key, [0.0] * width)
+                for i, value in enumerate(list(entry)):
+                    merged[i] += value
+        for key, merged in sorted(totals.items()):
+            labels = dict(zip(self.labelnames, key))
+            cumulative = 0.0
+            for bound, count in zip(self.buckets, merged):
+                cumulative += count
+                yield f"{self.name}_bucket", {**labels, "le": repr(bound)}, cumulative
+            cumulative += merged[len(self.buckets)]
+            yield f"{self.name}_bucket", {**labels, "le": "+Inf"}, cumulative
+            yield f"{self.name}_sum", labels, merged[-1]
+            yield f"{self.name}_count", labels, cumulative
+
+
+Collector = Callable[[], Iterable[Tuple[str, str, str, Iterable[Sample]]]]
+
+
+class MetricsRegistry:
+    """Owns metrics and scrape-time collectors and renders them as text."""
+
+    def __init__(self):
+        self._metrics: Dict[str, _Metric] = {}
+        self._collectors: List[Collector] = []
+        self._lock = threading.Lock()
+
+    def _register(self, metric: _Metric) -> _Metric:
+        with self._lock:
+            existing = self._metrics.get(metric.name)
+            if existing is not None:
+                if type(existing) is not type(metric) or existing.labelnames != metric.labelnames:
+                    raise ValueError(f"Metric {metric.name} already registered with a different shape")
+                return existing
+            self._metrics[metric.name] = metric
+            return metric
+
+    def counter(self, name: str, documentation: str, labelnames: Sequence[str] = ()) -> Counter:
+        return self._register(Counter(name, documentation, labelnames))  # type: ignore[return-value]
+
+    def gauge(self, name: str, documentation: str, labelnames: Sequence[str] = ()) -> Gauge:
+        return self._register(Gauge(name, documentation, labelnames))  # type: ignore[return-value]
+
+    def histogram(
+        self,
+        name: str,
+        documentation: str,
+        labelnames: Sequence[str] = (),
+        buckets: Optional[Sequence[float]] = None,
+    ) -> Histogram:
+        return self._register(Histogram(name, documentation, labelnames, buckets))  # type: ignore[return-value]
+
+    def register_collector(self, collector: Collector) -> None:
+        """
+        Add a scrape-time collector.
+
+        A collector returns ``(name, type, help, samples)`` families; a failing
+        collector is logged and skipped so one broken source cannot break the
+        whole scrape.
+        """
+        with self._lock:
+            self._collectors.append(collector)
+
+    def render(self, baseline: Optional[Dict[Tuple[str, str], float]] = None) -> str:
+        """
+        All metrics in the Prometheus text exposition format (0.0.4).
+
+        Args:
+            baseline: When given, counter and histogram samples are rendered as
+                the change since the values recorded here, and the current
+                values are stored for the next call (gauges stay absolute)
+        """
+        lines: List[str] = []
+
+        def family(name: str, kind: str, documentation: str, samples: Iterable[Sample]) -> None:
+            lines.append(f"# HELP {name} {documentation}")
+            lines.append(f"# TYPE {name} {kind}")
+            for sample_name, labels, value in samples:
+                formatted = _format_labels(labels)
+                if baseline is not None and kind in ("counter", "histogram"):
+                    key = (sample_name, formatted)
+                    value, baseline[key] = value - baseline.get(key, 0.0), value
+                lines.append(f"{sample_name}{formatted} {_format_value(value)}")
+
+        with self._lock:
+            metrics = list(self._metrics.values())
+            collectors = list(self._collectors)
+
+        for metric in metrics:
+            family(metric.family_name, metric.kind, metric.documentation, metric.samples())
+        for collector in collectors:
+            try:
+                for name, kind, documentation, samples in collector():
+                    family(name, kind, documentation, list(samples))
+            except Exception as e:
+                logger.warning(f"Metrics collector {getattr(collector, '__name__', collector)} failed: {e}")
+
+        return "\n".join(lines) + "\n"
+
+
+_registry = MetricsRegistry()
+
+
+def get_registry() -> MetricsRegistry:
+    return _registry
+
+
+def render() -> str:
+    return _registry.render()
+
+
+_snapshot_baseline: Dict[Tuple[str, str], float] = {}
+_snapshot_lock = threading.Lock()
+
+
+def append_snapshot(path: str) -> None:
+    """
+    Append the samples since the previous snapshot to ``path`` for short-lived processes.
+
+    A warm process (e.g. a reused Lambda container) appends many snapshots, so
+    counters and histograms are written as deltas and an aggregator can simply
+    sum every snapshot; gauges are written as current values. Each snapshot is
+    preceded by a ``# snapshot <unix time> pid=<pid> delta`` comment so a
+    sidecar or log shipper can split them.
+    """
+    with _snapshot_lock:
+        text = f"# snapshot {time.time():.3f} pid={os.getpid()} delta\n" + _registry.render(_snapshot_baseline)
+    with open(path, "a") as f:
+        f.write(text)
+
+
+class _MetricsHandler(BaseHTTPRequestHandler):
+    def do_GET(self) -> None:
+        if self.path.split("?", 1)[0] != "/metrics":
+            self.send_error(404)
+            return
+        body = render().encode("utf-8")
+        self.send_response(200)
+        self.send_header("Content-Type", "text/plain; version=0.0.4")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format: str, *args) -> None:
+        pass
+
+
+def start_http_server(port: int, host: str = "127.0.0.1") -> ThreadingHTTPServer:
+    """
+    Serve ``/metrics`` on a separate listener (loopback by default) in a daemon thread.
+
+    Returns:
+        The server; call ``shutdown()`` to stop it
+    """
+    server = ThreadingHTTPServer((host, port), _MetricsHandler)
+    server.daemon_threads = True
+    threading.Thread(target=server.serve_forever, name="metrics-http", daemon=True).start()
+    return server
+
+
+# ============================================================================
+# Shared metric families
+# ============================================================================
+
+ENGINE_REQUESTS = _registry.counter(
+    "zygotrix_engine_requests",
+    "Engine action invocations by backend and outcome.",
+    ("action", "backend", "status"),
+)
+ENGINE_LATENCY = _registry.histogram(
+    "zygotrix_engine_latency_seconds",
+    "Engine action latency in seconds.",
+    ("action", "backend"),
+)
+ENGINE_BYTES = _registry.counter(
+    "zygotrix_engine_bytes",
+    "Bytes sent to and received from the engine.",
+    ("action", "direction"),
+)
+ENGINE_INFLIGHT = _registry.gauge(
+    "zygotrix_engine_inflight_requests",
+    "Engine invocations currently in progress.",
+    ("action",),
+)
+ENGINE_FALLBACKS = _registry.counter(
+    "zygotrix_engine_fallbacks",
+    "Requests served by the Python fallback after the engine failed.",
+    ("action",),
+)
+
+
+@contextmanager
+def track_engine_call(action: str, backend: str) -> Iterator[None]:
+    """Count, time and track concurrency of one engine action."""
+    ENGINE_INFLIGHT.inc(action=action)
+    start = time.perf_counter()
+    status = "error"
+    try:
+        yield
+        status = "ok"
+    finally:
+        ENGINE_INFLIGHT.dec(action=action)
+        ENGINE_LATENCY.observe(time.perf_counter() - start, action=action, backend=backend)
+        ENGINE_REQUESTS.inc(action=action, backend=backend, status=status)
+
+
+# ============================================================================
+# Scrape-time collectors
+# ============================================================================
+
+_caches: Dict[str, Callable[[], dict]] = {}
+
+
+def register_cache(name: str, get_stats: Callable[[], dict]) -> None:
+    """Export a cache's ``get_stats()`` (hits, misses, size) on every scrape."""
+    _caches[name] = get_stats
+
+
+def _collect_caches():
+    stats = {}
+    for name, get_stats in list(_caches.items()):
+        try:
+            stats[name] = get_stats()
+        except Exception as e:
+            logger.warning(f"Cache stats for {name} unavailable: {e}")
+
+    def rows(key: str) -> List[Sample]:
+        return [({"cache": name}, float(s.get(key, 0))) for name, s in stats.items()]
+
+    def with_name(metric: str, values: List[Tuple[Dict[str, str], float]]) -> List[Sample]:
+        return [(metric, labels, value) for labels, value in values]
+
+    ratios = []
+    for name, s in stats.items():
+        total = s.get("hits", 0) + s.get("misses", 0)
+        ratios.append(("zygotrix_cache_hit_ratio", {"cache": name}, s.get("hits", 0) / total if total else 0.0))
+
+    yield "zygotrix_cache_hits_total", "counter", "Cache hits.", with_name("zygotrix_cache_hits_total", rows("hits"))
+    yield "zygotrix_cache_misses_total", "counter", "Cache misses.", with_name("zygotrix_cache_misses_total", rows("misses"))
+    yield "zygotrix_cache_entries", "gauge", "Entries currently cached.", with_name("zygotrix_cache_entries", rows("size"))
+    yield "zygotrix_cache_hit_ratio", "gauge", "Cache hits / lookups since start.", ratios
+
+
+_pools: Dict[str, Callable[[], Tuple[float, float]]] = {}
+
+
+def register_pool(name: str, usage: Callable[[], Tuple[float, float]]) -> None:
+    """Export a worker pool as (busy, capacity) on every scrape."""
+    _pools[name] = usage
+
+
+def _collect_pools():
+    busy, capacity, utilisation = [], [], []
+    for name, usage in list(_pools.items()):
+        try:
+            used, total = usage()
+        except Exception:
+            # e.g. the anyio limiter outside an event loop
+            continue
+        labels = {"pool": name}
+        busy.append(("zygotrix_pool_busy_workers", labels, used))
+        capacity.append(("zygotrix_pool_max_workers", labels, total))
+        utilisation.append(("zygotrix_pool_utilisation", labels, used / total if total else 0.0))
+    yield "zygotrix_pool_busy_workers", "gauge", "Workers currently busy.", busy
+    yield "zygotrix_pool_max_workers", "gauge", "Worker pool capacity.", capacity
+    yield "zygotrix_pool_utilisation", "gauge", "Busy workers / capacity.", utilisation
+
+
+_queues: Dict[str, Callable[[], Dict[str, float]]] = {}
+
+
+def register_queue(name: str, depth: Callable[[], Dict[str, float]]) -> None:
+    """Export a queue's depth by state (e.g. queued, active) on every scrape."""
+    _queues[name] = depth
+
+
+def _collect_queues():
+    samples = []
+    for name, depth in list(_queues.items()):
+        try:
+            states = depth()
+        except Exception as e:
+            logger.warning(f"Queue depth for {name} unavailable: {e}")
+            continue
+        for state, value in states.items():
+            samples.append(("zygotrix_queue_depth", {"queue": name, "state": state}, float(value)))
+    yield "zygotrix_queue_depth", "gauge", "Jobs in each queue by state.", samples
+
+
+def _collect_process():
+    """Allocator and interpreter statistics."""
+    samples = [("python_allocated_blocks", {}, float(sys.getallocatedblocks()))]
+    yield "python_allocated_blocks", "gauge", "Memory blocks currently allocated by the interpreter.", samples
+
+    gc_samples = [
+        ("python_gc_collections_total", {"generation": str(i)}, float(s["collections"]))
+        for i, s in enumerate(gc.get_stats())
+    ]
+    yield "python_gc_collections_total", "counter", "Garbage collector runs per generation.", gc_samples
+
+    try:
+        import resource
+
+        usage = resource.getrusage(resource.RUSAGE_SELF)
+        # ru_maxrss is KiB on Linux, bytes on macOS
+        scale = 1 if sys.platform == "darwin" else 1024
+        yield "process_max_resident_memory_bytes", "gauge", "Peak resident set size.", [
+            ("process_max_resident_memory_bytes", {}, float(usage.ru_maxrss * scale))
+        ]
+        yield "process_cpu_seconds_total", "counter", "User and system CPU time.", [
+            ("process_cpu_seconds_total", {}, usage.ru_utime + usage.ru_stime)
+        ]
+    except ImportError:
+        pass
+
+
+for _collector in (_collect_caches, _collect_pools, _collect_queues, _collect_process):
+    _registry.register_collector(_collector)
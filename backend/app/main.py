@@ -28,9 +28,11 @@ from .routes.deep_research import router as deep_research_router
 from .routes.web_search import router as web_search_router
 from .routes.scholar_analytics import router as scholar_analytics_router
 from .routes.pedigree import router as pedigree_router
+from .routes.genomics import router as genomics_router
 from .schema.auth import UserProfile
 from .schema.polygenic import PolygenicScoreRequest, PolygenicScoreResponse
 from .schema.common import HealthResponse
+from .core import metrics
 from .services import polygenic as polygenic_services
 from .mcp import mcp_lifespan
 from app.models import Trait
@@ -99,12 +101,32 @@ async def lifespan(app: FastAPI):
         except Exception as e:
             logger.warning(f"⚠️ Could not pre-warm Deep Research service: {e}")
         
+        # Metrics are served on their own local listener, not on the public API
+        metrics_server = None
+        if settings.metrics_port:
+            from anyio.to_thread import current_default_thread_limiter
+
+            # The limiter belongs to this event loop; the scrape thread only reads it
+            limiter = current_default_thread_limiter()
+            metrics.register_pool(
+                "request_threadpool", lambda: (limiter.borrowed_tokens, limiter.total_tokens)
+            )
+            try:
+                metrics_server = metrics.start_http_server(settings.metrics_port, settings.metrics_host)
+                logger.info(f"✅ Metrics on http://{settings.metrics_host}:{settings.metrics_port}/metrics")
+            except OSError as e:
+                # e.g. another worker process already owns the port
+                logger.warning(f"⚠️ Metrics listener unavailable: {e}")
+
         logger.info("✅ Zygotrix Backend started successfully")
         
         yield  # Application runs here
         
         # Shutdown
         logger.info("👋 Shutting down Zygotrix Backend...")
+        if metrics_server is not None:
+            metrics_server.shutdown()
+            metrics_server.server_close()
     
     logger.info("✅ MCP Client disconnected")
     logger.info("✅ Zygotrix Backend shutdown complete")
@@ -175,6 +197,7 @@ app.include_router(deep_research_router)
 app.include_router(web_search_router)
 app.include_router(scholar_analytics_router)
 app.include_router(pedigree_router)
+app.include_router(genomics_router)
 
 
 @app.get("/health", response_model=HealthResponse, tags=["System"])
@@ -390,7 +390,7 @@ mcp_tools: List[Dict[str, Any]] = [
             ToolParameter(
                 name="analysis_type",
                 type="string",
-                description="Type of analysis: 'linear' (quantitative traits), 'logistic' (binary traits), 'chi_square' (fast association)",
+                description="Type of analysis: 'linear' (quantitative traits), 'logistic' (binary traits), 'chi_square' (fast association), 'tdt' / 'sib_tdt' (family-based, PLINK datasets with parents in the .fam)",
                 required=False,
                 default="linear",
             ),
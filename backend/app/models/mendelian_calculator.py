@@ -1,11 +1,113 @@
 """
 MendelianCalculator - replaces zygotrix_engine.mendelian.MendelianCalculator
-Provides Punnett square calculations for preview feature.
+Provides exact Punnett square calculations for preview feature.
+
+Genotypes of any even ploidy are handled as allele-count multisets. A parent
+of ploidy k transmits k/2 chromosomes drawn without replacement (random
+chromosome segregation), so the probability of a gamete with allele counts g
+from a parent with counts n is the multivariate hypergeometric weight
+prod(C(n_i, g_i)) / C(k, k/2). Gametes and offspring are enumerated as
+distinct multisets with these weights instead of as ordered allele tuples,
+which keeps tetraploid and highly multi-allelic crosses small.
 """
-from typing import Dict, List, Tuple
-import itertools
+from math import comb
+from typing import Callable, Dict, List, Mapping, Sequence, Tuple
 from .trait import Trait
 
+AlleleCounts = Tuple[int, ...]
+GameteDistribution = Dict[AlleleCounts, float]
+
+
+def allele_counts(alleles: Sequence[str], allele_order: Sequence[str]) -> AlleleCounts:
+    """Count vector of ``alleles`` over ``allele_order``."""
+    index = {allele: i for i, allele in enumerate(allele_order)}
+    counts = [0] * len(allele_order)
+    for allele in alleles:
+        if allele not in index:
+            raise ValueError(f"Allele '{allele}' not in trait alleles: {tuple(allele_order)}")
+        counts[index[allele]] += 1
+    return tuple(counts)
+
+
+def counts_to_genotype(counts: AlleleCounts, allele_order: Sequence[str]) -> str:
+    """Canonical (sorted) genotype string for a count vector."""
+    return "".join(sorted(
+        allele for allele, count in zip(allele_order, counts) for _ in range(count)
+    ))
+
+
+def _diploid_gametes(counts: AlleleCounts) -> GameteDistribution:
+    """Ploidy 2: one allele per gamete."""
+    gametes: GameteDistribution = {}
+    for i, n in enumerate(counts):
+        if n:
+            gamete = [0] * len(counts)
+            gamete[i] = 1
+            gametes[tuple(gamete)] = n / 2
+    return gametes
+
+
+def _tetraploid_gametes(counts: AlleleCounts) -> GameteDistribution:
+    """Ploidy 4: two alleles per gamete, C(4, 2) = 6 equally likely chromosome pairs."""
+    gametes: GameteDistribution = {}
+    present = [i for i, n in enumerate(counts) if n]
+    for a, i in enumerate(present):
+        for j in present[a:]:
+            gamete = [0] * len(counts)
+            gamete[i] += 1
+            gamete[j] += 1
+            ways = comb(counts[i], 2) if i == j else counts[i] * counts[j]
+            if ways:
+                gametes[tuple(gamete)] = ways / 6
+    return gametes
+
+
+def _generic_gametes(counts: AlleleCounts) -> GameteDistribution:
+    """Any even ploidy: enumerate gamete count vectors with hypergeometric weights."""
+    ploidy = sum(counts)
+    size = ploidy // 2
+    total = comb(ploidy, size)
+    gametes: GameteDistribution = {}
+
+    def extend(position: int, remaining: int, prefix: List[int], ways: int) -> None:
+        if position == len(counts) - 1:
+            if remaining <= counts[position]:
+                gametes[tuple(prefix + [remaining])] = ways * comb(counts[position], remaining) / total
+            return
+        for take in range(min(remaining, counts[position]) + 1):
+            extend(position + 1, remaining - take, prefix + [take], ways * comb(counts[position], take))
+
+    if counts:
+        extend(0, size, [], 1)
+    return {g: w for g, w in gametes.items() if w > 0}
+
+
+# Specialised enumerators by ploidy; anything else uses the generic path
+GAMETE_ENUMERATORS: Dict[int, Callable[[AlleleCounts], GameteDistribution]] = {
+    2: _diploid_gametes,
+    4: _tetraploid_gametes,
+}
+
+
+def gamete_distribution(counts: AlleleCounts) -> GameteDistribution:
+    """Gamete count vectors and their probabilities for a parent genotype."""
+    enumerate_gametes = GAMETE_ENUMERATORS.get(sum(counts), _generic_gametes)
+    return enumerate_gametes(counts)
+
+
+def offspring_distribution(
+    parent1: AlleleCounts,
+    parent2: AlleleCounts,
+) -> Dict[AlleleCounts, float]:
+    """Exact offspring genotype (count vector) distribution for a single locus."""
+    offspring: Dict[AlleleCounts, float] = {}
+    gametes2 = gamete_distribution(parent2)
+    for g1, w1 in gamete_distribution(parent1).items():
+        for g2, w2 in gametes2.items():
+            child = tuple(a + b for a, b in zip(g1, g2))
+            offspring[child] = offspring.get(child, 0.0) + w1 * w2
+    return offspring
+
 
 class MendelianCalculator:
     """
@@ -26,54 +128,30 @@ class MendelianCalculator:
         Calculate Punnett square for a single-trait cross.
         Returns genotypic and phenotypic distributions with steps.
         """
-        # Parse genotypes
-        p1_alleles = self._parse_genotype(parent1_genotype, trait)
-        p2_alleles = self._parse_genotype(parent2_genotype, trait)
-
-        # Generate gametes (each parent contributes one allele)
-        p1_gametes = list(p1_alleles)
-        p2_gametes = list(p2_alleles)
+        gametes_p1 = self._gamete_distribution(parent1_genotype, trait)
+        gametes_p2 = self._gamete_distribution(parent2_genotype, trait)
 
-        # Punnett square: all combinations
-        offspring_genotypes: List[str] = []
+        # Punnett square over distinct gametes, weighted by their probabilities
         steps = []
-
-        for g1 in p1_gametes:
-            for g2 in p2_gametes:
-                # Canonical form (sorted)
-                genotype = "".join(sorted([g1, g2]))
-                offspring_genotypes.append(genotype)
+        for g1, w1 in gametes_p1.items():
+            for g2, w2 in gametes_p2.items():
                 steps.append({
                     "parent1_gamete": g1,
                     "parent2_gamete": g2,
-                    "offspring_genotype": genotype,
+                    "offspring_genotype": "".join(sorted(
+                        trait._parse_genotype(g1) + trait._parse_genotype(g2)
+                    )),
+                    "probability": w1 * w2,
                 })
 
-        # Count genotypes
-        genotypic_counts: Dict[str, int] = {}
-        for genotype in offspring_genotypes:
-            genotypic_counts[genotype] = genotypic_counts.get(genotype, 0) + 1
-
-        total = len(offspring_genotypes)
-
-        # Convert to ratios/percentages
-        genotypic_ratios = {}
-        for genotype, count in genotypic_counts.items():
-            value = (count / total) * 100 if as_percentages else count / total
-            genotypic_ratios[genotype] = value
+        genotype_distribution = self.calculate_offspring_probabilities(
+            parent1_genotype, parent2_genotype, trait
+        )
+        phenotype_distribution = trait.phenotype_distribution(genotype_distribution)
 
-        # Map genotypes to phenotypes
-        phenotypic_counts: Dict[str, int] = {}
-        for genotype in offspring_genotypes:
-            phenotype = trait.phenotype_map.get(
-                genotype, f"Unknown ({genotype})")
-            phenotypic_counts[phenotype] = phenotypic_counts.get(
-                phenotype, 0) + 1
-
-        phenotypic_ratios = {}
-        for phenotype, count in phenotypic_counts.items():
-            value = (count / total) * 100 if as_percentages else count / total
-            phenotypic_ratios[phenotype] = value
+        scale = 100.0 if as_percentages else 1.0
+        genotypic_ratios = {g: p * scale for g, p in genotype_distribution.items()}
+        phenotypic_ratios = {ph: p * scale for ph, p in phenotype_distribution.items()}
 
         return {
             "genotypic_ratios": genotypic_ratios,
@@ -83,6 +161,63 @@ class MendelianCalculator:
             "parent2_genotype": parent2_genotype,
         }
 
+    def calculate_offspring_probabilities(
+        self,
+        parent1_genotype: str,
+        parent2_genotype: str,
+        trait: Trait,
+    ) -> Dict[str, float]:
+        """Exact offspring genotype distribution keyed by canonical genotype."""
+        p1 = self._genotype_counts(parent1_genotype, trait)
+        p2 = self._genotype_counts(parent2_genotype, trait)
+        return {
+            counts_to_genotype(child, trait.alleles): probability
+            for child, probability in offspring_distribution(p1, p2).items()
+        }
+
+    def calculate_multilocus_cross(
+        self,
+        traits: Mapping[str, Trait],
+        parent1_genotypes: Mapping[str, str],
+        parent2_genotypes: Mapping[str, str],
+    ) -> Dict[Tuple[str, ...], float]:
+        """
+        Joint phenotype distribution across independently assorting loci.
+
+        Each locus is solved on its own and the per-locus phenotype
+        distributions are combined, so the work grows with the number of
+        phenotype classes rather than with the number of gamete tuples.
+
+        Returns:
+            Mapping from a tuple of phenotypes (in ``traits`` order) to probability
+        """
+        joint: Dict[Tuple[str, ...], float] = {(): 1.0}
+        for key, trait in traits.items():
+            locus = trait.phenotype_distribution(self.calculate_offspring_probabilities(
+                parent1_genotypes[key], parent2_genotypes[key], trait
+            ))
+            joint = {
+                prefix + (phenotype,): p * q
+                for prefix, p in joint.items()
+                for phenotype, q in locus.items()
+            }
+        return joint
+
+    def _gamete_distribution(self, genotype: str, trait: Trait) -> Dict[str, float]:
+        """Gamete probabilities keyed by gamete allele string."""
+        counts = self._genotype_counts(genotype, trait)
+        return {
+            counts_to_genotype(gamete, trait.alleles): probability
+            for gamete, probability in gamete_distribution(counts).items()
+        }
+
+    def _genotype_counts(self, genotype: str, trait: Trait) -> AlleleCounts:
+        alleles = self._parse_genotype(genotype, trait)
+        if len(alleles) != trait.ploidy:
+            raise ValueError(
+                f"Genotype must have exactly {trait.ploidy} alleles, got: {genotype}")
+        return allele_counts(alleles, trait.alleles)
+
     def _parse_genotype(self, genotype: str, trait: Trait) -> List[str]:
         """Parse genotype into alleles using trait's allele list."""
         return trait._parse_genotype(genotype)
@@ -19,12 +19,21 @@ class Trait:
         phenotype_map: Dict[str, str],
         description: Optional[str] = None,
         metadata: Optional[Dict[str, Any]] = None,
+        ploidy: Optional[int] = None,
     ):
         self.name = name
         self.alleles = tuple(alleles) if isinstance(alleles, list) else alleles
         self.phenotype_map = phenotype_map
         self.description = description
         self.metadata = metadata or {}
+        if ploidy is None:
+            try:
+                ploidy = int(self.metadata.get("ploidy", 2))
+            except (TypeError, ValueError):
+                ploidy = 2
+        if ploidy < 2 or ploidy % 2:
+            raise ValueError(f"Ploidy must be an even number >= 2, got: {ploidy}")
+        self.ploidy = ploidy
 
     def canonical_genotype(self, genotype: str) -> str:
         """
@@ -34,9 +43,9 @@ class Trait:
         # Split genotype into individual alleles (handles multi-char alleles like Rh+)
         alleles = self._parse_genotype(genotype)
 
-        if len(alleles) != 2:
+        if len(alleles) != self.ploidy:
             raise ValueError(
-                f"Genotype must have exactly 2 alleles, got: {genotype}")
+                f"Genotype must have exactly {self.ploidy} alleles, got: {genotype}")
 
         # Validate alleles exist in trait
         for allele in alleles:
@@ -80,9 +89,41 @@ class Trait:
         Returns canonical form (sorted).
         """
         genotypes = []
-        for a1, a2 in itertools.combinations_with_replacement(self.alleles, 2):
-            genotypes.append("".join(sorted([a1, a2])))
+        for combo in itertools.combinations_with_replacement(self.alleles, self.ploidy):
+            genotypes.append("".join(sorted(combo)))
         return genotypes
 
+    def phenotype_for(self, genotype: str) -> str:
+        """
+        Look up the phenotype of a canonical genotype.
+
+        Polyploid genotypes without an explicit mapping fall back to the diploid
+        genotype carrying the same set of alleles (e.g. "AAAa" -> "Aa"), i.e. the
+        phenotype depends on which alleles are present rather than on dosage.
+        """
+        if genotype in self.phenotype_map:
+            return self.phenotype_map[genotype]
+
+        if self.ploidy > 2:
+            present = sorted(set(self._parse_genotype(genotype)))
+            if len(present) == 1:
+                diploid = present[0] * 2
+            elif len(present) == 2:
+                diploid = "".join(present)
+            else:
+                diploid = None
+            if diploid is not None and diploid in self.phenotype_map:
+                return self.phenotype_map[diploid]
+
+        return f"Unknown ({genotype})"
+
+    def phenotype_distribution(self, genotype_distribution: Dict[str, float]) -> Dict[str, float]:
+        """Collapse a genotype probability distribution onto phenotypes."""
+        distribution: Dict[str, float] = {}
+        for genotype, probability in genotype_distribution.items():
+            phenotype = self.phenotype_for(genotype)
+            distribution[phenotype] = distribution.get(phenotype, 0.0) + probability
+        return distribution
+
     def __repr__(self) -> str:
-        return f"Trait(name={self.name}, alleles={self.alleles})"
+        return f"Trait(name={self.name}, alleles={self.alleles}, ploidy={self.ploidy})"
@@ -2,9 +2,14 @@
 GWAS Result Repository
 ======================
 Data access layer for GWAS analysis results.
+
+Full association lists are stored in fixed-size chunk documents of a side
+collection, so results of any size stay under the MongoDB document limit
+and can be written from a stream. Results stored before that keep their
+associations inline and are still read.
 """
 
-from typing import Optional, List, Dict, Any
+from typing import Optional, List, Dict, Any, Iterable, Iterator
 from datetime import datetime
 from pymongo.collection import Collection
 from bson import ObjectId
@@ -20,11 +25,16 @@ from ..schema.gwas import (
 )
 
 
+# Associations per chunk document
+ASSOCIATION_CHUNK_SIZE = 5000
+
+
 class GwasResultRepository:
     """Repository for GWAS analysis result operations."""
 
     def __init__(self):
         self._collection: Optional[Collection] = None
+        self._association_collection: Optional[Collection] = None
 
     def _get_collection(self) -> Collection:
         """Get the GWAS results collection."""
@@ -34,12 +44,61 @@ class GwasResultRepository:
             raise RuntimeError("GWAS results collection not available")
         return self._collection
 
+    def _get_association_collection(self) -> Collection:
+        """Get the collection holding association chunks."""
+        if self._association_collection is None:
+            self._association_collection = get_collection(
+                CollectionName.GWAS_RESULT_ASSOCIATIONS, required=True
+            )
+        if self._association_collection is None:
+            raise RuntimeError("GWAS result associations collection not available")
+        return self._association_collection
+
+    def store_associations(self, job_id: str, associations: Iterable[Dict[str, Any]]) -> int:
+        """
+        Store a job's full association list in chunks, consuming it as a stream.
+
+        Chunks left by an earlier attempt of the job are replaced.
+
+        Args:
+            job_id: Job ID
+            associations: Association dicts, in the order they should be read back
+
+        Returns:
+            Number of associations stored
+        """
+        collection = self._get_association_collection()
+        collection.delete_many({"job_id": job_id})
+
+        count = 0
+        n_chunks = 0
+        chunk: List[Dict[str, Any]] = []
+        for assoc in associations:
+            chunk.append(assoc)
+            count += 1
+            if len(chunk) == ASSOCIATION_CHUNK_SIZE:
+                collection.insert_one({"job_id": job_id, "chunk": n_chunks, "associations": chunk})
+                n_chunks += 1
+                chunk = []
+        if chunk:
+            collection.insert_one({"job_id": job_id, "chunk": n_chunks, "associations": chunk})
+        return count
+
+    def _iter_associations(self, doc: Dict[str, Any]) -> Iterator[Dict[str, Any]]:
+        """Associations of a result document, chunked or inline."""
+        if not doc.get("associations_chunked"):
+            yield from doc.get("associations", [])
+            return
+        cursor = self._get_association_collection().find({"job_id": doc["job_id"]}).sort("chunk", 1)
+        for chunk in cursor:
+            yield from chunk["associations"]
+
     def create(
         self,
         job_id: str,
         user_id: str,
         dataset_id: str,
-        associations: List[Dict[str, Any]],  # Raw dicts from C++ engine
+        associations: Optional[List[Dict[str, Any]]],  # Raw dicts from C++ engine
         summary: Dict[str, Any],
         manhattan_plot_data: Dict[str, Any],
         qq_plot_data: Dict[str, Any],
@@ -52,7 +111,8 @@ class GwasResultRepository:
             job_id: Job ID
             user_id: User ID
             dataset_id: Dataset ID
-            associations: List of SNP associations
+            associations: List of SNP associations, or None when they were
+                already written with store_associations
             summary: Summary statistics
             manhattan_plot_data: Manhattan plot data
             qq_plot_data: Q-Q plot data
@@ -63,12 +123,14 @@ class GwasResultRepository:
         """
         collection = self._get_collection()
         now = datetime.utcnow()
+        if associations is not None:
+            self.store_associations(job_id, associations)
 
         result_doc = {
             "job_id": job_id,
             "user_id": user_id,
             "dataset_id": dataset_id,
-            "associations": associations,  # Full results
+            "associations_chunked": True,  # Full results live in the chunk collection
             "summary": summary,
             "manhattan_plot_data": manhattan_plot_data,
             "qq_plot_data": qq_plot_data,
@@ -168,6 +230,9 @@ class GwasResultRepository:
             List of associations for the chromosome
         """
         collection = self._get_collection()
+        doc = collection.find_one({"job_id": job_id}, projection={"associations_chunked": 1})
+        if doc and doc.get("associations_chunked"):
+            collection = self._get_association_collection()
 
         # Build aggregation pipeline
         match_stage: Dict[str, Any] = {"job_id": job_id}
@@ -233,6 +298,7 @@ class GwasResultRepository:
         """
         collection = self._get_collection()
         result = collection.delete_one({"job_id": job_id})
+        self._get_association_collection().delete_many({"job_id": job_id})
         return result.deleted_count > 0
 
     def _doc_to_summary_response(self, doc: Dict[str, Any]) -> GwasResultResponse:
@@ -255,7 +321,7 @@ class GwasResultRepository:
             id=str(doc["_id"]),
             job_id=doc["job_id"],
             summary=GwasSummaryStats(**doc["summary"]),
-            associations=[SnpAssociation(**assoc) for assoc in doc.get("associations", [])],
+            associations=[SnpAssociation(**assoc) for assoc in self._iter_associations(doc)],
             manhattan_plot_data=ManhattanPlotData(**doc["manhattan_plot_data"]),
             qq_plot_data=QQPlotData(**doc["qq_plot_data"]),
             created_at=doc["created_at"],
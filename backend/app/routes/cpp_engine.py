@@ -1,6 +1,6 @@
 from __future__ import annotations
 
-from fastapi import APIRouter
+from fastapi import APIRouter, HTTPException
 
 from ..schema.cpp_engine import GeneticCrossRequest, GeneticCrossResponse
 from ..services.cpp_engine import run_cpp_cross
@@ -10,4 +10,7 @@ router = APIRouter(prefix="/api/cpp", tags=["C++ Engine"])
 
 @router.post("/cross", response_model=GeneticCrossResponse)
 def compute_cpp_cross(request: GeneticCrossRequest) -> GeneticCrossResponse:
-    return run_cpp_cross(request)
+    try:
+        return run_cpp_cross(request)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
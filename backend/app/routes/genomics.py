@@ -0,0 +1,106 @@
+from fastapi import APIRouter, Depends, HTTPException
+
+from ..dependencies import get_current_user
+from ..schema.auth import UserProfile
+from ..schema.genomics import (
+    GwasPowerRequest,
+    GwasPowerResponse,
+    LinkageMapRequest,
+    LinkageMapResponse,
+    QtlScanRequest,
+    QtlScanResponse,
+)
+from ..services.genomics.gwas_power import gwas_power
+from ..services.genomics.linkage_map import build_linkage_map
+from ..services.genomics.qtl import scan_qtl
+
+router = APIRouter(prefix="/api/genomics", tags=["Genomics"])
+
+
+@router.post("/qtl/scan", response_model=QtlScanResponse)
+def qtl_scan(
+    request: QtlScanRequest,
+    current_user: UserProfile = Depends(get_current_user),  # noqa: F841 - auth guard
+) -> QtlScanResponse:
+    """
+    Haley–Knott interval mapping for an F2 or backcross population.
+
+    Returns LOD profiles per chromosome, the peak on each chromosome with its
+    1.5-LOD support interval, and permutation-based genome-wide thresholds.
+    """
+    try:
+        result = scan_qtl(
+            cross_type=request.cross_type,
+            chromosomes=[chrom.model_dump() for chrom in request.chromosomes],
+            genotypes=request.genotypes,
+            phenotypes=request.phenotypes,
+            covariates=request.covariates,
+            step_cm=request.step_cm,
+            map_function=request.map_function,
+            error_prob=request.error_prob,
+            n_permutations=request.n_permutations,
+            alphas=request.alphas,
+            seed=request.seed,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return QtlScanResponse(**result)
+
+
+@router.post("/linkage-map", response_model=LinkageMapResponse)
+def linkage_map(
+    request: LinkageMapRequest,
+    current_user: UserProfile = Depends(get_current_user),  # noqa: F841 - auth guard
+) -> LinkageMapResponse:
+    """
+    Build a genetic linkage map from F2 or backcross marker genotypes.
+
+    Markers are grouped by two-point LOD, ordered within each group and the
+    adjacent intervals refined by multipoint EM. ``linkage`` in the response
+    can be passed as the ``linkage`` field of a cross request.
+    """
+    try:
+        result = build_linkage_map(
+            cross_type=request.cross_type,
+            marker_names=request.marker_names,
+            genotypes=request.genotypes,
+            lod_threshold=request.lod_threshold,
+            max_rf=request.max_rf,
+            map_function=request.map_function,
+            error_prob=request.error_prob,
+            refine=request.refine,
+            include_pairwise=request.include_pairwise,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return LinkageMapResponse(**result)
+
+
+@router.post("/gwas-power", response_model=GwasPowerResponse)
+def gwas_power_grid(
+    request: GwasPowerRequest,
+    current_user: UserProfile = Depends(get_current_user),  # noqa: F841 - auth guard
+) -> GwasPowerResponse:
+    """
+    Power of a single-variant association test over a study-design grid.
+
+    Analytic power uses the closed-form 1-df non-central χ² tail; the
+    simulated mode adds Monte-Carlo power from the production regression
+    kernel. With ``target_power`` each point also reports the required N.
+    """
+    try:
+        result = gwas_power(
+            trait_type=request.trait_type,
+            sample_sizes=request.sample_sizes,
+            mafs=request.mafs,
+            effect_sizes=request.effect_sizes,
+            alphas=request.alphas,
+            case_fractions=request.case_fractions,
+            mode=request.mode,
+            replicates=request.replicates,
+            target_power=request.target_power,
+            seed=request.seed,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return GwasPowerResponse(**result)
@@ -11,7 +11,8 @@ from fastapi import APIRouter, Depends, HTTPException, Query, Path, UploadFile,
 from fastapi.responses import StreamingResponse
 import io
 import csv
-import json
+import shutil
+import tempfile
 
 from ..dependencies import get_current_user_optional
 from ..schema.auth import UserProfile
@@ -34,6 +35,33 @@ from ..repositories import (
 )
 from ..services import get_gwas_analysis_service, get_gwas_dataset_service
 from ..services import gwas_dataset  # For legacy trait search
+from ..services.gwas_catalog_crossref import crossref_associations
+from ..services.genomics.admixture import dataset_admixture
+from ..services.genomics.coloc import colocalize
+from ..services.genomics.haplotype_blocks import dataset_haplotype_blocks
+from ..services.genomics.liftover import dataset_liftover, lift_associations
+from ..services.genomics.mendelian_randomization import dataset_panel, mendelian_randomization
+from ..services.genomics.roh import dataset_roh
+from ..services.genomics.sample_qc import dataset_sample_qc
+from ..services.genomics.sumstats import (
+    dataset_reference,
+    delete_sumstats,
+    ingest_sumstats,
+    list_sumstats,
+    open_sumstats,
+)
+from ..schema.genomics import (
+    AdmixtureResponse,
+    ColocResponse,
+    HaplotypeBlocksResponse,
+    LiftoverResponse,
+    MendelianRandomizationRequest,
+    MendelianRandomizationResponse,
+    RohResponse,
+    SampleQcResponse,
+    SumstatsResponse,
+)
+from ..serializers import json_writer
 
 
 async def get_public_or_auth_user(
@@ -151,6 +179,172 @@ def get_dataset(
     return dataset
 
 
+@router.get("/datasets/{dataset_id}/haplotype-blocks", response_model=HaplotypeBlocksResponse)
+def get_haplotype_blocks(
+    dataset_id: str = Path(..., description="Dataset ID"),
+    method: str = Query("gabriel", pattern="^(gabriel|dprime)$", description="Gabriel CI or fast D' spine"),
+    chromosome: Optional[List[int]] = Query(None, description="Restrict to these chromosomes"),
+    max_distance_kb: float = Query(500.0, gt=0, le=5000, description="Maximum block span"),
+    max_window_snps: int = Query(200, ge=2, le=1000, description="Maximum SNPs between a pair"),
+    maf_threshold: float = Query(0.05, ge=0, lt=0.5, description="Skip rarer SNPs"),
+    dprime_threshold: float = Query(0.8, gt=0, le=1, description="Strong-LD |D'| for the dprime method"),
+    min_haplotype_frequency: float = Query(0.01, ge=0, le=1, description="Hide rarer haplotypes"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> HaplotypeBlocksResponse:
+    """
+    Partition each chromosome of a dataset into LD blocks.
+
+    Returns block boundaries and per-block haplotype frequencies. Results are
+    cached per dataset and parameter set.
+    """
+    try:
+        result = dataset_haplotype_blocks(
+            current_user.id,
+            dataset_id,
+            method=method,
+            chromosomes=chromosome,
+            max_distance_kb=max_distance_kb,
+            max_window_snps=max_window_snps,
+            maf_threshold=maf_threshold,
+            dprime_threshold=dprime_threshold,
+            min_haplotype_frequency=min_haplotype_frequency,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    if result is None:
+        raise HTTPException(status_code=404, detail=f"Dataset {dataset_id} not found or not processed")
+    return HaplotypeBlocksResponse(**result)
+
+
+@router.get("/datasets/{dataset_id}/roh", response_model=RohResponse)
+def get_runs_of_homozygosity(
+    dataset_id: str = Path(..., description="Dataset ID"),
+    window_snps: int = Query(50, ge=5, le=1000, description="Scanning window size"),
+    window_max_het: int = Query(1, ge=0, description="Heterozygous calls allowed per window"),
+    window_max_missing: int = Query(5, ge=0, description="Missing calls allowed per window"),
+    max_gap_kb: float = Query(1000.0, gt=0, description="Maximum gap between adjacent SNPs in a run"),
+    min_snps: int = Query(100, ge=1, description="Minimum SNPs per run"),
+    min_length_kb: float = Query(1000.0, ge=0, description="Minimum run length"),
+    max_kb_per_snp: float = Query(50.0, gt=0, description="Minimum run density (kb per SNP)"),
+    include_segments: bool = Query(False, description="Return individual runs per sample"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> RohResponse:
+    """
+    Runs of homozygosity and inbreeding coefficients (F_ROH, F_hom, F_grm)
+    for every sample of a dataset, from its autosomal SNPs.
+    """
+    try:
+        result = dataset_roh(
+            current_user.id,
+            dataset_id,
+            window_snps=window_snps,
+            window_max_het=window_max_het,
+            window_max_missing=window_max_missing,
+            max_gap_kb=max_gap_kb,
+            min_snps=min_snps,
+            min_length_kb=min_length_kb,
+            max_kb_per_snp=max_kb_per_snp,
+            include_segments=include_segments,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    if result is None:
+        raise HTTPException(status_code=404, detail=f"Dataset {dataset_id} not found or not processed")
+    return RohResponse(**result)
+
+
+@router.get("/datasets/{dataset_id}/sample-qc", response_model=SampleQcResponse)
+def get_sample_qc(
+    dataset_id: str = Path(..., description="Dataset ID"),
+    min_call_rate: float = Query(0.95, ge=0, le=1, description="Exclude samples below this call rate"),
+    het_sd: float = Query(3.0, gt=0, description="Heterozygosity outlier threshold (SDs from the mean)"),
+    female_max_f: float = Query(0.2, description="X-chromosome F below which a sample is female"),
+    male_min_f: float = Query(0.8, description="X-chromosome F above which a sample is male"),
+    sex_check: bool = Query(True, description="Exclude samples whose reported sex contradicts the X F"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> SampleQcResponse:
+    """
+    Per-sample call rate, heterozygosity and sex-check metrics for a dataset,
+    with the exclusion mask that ``apply_sample_qc`` applies to GWAS jobs.
+    """
+    try:
+        result = dataset_sample_qc(
+            current_user.id,
+            dataset_id,
+            min_call_rate=min_call_rate,
+            het_sd=het_sd,
+            female_max_f=female_max_f,
+            male_min_f=male_min_f,
+            sex_check=sex_check,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    if result is None:
+        raise HTTPException(status_code=404, detail=f"Dataset {dataset_id} not found or not processed")
+    return SampleQcResponse(**result)
+
+
+@router.get("/datasets/{dataset_id}/admixture", response_model=AdmixtureResponse)
+def get_dataset_admixture(
+    dataset_id: str = Path(..., description="Dataset ID"),
+    k: int = Query(3, ge=2, le=20, description="Ancestral populations (ignored in supervised mode)"),
+    reference_column: Optional[str] = Query(
+        None, description="Sample column with reference population labels; enables supervised mode"
+    ),
+    min_maf: float = Query(0.01, ge=0, le=0.5, description="Skip SNPs below this MAF"),
+    max_snps: int = Query(20_000, ge=100, le=200_000, description="Thin evenly to at most this many SNPs"),
+    max_iterations: int = Query(500, ge=1, le=1000, description="SQUAREM cycles"),
+    tolerance: float = Query(1e-4, gt=0, description="Log-likelihood convergence threshold"),
+    seed: Optional[int] = Query(None, description="Seed for the starting point"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> AdmixtureResponse:
+    """
+    ADMIXTURE-style ancestry proportions (Q) and ancestral allele
+    frequencies (P) for a dataset, fitted by SQUAREM-accelerated EM.
+    """
+    try:
+        result = dataset_admixture(
+            current_user.id,
+            dataset_id,
+            k=k,
+            reference_column=reference_column,
+            min_maf=min_maf,
+            max_snps=max_snps,
+            max_iterations=max_iterations,
+            tolerance=tolerance,
+            seed=seed,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    if result is None:
+        raise HTTPException(status_code=404, detail=f"Dataset {dataset_id} not found or not processed")
+    return AdmixtureResponse(**result)
+
+
+@router.get("/datasets/{dataset_id}/liftover", response_model=LiftoverResponse)
+def get_dataset_liftover(
+    dataset_id: str = Path(..., description="Dataset ID"),
+    source_build: str = Query("GRCh37", description="Build of the dataset coordinates"),
+    target_build: str = Query("GRCh38", description="Build to lift to"),
+    include_unmapped: bool = Query(True, description="List variants that could not be lifted"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> LiftoverResponse:
+    """
+    Lift a dataset's variant coordinates to another genome build with the
+    UCSC chain file for the build pair, reporting unmapped, ambiguous and
+    strand-flipped variants.
+    """
+    try:
+        result = dataset_liftover(
+            current_user.id, dataset_id, source_build, target_build, include_unmapped
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    if result is None:
+        raise HTTPException(status_code=404, detail=f"Dataset {dataset_id} not found or not processed")
+    return LiftoverResponse(**result)
+
+
 @router.delete("/datasets/{dataset_id}", status_code=204)
 def delete_dataset(
     dataset_id: str = Path(..., description="Dataset ID"),
@@ -203,7 +397,9 @@ def create_analysis_job(
         "phenotype_column": "height",
         "covariates": ["age", "sex"],
         "maf_threshold": 0.01,
-        "num_threads": 4
+        "num_threads": 4,
+        "memory_budget_mb": 512,
+        "apply_sample_qc": true
     }
     ```
     """
@@ -254,6 +450,9 @@ def create_analysis_job(
         covariates=request.covariates,
         maf_threshold=request.maf_threshold,
         num_threads=request.num_threads,
+        memory_budget_mb=request.memory_budget_mb,
+        exclude_samples=request.exclude_samples,
+        apply_sample_qc=request.apply_sample_qc,
     )
 
     return job
@@ -268,6 +467,9 @@ def _run_analysis_background(
     covariates: Optional[List[str]],
     maf_threshold: float,
     num_threads: int,
+    memory_budget_mb: Optional[int] = None,
+    exclude_samples: Optional[List[str]] = None,
+    apply_sample_qc: bool = False,
 ) -> None:
     """Background task to run GWAS analysis."""
     analysis_service = get_gwas_analysis_service()
@@ -282,6 +484,9 @@ def _run_analysis_background(
             covariates=covariates,
             maf_threshold=maf_threshold,
             num_threads=num_threads,
+            memory_budget_mb=memory_budget_mb,
+            exclude_samples=exclude_samples,
+            apply_sample_qc=apply_sample_qc,
         )
     except Exception as e:
         # Error handling is done in the service
@@ -464,6 +669,135 @@ def get_top_associations(
     return associations[:limit]
 
 
+@router.get("/jobs/{job_id}/catalog-matches", response_model=dict)
+def get_catalog_matches(
+    job_id: str = Path(..., description="Job ID"),
+    window_bp: int = Query(0, ge=0, le=1_000_000, description="Match catalogue variants within this distance"),
+    max_per_hit: int = Query(20, ge=1, le=200, description="Max catalogue rows per hit"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> dict:
+    """
+    Cross-reference a job's top hits against the public GWAS Catalog.
+
+    Returns known associations per hit plus enrichment counts, using all
+    tested associations of the job as the background.
+    """
+    result_repo = get_gwas_result_repository()
+
+    # Verify access
+    analysis_service = get_gwas_analysis_service()
+    job = analysis_service.get_job_status(job_id, current_user.id)
+    if not job:
+        raise HTTPException(status_code=404, detail=f"Job {job_id} not found")
+
+    result = result_repo.find_by_job_id(job_id)
+    detail = result_repo.find_detailed_by_job_id(job_id)
+    if not result or not detail:
+        raise HTTPException(
+            status_code=404,
+            detail=f"Results not found for job {job_id}",
+        )
+
+    try:
+        return crossref_associations(
+            result.top_hits,
+            background=detail.associations,
+            window_bp=window_bp,
+            max_per_hit=max_per_hit,
+        )
+    except gwas_dataset.DatasetLoadError as exc:
+        raise HTTPException(status_code=500, detail=str(exc))
+
+
+@router.get("/jobs/{job_id}/coloc", response_model=ColocResponse)
+def get_job_coloc(
+    job_id: str = Path(..., description="Job ID"),
+    other_job_id: str = Query(..., description="Job to colocalise with"),
+    p_threshold: float = Query(5e-8, gt=0, lt=1, description="SNPs below this p in either job seed a locus"),
+    window_kb: float = Query(500.0, gt=0, le=10_000, description="Locus half-width around each seed SNP"),
+    p1: float = Query(1e-4, gt=0, lt=1, description="Prior probability a SNP is causal for this job's trait"),
+    p2: float = Query(1e-4, gt=0, lt=1, description="Prior probability a SNP is causal for the other trait"),
+    p12: float = Query(1e-5, gt=0, lt=1, description="Prior probability a SNP is causal for both"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> ColocResponse:
+    """
+    Bayesian colocalisation (coloc ABF) of two jobs' association results.
+
+    Returns H0–H4 posteriors for every locus significant in either job and
+    the SNP most likely to be the shared causal variant.
+    """
+    result_repo = get_gwas_result_repository()
+    analysis_service = get_gwas_analysis_service()
+
+    jobs = {}
+    details = {}
+    for jid in (job_id, other_job_id):
+        jobs[jid] = analysis_service.get_job_status(jid, current_user.id)
+        if not jobs[jid]:
+            raise HTTPException(status_code=404, detail=f"Job {jid} not found")
+        details[jid] = result_repo.find_detailed_by_job_id(jid)
+        if not details[jid]:
+            raise HTTPException(status_code=404, detail=f"Results not found for job {jid}")
+
+    def is_binary(jid: str) -> bool:
+        return jobs[jid].analysis_type != GwasAnalysisType.LINEAR
+
+    try:
+        result = colocalize(
+            [assoc.model_dump() for assoc in details[job_id].associations],
+            [assoc.model_dump() for assoc in details[other_job_id].associations],
+            first_binary=is_binary(job_id),
+            second_binary=is_binary(other_job_id),
+            p_threshold=p_threshold,
+            window_kb=window_kb,
+            p1=p1,
+            p2=p2,
+            p12=p12,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return ColocResponse(job_id=job_id, other_job_id=other_job_id, **result)
+
+
+@router.get("/jobs/{job_id}/liftover", response_model=LiftoverResponse)
+def get_job_liftover(
+    job_id: str = Path(..., description="Job ID"),
+    source_build: str = Query("GRCh37", description="Build of the result coordinates"),
+    target_build: str = Query("GRCh38", description="Build to lift to"),
+    include_unmapped: bool = Query(True, description="List associations that could not be lifted"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> LiftoverResponse:
+    """
+    Lift all tested associations of a job to another genome build, e.g. to
+    join them with catalogue or meta-analysis data on a different build.
+    """
+    result_repo = get_gwas_result_repository()
+
+    # Verify access
+    analysis_service = get_gwas_analysis_service()
+    job = analysis_service.get_job_status(job_id, current_user.id)
+    if not job:
+        raise HTTPException(status_code=404, detail=f"Job {job_id} not found")
+
+    detail = result_repo.find_detailed_by_job_id(job_id)
+    if not detail:
+        raise HTTPException(
+            status_code=404,
+            detail=f"Results not found for job {job_id}",
+        )
+
+    try:
+        result = lift_associations(
+            [assoc.model_dump() for assoc in detail.associations],
+            source_build,
+            target_build,
+            include_unmapped,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return LiftoverResponse(job_id=job_id, **result)
+
+
 @router.get("/jobs/{job_id}/export")
 def export_results(
     job_id: str = Path(..., description="Job ID"),
@@ -479,63 +813,179 @@ def export_results(
     """
     analysis_service = get_gwas_analysis_service()
 
-    result = analysis_service.get_job_results(job_id, current_user.id)
+    # Checks ownership and completion
+    analysis_service.get_job_results(job_id, current_user.id)
+    detail = get_gwas_result_repository().find_detailed_by_job_id(job_id)
+    if not detail:
+        raise HTTPException(status_code=404, detail=f"Results not found for job {job_id}")
+    records = [assoc.model_dump() for assoc in detail.associations]
 
     if format == "csv":
-        return _export_as_csv(result)
+        return _export_as_csv(job_id, records)
     else:
-        return _export_as_json(result)
+        return _export_as_json(job_id, records)
+
 
+_EXPORT_COLUMNS = [
+    "rsid", "chromosome", "position", "ref_allele", "alt_allele",
+    "p_value", "beta", "se", "t_stat", "maf", "n_samples",
+    "odds_ratio", "ci_lower", "ci_upper",
+]
 
-def _export_as_csv(result: GwasResultResponse) -> StreamingResponse:
+
+def _export_as_csv(job_id: str, records: List[dict]) -> StreamingResponse:
     """Export results as CSV."""
     output = io.StringIO()
-    writer = csv.DictWriter(
-        output,
-        fieldnames=[
-            "rsid", "chromosome", "position", "ref_allele", "alt_allele",
-            "p_value", "beta", "se", "t_stat", "maf", "n_samples",
-            "odds_ratio", "ci_lower", "ci_upper",
-        ],
-    )
+    writer = csv.DictWriter(output, fieldnames=_EXPORT_COLUMNS, extrasaction="ignore")
     writer.writeheader()
-
-    for assoc in result.associations:
-        writer.writerow({
-            "rsid": assoc.get("rsid"),
-            "chromosome": assoc.get("chromosome"),
-            "position": assoc.get("position"),
-            "ref_allele": assoc.get("ref_allele"),
-            "alt_allele": assoc.get("alt_allele"),
-            "p_value": assoc.get("p_value"),
-            "beta": assoc.get("beta"),
-            "se": assoc.get("se"),
-            "t_stat": assoc.get("t_stat"),
-            "maf": assoc.get("maf"),
-            "n_samples": assoc.get("n_samples"),
-            "odds_ratio": assoc.get("odds_ratio"),
-            "ci_lower": assoc.get("ci_lower"),
-            "ci_upper": assoc.get("ci_upper"),
-        })
+    writer.writerows(records)
 
     output.seek(0)
     return StreamingResponse(
         io.BytesIO(output.getvalue().encode("utf-8")),
         media_type="text/csv",
-        headers={"Content-Disposition": f"attachment; filename=gwas_results_{result.job_id}.csv"},
+        headers={"Content-Disposition": f"attachment; filename=gwas_results_{job_id}.csv"},
     )
 
 
-def _export_as_json(result: GwasResultResponse) -> StreamingResponse:
-    """Export results as JSON."""
-    output = json.dumps(result.associations, indent=2)
+def _export_as_json(job_id: str, records: List[dict]) -> StreamingResponse:
+    """Export results as JSON (one association per line, streamed in chunks)."""
     return StreamingResponse(
-        io.BytesIO(output.encode("utf-8")),
+        json_writer.iter_records_json(records, keys=_EXPORT_COLUMNS),
         media_type="application/json",
-        headers={"Content-Disposition": f"attachment; filename=gwas_results_{result.job_id}.json"},
+        headers={"Content-Disposition": f"attachment; filename=gwas_results_{job_id}.json"},
     )
 
 
+# ============================================================================
+# Summary Statistics Endpoints
+# ============================================================================
+
+def _upload_suffix(filename: Optional[str]) -> str:
+    """Temp-file suffix from an upload name: its last extensions, never path parts."""
+    base = (filename or "").replace("\\", "/").rsplit("/", 1)[-1]
+    extensions = base.split(".")[1:][-2:]
+    return "".join(f".{ext}" for ext in extensions if ext.isascii() and ext.isalnum() and len(ext) <= 8)
+
+
+@router.post("/sumstats/upload", response_model=SumstatsResponse, status_code=201)
+def upload_sumstats(
+    name: str = Query(..., description="Summary statistics name"),
+    reference_dataset_id: Optional[str] = Query(None, description="Dataset to harmonise alleles against"),
+    palindromic_maf_window: float = Query(0.08, ge=0, le=0.5, description="Drop palindromic SNPs with EAF this close to 0.5"),
+    file: UploadFile = File(..., description="Summary statistics (TSV, CSV or whitespace; optionally gzipped)"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> SumstatsResponse:
+    """
+    Ingest external GWAS summary statistics for PRS, meta-analysis and MR.
+
+    Columns are detected from the header. With ``reference_dataset_id`` the
+    alleles are harmonised to the dataset's ALT allele (swaps, strand flips,
+    palindromic SNPs by allele frequency) and unmatched variants dropped.
+    """
+    reference = None
+    if reference_dataset_id:
+        reference = dataset_reference(current_user.id, reference_dataset_id)
+        if reference is None:
+            raise HTTPException(
+                status_code=404,
+                detail=f"Dataset {reference_dataset_id} not found or not processed",
+            )
+
+    with tempfile.NamedTemporaryFile(suffix=_upload_suffix(file.filename)) as tmp:
+        shutil.copyfileobj(file.file, tmp)
+        tmp.flush()
+        try:
+            meta = ingest_sumstats(
+                current_user.id,
+                tmp.name,
+                name,
+                reference=reference,
+                reference_name=reference_dataset_id,
+                palindromic_maf_window=palindromic_maf_window,
+                source_name=file.filename,
+            )
+        except ValueError as e:
+            raise HTTPException(status_code=400, detail=str(e))
+    return SumstatsResponse(**meta)
+
+
+@router.get("/sumstats", response_model=List[SumstatsResponse])
+def get_sumstats_list(
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> List[SumstatsResponse]:
+    """List the summary statistics ingested by the current user."""
+    return [SumstatsResponse(**meta) for meta in list_sumstats(current_user.id)]
+
+
+@router.get("/sumstats/{sumstats_id}", response_model=SumstatsResponse)
+def get_sumstats(
+    sumstats_id: str = Path(..., description="Summary statistics ID"),
+    top: int = Query(20, ge=0, le=1000, description="Most significant variants to include"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> SumstatsResponse:
+    """Ingestion summary of a summary-statistics file and its top variants."""
+    store = open_sumstats(current_user.id, sumstats_id)
+    if store is None:
+        raise HTTPException(status_code=404, detail=f"Summary statistics {sumstats_id} not found")
+    return SumstatsResponse(**store.meta, top_variants=store.records(store.top_rows(top)))
+
+
+@router.delete("/sumstats/{sumstats_id}", status_code=204)
+def remove_sumstats(
+    sumstats_id: str = Path(..., description="Summary statistics ID"),
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+):
+    """Delete an ingested summary-statistics file."""
+    if not delete_sumstats(current_user.id, sumstats_id):
+        raise HTTPException(status_code=404, detail=f"Summary statistics {sumstats_id} not found")
+
+
+@router.post("/sumstats/mr", response_model=MendelianRandomizationResponse)
+def run_mendelian_randomization(
+    request: MendelianRandomizationRequest,
+    current_user: UserProfile = Depends(get_public_or_auth_user),
+) -> MendelianRandomizationResponse:
+    """
+    Two-sample Mendelian randomisation of an exposure on an outcome.
+
+    Instruments are exposure variants below ``p_threshold``, LD-clumped
+    against ``reference_dataset_id`` when given. Returns IVW, MR-Egger,
+    weighted median and weighted mode estimates with heterogeneity tests.
+    """
+    stores = {}
+    for role, sumstats_id in (("exposure", request.exposure_id), ("outcome", request.outcome_id)):
+        stores[role] = open_sumstats(current_user.id, sumstats_id)
+        if stores[role] is None:
+            raise HTTPException(status_code=404, detail=f"Summary statistics {sumstats_id} not found")
+
+    panel = None
+    if request.reference_dataset_id:
+        panel = dataset_panel(current_user.id, request.reference_dataset_id)
+        if panel is None:
+            raise HTTPException(
+                status_code=404,
+                detail=f"Dataset {request.reference_dataset_id} not found or not processed",
+            )
+
+    try:
+        result = mendelian_randomization(
+            stores["exposure"],
+            stores["outcome"],
+            p_threshold=request.p_threshold,
+            panel=panel,
+            clump_r2=request.clump_r2,
+            clump_kb=request.clump_kb,
+            n_bootstrap=request.n_bootstrap,
+            mode_phi=request.mode_phi,
+            palindromic_maf_window=request.palindromic_maf_window,
+            seed=request.seed,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return MendelianRandomizationResponse(**result)
+
+
 # ============================================================================
 # Legacy Trait Search Endpoints (from original gwas.py)
 # ============================================================================
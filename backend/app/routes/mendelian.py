@@ -14,6 +14,8 @@ from ..schema.mendelian import (
     JointPhenotypeSimulationResponse,
     GenotypeRequest,
     GenotypeResponse,
+    InverseCrossRequest,
+    InverseCrossResponse,
 )
 
 router = APIRouter(prefix="/api/mendelian", tags=["Mendelian"])
@@ -140,3 +142,18 @@ def get_trait_genotypes(request: GenotypeRequest) -> GenotypeResponse:
         return GenotypeResponse(genotypes=genotypes, missing_traits=missing)
     except ValueError as e:
         raise HTTPException(status_code=400, detail=str(e))
+
+
+@router.post("/infer-parents", response_model=InverseCrossResponse)
+def infer_parents(request: InverseCrossRequest) -> InverseCrossResponse:
+    """Rank parental genotypes (and linkage) that explain observed offspring counts."""
+    try:
+        result = mendelian_services.infer_parental_genotypes(
+            trait_keys=request.trait_keys,
+            observed=[(o.phenotypes, o.count) for o in request.observed],
+            linked=request.linked,
+            max_hypotheses=request.max_hypotheses,
+        )
+        return InverseCrossResponse(**result)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
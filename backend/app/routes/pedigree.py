@@ -1,6 +1,12 @@
 from fastapi import APIRouter, HTTPException, Depends
-from app.schema.pedigree import PedigreeRequest, PedigreeResponse
+from app.schema.pedigree import (
+    PedigreeRequest,
+    PedigreeResponse,
+    HypotheticalChildRequest,
+    HypotheticalChildResponse,
+)
 from app.services.pedigree_agent import process_pedigree_query
+from app.services.pedigree_solver import query_hypothetical_children
 from app.dependencies import get_current_user
 from app.schema.auth import UserProfile
 
@@ -16,6 +22,29 @@ async def analyze_pedigree(
     Orchestrates LLM extraction -> C++ Validation -> LLM Explanation.
     """
     try:
-        return await process_pedigree_query(request)
+        return await process_pedigree_query(request, user_id=current_user.id)
     except Exception as e:
-        raise HTTPException(status_code=500, detail=str(e))
\ No newline at end of file
+        raise HTTPException(status_code=500, detail=str(e))
+
+@router.post("/hypothetical-children", response_model=HypotheticalChildResponse)
+async def hypothetical_children(
+    request: HypotheticalChildRequest,
+    current_user: UserProfile = Depends(get_current_user)
+):
+    """
+    "What is the chance our next child is X" for one or more couples.
+    Answered from the posteriors of an already solved pedigree session, without re-solving.
+    Only the caller's own sessions are visible; any other session_id is a 404.
+    """
+    pairs = [
+        (query.parent_ids[0], query.parent_ids[1] if len(query.parent_ids) > 1 else None)
+        for query in request.queries
+    ]
+    try:
+        results = query_hypothetical_children(request.session_id, pairs, user_id=current_user.id)
+    except LookupError as e:
+        # KeyError (unknown member) is a LookupError too
+        raise HTTPException(status_code=404, detail=str(e))
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return HypotheticalChildResponse(session_id=request.session_id, results=results)
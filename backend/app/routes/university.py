@@ -5,7 +5,7 @@ from typing import Optional
 from fastapi import APIRouter, Depends, HTTPException, Query
 
 from ..schema.auth import UserProfile, UniversityOnboardingRequest
-from ..dependencies import get_current_user, get_current_user_optional
+from ..dependencies import get_current_admin, get_current_user, get_current_user_optional
 from ..services import university as university_services
 from ..services.email_service import EmailService
 from ..schema.university import (
@@ -21,6 +21,8 @@ from ..schema.university import (
     CourseEnrollmentResponse,
     CourseProgressUpdateRequest,
     AssessmentSubmissionRequest,
+    GeneratedProblemsRequest,
+    GeneratedProblemsResponse,
 )
 
 logger = logging.getLogger(__name__)
@@ -61,6 +63,19 @@ def list_practice_sets() -> PracticeSetListResponse:
     return PracticeSetListResponse(practice_sets=practice_sets)
 
 
+@router.post("/practice-sets/generate", response_model=GeneratedProblemsResponse)
+def generate_practice_problems(
+    payload: GeneratedProblemsRequest,
+    current_user: UserProfile = Depends(get_current_admin),
+) -> GeneratedProblemsResponse:
+    """Generate distinct, exactly solved cross problems for assessments and practice sets."""
+    try:
+        result = university_services.generate_practice_problems(**payload.model_dump())
+    except ValueError as exc:
+        raise HTTPException(status_code=400, detail=str(exc))
+    return GeneratedProblemsResponse(**result)
+
+
 @router.get("/dashboard", response_model=DashboardSummaryResponse)
 def dashboard_summary(
     current_user: UserProfile = Depends(get_current_user),
@@ -193,6 +193,23 @@ class GeneticCrossRequest(BaseModel):
     mother: ParentGenotype
     father: ParentGenotype
     simulations: Optional[int] = Field(500, ge=1, le=50000)
+    ploidy: int = Field(2, ge=2, le=12, description="Allele copies per genotype (even)")
+
+    @model_validator(mode="after")
+    def validate_ploidy(self) -> "GeneticCrossRequest":
+        if self.ploidy % 2:
+            raise ValueError("Ploidy must be even so gametes carry ploidy/2 alleles")
+        if self.ploidy == 2:
+            # Diploid requests keep allowing hemizygous sex-linked genotypes
+            return self
+        for parent_name, parent in (("mother", self.mother), ("father", self.father)):
+            for gene_id, alleles in parent.genotype.items():
+                if len(alleles) != self.ploidy:
+                    raise ValueError(
+                        f"{parent_name} genotype for '{gene_id}' has {len(alleles)} alleles; "
+                        f"expected {self.ploidy}"
+                    )
+        return self
 
 
 class TraitSummary(BaseModel):
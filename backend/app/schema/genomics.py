@@ -0,0 +1,516 @@
+"""
+Genomics Schema Definitions
+===========================
+Request and response models for the statistical genetics endpoints
+(QTL mapping and related analyses on genotype matrices).
+"""
+
+from typing import Any, Dict, List, Literal, Optional
+
+from pydantic import BaseModel, Field
+
+from .cpp_engine import LinkageDefinition
+
+
+# ============================================================================
+# QTL Mapping
+# ============================================================================
+
+class GeneticMarker(BaseModel):
+    """A marker on a genetic map."""
+    name: str = Field(..., min_length=1, description="Marker identifier")
+    position_cm: float = Field(..., ge=0, description="Position in centiMorgans")
+
+
+class MapChromosome(BaseModel):
+    """A chromosome of a genetic map; markers are genotype columns in this order."""
+    name: str = Field(..., min_length=1)
+    markers: List[GeneticMarker] = Field(..., min_length=1, max_length=5000)
+
+
+class QtlScanRequest(BaseModel):
+    """Haley–Knott interval mapping request for an experimental cross."""
+    cross_type: Literal["f2", "backcross"] = Field("f2", description="Experimental cross design")
+    chromosomes: List[MapChromosome] = Field(..., min_length=1, max_length=100)
+    genotypes: List[List[int]] = Field(
+        ..., min_length=1, max_length=10000,
+        description="Per individual marker codes (0=AA, 1=AB, 2=BB, -1=missing), all chromosomes concatenated",
+    )
+    phenotypes: List[Optional[float]] = Field(
+        ..., min_length=1, max_length=10000, description="One value per individual (null = missing)"
+    )
+    covariates: Optional[List[List[float]]] = Field(
+        None, max_length=10000, description="Additive covariates per individual"
+    )
+    step_cm: float = Field(1.0, ge=0, le=50, description="Pseudo-marker spacing (0 = markers only)")
+    map_function: Literal["haldane", "kosambi"] = "haldane"
+    error_prob: float = Field(1e-4, ge=0, lt=0.5, description="Genotyping error rate")
+    n_permutations: int = Field(1000, ge=0, le=10000, description="Permutations for genome-wide thresholds")
+    alphas: List[float] = Field(default_factory=lambda: [0.05, 0.01], min_length=1)
+    seed: Optional[int] = None
+
+
+class QtlPeak(BaseModel):
+    """Highest LOD position on a chromosome."""
+    position_cm: float
+    locus: str
+    lod: float
+    support_interval_cm: List[float] = Field(..., description="1.5-LOD support interval")
+    additive_effect: float
+    dominance_effect: Optional[float] = None
+    genome_wide_p: Optional[float] = None
+
+
+class QtlChromosomeProfile(BaseModel):
+    """LOD profile along one chromosome."""
+    chromosome: str
+    positions_cm: List[float]
+    loci: List[str]
+    lod: List[float]
+    peak: QtlPeak
+
+
+class QtlSignificantPeak(QtlPeak):
+    chromosome: str
+
+
+class QtlScanResponse(BaseModel):
+    """Genome scan result."""
+    cross_type: str
+    map_function: str
+    n_individuals: int
+    n_markers: int
+    n_positions: int
+    n_permutations: int
+    thresholds: Dict[str, float] = Field(default_factory=dict, description="Genome-wide LOD threshold per alpha")
+    max_lod: float
+    chromosomes: List[QtlChromosomeProfile]
+    significant_peaks: List[QtlSignificantPeak] = Field(default_factory=list)
+
+
+# ============================================================================
+# Linkage Map Construction
+# ============================================================================
+
+class LinkageMapRequest(BaseModel):
+    """Estimate a genetic map from marker genotypes of an experimental cross."""
+    cross_type: Literal["f2", "backcross"] = Field("f2", description="Experimental cross design")
+    marker_names: List[str] = Field(..., min_length=2, max_length=5000)
+    genotypes: List[List[int]] = Field(
+        ..., min_length=1, max_length=10000,
+        description="Per individual marker codes (0=AA, 1=AB, 2=BB, -1=missing)",
+    )
+    lod_threshold: float = Field(3.0, ge=0, description="Minimum two-point LOD for linkage")
+    max_rf: float = Field(0.35, gt=0, le=0.5, description="Maximum two-point recombination fraction for linkage")
+    map_function: Literal["haldane", "kosambi"] = "haldane"
+    error_prob: float = Field(1e-4, ge=0, lt=0.5, description="Genotyping error rate")
+    refine: bool = Field(True, description="Refine adjacent intervals by multipoint EM")
+    include_pairwise: bool = Field(False, description="Return pairwise rf/LOD matrices (up to 500 markers)")
+
+
+class MapInterval(BaseModel):
+    """Adjacent marker interval of a linkage group."""
+    left: str
+    right: str
+    recombination_fraction: float
+    lod: float = Field(..., description="Two-point LOD of the adjacent pair")
+
+
+class LinkageGroup(BaseModel):
+    """Ordered markers of one linkage group."""
+    name: str
+    markers: List[GeneticMarker]
+    length_cm: float
+    intervals: List[MapInterval]
+    log10_likelihood: Optional[float] = None
+    em_iterations: int = 0
+
+
+class LinkageMapResponse(BaseModel):
+    """Estimated genetic map."""
+    cross_type: str
+    map_function: str
+    n_individuals: int
+    n_markers: int
+    lod_threshold: float
+    max_rf: float
+    groups: List[LinkageGroup]
+    unlinked: List[str] = Field(default_factory=list)
+    linkage: List[LinkageDefinition] = Field(
+        default_factory=list, description="Adjacent-marker linkage, usable as cross input"
+    )
+    pairwise: Optional[Dict[str, Any]] = None
+
+
+# ============================================================================
+# Haplotype Blocks
+# ============================================================================
+
+class BlockHaplotype(BaseModel):
+    """A haplotype of a block and its estimated frequency."""
+    alleles: List[str] = Field(..., description="Allele at each SNP of the block")
+    frequency: float
+
+
+class HaplotypeBlock(BaseModel):
+    """An LD block on one chromosome."""
+    chromosome: int
+    start_position: int
+    end_position: int
+    span_bp: int
+    n_snps: int
+    rsids: List[str]
+    haplotypes: Optional[List[BlockHaplotype]] = Field(
+        None, description="Haplotypes above the frequency cutoff (None for blocks too long to phase)"
+    )
+
+
+class ChromosomeBlocks(BaseModel):
+    """Block partition of one chromosome."""
+    chromosome: int
+    n_snps: int
+    n_snps_used: int = Field(..., description="SNPs passing the MAF / missingness filters")
+    n_blocks: int
+    snps_in_blocks: int
+    blocks: List[HaplotypeBlock]
+
+
+class HaplotypeBlocksResponse(BaseModel):
+    """Haplotype block partition of a dataset."""
+    dataset_id: str
+    method: Literal["gabriel", "dprime"]
+    n_snps: int
+    n_snps_used: int
+    n_blocks: int
+    chromosomes: List[ChromosomeBlocks]
+
+
+# ============================================================================
+# Runs of Homozygosity
+# ============================================================================
+
+class RohSegment(BaseModel):
+    """A run of homozygosity."""
+    chromosome: int
+    start_position: int
+    end_position: int
+    length_kb: float
+    n_snps: int
+    n_het: int
+    n_missing: int
+
+
+class SampleRoh(BaseModel):
+    """ROH summary and inbreeding coefficients of one sample."""
+    sample_id: str
+    n_roh: int
+    total_roh_kb: float
+    mean_roh_kb: float
+    longest_roh_kb: float
+    f_roh: float = Field(..., description="Fraction of the autosomes in ROH")
+    f_hom: Optional[float] = Field(None, description="Excess homozygosity (PLINK --het)")
+    f_grm: Optional[float] = Field(None, description="GRM diagonal minus one (GCTA Fhat1)")
+    n_called: int
+    segments: Optional[List[RohSegment]] = None
+
+
+class RohResponse(BaseModel):
+    """Per-sample runs of homozygosity for a dataset."""
+    dataset_id: str
+    n_samples: int
+    n_snps: int
+    autosome_length_kb: float
+    parameters: Dict[str, Any]
+    samples: List[SampleRoh]
+
+
+# ============================================================================
+# Sample QC
+# ============================================================================
+
+class SampleQcMetrics(BaseModel):
+    """QC metrics of one sample."""
+    sample_id: str
+    call_rate: float
+    het_rate: Optional[float] = Field(None, description="Autosomal heterozygosity rate")
+    f_het: Optional[float] = Field(None, description="Autosomal excess-homozygosity F")
+    x_f: Optional[float] = Field(None, description="X-chromosome F used for the sex check")
+    y_call_rate: Optional[float] = None
+    reported_sex: int = Field(0, description="1 = male, 2 = female, 0 = unknown")
+    inferred_sex: int = Field(0, description="1 = male, 2 = female, 0 = ambiguous")
+    excluded: bool
+    reasons: List[str] = Field(default_factory=list)
+
+
+class SampleQcResponse(BaseModel):
+    """Per-sample QC of a dataset and the resulting exclusion mask."""
+    dataset_id: str
+    n_samples: int
+    n_snps: int
+    n_x_snps: int
+    n_y_snps: int
+    het_rate_mean: Optional[float] = None
+    het_rate_sd: float
+    thresholds: Dict[str, Any]
+    exclusion_mask: List[bool] = Field(..., description="True for excluded samples, in dataset sample order")
+    excluded_samples: List[str]
+    n_excluded: int
+    reason_counts: Dict[str, int]
+    samples: List[SampleQcMetrics]
+
+
+# ============================================================================
+# Admixture
+# ============================================================================
+
+class AdmixtureSample(BaseModel):
+    """Ancestry proportions of one sample (a row of Q)."""
+    sample_id: str
+    reference: Optional[str] = Field(None, description="Reference population label (supervised mode)")
+    q: List[float]
+
+
+class AdmixtureFrequencies(BaseModel):
+    """Ancestral allele frequencies of one SNP (a column of P)."""
+    rsid: Optional[str] = None
+    chromosome: int
+    position: int
+    p: List[float]
+
+
+class AdmixtureResponse(BaseModel):
+    """Model-based ancestry estimates of a dataset."""
+    dataset_id: str
+    mode: Literal["unsupervised", "supervised"]
+    k: int
+    clusters: List[str] = Field(..., description="Ancestral populations, in Q/P column order")
+    n_samples: int
+    n_snps: int
+    loglik: float
+    iterations: int = Field(..., description="SQUAREM cycles")
+    em_steps: int
+    converged: bool
+    work_capped: bool = Field(False, description="Stopped early by the EM work budget")
+    samples: List[AdmixtureSample]
+    allele_frequencies: List[AdmixtureFrequencies]
+
+
+# ============================================================================
+# Liftover
+# ============================================================================
+
+class LiftedVariant(BaseModel):
+    """One variant with its source and lifted coordinates."""
+    rsid: Optional[str] = None
+    chromosome: Any
+    position: int
+    ref_allele: str = Field(..., description="REF allele, reverse-complemented if the strand flipped")
+    alt_allele: str
+    status: Literal["mapped", "unmapped", "multiple", "split"]
+    new_chromosome: Optional[int] = None
+    new_contig: Optional[str] = None
+    new_position: Optional[int] = None
+    strand_flipped: bool = False
+
+
+class LiftoverResponse(BaseModel):
+    """Variants of a dataset or result set lifted to another genome build."""
+    dataset_id: Optional[str] = None
+    job_id: Optional[str] = None
+    source_build: str
+    target_build: str
+    n_variants: int
+    n_mapped: int
+    n_unmapped: int
+    n_multiple: int = Field(..., description="Variants covered by more than one chain")
+    n_split: int = Field(..., description="Variants whose REF allele crosses an alignment gap")
+    n_strand_flipped: int
+    variants: List[LiftedVariant]
+    unmapped: List[LiftedVariant] = Field(default_factory=list)
+
+
+# ============================================================================
+# Summary statistics
+# ============================================================================
+
+class SumstatsVariant(BaseModel):
+    """One harmonised summary-statistics record."""
+    rsid: Optional[str] = None
+    chromosome: int
+    position: int
+    effect_allele: str
+    other_allele: str
+    beta: Optional[float] = None
+    se: Optional[float] = None
+    p: Optional[float] = None
+    eaf: Optional[float] = None
+    n: Optional[float] = None
+    harmonisation: int = Field(0, description="Bit flags: 1 = alleles swapped, 2 = strand flipped, 4 = palindromic")
+
+
+class SumstatsResponse(BaseModel):
+    """An ingested summary-statistics file."""
+    sumstats_id: str
+    name: str
+    source: str
+    columns: Dict[str, str] = Field(..., description="Detected header column per role")
+    n_rows: int
+    n_malformed: int
+    n_variants: int
+    reference: Optional[str] = Field(None, description="Dataset the alleles were harmonised against")
+    palindromic_maf_window: Optional[float] = None
+    harmonisation: Dict[str, int]
+    top_variants: Optional[List[SumstatsVariant]] = None
+
+
+# ============================================================================
+# Mendelian randomisation
+# ============================================================================
+
+class MendelianRandomizationRequest(BaseModel):
+    """Two-sample MR between two ingested summary-statistics files."""
+    exposure_id: str = Field(..., description="Sumstats ID of the exposure")
+    outcome_id: str = Field(..., description="Sumstats ID of the outcome")
+    p_threshold: float = Field(5e-8, gt=0, lt=1, description="Instrument p-value threshold on the exposure")
+    reference_dataset_id: Optional[str] = Field(None, description="Dataset used as LD panel for clumping (no clumping if omitted)")
+    clump_r2: float = Field(0.001, gt=0, le=1)
+    clump_kb: float = Field(10_000.0, gt=0)
+    n_bootstrap: int = Field(1000, ge=100, le=100_000, description="Resamples for weighted median / mode SEs")
+    mode_phi: float = Field(1.0, gt=0, description="Weighted mode bandwidth multiplier")
+    palindromic_maf_window: float = Field(0.08, ge=0, le=0.5)
+    seed: Optional[int] = Field(None, description="Bootstrap seed for reproducible SEs")
+
+
+class MrEstimate(BaseModel):
+    """Causal estimate of one MR method."""
+    method: Literal["wald_ratio", "ivw_fixed", "ivw_random", "egger", "weighted_median", "weighted_mode"]
+    n_snps: int
+    beta: float
+    se: float
+    p: float
+    ci_lower: float
+    ci_upper: float
+
+
+class MrHeterogeneity(BaseModel):
+    """Cochran's Q (IVW) or Rücker's Q' (Egger)."""
+    q: float
+    df: int
+    p: float
+
+
+class MrInstrument(BaseModel):
+    """A harmonised instrument with its Wald ratio."""
+    rsid: Optional[str] = None
+    chromosome: int
+    position: int
+    effect_allele: str
+    other_allele: str
+    beta_exposure: float
+    se_exposure: float
+    p_exposure: float
+    beta_outcome: float
+    se_outcome: float
+    ratio: float
+    ratio_se: float
+
+
+class MendelianRandomizationResponse(BaseModel):
+    """MR estimates, heterogeneity and pleiotropy tests, and the instruments used."""
+    exposure: Optional[str] = None
+    outcome: Optional[str] = None
+    p_threshold: float
+    clumped: bool
+    n_bootstrap: int
+    counts: Dict[str, int] = Field(..., description="Instruments left after each selection step")
+    methods: List[MrEstimate]
+    heterogeneity: Dict[str, MrHeterogeneity]
+    egger_intercept: Optional[Dict[str, float]] = None
+    instruments: List[MrInstrument]
+
+
+# ============================================================================
+# Colocalisation
+# ============================================================================
+
+class ColocTopSnp(BaseModel):
+    """Most likely shared causal variant of a locus."""
+    rsid: Optional[str] = None
+    position: int
+    snp_pp_h4: float = Field(..., description="Posterior of being the shared causal variant given H4")
+    p_first: float
+    p_second: float
+
+
+class ColocLocus(BaseModel):
+    """Posterior probabilities of the coloc hypotheses at one locus."""
+    chromosome: int
+    start: int
+    end: int
+    n_snps: int
+    min_p_first: float
+    min_p_second: float
+    posteriors: Dict[str, float] = Field(..., description="H0–H4 posterior probabilities")
+    top_snp: ColocTopSnp
+
+
+class ColocResponse(BaseModel):
+    """Colocalisation of two GWAS result sets."""
+    job_id: str
+    other_job_id: str
+    n_first: int
+    n_second: int
+    n_shared: int
+    n_allele_mismatch: int
+    n_used: int
+    priors: Dict[str, Any]
+    loci: List[ColocLocus]
+
+
+# ============================================================================
+# GWAS Power
+# ============================================================================
+
+class GwasPowerRequest(BaseModel):
+    """Power / sample-size grid for planning a single-variant GWAS."""
+    trait_type: Literal["quantitative", "binary"] = "quantitative"
+    sample_sizes: List[int] = Field(..., min_length=1, description="Total sample sizes (cases + controls)")
+    mafs: List[float] = Field(..., min_length=1, description="Minor allele frequencies (controls, for binary traits)")
+    effect_sizes: List[float] = Field(
+        ..., min_length=1,
+        description="Per-allele effect in SD units (quantitative) or allelic odds ratio (binary)",
+    )
+    alphas: List[float] = Field(default_factory=lambda: [5e-8], min_length=1)
+    case_fractions: Optional[List[float]] = Field(None, description="Fraction of cases (binary traits, default 0.5)")
+    mode: Literal["analytic", "simulated"] = "analytic"
+    replicates: int = Field(500, ge=1, le=100_000, description="Simulated datasets per grid cell")
+    target_power: Optional[float] = Field(None, gt=0, lt=1, description="Also report the N needed to reach this power")
+    seed: Optional[int] = None
+
+
+class GwasPowerPoint(BaseModel):
+    """Power at one grid point."""
+    n: int
+    maf: float
+    effect_size: float
+    case_fraction: Optional[float] = None
+    alpha: float
+    ncp: float = Field(..., description="Non-centrality of the 1-df test")
+    power: float
+    simulated_power: Optional[float] = None
+    simulated_se: Optional[float] = None
+    required_n: Optional[int] = None
+
+
+class GwasPowerResponse(BaseModel):
+    """Power surface over the requested grid."""
+    trait_type: str
+    mode: str
+    replicates: int
+    target_power: Optional[float] = None
+    sample_sizes: List[int]
+    mafs: List[float]
+    effect_sizes: List[float]
+    case_fractions: List[float]
+    alphas: List[float]
+    points: List[GwasPowerPoint]
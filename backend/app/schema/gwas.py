@@ -36,6 +36,8 @@ class GwasAnalysisType(str, Enum):
     LINEAR = "linear"  # Linear regression for quantitative traits
     LOGISTIC = "logistic"  # Logistic regression for binary traits
     CHI_SQUARE = "chi_square"  # Chi-square test for allelic association
+    TDT = "tdt"  # Transmission disequilibrium test on parent-child trios
+    SIB_TDT = "sib_tdt"  # Sib-TDT on discordant sibships
 
 
 class GwasFileFormat(str, Enum):
@@ -192,6 +194,17 @@ class GwasAnalysisRequest(BaseModel):
     maf_threshold: float = Field(default=0.01, ge=0.001, le=0.5, description="Minimum MAF")
     significance_threshold: float = Field(default=5e-8, ge=0, le=1, description="P-value threshold")
     num_threads: int = Field(default=4, ge=1, le=32, description="Number of CPU threads for analysis")
+    memory_budget_mb: Optional[int] = Field(
+        None,
+        ge=64,
+        le=65536,
+        description="Peak memory for the analysis; large cohorts are tiled and spilled to disk to stay under it",
+    )
+    exclude_samples: List[str] = Field(default_factory=list, description="Sample IDs left out of the analysis")
+    apply_sample_qc: bool = Field(
+        default=False,
+        description="Also exclude samples failing default sample QC (call rate, heterozygosity, sex check)",
+    )
 
     @field_validator("phenotype_column")
     @classmethod
@@ -260,6 +273,17 @@ class GwasSummaryStats(BaseModel):
     genomic_inflation_lambda: float = Field(..., description="Genomic inflation factor")
     mean_chi_square: Optional[float] = Field(None, description="Mean chi-square statistic")
     median_p_value: Optional[float] = Field(None, ge=0, le=1)
+    memory_report: Optional[Dict[str, Any]] = Field(
+        None,
+        description=(
+            "Memory budget, tiling and whether the run degraded to stay within it; "
+            "budgeted is false when the engine did not confirm the budget"
+        ),
+    )
+    excluded_samples: Optional[int] = Field(None, ge=0, description="Samples left out of the analysis")
+    sample_qc: Optional[Dict[str, Any]] = Field(
+        None, description="Sample QC failures and thresholds when apply_sample_qc was set"
+    )
 
 
 class GwasResultCreate(BaseModel):
@@ -75,3 +75,50 @@ class GenotypeRequest(BaseModel):
 class GenotypeResponse(BaseModel):
     genotypes: Dict[str, List[str]] = Field(...)
     missing_traits: List[str] = Field(default_factory=list)
+
+
+class ObservedOffspringClass(BaseModel):
+    phenotypes: List[str] = Field(..., min_length=1)
+    count: int = Field(..., ge=0)
+
+
+class InverseCrossRequest(BaseModel):
+    trait_keys: List[str] = Field(..., min_length=1)
+    observed: List[ObservedOffspringClass] = Field(..., min_length=1)
+    linked: bool = Field(default=False)
+    max_hypotheses: int = Field(default=10, ge=1, le=100)
+
+    @field_validator("trait_keys")
+    @classmethod
+    def validate_trait_count(cls, value: List[str]) -> List[str]:
+        if len(value) > 3:
+            raise ValueError("Maximum 3 traits allowed")
+        return value
+
+
+class ParentalHypothesis(BaseModel):
+    rank: int
+    parent1_genotypes: Dict[str, str]
+    parent2_genotypes: Dict[str, str]
+    parent1_phase: Optional[str] = None
+    parent2_phase: Optional[str] = None
+    recombination_fraction: Optional[float] = None
+    linkage_lod: Optional[float] = None
+    log_likelihood: float
+    delta_log_likelihood: float
+    deviance: float
+    chi_square: float
+    degrees_of_freedom: int
+    p_value: Optional[float] = None
+    expected_counts: List[float]
+
+
+class InverseCrossResponse(BaseModel):
+    trait_keys: List[str]
+    phenotype_classes: List[List[str]]
+    total_offspring: int
+    linked: bool
+    hypotheses: List[ParentalHypothesis]
+    hypotheses_evaluated: int
+    hypotheses_pruned: int
+    hypotheses_bounded: int
@@ -11,6 +11,7 @@ class PedigreeMember(BaseModel):
 class PedigreeRequest(BaseModel):
     query: str = Field(..., description="The user's natural language query")
     conversation_history: List[Dict[str, str]] = Field(default_factory=list)
+    session_id: Optional[str] = Field(None, description="Pedigree session to re-solve incrementally")
 
 class PedigreeStructure(BaseModel):
     """The structured extraction payload sent to C++"""
@@ -30,4 +31,25 @@ class PedigreeResponse(BaseModel):
     ai_message: str
     analysis_result: Optional[GeneticAnalysisResult] = None
     structured_data: Optional[PedigreeStructure] = None
-    requires_clarification: bool = False
\ No newline at end of file
+    requires_clarification: bool = False
+    session_id: Optional[str] = None
+
+
+class HypotheticalChildQuery(BaseModel):
+    """A prospective couple; a single id pairs that member with a population partner"""
+    parent_ids: List[str] = Field(..., min_length=1, max_length=2)
+
+class HypotheticalChildRequest(BaseModel):
+    session_id: str = Field(..., description="Session of an already solved pedigree")
+    queries: List[HypotheticalChildQuery] = Field(..., min_length=1, max_length=500)
+
+class HypotheticalChildResult(BaseModel):
+    parent_ids: List[str]
+    method: Literal["family_joint", "conditioned", "independent", "population_partner"]
+    exact: bool
+    genotype_distribution: Dict[str, float]
+    phenotype_distribution: Dict[str, float]
+
+class HypotheticalChildResponse(BaseModel):
+    session_id: str
+    results: List[HypotheticalChildResult]
@@ -3,7 +3,7 @@
 from __future__ import annotations
 
 from datetime import datetime
-from typing import List, Optional
+from typing import Dict, List, Literal, Optional
 
 from pydantic import BaseModel, Field, conint, confloat, ConfigDict
 
@@ -326,3 +326,41 @@ class CertificateResponse(BaseModel):
 
 class AssessmentHistoryResponse(BaseModel):
     attempts: List[AssessmentAttemptModel] = Field(default_factory=list)
+
+
+class GeneratedProblemsRequest(BaseModel):
+    count: int = Field(100, ge=1, le=20000)
+    min_traits: int = Field(1, ge=1, le=3)
+    max_traits: int = Field(2, ge=1, le=3)
+    dominance_types: List[
+        Literal["complete", "incomplete", "codominant", "multiple_alleles"]
+    ] = Field(default_factory=lambda: ["complete", "incomplete", "codominant", "multiple_alleles"])
+    question_types: List[Literal["phenotype_ratio", "phenotype_probability"]] = Field(
+        default_factory=lambda: ["phenotype_ratio", "phenotype_probability"]
+    )
+    linkage_probability: float = Field(0.0, ge=0, le=1)
+    min_phenotype_classes: int = Field(2, ge=1)
+    max_phenotype_classes: int = Field(16, ge=1)
+    seed: Optional[int] = None
+
+
+class GeneratedProblemModel(AssessmentQuestionModel):
+    id: str
+    hash: str
+    topic: str
+    difficulty: str
+    question_type: str
+    answer: str
+    phenotype_distribution: Dict[str, str] = Field(default_factory=dict)
+    traits: List[str] = Field(default_factory=list)
+    parent1: str
+    parent2: str
+    recombination_fraction: Optional[float] = None
+
+
+class GeneratedProblemsResponse(BaseModel):
+    problems: List[GeneratedProblemModel] = Field(default_factory=list)
+    requested: int
+    generated: int
+    duplicates_removed: int
+    seed: int
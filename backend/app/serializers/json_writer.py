@@ -0,0 +1,203 @@
+"""
+JSON Writer
+===========
+Direct-to-buffer JSON writer for large engine result sets (GWAS
+associations, ORFs, sequence statistics).
+
+The standard library encoder loses its C fast path as soon as ``indent`` is
+used and spends most of its time dispatching on types per value. Result sets
+are homogeneous lists of flat records, so this writer inspects them column
+by column instead and compiles one %-format row template: clean columns are
+formatted directly by the template in C, and only columns that need escaping,
+nulls or non-finite handling go through a per-value encoder first.
+
+- Floats use ``repr``, which is shortest-roundtrip in CPython. NaN and
+  infinities become ``null`` (the stdlib emits invalid ``NaN`` tokens).
+- Columns listed in ``precision`` use fixed significant digits instead,
+  which keeps probabilities short.
+- Strings go through a precomputed escape table; strings that need no
+  escaping (the common case) skip it entirely.
+- Output is collected as a list of chunks and joined once.
+"""
+
+from __future__ import annotations
+
+import json
+import math
+import re
+from operator import itemgetter
+from typing import Any, Callable, Iterator, List, Mapping, Optional, Sequence
+
+_NEEDS_ESCAPE = re.compile(r'[\x00-\x1f"\\]')
+_ESCAPE_TABLE = {i: f"\\u{i:04x}" for i in range(0x20)}
+_ESCAPE_TABLE.update({
+    ord('"'): '\\"',
+    ord("\\"): "\\\\",
+    ord("\n"): "\\n",
+    ord("\r"): "\\r",
+    ord("\t"): "\\t",
+    ord("\b"): "\\b",
+    ord("\f"): "\\f",
+})
+
+_DEFAULT_CHUNK_ROWS = 10_000
+
+Encoder = Callable[[Any], str]
+
+
+def encode_string(value: str) -> str:
+    if _NEEDS_ESCAPE.search(value) is None:
+        return f'"{value}"'
+    return f'"{value.translate(_ESCAPE_TABLE)}"'
+
+
+def encode_float(value: float) -> str:
+    if value != value or value in (math.inf, -math.inf):
+        return "null"
+    return repr(float(value))
+
+
+def float_encoder(significant_digits: int) -> Encoder:
+    """Fixed-precision float encoder (e.g. for probabilities)."""
+    spec = f".{significant_digits}g"
+
+    def encode(value: float) -> str:
+        if value != value or value in (math.inf, -math.inf):
+            return "null"
+        return format(value, spec)
+
+    return encode
+
+
+def encode_value(value: Any) -> str:
+    """Encode any JSON-compatible value (generic, slower path)."""
+    if value is None:
+        return "null"
+    if value is True:
+        return "true"
+    if value is False:
+        return "false"
+    if isinstance(value, str):
+        return encode_string(value)
+    if isinstance(value, int):
+        return int.__repr__(value)
+    if isinstance(value, float):
+        return encode_float(value)
+    if isinstance(value, Mapping):
+        return "{" + ",".join(
+            f"{encode_string(str(k))}:{encode_value(v)}" for k, v in value.items()
+        ) + "}"
+    if isinstance(value, (list, tuple)):
+        return "[" + ",".join(map(encode_value, value)) + "]"
+    if hasattr(value, "item"):
+        # numpy scalars
+        return encode_value(value.item())
+    return json.dumps(value, default=str)
+
+
+def _column_encoder(values: Sequence[Any], key: str, precision: Mapping[str, int]) -> Encoder:
+    """Per-value encoder for columns the template cannot format directly."""
+    kinds = set(map(type, values)) - {type(None)}
+    if kinds <= {float, int} and kinds:
+        base = float_encoder(precision[key]) if key in precision else encode_float
+        inner = base
+        base = lambda v: int.__repr__(v) if type(v) is int else inner(v)  # noqa: E731
+    elif kinds == {str}:
+        base = encode_string
+    else:
+        return encode_value
+    typed = base
+    return lambda v: "null" if v is None else typed(v)  # noqa: E731
+
+
+def _column_slot(values: Sequence[Any], key: str, precision: Mapping[str, int]) -> Optional[str]:
+    """
+    A %-format slot that writes the raw column values directly, or None.
+
+    Clean string, integer and finite float columns are formatted entirely by
+    ``str.__mod__`` in C: ``"%s"`` inside quotes, ``%d`` and ``%r`` (the
+    shortest-roundtrip float repr) or ``%.Ng`` for fixed precision.
+    """
+    kinds = set(map(type, values))
+    if kinds == {str}:
+        return '"%s"' if _NEEDS_ESCAPE.search("".join(values)) is None else None
+    if kinds == {int}:
+        return "%d"
+    if kinds <= {float, int} and kinds:
+        # A non-finite value anywhere makes the sum non-finite
+        try:
+            if not math.isfinite(math.fsum(values)):
+                return None
+        except OverflowError:
+            return None
+        return f"%.{precision[key]}g" if key in precision else "%r"
+    return None
+
+
+def encode_records(
+    records: Sequence[Mapping[str, Any]],
+    keys: Optional[Sequence[str]] = None,
+    precision: Optional[Mapping[str, int]] = None,
+) -> List[str]:
+    """
+    Encode flat records to one JSON object string each.
+
+    Args:
+        records: Homogeneous mappings (missing keys are written as null)
+        keys: Output keys in order; defaults to the first record's keys
+        precision: Significant digits per float column (others are shortest-roundtrip)
+    """
+    if not records:
+        return []
+    keys = list(keys if keys is not None else records[0].keys())
+    precision = precision or {}
+
+    try:
+        rows = list(map(itemgetter(*keys), records)) if len(keys) > 1 else [(r[keys[0]],) for r in records]
+    except KeyError:
+        rows = [tuple(record.get(key) for key in keys) for record in records]
+
+    columns = list(zip(*rows))
+    slots = []
+    encoded = False
+    for i, key in enumerate(keys):
+        values = columns[i]
+        slot = _column_slot(values, key, precision)
+        if slot is None:
+            slot = "%s"
+            columns[i] = tuple(map(_column_encoder(values, key, precision), values))
+            encoded = True
+        slots.append(encode_string(key).replace("%", "%%") + ":" + slot)
+
+    if encoded:
+        rows = list(zip(*columns))
+    return list(map(("{" + ",".join(slots) + "}").__mod__, rows))
+
+
+def dumps_records(
+    records: Sequence[Mapping[str, Any]],
+    keys: Optional[Sequence[str]] = None,
+    precision: Optional[Mapping[str, int]] = None,
+    one_per_line: bool = False,
+) -> str:
+    """Serialise a list of flat records as a JSON array."""
+    rows = encode_records(records, keys=keys, precision=precision)
+    if one_per_line:
+        return "[\n" + ",\n".join(rows) + "\n]" if rows else "[]"
+    return "[" + ",".join(rows) + "]"
+
+
+def iter_records_json(
+    records: Sequence[Mapping[str, Any]],
+    keys: Optional[Sequence[str]] = None,
+    precision: Optional[Mapping[str, int]] = None,
+    chunk_rows: int = _DEFAULT_CHUNK_ROWS,
+) -> Iterator[bytes]:
+    """Stream a JSON array of records in UTF-8 chunks of ``chunk_rows`` rows."""
+    yield b"[\n"
+    for start in range(0, len(records), chunk_rows):
+        rows = encode_records(records[start:start + chunk_rows], keys=keys, precision=precision)
+        separator = ",\n" if start else ""
+        yield (separator + ",\n".join(rows)).encode("utf-8")
+    yield b"\n]"
+
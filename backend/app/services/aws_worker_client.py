@@ -1,13 +1,16 @@
-import boto3
 import json
 import logging
 from fastapi import HTTPException
 from app.config import get_settings
+from app.core.metrics import ENGINE_BYTES, track_engine_call
 
 logger = logging.getLogger(__name__)
 
 class AwsWorkerClient:
     def __init__(self):
+        # Imported here so processes that never call the worker skip boto3's import cost
+        import boto3
+
         self.settings = get_settings()
         
         # We explicitly use the keys from your .env
@@ -24,20 +27,29 @@ class AwsWorkerClient:
         Invokes the Zygotrix C++ Lambda.
         action: 'cross', 'gwas', 'protein', or 'dna'
         """
+        with track_engine_call(action, backend="lambda"):
+            return self._invoke(action, payload)
+
+    def _invoke(self, action: str, payload: dict) -> dict:
         try:
             logger.info(f"Invoking Lambda: {action}")
-            
+
+            request_body = json.dumps({
+                "action": action,
+                "payload": payload
+            })
+            ENGINE_BYTES.inc(len(request_body), action=action, direction="sent")
+
             response = self.client.invoke(
                 FunctionName=self.function_name,
                 InvocationType='RequestResponse', # Synchronous wait
-                Payload=json.dumps({
-                    "action": action,
-                    "payload": payload
-                })
+                Payload=request_body
             )
 
             # Read response
-            response_payload = json.loads(response['Payload'].read())
+            response_body = response['Payload'].read()
+            ENGINE_BYTES.inc(len(response_body), action=action, direction="received")
+            response_payload = json.loads(response_body)
             
             # 1. Check for Lambda Platform Errors (Timeout, etc.)
             if 'FunctionError' in response:
@@ -11,6 +11,8 @@ import logging
 from typing import Optional
 from collections import OrderedDict
 
+from app.core.metrics import register_cache
+
 logger = logging.getLogger(__name__)
 
 
@@ -105,4 +107,5 @@ def get_response_cache() -> ResponseCacheService:
             max_size=1000,      # Max 1000 cached responses
             ttl_seconds=3600    # Cache for 1 hour
         )
+        register_cache("chatbot_responses", _response_cache.get_stats)
     return _response_cache
\ No newline at end of file
@@ -23,6 +23,8 @@ import boto3
 from botocore.exceptions import ClientError, NoCredentialsError
 from botocore.config import Config
 
+from .genomics.dataset_cache import invalidate_dataset
+
 logger = logging.getLogger(__name__)
 
 
@@ -384,6 +386,9 @@ class CloudStorageManager:
     ) -> str:
         """
         Save processed dataset (SNPs, samples, phenotypes) as JSON.
+
+        Cached analyses of the dataset are invalidated, since they were
+        computed from the previous processed data.
         
         Returns:
             Path/key to saved file
@@ -401,6 +406,7 @@ class CloudStorageManager:
                     ACL='private',
                     ContentType='application/json',
                 )
+                invalidate_dataset(dataset_id)
                 logger.info(f"☁️ Saved processed data to Spaces: {key}")
                 return key
                 
@@ -413,6 +419,7 @@ class CloudStorageManager:
             
             with open(local_path, "w") as f:
                 f.write(json_data.decode('utf-8'))
+            invalidate_dataset(dataset_id)
             
             logger.info(f"📁 Saved processed data locally: {local_path}")
             return str(local_path)
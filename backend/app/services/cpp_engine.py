@@ -1,23 +1,44 @@
 from __future__ import annotations
 
+from typing import Optional
+
 from app.schema.cpp_engine import GeneticCrossRequest, GeneticCrossResponse
 from app.schema.pedigree import PedigreeStructure, GeneticAnalysisResult
 from app.services.aws_worker_client import get_aws_worker
+from app.services.pedigree_solver import solve_pedigree
 
 def run_cpp_cross(request: GeneticCrossRequest) -> GeneticCrossResponse:
     """
     Executes a genetic cross using the AWS Lambda C++ Engine.
     Action: 'cross'
+
+    The engine is diploid; polyploid crosses go through the exact calculator
+    (``/api/mendelian``) instead, so they are rejected here.
     """
+    if request.ploidy != 2:
+        raise ValueError(
+            f"The C++ engine only simulates diploid crosses (got ploidy {request.ploidy})")
     worker = get_aws_worker()
     payload = request.model_dump(exclude_none=True)
+    # Diploid payloads stay identical to the pre-polyploid request format
+    payload.pop("ploidy", None)
     response_data = worker.invoke(action="cross", payload=payload)
     return GeneticCrossResponse.model_validate(response_data)
 
-def run_pedigree_analysis(structure: PedigreeStructure) -> GeneticAnalysisResult:
+def run_pedigree_analysis(
+    structure: PedigreeStructure,
+    session_id: Optional[str] = None,
+    user_id: Optional[str] = None,
+) -> GeneticAnalysisResult:
     """
     Invokes the C++ Engine to validate and solve a full pedigree tree.
     Action: 'pedigree_analyze'
+
+    The engine is the authoritative solver and its result is always the one
+    returned. A ``session_id`` only mirrors the pedigree into that user's
+    incremental session, which caches the factor graph between edits and
+    answers follow-up hypothetical-child queries. The backend solver answers
+    in the engine's place only when the worker is unavailable.
     """
     worker = get_aws_worker()
     
@@ -27,19 +48,15 @@ def run_pedigree_analysis(structure: PedigreeStructure) -> GeneticAnalysisResult
     # Invoke Lambda with the new action
     try:
         response_data = worker.invoke(action="pedigree_analyze", payload=payload)
-        return GeneticAnalysisResult.model_validate(response_data)
+        result = GeneticAnalysisResult.model_validate(response_data)
     except Exception as e:
         import logging
         logger = logging.getLogger(__name__)
-        logger.warning(f"AWS Worker failed, using local MOCK for pedigree analysis: {e}")
-        
-        # fallback mock response for testing/dev
-        return GeneticAnalysisResult(
-             status="SOLVABLE",
-             mode_used="MENDELIAN",
-             probability_map={
-                 "gen1_m": {"AA": 0.0, "Aa": 1.0, "aa": 0.0},
-                 "gen1_f": {"AA": 0.0, "Aa": 1.0, "aa": 0.0}
-             },
-             visualization_grid={}
-        )
\ No newline at end of file
+        logger.warning(f"AWS Worker failed, using local solver for pedigree analysis: {e}")
+
+        _, result = solve_pedigree(structure, session_id=session_id, user_id=user_id)
+        return result
+
+    if session_id is not None:
+        solve_pedigree(structure, session_id=session_id, user_id=user_id)
+    return result
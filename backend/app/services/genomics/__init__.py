@@ -0,0 +1,6 @@
+"""
+Genomics Package.
+
+Statistical genetics analyses on genotype matrices (experimental crosses,
+linkage maps, population samples) implemented with numpy.
+"""
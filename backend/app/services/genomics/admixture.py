@@ -0,0 +1,375 @@
+"""
+Admixture
+=========
+Model-based ancestry estimation (ADMIXTURE; Alexander et al. 2009) for a
+genotype dataset.
+
+Each genotype is binomial with alt-allele probability f_ij = Σ_k Q_ik P_kj,
+where Q holds the ancestry proportions of every sample and P the allele
+frequencies of every ancestral population. The likelihood is maximised by
+block-relaxation EM, one fused pass per step:
+
+- SNPs are split into column blocks evaluated on the shared compute pool
+  (``compute_pool``); each block computes its expected allele assignments,
+  updates its own columns of P and returns per-sample sums, which are
+  reduced into the Q update
+- SQUAREM (Varadhan & Roland 2008, scheme S3) extrapolates two EM steps into
+  one longer step, projected back onto the parameter space and stabilised by
+  a further EM step; the step length is halved towards plain EM whenever
+  the extrapolation lowers the likelihood
+
+In supervised mode (ADMIXTURE ``--supervised``) reference samples carry a
+population label, their Q rows are fixed to that population, and K is the
+number of labels. Q_i·P gives a sample's individual allele frequencies,
+usable as personalised priors in place of the coarse population presets.
+
+Genotypes are held as int8 dosages (-1 = missing, ignored by the
+likelihood) and widened per block; only autosomal SNPs above ``min_maf`` are
+used, thinned evenly to ``max_snps``. A fit spends at most ``MAX_EM_WORK``
+genotype evaluations; one that runs out stops early, unconverged, with
+``work_capped`` set.
+"""
+
+from __future__ import annotations
+
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from .compute_pool import map_tasks
+from .dataset_cache import DatasetResultCache, dataset_sample_ids
+
+# Bounds keeping allele frequencies and proportions off the boundary
+_FREQ_EPS = 1e-5
+_Q_EPS = 1e-6
+# SNP columns per thread-pool task
+_SNP_BLOCK = 2048
+_MAX_K = 20
+# Upper bound on samples x SNPs x EM steps for one fit
+MAX_EM_WORK = 2_000_000_000
+# SQUAREM cycles the dataset analysis keeps affordable when thinning SNPs
+_MIN_BUDGET_CYCLES = 50
+_MISSING_LABELS = {"", "NA", "-9", "0"}
+
+
+class _EmStep:
+    """One EM update of (Q, P), evaluated in parallel SNP blocks."""
+
+    def __init__(self, genotypes: np.ndarray, fixed: np.ndarray, workers: Optional[int] = None):
+        self.genotypes = genotypes
+        self.fixed = fixed
+        self.observed_alleles = 2.0 * (genotypes >= 0).sum(axis=1)
+        self.has_missing = bool((genotypes < 0).any())
+        self.blocks = [
+            slice(start, min(start + _SNP_BLOCK, genotypes.shape[1]))
+            for start in range(0, genotypes.shape[1], _SNP_BLOCK)
+        ]
+        self.workers = workers
+
+    def __call__(
+        self, q: np.ndarray, p: np.ndarray, with_loglik: bool = True
+    ) -> Tuple[np.ndarray, np.ndarray, float]:
+        """
+        Returns:
+            (updated Q, updated P, log-likelihood of the input parameters,
+            NaN unless ``with_loglik``)
+        """
+        p_new = np.empty_like(p)
+
+        def run(block: slice) -> Tuple[np.ndarray, float]:
+            g = self.genotypes[:, block]
+            alt = g.astype(np.float64)
+            ref = 2.0 - alt
+            if self.has_missing:
+                missing = g < 0
+                alt[missing] = 0.0
+                ref[missing] = 0.0
+            p_block = p[:, block]
+            f = q @ p_block
+            np.clip(f, _FREQ_EPS, 1.0 - _FREQ_EPS, out=f)
+            loglik = (
+                float(np.vdot(alt, np.log(f)) + np.vdot(ref, np.log1p(-f))) if with_loglik else float("nan")
+            )
+
+            # Expected allele assignments, scaled by Q and P below
+            alt /= f
+            ref /= 1.0 - f
+            alt_counts = p_block * (q.T @ alt)
+            ref_counts = (1.0 - p_block) * (q.T @ ref)
+            p_new[:, block] = alt_counts / np.maximum(alt_counts + ref_counts, 1e-300)
+            return alt @ p_block.T + ref @ (1.0 - p_block).T, loglik
+
+        parts = map_tasks(run, self.blocks, self.workers)
+        sample_sums = sum(part for part, _ in parts)
+        loglik = sum(ll for _, ll in parts)
+
+        q_new = q * sample_sums / np.maximum(self.observed_alleles, 1.0)[:, None]
+        q_new = _project_q(q_new)
+        q_new[self.fixed] = q[self.fixed]
+        return q_new, np.clip(p_new, _FREQ_EPS, 1.0 - _FREQ_EPS), loglik
+
+
+def _project_q(q: np.ndarray) -> np.ndarray:
+    q = np.clip(q, _Q_EPS, None)
+    return q / q.sum(axis=1, keepdims=True)
+
+
+def admixture(
+    genotypes: np.ndarray,
+    k: int,
+    labels: Optional[Sequence[Optional[str]]] = None,
+    max_iterations: int = 500,
+    tolerance: float = 1e-4,
+    seed: Optional[int] = None,
+    workers: Optional[int] = None,
+) -> Dict[str, Any]:
+    """
+    Fit ancestry proportions Q and population allele frequencies P.
+
+    Args:
+        genotypes: (samples, snps) int8 alt-allele dosages, -1 = missing
+        k: Number of ancestral populations (unsupervised mode)
+        labels: Per-sample reference population or None; when any sample is
+            labelled the fit is supervised and K is the number of labels
+        max_iterations: SQUAREM cycles (three EM steps each)
+        tolerance: Stop when the log-likelihood gains less than this
+        seed: RNG seed for the starting point
+        workers: 1 to run inline; otherwise blocks run on the shared compute pool
+
+    Returns:
+        Dict with ``q`` (samples x K), ``p`` (K x snps), ``clusters``,
+        ``loglik``, ``iterations``, ``em_steps``, ``converged`` and
+        ``work_capped`` (stopped early by ``MAX_EM_WORK``)
+
+    Raises:
+        ValueError: On an invalid K or label set, or if a single SQUAREM
+            cycle exceeds ``MAX_EM_WORK``
+    """
+    n, m = genotypes.shape
+    # EM steps the work budget affords; a cycle takes at least three
+    max_em_steps = MAX_EM_WORK // max(n * m, 1)
+    if max_em_steps < 3:
+        raise ValueError(f"Admixture fit too large ({n} samples x {m} SNPs); reduce max_snps")
+    rng = np.random.default_rng(seed)
+    labelled = [label for label in (labels or []) if label is not None]
+
+    if labelled:
+        clusters = sorted(set(labelled))
+        if len(clusters) < 2:
+            raise ValueError("Supervised admixture needs reference samples from at least two populations")
+        if len(labelled) == n:
+            raise ValueError("Supervised admixture needs at least one unlabelled sample")
+        k = len(clusters)
+        index = {name: i for i, name in enumerate(clusters)}
+        fixed = np.array([label is not None for label in labels])
+        q = np.full((n, k), 1.0 / k)
+        for i, label in enumerate(labels):
+            if label is not None:
+                q[i] = _Q_EPS
+                q[i, index[label]] = 1.0
+        q = _project_q(q)
+
+        # Start P at the reference populations' observed frequencies
+        p = np.empty((k, m))
+        for name, row in index.items():
+            members = genotypes[[i for i, label in enumerate(labels) if label == name]]
+            called = members >= 0
+            alt = np.where(called, members, 0).sum(axis=0)
+            p[row] = (alt + 0.5) / (2.0 * called.sum(axis=0) + 1.0)
+    else:
+        if not 2 <= k <= _MAX_K:
+            raise ValueError(f"K must be between 2 and {_MAX_K}")
+        if n < k:
+            raise ValueError("K cannot exceed the number of samples")
+        clusters = [f"K{i + 1}" for i in range(k)]
+        fixed = np.zeros(n, dtype=bool)
+        q = rng.dirichlet(np.ones(k), size=n)
+        p = rng.uniform(0.1, 0.9, size=(k, m))
+    p = np.clip(p, _FREQ_EPS, 1.0 - _FREQ_EPS)
+
+    step = _EmStep(genotypes, fixed, workers)
+    previous = -np.inf
+    loglik = -np.inf
+    converged = False
+    work_capped = False
+    em_steps = 0
+    iterations = 0
+    for iterations in range(1, max_iterations + 1):
+        if em_steps + 3 > max_em_steps:
+            work_capped = True
+            iterations -= 1
+            break
+        q1, p1, loglik = step(q, p)
+        q2, p2, _ = step(q1, p1, with_loglik=False)
+        em_steps += 2
+        if loglik - previous < tolerance:
+            converged = True
+            break
+        previous = loglik
+
+        rq, rp = q1 - q, p1 - p
+        vq, vp = q2 - q1 - rq, p2 - p1 - rp
+        r_norm = np.sqrt(np.sum(rq ** 2) + np.sum(rp ** 2))
+        v_norm = np.sqrt(np.sum(vq ** 2) + np.sum(vp ** 2))
+        alpha = min(-r_norm / v_norm, -1.0) if v_norm > 0 else -1.0
+
+        # Backtrack towards alpha = -1 (plain EM from q2, p2), which
+        # never lowers the likelihood
+        while True:
+            if em_steps >= max_em_steps:
+                # Out of budget mid-backtrack: keep the plain EM step
+                q_s, p_s, work_capped = q2, p2, True
+                break
+            q_x = _project_q(q - 2.0 * alpha * rq + alpha ** 2 * vq)
+            q_x[fixed] = q[fixed]
+            p_x = np.clip(p - 2.0 * alpha * rp + alpha ** 2 * vp, _FREQ_EPS, 1.0 - _FREQ_EPS)
+            q_s, p_s, loglik_x = step(q_x, p_x)
+            em_steps += 1
+            if alpha == -1.0 or (np.isfinite(loglik_x) and loglik_x >= loglik):
+                break
+            alpha = (alpha - 1.0) / 2.0 if alpha < -3.0 else -1.0
+        q, p = q_s, p_s
+        if work_capped:
+            break
+
+    return {
+        "q": q,
+        "p": p,
+        "clusters": clusters,
+        "loglik": float(loglik),
+        "iterations": iterations,
+        "em_steps": em_steps,
+        "converged": converged,
+        "work_capped": work_capped,
+    }
+
+
+def _select_snps(
+    snps: Sequence[Dict[str, Any]],
+    n_samples: int,
+    min_maf: float,
+    max_snps: int,
+) -> Tuple[List[int], np.ndarray]:
+    """Autosomal SNPs above ``min_maf``, evenly thinned to ``max_snps``."""
+    candidates = []
+    rows = []
+    for i, snp in enumerate(snps):
+        if not 1 <= int(snp["chromosome"]) <= 22:
+            continue
+        genotypes = snp.get("genotypes") or []
+        if len(genotypes) != n_samples:
+            raise ValueError(f"SNP {snp.get('rsid')} has {len(genotypes)} genotypes for {n_samples} samples")
+        candidates.append(i)
+        rows.append(genotypes)
+    if not rows:
+        raise ValueError("Dataset has no autosomal SNPs")
+
+    dosages = np.array(rows, dtype=np.int8)
+    called = dosages >= 0
+    with np.errstate(invalid="ignore", divide="ignore"):
+        freq = np.where(called, dosages, 0).sum(axis=1) / (2.0 * called.sum(axis=1))
+    keep = np.flatnonzero(np.nan_to_num(np.minimum(freq, 1.0 - freq)) >= min_maf)
+    if keep.size > max_snps:
+        keep = keep[np.linspace(0, keep.size - 1, max_snps).round().astype(np.int64)]
+    if keep.size == 0:
+        raise ValueError(f"No autosomal SNPs with MAF >= {min_maf}")
+    return [candidates[i] for i in keep], np.ascontiguousarray(dosages[keep].T)
+
+
+def _reference_labels(samples: Sequence[Any], column: str) -> List[Optional[str]]:
+    labels: List[Optional[str]] = []
+    for sample in samples:
+        if not isinstance(sample, dict):
+            raise ValueError("Supervised admixture needs sample records with population labels")
+        raw = (sample.get("phenotypes") or {}).get(column, sample.get(column))
+        label = None if raw is None else str(raw).strip()
+        labels.append(None if label is None or label in _MISSING_LABELS else label)
+    return labels
+
+
+def dataset_admixture_analysis(
+    snps: Sequence[Dict[str, Any]],
+    samples: Sequence[Any],
+    k: int = 3,
+    reference_column: Optional[str] = None,
+    min_maf: float = 0.01,
+    max_snps: int = 20_000,
+    max_iterations: int = 500,
+    tolerance: float = 1e-4,
+    seed: Optional[int] = None,
+) -> Dict[str, Any]:
+    """
+    Admixture fit for processed dataset records.
+
+    Args:
+        reference_column: Sample column holding reference population labels
+            (blank for samples to estimate); enables supervised mode
+
+    Returns:
+        Per-sample ancestry proportions and per-SNP population frequencies
+    """
+    if not samples:
+        raise ValueError("Dataset has no samples")
+    sample_ids = dataset_sample_ids(samples)
+    labels = _reference_labels(samples, reference_column) if reference_column else None
+    if labels is not None and not any(labels):
+        raise ValueError(f"No sample has a population label in '{reference_column}'")
+
+    # Thin further on large cohorts so the work budget covers a useful fit
+    affordable = MAX_EM_WORK // (3 * _MIN_BUDGET_CYCLES * len(sample_ids))
+    indices, genotypes = _select_snps(snps, len(sample_ids), min_maf, max(min(max_snps, affordable), 1))
+    fit = admixture(
+        genotypes,
+        k,
+        labels=labels,
+        max_iterations=max_iterations,
+        tolerance=tolerance,
+        seed=seed,
+    )
+
+    q, p = fit["q"], fit["p"]
+    return {
+        "mode": "supervised" if labels is not None else "unsupervised",
+        "k": len(fit["clusters"]),
+        "clusters": fit["clusters"],
+        "n_samples": len(sample_ids),
+        "n_snps": len(indices),
+        "loglik": fit["loglik"],
+        "iterations": fit["iterations"],
+        "em_steps": fit["em_steps"],
+        "converged": fit["converged"],
+        "work_capped": fit["work_capped"],
+        "samples": [
+            {
+                "sample_id": sample_id,
+                "reference": labels[i] if labels is not None else None,
+                "q": [float(v) for v in q[i]],
+            }
+            for i, sample_id in enumerate(sample_ids)
+        ],
+        "allele_frequencies": [
+            {
+                "rsid": snps[index].get("rsid"),
+                "chromosome": int(snps[index]["chromosome"]),
+                "position": int(snps[index]["position"]),
+                "p": [float(v) for v in p[:, column]],
+            }
+            for column, index in enumerate(indices)
+        ],
+    }
+
+
+_admixture_cache = DatasetResultCache("admixture", max_size=8)
+
+
+def dataset_admixture(user_id: str, dataset_id: str, **params: Any) -> Optional[Dict[str, Any]]:
+    """
+    Admixture fit of a user's processed GWAS dataset (cached).
+
+    Returns:
+        Fit result, or None if the dataset does not exist for the user
+    """
+    def analysis(data: Dict[str, Any]) -> Dict[str, Any]:
+        return dataset_admixture_analysis(data.get("snps", []), data.get("samples", []), **params)
+
+    return _admixture_cache.compute(user_id, dataset_id, params, analysis)
@@ -0,0 +1,260 @@
+"""
+Colocalisation
+==============
+Bayesian colocalisation (Giambartolomei et al. 2014, ``coloc.abf``) of two
+GWAS result sets, e.g. two traits or a trait and an expression phenotype.
+
+The result sets are sort-merged on packed ``(chromosome, position)`` keys
+with matching alleles. Candidate loci are windows around every shared SNP
+below ``p_threshold`` in either trait; overlapping windows are merged.
+
+Per SNP, Wakefield's approximate Bayes factor is
+
+    log ABF = ½ · (log(1 − r) + r · z²),  r = W / (V + W)
+
+with V the squared standard error and W the prior effect variance (0.15²
+for quantitative traits, 0.2² for binary ones). Per locus, the posteriors
+of the five hypotheses
+
+- H0: no association
+- H1 / H2: association with trait 1 / trait 2 only
+- H3: both traits, distinct causal variants
+- H4: both traits, one shared causal variant
+
+are aggregated in log space with segmented log-sum-exp reductions over the
+sorted SNPs, so every locus is computed in the same vectorised pass.
+"""
+
+from __future__ import annotations
+
+from typing import Any, Dict, List, Optional, Sequence
+
+import numpy as np
+
+from ..gwas_catalog_index import position_key
+from .sumstats import normal_isf
+
+PRIOR_SD_QUANTITATIVE = 0.15
+PRIOR_SD_BINARY = 0.2
+HYPOTHESES = ("H0", "H1", "H2", "H3", "H4")
+
+
+def _association_arrays(associations: Sequence[Dict[str, Any]], binary: bool) -> Dict[str, np.ndarray]:
+    """
+    Columns of an association result set with an effect-size variance per SNP.
+
+    Variances come from the standard error, else from the odds-ratio CI,
+    else from MAF and sample size (unit phenotype variance, or a balanced
+    case-control design for binary traits) with z from the p-value.
+    """
+    def column(name: str) -> np.ndarray:
+        return np.array([a.get(name) if a.get(name) is not None else np.nan for a in associations], dtype=np.float64)
+
+    beta, se, p = column("beta"), column("se"), column("p_value")
+    odds_ratio, ci_lower, ci_upper = column("odds_ratio"), column("ci_lower"), column("ci_upper")
+    maf, n = column("maf"), column("n_samples")
+
+    with np.errstate(invalid="ignore", divide="ignore"):
+        from_or = ~np.isfinite(beta) & np.isfinite(odds_ratio) & (odds_ratio > 0)
+        beta[from_or] = np.log(odds_ratio[from_or])
+        from_ci = ~np.isfinite(se) & np.isfinite(ci_lower) & np.isfinite(ci_upper) & (ci_lower > 0)
+        se[from_ci] = (np.log(ci_upper[from_ci]) - np.log(ci_lower[from_ci])) / (2 * 1.959963984540054)
+
+        variance = se ** 2
+        z = beta / se
+        fallback = ~(np.isfinite(z) & (variance > 0)) & np.isfinite(p) & (p > 0) & (maf > 0) & (n > 0)
+        scale = 0.25 if binary else 1.0
+        variance[fallback] = 1.0 / (2 * n[fallback] * maf[fallback] * (1 - maf[fallback]) * scale)
+        z[fallback] = normal_isf(np.minimum(p[fallback], 1.0) / 2.0)
+
+    return {
+        "keys": position_key(
+            np.array([int(a["chromosome"]) for a in associations], dtype=np.int64),
+            np.array([int(a["position"]) for a in associations], dtype=np.int64),
+        ),
+        "rsid": np.array([a.get("rsid") or "" for a in associations], dtype=object),
+        "ref": np.array([str(a.get("ref_allele") or "").upper() for a in associations], dtype=object),
+        "alt": np.array([str(a.get("alt_allele") or "").upper() for a in associations], dtype=object),
+        "z": z,
+        "variance": variance,
+        "p": p,
+    }
+
+
+def log_abf(z: np.ndarray, variance: np.ndarray, prior_sd: float) -> np.ndarray:
+    """Wakefield log approximate Bayes factors."""
+    prior_variance = prior_sd ** 2
+    r = prior_variance / (variance + prior_variance)
+    return 0.5 * (np.log1p(-r) + r * z ** 2)
+
+
+def _unique_key_order(keys: np.ndarray) -> np.ndarray:
+    """Sorting permutation of ``keys`` without duplicated keys (multi-allelic sites cannot be paired)."""
+    order = np.argsort(keys, kind="stable")
+    ordered = keys[order]
+    unique = np.ones(ordered.size, dtype=bool)
+    unique[1:] = ordered[1:] != ordered[:-1]
+    unique[:-1] &= ordered[:-1] != ordered[1:]
+    return order[unique]
+
+
+def _merge_join(first: Dict[str, np.ndarray], second: Dict[str, np.ndarray]) -> Dict[str, np.ndarray]:
+    """Rows of both sets at shared keys with the same allele pair (either orientation), sorted by key."""
+    order_a, order_b = _unique_key_order(first["keys"]), _unique_key_order(second["keys"])
+
+    _, in_a, in_b = np.intersect1d(
+        first["keys"][order_a], second["keys"][order_b], assume_unique=True, return_indices=True
+    )
+    rows_a, rows_b = order_a[in_a], order_b[in_b]
+    same = (first["ref"][rows_a] == second["ref"][rows_b]) & (first["alt"][rows_a] == second["alt"][rows_b])
+    swapped = (first["ref"][rows_a] == second["alt"][rows_b]) & (first["alt"][rows_a] == second["ref"][rows_b])
+    alleles_ok = same | swapped
+    usable = (
+        alleles_ok
+        & np.isfinite(first["z"][rows_a]) & (first["variance"][rows_a] > 0)
+        & np.isfinite(second["z"][rows_b]) & (second["variance"][rows_b] > 0)
+    )
+    return {
+        "rows_a": rows_a[usable],
+        "rows_b": rows_b[usable],
+        "n_shared": int(rows_a.size),
+        "n_allele_mismatch": int((~alleles_ok).sum()),
+    }
+
+
+def _segment_logsumexp(values: np.ndarray, starts: np.ndarray, segment: np.ndarray) -> np.ndarray:
+    peak = np.maximum.reduceat(values, starts)
+    return np.log(np.add.reduceat(np.exp(values - peak[segment]), starts)) + peak
+
+
+def colocalize(
+    first: Sequence[Dict[str, Any]],
+    second: Sequence[Dict[str, Any]],
+    first_binary: bool = False,
+    second_binary: bool = False,
+    p_threshold: float = 5e-8,
+    window_kb: float = 500.0,
+    p1: float = 1e-4,
+    p2: float = 1e-4,
+    p12: float = 1e-5,
+    prior_sd: Optional[Sequence[float]] = None,
+) -> Dict[str, Any]:
+    """
+    Colocalisation posteriors for every candidate locus of two result sets.
+
+    Args:
+        first, second: Association records (chromosome, position, alleles,
+            beta / se or odds ratio / CI or p-value, maf, n_samples)
+        first_binary, second_binary: Binary traits use the wider effect prior
+        p_threshold: SNPs below this p in either trait seed candidate loci
+        window_kb: Half-width of the window around every seed
+        p1, p2, p12: Prior probabilities of a SNP being causal for trait 1,
+            trait 2 or both
+        prior_sd: Override the prior effect SDs of the two traits
+
+    Returns:
+        Dict with join counts and per-locus posteriors and top shared SNP
+
+    Raises:
+        ValueError: If the priors are inconsistent
+    """
+    if not (0 < p1 < 1 and 0 < p2 < 1 and 0 < p12 < 1):
+        raise ValueError("Priors p1, p2 and p12 must be between 0 and 1")
+    if p12 > min(p1, p2):
+        raise ValueError("p12 cannot exceed p1 or p2")
+    if prior_sd is None:
+        prior_sd = (
+            PRIOR_SD_BINARY if first_binary else PRIOR_SD_QUANTITATIVE,
+            PRIOR_SD_BINARY if second_binary else PRIOR_SD_QUANTITATIVE,
+        )
+
+    a = _association_arrays(first, first_binary)
+    b = _association_arrays(second, second_binary)
+    joined = _merge_join(a, b)
+    rows_a, rows_b = joined["rows_a"], joined["rows_b"]
+    keys = a["keys"][rows_a]
+    result: Dict[str, Any] = {
+        "n_first": len(first),
+        "n_second": len(second),
+        "n_shared": joined["n_shared"],
+        "n_allele_mismatch": joined["n_allele_mismatch"],
+        "n_used": int(keys.size),
+        "priors": {"p1": p1, "p2": p2, "p12": p12, "prior_sd": list(prior_sd)},
+        "loci": [],
+    }
+
+    p_a, p_b = a["p"][rows_a], b["p"][rows_b]
+    seeds = keys[(p_a < p_threshold) | (p_b < p_threshold)]
+    if seeds.size == 0:
+        return result
+
+    # Merge seed windows into loci, never across chromosomes
+    window = int(window_kb * 1000)
+    chromosome_base = (seeds >> 32) << 32
+    starts = np.maximum(seeds - window, chromosome_base + 1)
+    ends = seeds + window
+    new_locus = np.ones(seeds.size, dtype=bool)
+    new_locus[1:] = starts[1:] > np.maximum.accumulate(ends)[:-1]
+    locus_start = starts[new_locus]
+    locus_end = np.maximum.reduceat(ends, np.flatnonzero(new_locus))
+
+    candidate = np.searchsorted(locus_start, keys, side="right") - 1
+    inside = (candidate >= 0) & (keys <= locus_end[np.maximum(candidate, 0)])
+    snps = np.flatnonzero(inside)
+    locus = candidate[snps]
+    segment_starts = np.flatnonzero(np.r_[True, locus[1:] != locus[:-1]])
+    segment = np.cumsum(np.r_[True, locus[1:] != locus[:-1]]) - 1
+
+    l1 = log_abf(a["z"][rows_a][snps], a["variance"][rows_a][snps], prior_sd[0])
+    l2 = log_abf(b["z"][rows_b][snps], b["variance"][rows_b][snps], prior_sd[1])
+    sum1 = _segment_logsumexp(l1, segment_starts, segment)
+    sum2 = _segment_logsumexp(l2, segment_starts, segment)
+    sum12 = _segment_logsumexp(l1 + l2, segment_starts, segment)
+
+    with np.errstate(divide="ignore"):
+        both = sum1 + sum2
+        # log(Σ_i Σ_j≠i ABF1_i · ABF2_j) = log(ΣABF1 · ΣABF2 − Σ ABF1_i · ABF2_i)
+        h3 = np.log(p1) + np.log(p2) + both + np.log1p(-np.minimum(np.exp(sum12 - both), 1.0))
+    log_h = np.column_stack([
+        np.zeros(sum1.size),
+        np.log(p1) + sum1,
+        np.log(p2) + sum2,
+        h3,
+        np.log(p12) + sum12,
+    ])
+    log_h -= np.max(log_h, axis=1, keepdims=True)
+    posterior = np.exp(log_h)
+    posterior /= posterior.sum(axis=1, keepdims=True)
+
+    # Per-SNP posterior of being the shared causal variant, given H4
+    shared = l1 + l2
+    snp_pp = np.exp(shared - sum12[segment])
+    top = np.maximum.reduceat(np.where(np.isfinite(snp_pp), snp_pp, -1), segment_starts)
+
+    loci: List[Dict[str, Any]] = []
+    segment_stops = np.r_[segment_starts[1:], snps.size]
+    for s, (start, stop) in enumerate(zip(segment_starts.tolist(), segment_stops.tolist())):
+        members = snps[start:stop]
+        best_row = members[np.argmax(snp_pp[start:stop])]
+        locus_keys = keys[members]
+        locus_p_a = np.where(np.isfinite(p_a[members]), p_a[members], np.inf)
+        locus_p_b = np.where(np.isfinite(p_b[members]), p_b[members], np.inf)
+        lead_a, lead_b = members[np.argmin(locus_p_a)], members[np.argmin(locus_p_b)]
+        loci.append({
+            "chromosome": int(locus_keys[0] >> 32),
+            "start": int(locus_keys[0] & 0xFFFFFFFF),
+            "end": int(locus_keys[-1] & 0xFFFFFFFF),
+            "n_snps": int(members.size),
+            "min_p_first": float(p_a[lead_a]),
+            "min_p_second": float(p_b[lead_b]),
+            "posteriors": dict(zip(HYPOTHESES, posterior[s].tolist())),
+            "top_snp": {
+                "rsid": a["rsid"][rows_a[best_row]] or None,
+                "position": int(keys[best_row] & 0xFFFFFFFF),
+                "snp_pp_h4": float(top[s]),
+                "p_first": float(p_a[best_row]),
+                "p_second": float(p_b[best_row]),
+            },
+        })
+    result["loci"] = loci
+    return result
@@ -0,0 +1,81 @@
+"""
+Compute pool
+============
+One bounded thread pool shared by the CPU-heavy genomics analyses
+(simulated power, admixture EM, liftover lookups, MR bootstrap). Requests
+queue for its workers instead of each starting ``os.cpu_count()`` threads of
+their own, so concurrent requests cannot multiply the number of busy
+threads.
+
+Work is submitted from request threads only: a task running on the pool
+must not wait for other tasks of the pool.
+"""
+
+from __future__ import annotations
+
+import os
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from typing import Callable, List, Optional, Sequence, TypeVar
+
+from app.core.metrics import register_pool
+
+T = TypeVar("T")
+R = TypeVar("R")
+
+_DEFAULT_MAX_WORKERS = 4
+
+_pool: Optional[ThreadPoolExecutor] = None
+_pool_lock = threading.Lock()
+_busy = 0
+_busy_lock = threading.Lock()
+
+
+def pool_workers() -> int:
+    """Worker threads of the shared pool."""
+    from app.config import get_settings
+
+    configured = get_settings().analysis_pool_workers
+    return configured if configured > 0 else min(os.cpu_count() or 1, _DEFAULT_MAX_WORKERS)
+
+
+def get_compute_pool() -> ThreadPoolExecutor:
+    """The shared pool, created on first use."""
+    global _pool
+    if _pool is None:
+        with _pool_lock:
+            if _pool is None:
+                workers = pool_workers()
+                _pool = ThreadPoolExecutor(max_workers=workers, thread_name_prefix="genomics")
+                register_pool("genomics_compute", lambda: (_busy, workers))
+    return _pool
+
+
+def _tracked(fn: Callable[[T], R]) -> Callable[[T], R]:
+    def run(item: T) -> R:
+        global _busy
+        with _busy_lock:
+            _busy += 1
+        try:
+            return fn(item)
+        finally:
+            with _busy_lock:
+                _busy -= 1
+
+    return run
+
+
+def map_tasks(fn: Callable[[T], R], items: Sequence[T], workers: Optional[int] = None) -> List[R]:
+    """
+    ``[fn(item) for item in items]`` on the shared pool, in order.
+
+    Args:
+        workers: Run inline when 1 (or with a single item); otherwise the
+            shared pool's size bounds the parallelism
+
+    Raises:
+        Whatever ``fn`` raises, for the first failing item
+    """
+    if workers == 1 or len(items) <= 1:
+        return [fn(item) for item in items]
+    return list(get_compute_pool().map(_tracked(fn), items))
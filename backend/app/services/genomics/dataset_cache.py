@@ -0,0 +1,116 @@
+"""
+Dataset analysis cache
+======================
+Per-dataset analyses (haplotype blocks, ROH, sample QC) are pure functions
+of the processed dataset and their parameters, so their results are kept in
+small LRU caches keyed by ``(user_id, dataset_id, parameters)``. A user
+only ever gets results computed from their own dataset, and every cache
+drops a dataset's entries when it is deleted or its processed data is
+rewritten (:func:`invalidate_dataset`).
+"""
+
+from __future__ import annotations
+
+import hashlib
+import json
+import threading
+from collections import OrderedDict
+from typing import Any, Callable, Dict, List, Optional, Sequence, Tuple
+
+from app.core.metrics import register_cache
+
+
+def dataset_sample_ids(samples: Sequence[Any]) -> List[str]:
+    """Sample IDs of processed data; PLINK datasets store sample records, VCFs plain IDs."""
+    return [str(s.get("sample_id")) if isinstance(s, dict) else str(s) for s in samples]
+
+
+CacheKey = Tuple[str, str, str]
+
+_caches: List["DatasetResultCache"] = []
+
+
+def invalidate_dataset(dataset_id: str) -> int:
+    """Drop a dataset's results from every cache; returns the entries removed."""
+    return sum(cache.invalidate(dataset_id) for cache in list(_caches))
+
+
+class DatasetResultCache:
+    """LRU cache of analysis results per (user, dataset, parameters)."""
+
+    def __init__(self, name: str, max_size: int = 32):
+        self.name = name
+        self.max_size = max_size
+        self.entries: OrderedDict[CacheKey, Dict[str, Any]] = OrderedDict()
+        self.lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+        register_cache(name, self.get_stats)
+        _caches.append(self)
+
+    @staticmethod
+    def key(user_id: str, dataset_id: str, params: Dict[str, Any]) -> CacheKey:
+        encoded = json.dumps(params, sort_keys=True, default=str).encode()
+        return (str(user_id), str(dataset_id), hashlib.sha1(encoded).hexdigest())
+
+    def get(self, key: CacheKey) -> Optional[Dict[str, Any]]:
+        with self.lock:
+            cached = self.entries.get(key)
+            if cached is None:
+                self.misses += 1
+                return None
+            self.hits += 1
+            self.entries.move_to_end(key)
+            return cached
+
+    def put(self, key: CacheKey, value: Dict[str, Any]) -> None:
+        with self.lock:
+            self.entries[key] = value
+            while len(self.entries) > self.max_size:
+                self.entries.popitem(last=False)
+
+    def invalidate(self, dataset_id: str) -> int:
+        with self.lock:
+            stale = [key for key in self.entries if key[1] == str(dataset_id)]
+            for key in stale:
+                del self.entries[key]
+            return len(stale)
+
+    def get_stats(self) -> dict:
+        total = self.hits + self.misses
+        return {
+            "size": len(self.entries),
+            "max_size": self.max_size,
+            "hits": self.hits,
+            "misses": self.misses,
+            "hit_rate": f"{(self.hits / total * 100) if total else 0:.1f}%",
+        }
+
+    def compute(
+        self,
+        user_id: str,
+        dataset_id: str,
+        params: Dict[str, Any],
+        analysis: Callable[[Dict[str, Any]], Dict[str, Any]],
+    ) -> Optional[Dict[str, Any]]:
+        """
+        Cached ``analysis(processed_data)`` for a user's dataset.
+
+        Returns:
+            Analysis result with ``dataset_id``, or None if the dataset does
+            not exist for the user (or has no processed data)
+        """
+        from app.services.gwas_dataset_service import get_gwas_dataset_service
+
+        # The user is part of the key, so a hit is always a result this user
+        # was allowed to compute; deletion invalidates it
+        key = self.key(user_id, dataset_id, params)
+        cached = self.get(key)
+        if cached is not None:
+            return cached
+        data = get_gwas_dataset_service().load_dataset_for_analysis(user_id, dataset_id)
+        if not data:
+            return None
+        result = {"dataset_id": dataset_id, **analysis(data)}
+        self.put(key, result)
+        return result
@@ -0,0 +1,34 @@
+"""
+Genetic map functions
+=====================
+Conversions between map distance (cM) and recombination fraction.
+"""
+
+from __future__ import annotations
+
+import numpy as np
+
+MAP_FUNCTIONS = ("haldane", "kosambi")
+
+# Recombination fractions are clipped just below 0.5 so the inverse maps stay finite
+_R_MAX = 0.5 - 1e-12
+
+
+def cm_to_r(distance_cm, map_function: str = "haldane"):
+    """Recombination fraction for a map distance in centiMorgans."""
+    d = np.abs(np.asarray(distance_cm, dtype=np.float64)) / 100.0
+    if map_function == "haldane":
+        return 0.5 * (1.0 - np.exp(-2.0 * d))
+    if map_function == "kosambi":
+        return 0.5 * np.tanh(2.0 * d)
+    raise ValueError(f"Unknown map function: {map_function}")
+
+
+def r_to_cm(r, map_function: str = "haldane"):
+    """Map distance in centiMorgans for a recombination fraction."""
+    r = np.clip(np.asarray(r, dtype=np.float64), 0.0, _R_MAX)
+    if map_function == "haldane":
+        return -50.0 * np.log1p(-2.0 * r)
+    if map_function == "kosambi":
+        return 25.0 * np.log((1.0 + 2.0 * r) / (1.0 - 2.0 * r))
+    raise ValueError(f"Unknown map function: {map_function}")
@@ -0,0 +1,354 @@
+"""
+GWAS power
+==========
+Study-planning power and sample-size calculations for single-variant tests.
+
+Power is evaluated over the full grid of sample size, allele frequency, effect
+size, significance level and (for case-control designs) case fraction:
+
+- quantitative traits: per-allele effect in trait standard deviations; the
+  variant explains q² = 2p(1-p)β² of the variance and the regression test has
+  non-centrality N·q²/(1-q²)
+- binary traits: allelic odds ratio under a multiplicative model with ``maf``
+  as the control allele frequency; the trend test non-centrality is
+  2N·φ(1-φ)·(p_case - p_control)² / (p̄(1-p̄)) for case fraction φ
+
+The 1-df non-central χ² tail is closed-form, P(χ²₁(λ) > c) =
+Φ(√λ - √c) + Φ(-√λ - √c), so the whole grid is evaluated in a handful of
+array operations; required sample sizes invert the same relation.
+
+Simulated power draws genotypes and phenotypes for every grid cell and
+tests each replicate, so it also reflects finite-sample behaviour
+(monomorphic draws, the discreteness of case-control counts):
+
+- quantitative traits run the association kernel of the production linear
+  analyzer (``gwas_out_of_core.regression_statistics``) with t tails
+- binary traits run the allelic trend test N·r² against χ²₁, the score test
+  of a logistic model and the test the analytic formula above describes
+
+Replicates are generated in chunks on the shared compute pool; each
+chunk has its own Philox stream spawned from the seed, so results do not
+depend on the thread count.
+"""
+
+from __future__ import annotations
+
+import math
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from ...utils.statistics import t_sf_two_sided
+from ..gwas_out_of_core import regression_statistics
+from .compute_pool import map_tasks
+from .sumstats import normal_isf
+
+TRAIT_TYPES = ("quantitative", "binary")
+
+# Largest power grid evaluated in one request
+MAX_GRID_POINTS = 50_000
+# Upper bound on simulated genotype draws (sum of N x replicates over cells);
+# a few seconds of the shared pool per request
+MAX_SIMULATED_GENOTYPES = 20_000_000
+# Genotype values per simulation chunk (bounds per-thread memory)
+_SIM_CHUNK_VALUES = 1 << 21
+
+
+def normal_sf(x: np.ndarray) -> np.ndarray:
+    """Standard normal upper tail, elementwise."""
+    erfc = np.frompyfunc(math.erfc, 1, 1)
+    return (0.5 * erfc(np.asarray(x, dtype=np.float64) / math.sqrt(2.0))).astype(np.float64)
+
+
+def _case_allele_frequency(maf: np.ndarray, odds_ratio: np.ndarray) -> np.ndarray:
+    return odds_ratio * maf / (1.0 + maf * (odds_ratio - 1.0))
+
+
+def noncentrality(
+    trait_type: str,
+    n: np.ndarray,
+    maf: np.ndarray,
+    effect: np.ndarray,
+    case_fraction: Optional[np.ndarray] = None,
+) -> np.ndarray:
+    """
+    Non-centrality parameter of the 1-df association test (broadcasting).
+
+    Raises:
+        ValueError: if a quantitative effect explains all trait variance
+    """
+    n, maf, effect = (np.asarray(a, dtype=np.float64) for a in (n, maf, effect))
+    if trait_type == "quantitative":
+        q2 = 2.0 * maf * (1.0 - maf) * effect ** 2
+        if np.any(q2 >= 1.0):
+            raise ValueError("Effect sizes must explain less than all of the trait variance (2p(1-p)β² < 1)")
+        return n * q2 / (1.0 - q2)
+
+    phi = np.asarray(case_fraction, dtype=np.float64)
+    p_case = _case_allele_frequency(maf, effect)
+    p_bar = phi * p_case + (1.0 - phi) * maf
+    return 2.0 * n * phi * (1.0 - phi) * (p_case - maf) ** 2 / (p_bar * (1.0 - p_bar))
+
+
+def analytic_power(ncp: np.ndarray, alpha: np.ndarray) -> np.ndarray:
+    """Power of a two-sided 1-df test with non-centrality ``ncp`` at level ``alpha``."""
+    z = normal_isf(np.asarray(alpha, dtype=np.float64) / 2.0)
+    root = np.sqrt(ncp)
+    return np.clip(normal_sf(z - root) + normal_sf(z + root), 0.0, 1.0)
+
+
+def required_sample_size(ncp_per_sample: np.ndarray, alpha: np.ndarray, power: float) -> np.ndarray:
+    """
+    Smallest N reaching ``power`` (the negligible opposite tail is ignored).
+
+    Cells with no effect get a sample size of -1.
+    """
+    z_alpha = normal_isf(np.asarray(alpha, dtype=np.float64) / 2.0)
+    z_power = normal_isf(np.array([1.0 - power]))[0]
+    target = (z_alpha + z_power) ** 2
+    with np.errstate(divide="ignore", invalid="ignore"):
+        n = np.ceil(target / ncp_per_sample)
+    return np.where(ncp_per_sample > 0, n, -1).astype(np.int64)
+
+
+def _critical_t(alpha: float, df: int) -> float:
+    """Two-sided critical |t| by bisection on the production t tail."""
+    lo, hi = 0.0, 1.0
+    while t_sf_two_sided(hi, df) > alpha:
+        hi *= 2.0
+    for _ in range(100):
+        mid = 0.5 * (lo + hi)
+        if t_sf_two_sided(mid, df) > alpha:
+            lo = mid
+        else:
+            hi = mid
+        if hi - lo < 1e-10 * hi:
+            break
+    return hi
+
+
+def _simulate_cell(
+    rng: np.random.Generator,
+    trait_type: str,
+    n: int,
+    maf: float,
+    effect: float,
+    case_fraction: Optional[float],
+    replicates: int,
+    critical: np.ndarray,
+) -> np.ndarray:
+    """
+    Significant replicates per alpha for one chunk of one grid cell.
+
+    ``critical`` holds |t| thresholds for quantitative traits and χ²₁
+    thresholds for binary ones.
+    """
+    if trait_type == "quantitative":
+        g = rng.binomial(2, maf, size=(replicates, n)).astype(np.float64)
+        q2 = 2.0 * maf * (1.0 - maf) * effect ** 2
+        y = effect * (g - 2.0 * maf) + math.sqrt(1.0 - q2) * rng.standard_normal((replicates, n))
+        y_res = y - y.mean(axis=1, keepdims=True)
+        yy = np.einsum("ij,ij->i", y_res, y_res)
+    else:
+        n_cases = min(max(int(round(case_fraction * n)), 1), n - 1)
+        p_case = float(_case_allele_frequency(np.float64(maf), np.float64(effect)))
+        g = np.empty((replicates, n))
+        g[:, :n_cases] = rng.binomial(2, p_case, size=(replicates, n_cases))
+        g[:, n_cases:] = rng.binomial(2, maf, size=(replicates, n - n_cases))
+        y_res = np.zeros(n)
+        y_res[:n_cases] = 1.0
+        y_res -= y_res.mean()
+        yy = float(y_res @ y_res)
+
+    # Intercept-only design: residualising is centring
+    g -= g.mean(axis=1, keepdims=True)
+    if trait_type == "quantitative":
+        _, _, t_stat, usable = regression_statistics(g, y_res, yy, n - 2)
+        statistic = np.where(usable, np.abs(t_stat), 0.0)
+    else:
+        # Cochran-Armitage trend test: N times the squared genotype-status correlation
+        gg = np.einsum("ij,ij->i", g, g)
+        gy = g @ y_res
+        with np.errstate(divide="ignore", invalid="ignore"):
+            statistic = np.where(gg > 0, n * gy ** 2 / (gg * yy), 0.0)
+    return (statistic[:, None] > critical[None, :]).sum(axis=0)
+
+
+def simulated_power(
+    trait_type: str,
+    cells: Sequence[Tuple[int, float, float, Optional[float]]],
+    alphas: Sequence[float],
+    replicates: int,
+    seed: Optional[int] = None,
+    workers: Optional[int] = None,
+) -> np.ndarray:
+    """
+    Monte-Carlo power for every (n, maf, effect, case_fraction) cell.
+
+    Args:
+        workers: 1 to run inline; otherwise chunks run on the shared compute pool
+
+    Returns:
+        (n_cells, n_alphas) fraction of replicates reaching significance
+    """
+    critical_cache: Dict[int, np.ndarray] = {}
+    chi2_critical = normal_isf(np.asarray(alphas, dtype=np.float64) / 2.0) ** 2
+    tasks = []
+    for index, (n, *_rest) in enumerate(cells):
+        if n not in critical_cache:
+            critical_cache[n] = (
+                np.array([_critical_t(a, n - 2) for a in alphas])
+                if trait_type == "quantitative" else chi2_critical
+            )
+        chunk = max(1, _SIM_CHUNK_VALUES // n)
+        for start in range(0, replicates, chunk):
+            tasks.append((index, min(chunk, replicates - start)))
+
+    streams = np.random.SeedSequence(seed).spawn(len(tasks))
+    hits = np.zeros((len(cells), len(alphas)), dtype=np.int64)
+    task_hits: List[Optional[np.ndarray]] = [None] * len(tasks)
+
+    def run(task: int) -> None:
+        index, size = tasks[task]
+        n, maf, effect, case_fraction = cells[index]
+        rng = np.random.Generator(np.random.Philox(streams[task]))
+        task_hits[task] = _simulate_cell(
+            rng, trait_type, n, maf, effect, case_fraction, size, critical_cache[n]
+        )
+
+    map_tasks(run, range(len(tasks)), workers)
+
+    for (index, _), counts in zip(tasks, task_hits):
+        hits[index] += counts
+    return hits / replicates
+
+
+def gwas_power(
+    trait_type: str,
+    sample_sizes: Sequence[int],
+    mafs: Sequence[float],
+    effect_sizes: Sequence[float],
+    alphas: Sequence[float] = (5e-8,),
+    case_fractions: Optional[Sequence[float]] = None,
+    mode: str = "analytic",
+    replicates: int = 500,
+    target_power: Optional[float] = None,
+    seed: Optional[int] = None,
+) -> Dict[str, Any]:
+    """
+    Power surface of a single-variant GWAS test over a parameter grid.
+
+    Args:
+        trait_type: "quantitative" (effects in SD units per allele) or
+            "binary" (effects as allelic odds ratios)
+        case_fractions: fraction of cases; binary traits only (default 0.5)
+        mode: "analytic", or "simulated" to add Monte-Carlo power from the
+            production regression kernel (quantitative) or the allelic
+            trend test (binary)
+        target_power: when set, each point also carries the sample size
+            needed to reach it
+
+    Returns:
+        Grid axes and one point per (n, maf, effect, case_fraction, alpha)
+
+    Raises:
+        ValueError: on out-of-range parameters or an oversized grid
+    """
+    if trait_type not in TRAIT_TYPES:
+        raise ValueError(f"trait_type must be one of {', '.join(TRAIT_TYPES)}")
+    if mode not in ("analytic", "simulated"):
+        raise ValueError("mode must be 'analytic' or 'simulated'")
+    if not sample_sizes or not mafs or not effect_sizes or not alphas:
+        raise ValueError("sample_sizes, mafs, effect_sizes and alphas must not be empty")
+    if min(sample_sizes) < 10:
+        raise ValueError("Sample sizes must be at least 10")
+    if any(not 0 < p <= 0.5 for p in mafs):
+        raise ValueError("Allele frequencies must be in (0, 0.5]")
+    if any(not 0 < a < 1 for a in alphas):
+        raise ValueError("Significance levels must be in (0, 1)")
+    if target_power is not None and not 0 < target_power < 1:
+        raise ValueError("target_power must be in (0, 1)")
+
+    if trait_type == "binary":
+        fractions: List[Optional[float]] = list(case_fractions or [0.5])
+        if any(not 0 < f < 1 for f in fractions):
+            raise ValueError("Case fractions must be in (0, 1)")
+        if any(e <= 0 for e in effect_sizes):
+            raise ValueError("Odds ratios must be positive")
+    else:
+        fractions = [None]
+
+    n_points = len(sample_sizes) * len(mafs) * len(effect_sizes) * len(fractions) * len(alphas)
+    if n_points > MAX_GRID_POINTS:
+        raise ValueError(f"Power grid has {n_points} points; at most {MAX_GRID_POINTS} are supported")
+
+    # Cell axes (alpha varies fastest so simulated hits line up with points)
+    n_grid, maf_grid, effect_grid, fraction_index = (
+        a.ravel() for a in np.meshgrid(
+            np.asarray(sample_sizes, dtype=np.float64),
+            np.asarray(mafs, dtype=np.float64),
+            np.asarray(effect_sizes, dtype=np.float64),
+            np.arange(len(fractions)),
+            indexing="ij",
+        )
+    )
+    fraction_grid = (
+        np.asarray(fractions, dtype=np.float64)[fraction_index] if trait_type == "binary" else None
+    )
+    alpha_grid = np.asarray(alphas, dtype=np.float64)
+
+    ncp_unit = noncentrality(trait_type, 1.0, maf_grid, effect_grid, fraction_grid)
+    ncp = n_grid[:, None] * ncp_unit[:, None] * np.ones((1, alpha_grid.size))
+    power = analytic_power(ncp, alpha_grid[None, :])
+    required = (
+        required_sample_size(ncp_unit[:, None], alpha_grid[None, :], target_power)
+        if target_power is not None else None
+    )
+
+    simulated = None
+    if mode == "simulated":
+        if replicates < 1:
+            raise ValueError("replicates must be positive")
+        draws = int(n_grid.sum()) * replicates
+        if draws > MAX_SIMULATED_GENOTYPES:
+            raise ValueError(
+                f"Simulation needs {draws} genotype draws; at most {MAX_SIMULATED_GENOTYPES} are supported"
+            )
+        cells = [
+            (int(n), float(p), float(e), fractions[int(f)])
+            for n, p, e, f in zip(n_grid, maf_grid, effect_grid, fraction_index)
+        ]
+        simulated = simulated_power(trait_type, cells, alphas, replicates, seed=seed)
+
+    points = []
+    for c in range(n_grid.size):
+        for a in range(alpha_grid.size):
+            point: Dict[str, Any] = {
+                "n": int(n_grid[c]),
+                "maf": float(maf_grid[c]),
+                "effect_size": float(effect_grid[c]),
+                "case_fraction": fractions[int(fraction_index[c])],
+                "alpha": float(alpha_grid[a]),
+                "ncp": float(ncp[c, a]),
+                "power": float(power[c, a]),
+            }
+            if simulated is not None:
+                sim = float(simulated[c, a])
+                point["simulated_power"] = sim
+                point["simulated_se"] = math.sqrt(sim * (1.0 - sim) / replicates)
+            if required is not None:
+                point["required_n"] = int(required[c, a]) if required[c, a] > 0 else None
+            points.append(point)
+
+    return {
+        "trait_type": trait_type,
+        "mode": mode,
+        "replicates": replicates if mode == "simulated" else 0,
+        "target_power": target_power,
+        "sample_sizes": [int(n) for n in sample_sizes],
+        "mafs": [float(p) for p in mafs],
+        "effect_sizes": [float(e) for e in effect_sizes],
+        "case_fractions": [f for f in fractions if f is not None],
+        "alphas": [float(a) for a in alphas],
+        "points": points,
+    }
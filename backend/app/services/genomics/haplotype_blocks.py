@@ -0,0 +1,511 @@
+"""
+Haplotype block partitioning
+============================
+Splits each chromosome of a genotype dataset into LD blocks and estimates
+the haplotype frequencies inside every block.
+
+Pairwise LD is only needed between SNPs that can end up in the same block,
+so it is computed on a band: each SNP against the following SNPs within
+``max_distance_kb`` (at most ``max_window_snps``). The band is filled in row
+tiles; every pair is estimated once from the 3x3 two-locus genotype counts
+(indicator-matrix products) with a vectorised two-locus haplotype EM.
+
+Methods:
+
+- ``gabriel``: Gabriel et al. (2002) as in Haploview. A 90% likelihood
+  confidence interval for |D'| classifies pairs as strong LD
+  (lower >= 0.70, upper >= 0.98) or strong recombination (upper < 0.90);
+  a region is a block when its end markers are in strong LD and at least
+  95% of its informative pairs are strong LD.
+- ``dprime``: fast "solid spine" heuristic. A region is a block when its
+  first and last markers have |D'| >= ``dprime_threshold`` with every
+  marker in between.
+
+Candidate blocks are accepted longest first without overlaps. Haplotype
+frequencies come from a progressive (SNP-by-SNP, pruned) EM over the
+unphased genotypes of each block.
+"""
+
+from __future__ import annotations
+
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from .dataset_cache import DatasetResultCache
+
+METHODS = ("gabriel", "dprime")
+
+# Rows of the LD band estimated per tile
+_BAND_TILE = 512
+_PAIR_EM_ITERATIONS = 25
+# |D'| grid for the Gabriel likelihood confidence interval
+_DPRIME_GRID = np.linspace(0.0, 1.0, 101)
+_GABRIEL_STRONG_LOWER = 0.70
+_GABRIEL_STRONG_UPPER = 0.98
+_GABRIEL_RECOMBINATION_UPPER = 0.90
+_GABRIEL_INFORMATIVE_FRACTION = 0.95
+# Haplotypes are bit-packed into uint64
+MAX_HAPLOTYPE_SNPS = 64
+_HAPLOTYPE_EM_ITERATIONS = 50
+_HAPLOTYPE_PRUNE = 1e-3
+# Sorted block candidates filtered against accepted blocks per vectorised pass
+_SELECT_CHUNK = 4096
+
+
+# ----------------------------------------------------------------------
+# Pairwise LD on a band
+# ----------------------------------------------------------------------
+
+def _two_locus_counts(indicators: np.ndarray, rows: slice, cols: slice) -> np.ndarray:
+    """counts[g, h, a, b]: samples with dosage g at row SNP a and h at column SNP b."""
+    row_ind = indicators[:, rows]
+    col_ind = indicators[:, cols].transpose(0, 2, 1)
+    return np.matmul(row_ind[:, None], col_ind[None]).astype(np.float64)
+
+
+def _resolved_counts(counts: np.ndarray) -> Tuple[np.ndarray, ...]:
+    """
+    Haplotype counts (11, 10, 01, 00; 1 = alt allele) resolved without
+    ambiguity from 3x3 genotype counts, plus the double heterozygote count.
+    """
+    c = counts
+    return (
+        2 * c[2, 2] + c[2, 1] + c[1, 2],
+        2 * c[2, 0] + c[2, 1] + c[1, 0],
+        2 * c[0, 2] + c[0, 1] + c[1, 2],
+        2 * c[0, 0] + c[0, 1] + c[1, 0],
+        c[1, 1],
+    )
+
+
+def _haplotype_frequencies(resolved: Tuple[np.ndarray, ...]) -> Tuple[np.ndarray, ...]:
+    """Two-locus haplotype frequencies, EM over the phase of double heterozygotes."""
+    known11, known10, known01, known00, double_het = resolved
+    total = known11 + known10 + known01 + known00 + 2 * double_het
+    safe_total = np.maximum(total, 1.0)
+
+    f11 = f10 = f01 = f00 = np.full(total.shape, 0.25)
+    for _ in range(_PAIR_EM_ITERATIONS):
+        coupling = f11 * f00
+        repulsion = f10 * f01
+        p_coupling = np.where(coupling + repulsion > 0, coupling / np.maximum(coupling + repulsion, 1e-300), 0.5)
+        f11 = (known11 + double_het * p_coupling) / safe_total
+        f00 = (known00 + double_het * p_coupling) / safe_total
+        f10 = (known10 + double_het * (1 - p_coupling)) / safe_total
+        f01 = (known01 + double_het * (1 - p_coupling)) / safe_total
+    return f11, f10, f01, f00, total
+
+
+def _d_max(p: np.ndarray, q: np.ndarray, positive: np.ndarray) -> np.ndarray:
+    return np.where(
+        positive,
+        np.minimum(p * (1 - q), (1 - p) * q),
+        np.minimum(p * q, (1 - p) * (1 - q)),
+    )
+
+
+def _genotype_log_likelihood(resolved: Tuple[np.ndarray, ...], f11, f10, f01, f00) -> np.ndarray:
+    """log P(genotype counts | haplotype frequencies) up to a constant."""
+    known11, known10, known01, known00, double_het = resolved
+    eps = 1e-300
+    return (
+        known11 * np.log(np.maximum(f11, eps))
+        + known10 * np.log(np.maximum(f10, eps))
+        + known01 * np.log(np.maximum(f01, eps))
+        + known00 * np.log(np.maximum(f00, eps))
+        + double_het * np.log(np.maximum(f11 * f00 + f10 * f01, eps))
+    )
+
+
+def _dprime_interval(resolved: Tuple[np.ndarray, ...], p: np.ndarray, q: np.ndarray, positive: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+    """5% / 95% bounds of the |D'| likelihood, allele frequencies held fixed."""
+    sign = np.where(positive, 1.0, -1.0)
+    d_max = _d_max(p, q, positive)
+    ll = np.empty((_DPRIME_GRID.size,) + p.shape)
+    for k, dprime in enumerate(_DPRIME_GRID):
+        d = sign * dprime * d_max
+        f11 = p * q + d
+        f10 = p * (1 - q) - d
+        f01 = (1 - p) * q - d
+        f00 = (1 - p) * (1 - q) + d
+        ll[k] = _genotype_log_likelihood(resolved, f11, f10, f01, f00)
+    likelihood = np.exp(ll - ll.max(axis=0, keepdims=True))
+    cumulative = np.cumsum(likelihood, axis=0) / likelihood.sum(axis=0, keepdims=True)
+    lower = _DPRIME_GRID[np.argmax(cumulative >= 0.05, axis=0)]
+    upper = _DPRIME_GRID[np.argmax(cumulative >= 0.95, axis=0)]
+    return lower, upper
+
+
+def ld_band(
+    dosages: np.ndarray,
+    positions: np.ndarray,
+    max_distance_bp: int,
+    max_window_snps: int,
+    confidence_bounds: bool = False,
+) -> Dict[str, np.ndarray]:
+    """
+    Pairwise LD between each SNP and the next ``max_window_snps`` SNPs.
+
+    Args:
+        dosages: (n_snps, n_samples) alt-allele dosages, -1 = missing
+        positions: Sorted base-pair positions
+        max_distance_bp: Pairs further apart are left out of the band
+        max_window_snps: Band width
+        confidence_bounds: Also compute the Gabriel |D'| confidence interval
+
+    Returns:
+        Dict of (n_snps, width + 1) arrays indexed [i, offset]: ``dprime``
+        (absolute), ``r2``, ``in_window`` and, with confidence bounds,
+        ``lower`` / ``upper``. Offset 0 is unused.
+    """
+    m = dosages.shape[0]
+    width = max(1, min(max_window_snps, m - 1))
+    indicators = np.stack([(dosages == g) for g in range(3)]).astype(np.float32)
+
+    shape = (m, width + 1)
+    band = {
+        "dprime": np.zeros(shape, dtype=np.float32),
+        "r2": np.zeros(shape, dtype=np.float32),
+        "in_window": np.zeros(shape, dtype=bool),
+    }
+    if confidence_bounds:
+        band["lower"] = np.zeros(shape, dtype=np.float32)
+        band["upper"] = np.zeros(shape, dtype=np.float32)
+
+    for start in range(0, m, _BAND_TILE):
+        stop = min(start + _BAND_TILE, m)
+        col_stop = min(stop + width, m)
+        counts = _two_locus_counts(indicators, slice(start, stop), slice(start, col_stop))
+        # Gather the band out of the (rows x columns) tile: column = row + offset
+        rows = np.arange(stop - start)[:, None]
+        offsets = np.arange(width + 1)[None, :]
+        cols = rows + offsets
+        valid = (cols < col_stop - start) & (offsets > 0)
+        cols = np.minimum(cols, col_stop - start - 1)
+        resolved = _resolved_counts(counts[:, :, rows, cols])
+
+        f11, f10, f01, f00, total = _haplotype_frequencies(resolved)
+        p = f11 + f10
+        q = f11 + f01
+        d = f11 - p * q
+        positive = d > 0
+        d_max = _d_max(p, q, positive)
+        with np.errstate(invalid="ignore", divide="ignore"):
+            dprime = np.where(d_max > 0, np.abs(d) / d_max, 0.0)
+            denominator = p * (1 - p) * q * (1 - q)
+            r2 = np.where(denominator > 0, d * d / denominator, 0.0)
+
+        distance = positions[start + np.minimum(rows + offsets, m - 1 - start)] - positions[start:stop, None]
+        valid &= (distance <= max_distance_bp) & (total > 0)
+
+        band["dprime"][start:stop] = np.where(valid, np.minimum(dprime, 1.0), 0.0)
+        band["r2"][start:stop] = np.where(valid, np.minimum(r2, 1.0), 0.0)
+        band["in_window"][start:stop] = valid
+        if confidence_bounds:
+            lower, upper = _dprime_interval(resolved, p, q, positive)
+            band["lower"][start:stop] = np.where(valid, lower, 0.0)
+            band["upper"][start:stop] = np.where(valid, upper, 0.0)
+    return band
+
+
+# ----------------------------------------------------------------------
+# Block construction
+# ----------------------------------------------------------------------
+
+def _region_counts(pairs: np.ndarray) -> np.ndarray:
+    """
+    counts[i, d]: flagged band pairs with both markers in [i, i + d].
+
+    Filled one offset at a time by inclusion-exclusion over the two regions
+    one marker shorter, so every region of the band costs O(1).
+    """
+    m, width_1 = pairs.shape
+    counts = np.zeros((m, width_1), dtype=np.int32)
+    for d in range(1, width_1):
+        counts[:-1, d] = counts[1:, d - 1] + counts[:-1, d - 1] + pairs[:-1, d]
+        if d >= 2:
+            counts[:-1, d] -= counts[1:, d - 2]
+    return counts
+
+
+def _accept_longest_first(starts: np.ndarray, ends: np.ndarray, positions: np.ndarray) -> List[Tuple[int, int]]:
+    """
+    Greedy non-overlapping selection of candidate regions [start, end],
+    longest span first (leftmost first on ties).
+
+    Candidates are taken in that order in chunks; each chunk is filtered
+    against the blocks accepted so far in one vectorised pass, so only the
+    survivors of a chunk are checked one at a time.
+    """
+    order = np.lexsort((starts, -(positions[ends] - positions[starts])))
+    starts, ends = starts[order], ends[order]
+    used = np.zeros(positions.size, dtype=bool)
+    used_cum = np.zeros(positions.size + 1, dtype=np.int64)
+    blocks: List[Tuple[int, int]] = []
+    chunk = max(_SELECT_CHUNK, positions.size)
+    for first in range(0, starts.size, chunk):
+        i_chunk, j_chunk = starts[first:first + chunk], ends[first:first + chunk]
+        np.cumsum(used, out=used_cum[1:])
+        free = used_cum[j_chunk + 1] == used_cum[i_chunk]
+        for i, j in zip(i_chunk[free].tolist(), j_chunk[free].tolist()):
+            if used[i:j + 1].any():
+                continue
+            used[i:j + 1] = True
+            blocks.append((i, j))
+    return sorted(blocks)
+
+
+def _band_candidates(strong: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+    rows, offsets = np.nonzero(strong)
+    return rows, rows + offsets
+
+
+def gabriel_blocks(band: Dict[str, np.ndarray], positions: np.ndarray) -> List[Tuple[int, int]]:
+    """Gabriel et al. confidence-interval blocks over a band with bounds."""
+    window = band["in_window"]
+    strong = window & (band["lower"] >= _GABRIEL_STRONG_LOWER) & (band["upper"] >= _GABRIEL_STRONG_UPPER)
+    recombination = window & (band["upper"] < _GABRIEL_RECOMBINATION_UPPER)
+    # Pair counts of every region the band can hold, so all candidates are tested at once
+    n_strong = _region_counts(strong)
+    n_recombination = _region_counts(recombination)
+
+    starts, ends = _band_candidates(strong)
+    strong_pairs = n_strong[starts, ends - starts]
+    informative = strong_pairs + n_recombination[starts, ends - starts]
+    with np.errstate(invalid="ignore", divide="ignore"):
+        accepted = (informative > 0) & (strong_pairs / informative >= _GABRIEL_INFORMATIVE_FRACTION)
+    return _accept_longest_first(starts[accepted], ends[accepted], positions)
+
+
+def spine_blocks(band: Dict[str, np.ndarray], positions: np.ndarray, threshold: float) -> List[Tuple[int, int]]:
+    """Solid-spine blocks: end markers in strong LD with every marker in between."""
+    strong = band["in_window"] & (band["dprime"] >= threshold)
+    m, width_1 = strong.shape
+    # Row spine: SNP i strong with all of i+1..i+d
+    row_ok = np.cumprod(strong[:, 1:], axis=1).astype(bool)
+    # Column spine: SNP j strong with all of j-d..j-1 (band re-indexed by column)
+    by_column = np.zeros_like(strong[:, 1:])
+    for d in range(1, width_1):
+        by_column[d:, d - 1] = strong[:m - d, d]
+    col_ok = np.cumprod(by_column, axis=1).astype(bool)
+
+    spine = np.zeros_like(strong)
+    for d in range(1, width_1):
+        spine[:m - d, d] = row_ok[:m - d, d - 1] & col_ok[d:, d - 1]
+    starts, ends = _band_candidates(spine)
+    return _accept_longest_first(starts, ends, positions)
+
+
+# ----------------------------------------------------------------------
+# Block haplotypes
+# ----------------------------------------------------------------------
+
+def block_haplotypes(dosages: np.ndarray, min_frequency: float = 0.01) -> List[Tuple[int, float]]:
+    """
+    Haplotype frequencies of one block from unphased dosages.
+
+    SNPs are added one at a time; every sample keeps the haplotype pairs
+    consistent with its genotypes, EM re-estimates the frequencies, and pairs
+    with a negligible posterior are pruned before the next SNP.
+
+    Args:
+        dosages: (k, n_samples) dosages of the block, -1 = missing
+        min_frequency: Haplotypes below this frequency are not returned
+
+    Returns:
+        (haplotype bit code, frequency) pairs, most frequent first; bit j is
+        the allele at SNP j (1 = alt)
+    """
+    k, n = dosages.shape
+    if k > MAX_HAPLOTYPE_SNPS:
+        raise ValueError(f"Blocks longer than {MAX_HAPLOTYPE_SNPS} SNPs are not phased")
+    owner = np.arange(n)
+    h1 = np.zeros(n, dtype=np.uint64)
+    h2 = np.zeros(n, dtype=np.uint64)
+    frequencies = np.ones(1)
+    haplotypes = np.zeros(1, dtype=np.uint64)
+
+    for j in range(k):
+        bit = np.uint64(1) << np.uint64(j)
+        d = dosages[j, owner]
+        both = d == 2
+        h1 = np.where(both, h1 | bit, h1)
+        h2 = np.where(both, h2 | bit, h2)
+        # Heterozygous and missing samples branch into every consistent pair
+        branch = (d == 1) | (d < 0)
+        extra_owner = [owner[branch]]
+        extra_h1 = [h1[branch] | bit]
+        extra_h2 = [h2[branch]]
+        missing = d < 0
+        extra_owner += [owner[missing], owner[missing]]
+        extra_h1 += [h1[missing], h1[missing] | bit]
+        extra_h2 += [h2[missing] | bit, h2[missing] | bit]
+        het = d == 1
+        h2 = np.where(het, h2 | bit, h2)
+        owner = np.concatenate([owner] + extra_owner)
+        h1 = np.concatenate([h1] + extra_h1)
+        h2 = np.concatenate([h2] + extra_h2)
+
+        # Unordered pairs, deduplicated per sample
+        lo, hi = np.minimum(h1, h2), np.maximum(h1, h2)
+        pairs = np.unique(np.stack([owner.astype(np.uint64), lo, hi], axis=1), axis=0)
+        owner, h1, h2 = pairs[:, 0].astype(np.int64), pairs[:, 1], pairs[:, 2]
+
+        haplotypes, inverse = np.unique(np.concatenate([h1, h2]), return_inverse=True)
+        i1, i2 = inverse[:owner.size], inverse[owner.size:]
+        frequencies = np.full(haplotypes.size, 1.0 / haplotypes.size)
+        multiplicity = np.where(i1 != i2, 2.0, 1.0)
+        for _ in range(_HAPLOTYPE_EM_ITERATIONS):
+            weight = frequencies[i1] * frequencies[i2] * multiplicity
+            weight /= np.bincount(owner, weight, minlength=n)[owner]
+            updated = (np.bincount(i1, weight, haplotypes.size) + np.bincount(i2, weight, haplotypes.size)) / (2 * n)
+            converged = np.max(np.abs(updated - frequencies)) < 1e-7
+            frequencies = updated
+            if converged:
+                break
+
+        best = np.zeros(n)
+        np.maximum.at(best, owner, weight)
+        keep = (weight >= _HAPLOTYPE_PRUNE) | (weight >= best[owner])
+        owner, h1, h2 = owner[keep], h1[keep], h2[keep]
+
+    order = np.argsort(-frequencies, kind="stable")
+    return [
+        (int(haplotypes[idx]), float(frequencies[idx]))
+        for idx in order if frequencies[idx] >= min_frequency
+    ]
+
+
+# ----------------------------------------------------------------------
+# Dataset partitioning
+# ----------------------------------------------------------------------
+
+def partition_haplotype_blocks(
+    snps: Sequence[Dict[str, Any]],
+    method: str = "gabriel",
+    chromosomes: Optional[Sequence[int]] = None,
+    max_distance_kb: float = 500.0,
+    max_window_snps: int = 200,
+    maf_threshold: float = 0.05,
+    max_missing_rate: float = 0.1,
+    dprime_threshold: float = 0.8,
+    min_haplotype_frequency: float = 0.01,
+) -> Dict[str, Any]:
+    """
+    Partition every chromosome of a parsed dataset into haplotype blocks.
+
+    Args:
+        snps: Parsed SNP records (rsid, chromosome, position, ref_allele,
+            alt_allele, genotypes as dosages with -1 = missing)
+        method: "gabriel" or "dprime"
+        chromosomes: Restrict to these chromosomes (default: all)
+        max_distance_kb: Maximum block span / pair distance
+        max_window_snps: Maximum SNPs a pair may be apart
+        maf_threshold: SNPs below this minor allele frequency are skipped
+        max_missing_rate: SNPs with more missing calls are skipped
+        dprime_threshold: Strong-LD |D'| for the ``dprime`` method
+        min_haplotype_frequency: Haplotypes rarer than this are not reported
+
+    Returns:
+        Dict with per-chromosome blocks (boundaries, SNPs, haplotypes)
+
+    Raises:
+        ValueError: On unknown method or unusable input
+    """
+    if method not in METHODS:
+        raise ValueError(f"method must be one of {METHODS}, got: {method}")
+    wanted = set(chromosomes) if chromosomes else None
+
+    by_chromosome: Dict[int, List[Dict[str, Any]]] = {}
+    for snp in snps:
+        chrom = int(snp["chromosome"])
+        if wanted is None or chrom in wanted:
+            by_chromosome.setdefault(chrom, []).append(snp)
+    if not by_chromosome:
+        raise ValueError("No SNPs on the requested chromosomes")
+
+    results: List[Dict[str, Any]] = []
+    total_used = 0
+    for chrom in sorted(by_chromosome):
+        records = sorted(by_chromosome[chrom], key=lambda s: int(s["position"]))
+        dosages = np.array([s.get("genotypes") or [] for s in records], dtype=np.int8)
+        if dosages.ndim != 2 or dosages.shape[1] == 0:
+            raise ValueError(f"Chromosome {chrom} has no genotype data")
+        called = dosages >= 0
+        n_called = called.sum(axis=1)
+        with np.errstate(invalid="ignore", divide="ignore"):
+            alt_freq = np.where(called, dosages, 0).sum(axis=1) / np.maximum(2 * n_called, 1)
+        maf = np.minimum(alt_freq, 1 - alt_freq)
+        keep = (maf >= maf_threshold) & (1 - n_called / dosages.shape[1] <= max_missing_rate)
+        kept = np.flatnonzero(keep)
+        total_used += kept.size
+
+        blocks: List[Dict[str, Any]] = []
+        if kept.size >= 2:
+            sub = dosages[kept]
+            positions = np.array([int(records[i]["position"]) for i in kept], dtype=np.int64)
+            band = ld_band(
+                sub, positions, int(max_distance_kb * 1000), max_window_snps,
+                confidence_bounds=(method == "gabriel"),
+            )
+            spans = (
+                gabriel_blocks(band, positions) if method == "gabriel"
+                else spine_blocks(band, positions, dprime_threshold)
+            )
+            for i, j in spans:
+                members = [records[idx] for idx in kept[i:j + 1]]
+                haplotypes = None
+                if j - i + 1 <= MAX_HAPLOTYPE_SNPS:
+                    haplotypes = [
+                        {
+                            "alleles": [
+                                s["alt_allele"] if (code >> bit) & 1 else s["ref_allele"]
+                                for bit, s in enumerate(members)
+                            ],
+                            "frequency": round(freq, 6),
+                        }
+                        for code, freq in block_haplotypes(sub[i:j + 1], min_haplotype_frequency)
+                    ]
+                blocks.append({
+                    "chromosome": chrom,
+                    "start_position": int(positions[i]),
+                    "end_position": int(positions[j]),
+                    "span_bp": int(positions[j] - positions[i]),
+                    "n_snps": j - i + 1,
+                    "rsids": [s["rsid"] for s in members],
+                    "haplotypes": haplotypes,
+                })
+
+        results.append({
+            "chromosome": chrom,
+            "n_snps": len(records),
+            "n_snps_used": int(kept.size),
+            "n_blocks": len(blocks),
+            "snps_in_blocks": sum(b["n_snps"] for b in blocks),
+            "blocks": blocks,
+        })
+
+    return {
+        "method": method,
+        "n_snps": sum(len(v) for v in by_chromosome.values()),
+        "n_snps_used": int(total_used),
+        "n_blocks": sum(c["n_blocks"] for c in results),
+        "chromosomes": results,
+    }
+
+
+_block_cache = DatasetResultCache("haplotype_blocks")
+
+
+def dataset_haplotype_blocks(user_id: str, dataset_id: str, **params: Any) -> Optional[Dict[str, Any]]:
+    """
+    Haplotype blocks of a user's processed GWAS dataset (cached).
+
+    Returns:
+        Partition result, or None if the dataset does not exist for the user
+    """
+    return _block_cache.compute(
+        user_id, dataset_id, params,
+        lambda data: partition_haplotype_blocks(data.get("snps", []), **params),
+    )
@@ -0,0 +1,403 @@
+"""
+Liftover
+========
+Batched coordinate conversion between genome builds with UCSC chain files.
+
+A chain file is loaded once into a sorted interval index per source
+chromosome: parallel arrays of ungapped block starts and ends, the target
+chromosome, the offset into the target and the target strand. A batch of
+positions is looked up with binary searches over those arrays, in chunks
+that run on the shared genomics compute pool (``searchsorted`` releases the
+GIL).
+
+Chains may overlap in the source build. The number of blocks covering a
+position is the number of block starts at or before it minus the number of
+block ends at or before it (both sorted), so overlapping hits are found
+without an interval tree and reported as ``multiple``, as UCSC ``liftOver``
+does.
+
+Statuses per variant:
+
+- ``mapped``: both ends of the REF allele lie in the same aligned block
+- ``unmapped``: no block covers the variant (deleted or unaligned)
+- ``multiple``: more than one chain covers the variant
+- ``split``: the REF allele crosses a gap between blocks
+
+Variants lifted onto the reverse strand are moved to the forward-strand
+start of the allele and their alleles are reverse-complemented
+(``strand_flipped``).
+"""
+
+from __future__ import annotations
+
+import gzip
+from functools import lru_cache
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from .compute_pool import map_tasks
+from .dataset_cache import DatasetResultCache
+
+# UCSC assembly names of the supported builds
+_BUILD_ALIASES = {
+    "grch37": "hg19",
+    "hg19": "hg19",
+    "b37": "hg19",
+    "grch38": "hg38",
+    "hg38": "hg38",
+}
+_CHROMOSOME_NAMES = {23: "X", 24: "Y", 25: "M"}
+_CHROMOSOME_CODES = {"X": 23, "Y": 24, "M": 25, "MT": 25}
+# Positions looked up per thread-pool task
+_LOOKUP_CHUNK = 1 << 18
+_COMPLEMENT = str.maketrans("ACGTNacgtn", "TGCANtgcan")
+
+STATUS_MAPPED = "mapped"
+STATUS_UNMAPPED = "unmapped"
+STATUS_MULTIPLE = "multiple"
+STATUS_SPLIT = "split"
+_STATUSES = (STATUS_MAPPED, STATUS_UNMAPPED, STATUS_MULTIPLE, STATUS_SPLIT)
+
+
+def ucsc_build(build: str) -> str:
+    """UCSC assembly name (hg19 / hg38) of a build name."""
+    resolved = _BUILD_ALIASES.get(build.strip().lower())
+    if resolved is None:
+        raise ValueError(f"Unknown genome build '{build}'. Use GRCh37 or GRCh38")
+    return resolved
+
+
+def chromosome_code(name: str) -> Optional[int]:
+    """Numeric chromosome (X = 23, Y = 24, MT = 25) of a chain chromosome name."""
+    name = name[3:] if name.lower().startswith("chr") else name
+    if name.isdigit():
+        return int(name)
+    return _CHROMOSOME_CODES.get(name.upper())
+
+
+def _source_key(chromosome: Any) -> str:
+    name = str(chromosome)
+    name = name[3:] if name.lower().startswith("chr") else name
+    if name.isdigit():
+        return _CHROMOSOME_NAMES.get(int(name), str(int(name)))
+    return "M" if name.upper() == "MT" else name
+
+
+class _ChromosomeIndex:
+    """Aligned blocks of one source chromosome, sorted by start (0-based, half-open)."""
+
+    __slots__ = ("starts", "ends", "sorted_ends", "target", "offset", "reverse", "target_size")
+
+    def __init__(self, blocks: np.ndarray):
+        order = np.argsort(blocks[:, 0], kind="stable")
+        blocks = blocks[order]
+        self.starts = np.ascontiguousarray(blocks[:, 0])
+        self.ends = np.ascontiguousarray(blocks[:, 1])
+        self.sorted_ends = np.sort(self.ends)
+        self.target = blocks[:, 2].astype(np.int32)
+        # Target coordinate (on the chain's target strand) minus source coordinate
+        self.offset = np.ascontiguousarray(blocks[:, 3])
+        self.reverse = blocks[:, 4].astype(bool)
+        self.target_size = np.ascontiguousarray(blocks[:, 5])
+
+    def locate(self, positions: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        """Covering block of each 0-based position (-1 if none) and the cover count."""
+        candidate = np.searchsorted(self.starts, positions, side="right") - 1
+        cover = (candidate + 1) - np.searchsorted(self.sorted_ends, positions, side="right")
+        safe = np.maximum(candidate, 0)
+        inside = (candidate >= 0) & (positions < self.ends[safe])
+        block = np.where(inside, candidate, -1)
+        # One covering block that starts before a longer earlier block ended
+        for i in np.flatnonzero((cover == 1) & ~inside):
+            j = candidate[i]
+            while j >= 0 and not (self.starts[j] <= positions[i] < self.ends[j]):
+                j -= 1
+            block[i] = j
+        return block, cover
+
+    def target_position(self, block: np.ndarray, positions: np.ndarray) -> np.ndarray:
+        """Forward-strand 0-based target coordinate of positions inside ``block``."""
+        strand_coordinate = positions + self.offset[block]
+        return np.where(
+            self.reverse[block], self.target_size[block] - 1 - strand_coordinate, strand_coordinate
+        )
+
+
+class ChainIndex:
+    """Interval index of a UCSC chain file (source build -> target build)."""
+
+    def __init__(self, chain_path: Path):
+        self.path = Path(chain_path)
+        self.target_names: List[str] = []
+        self.n_chains = 0
+        self.chromosomes: Dict[str, _ChromosomeIndex] = {}
+        self._load()
+
+    def _load(self) -> None:
+        target_ids: Dict[str, int] = {}
+        blocks: Dict[str, List[Tuple[int, int, int, int, int, int]]] = {}
+        open_func = gzip.open if str(self.path).endswith(".gz") else open
+
+        with open_func(self.path, "rt") as f:
+            source = None
+            for line in f:
+                fields = line.split()
+                if not fields:
+                    continue
+                if fields[0] == "chain":
+                    # chain score tName tSize tStrand tStart tEnd qName qSize qStrand qStart qEnd id
+                    if len(fields) < 12:
+                        raise ValueError(f"Malformed chain header in {self.path.name}: {line.strip()}")
+                    source = _source_key(fields[2])
+                    source_pos = int(fields[5])
+                    target_name = fields[7]
+                    target = target_ids.setdefault(target_name, len(target_ids))
+                    target_size = int(fields[8])
+                    reverse = int(fields[9] == "-")
+                    target_pos = int(fields[10])
+                    chain_blocks = blocks.setdefault(source, [])
+                    self.n_chains += 1
+                    continue
+                if source is None:
+                    raise ValueError(f"Chain data before a chain header in {self.path.name}")
+                size = int(fields[0])
+                chain_blocks.append((
+                    source_pos, source_pos + size, target,
+                    target_pos - source_pos, reverse, target_size,
+                ))
+                if len(fields) >= 3:
+                    source_pos += size + int(fields[1])
+                    target_pos += size + int(fields[2])
+                else:
+                    source = None
+
+        if not blocks:
+            raise ValueError(f"No chains in {self.path.name}")
+        self.target_names = [_source_key(name) for name in target_ids]
+        self.chromosomes = {
+            name: _ChromosomeIndex(np.array(rows, dtype=np.int64))
+            for name, rows in blocks.items() if rows
+        }
+
+    def _lift_chromosome(
+        self,
+        index: _ChromosomeIndex,
+        starts: np.ndarray,
+        ends: np.ndarray,
+    ) -> Tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+        start_block, start_cover = index.locate(starts)
+        end_block, end_cover = index.locate(ends)
+
+        status = np.full(starts.shape, _STATUSES.index(STATUS_UNMAPPED), dtype=np.int8)
+        status[(start_block >= 0) | (end_block >= 0)] = _STATUSES.index(STATUS_SPLIT)
+        status[(start_cover > 1) | (end_cover > 1)] = _STATUSES.index(STATUS_MULTIPLE)
+        mapped = (start_block >= 0) & (start_block == end_block) & (start_cover == 1) & (end_cover == 1)
+        status[mapped] = _STATUSES.index(STATUS_MAPPED)
+
+        block = np.where(mapped, start_block, 0)
+        new_start = index.target_position(block, starts)
+        new_end = index.target_position(block, ends)
+        flipped = mapped & index.reverse[block]
+        position = np.where(flipped, new_end, new_start) + 1
+        target = np.where(mapped, index.target[block], -1)
+        return status, target, np.where(mapped, position, 0), flipped
+
+    def lift(
+        self,
+        chromosomes: Sequence[Any],
+        positions: Sequence[int],
+        lengths: Optional[Sequence[int]] = None,
+        workers: Optional[int] = None,
+    ) -> Dict[str, np.ndarray]:
+        """
+        Lift a batch of 1-based positions (or allele spans of ``lengths`` bases).
+
+        Args:
+            chromosomes: Source chromosome per variant (number or name)
+            positions: 1-based source positions
+            lengths: REF allele lengths (default 1)
+            workers: Run the lookup inline when 1 (default: shared compute pool)
+
+        Returns:
+            Arrays ``status`` (index into the status names), ``chromosome``
+            (target chromosome name index, -1 if unmapped), ``position``
+            (1-based, 0 if unmapped) and ``strand_flipped``
+        """
+        n = len(positions)
+        starts = np.asarray(positions, dtype=np.int64) - 1
+        spans = np.ones(n, dtype=np.int64) if lengths is None else np.maximum(np.asarray(lengths, dtype=np.int64), 1)
+        ends = starts + spans - 1
+        raw = np.asarray(chromosomes)
+        labels, inverse = np.unique(raw if raw.dtype.kind in "iu" else raw.astype(str), return_inverse=True)
+
+        out = {
+            "status": np.full(n, _STATUSES.index(STATUS_UNMAPPED), dtype=np.int8),
+            "chromosome": np.full(n, -1, dtype=np.int32),
+            "position": np.zeros(n, dtype=np.int64),
+            "strand_flipped": np.zeros(n, dtype=bool),
+        }
+        tasks = []
+        # Sorted queries keep consecutive binary searches on nearby cache lines
+        by_label = np.lexsort((starts, inverse)) if n else np.empty(0, dtype=np.int64)
+        bounds = np.searchsorted(inverse[by_label], np.arange(len(labels) + 1))
+        for label, key in enumerate(labels):
+            index = self.chromosomes.get(_source_key(key))
+            if index is None:
+                continue
+            rows = by_label[bounds[label]:bounds[label + 1]]
+            for chunk in range(0, rows.size, _LOOKUP_CHUNK):
+                tasks.append((index, rows[chunk:chunk + _LOOKUP_CHUNK]))
+
+        def run(task: Tuple[_ChromosomeIndex, np.ndarray]) -> None:
+            index, rows = task
+            valid = rows[starts[rows] >= 0]
+            status, target, position, flipped = self._lift_chromosome(index, starts[valid], ends[valid])
+            out["status"][valid] = status
+            out["chromosome"][valid] = target
+            out["position"][valid] = position
+            out["strand_flipped"][valid] = flipped
+
+        map_tasks(run, tasks, workers)
+        return out
+
+
+def reverse_complement(allele: str) -> str:
+    """Reverse complement of a nucleotide allele; symbolic alleles are returned unchanged."""
+    if not allele or allele[0] in "<*." or "[" in allele or "]" in allele:
+        return allele
+    return allele.translate(_COMPLEMENT)[::-1]
+
+
+def lift_variants(
+    variants: Sequence[Dict[str, Any]],
+    chain: ChainIndex,
+    include_unmapped: bool = True,
+) -> Dict[str, Any]:
+    """
+    Lift variant records (rsid, chromosome, position, ref_allele, alt_allele).
+
+    Returns:
+        Dict with the lifted variants, counts per status and strand flips.
+        Every lifted record keeps its source coordinates next to the new ones.
+    """
+    lifted = chain.lift(
+        [v["chromosome"] for v in variants],
+        [int(v["position"]) for v in variants],
+        [len(v.get("ref_allele") or "N") for v in variants],
+    )
+    counts = dict(zip(_STATUSES, np.bincount(lifted["status"], minlength=len(_STATUSES)).tolist()))
+
+    target_codes = [chromosome_code(name) for name in chain.target_names]
+    results = []
+    unmapped = []
+    for i, variant in enumerate(variants):
+        status = _STATUSES[lifted["status"][i]]
+        ref = variant.get("ref_allele") or ""
+        alt = variant.get("alt_allele") or ""
+        entry: Dict[str, Any] = {
+            "rsid": variant.get("rsid"),
+            "chromosome": variant["chromosome"],
+            "position": int(variant["position"]),
+            "ref_allele": ref,
+            "alt_allele": alt,
+            "status": status,
+            "new_chromosome": None,
+            "new_position": None,
+            "strand_flipped": False,
+        }
+        if status == STATUS_MAPPED:
+            target = int(lifted["chromosome"][i])
+            flipped = bool(lifted["strand_flipped"][i])
+            entry.update({
+                "new_chromosome": target_codes[target],
+                "new_contig": chain.target_names[target],
+                "new_position": int(lifted["position"][i]),
+                "strand_flipped": flipped,
+            })
+            if flipped:
+                entry["ref_allele"] = reverse_complement(ref)
+                entry["alt_allele"] = reverse_complement(alt)
+            results.append(entry)
+        elif include_unmapped:
+            unmapped.append(entry)
+
+    return {
+        "n_variants": len(variants),
+        "n_mapped": counts[STATUS_MAPPED],
+        "n_unmapped": counts[STATUS_UNMAPPED],
+        "n_multiple": counts[STATUS_MULTIPLE],
+        "n_split": counts[STATUS_SPLIT],
+        "n_strand_flipped": int(lifted["strand_flipped"].sum()),
+        "variants": results,
+        "unmapped": unmapped,
+    }
+
+
+def chain_path(source_build: str, target_build: str) -> Path:
+    """UCSC chain file for a build pair (``hg19ToHg38.over.chain.gz``) in the configured directory."""
+    from app.config import get_settings
+
+    source, target = ucsc_build(source_build), ucsc_build(target_build)
+    if source == target:
+        raise ValueError("Source and target builds are the same")
+    directory = Path(get_settings().liftover_chain_dir)
+    name = f"{source}To{target[0].upper()}{target[1:]}.over.chain"
+    for candidate in (directory / f"{name}.gz", directory / name):
+        if candidate.exists():
+            return candidate
+    raise ValueError(f"Chain file {name}.gz not found in {directory}")
+
+
+@lru_cache(maxsize=4)
+def load_chain(source_build: str, target_build: str) -> ChainIndex:
+    """Chain index for a build pair, loaded once per process."""
+    return ChainIndex(chain_path(source_build, target_build))
+
+
+_liftover_cache = DatasetResultCache("liftover", max_size=8)
+
+
+def dataset_liftover(
+    user_id: str,
+    dataset_id: str,
+    source_build: str,
+    target_build: str,
+    include_unmapped: bool = True,
+) -> Optional[Dict[str, Any]]:
+    """
+    Lift the variants of a user's processed GWAS dataset to another build (cached).
+
+    Returns:
+        Liftover result, or None if the dataset does not exist for the user
+    """
+    params = {
+        "source_build": ucsc_build(source_build),
+        "target_build": ucsc_build(target_build),
+        "include_unmapped": include_unmapped,
+    }
+    chain = load_chain(params["source_build"], params["target_build"])
+    return _liftover_cache.compute(
+        user_id, dataset_id, params,
+        lambda data: {
+            "source_build": source_build,
+            "target_build": target_build,
+            **lift_variants(data.get("snps", []), chain, include_unmapped),
+        },
+    )
+
+
+def lift_associations(
+    associations: Sequence[Dict[str, Any]],
+    source_build: str,
+    target_build: str,
+    include_unmapped: bool = True,
+) -> Dict[str, Any]:
+    """Lift a GWAS result set's associations to another build."""
+    chain = load_chain(ucsc_build(source_build), ucsc_build(target_build))
+    return {
+        "source_build": source_build,
+        "target_build": target_build,
+        **lift_variants(associations, chain, include_unmapped),
+    }
@@ -0,0 +1,400 @@
+"""
+Linkage map construction
+========================
+Estimates a genetic map from marker genotypes of an F2 intercross or a
+backcross, so crosses no longer need hand-entered recombination frequencies.
+
+1. Pairwise recombination fractions and LOD scores for every marker pair.
+   Two-locus genotype class counts come from products of genotype indicator
+   matrices, computed in tiles of markers, and the recombination fraction of
+   each pair is its two-point maximum likelihood estimate (EM over the
+   number of recombinant gametes, vectorised over all pairs of a tile).
+2. Markers are grouped into linkage groups by union-find over pairs with
+   ``LOD >= lod_threshold`` and ``r <= max_rf``.
+3. Markers within a group are ordered as a shortest open path through the
+   pairwise map distances (nearest-neighbour tour + 2-opt).
+4. Adjacent intervals are refined by multipoint EM on the ordered markers
+   (forward–backward over the cross HMM used by the QTL scan).
+
+``linkage`` in the result is shaped like ``LinkageDefinition`` entries and
+can be passed straight to the cross simulator.
+"""
+
+from __future__ import annotations
+
+from itertools import product
+from typing import Any, Dict, List, Optional, Sequence
+
+import numpy as np
+
+from .genetic_map import MAP_FUNCTIONS, r_to_cm
+from .qtl import CROSS_TYPES, _N_STATES, _PRIOR, _emission, _transition
+
+MAX_MARKERS = 5000
+# Individuals x markers accepted in one request
+MAX_GENOTYPE_CELLS = 10_000_000
+# Markers per row tile of the pairwise matrices
+_PAIR_TILE = 256
+_PAIR_EM_ITERATIONS = 30
+_MIN_RF = 1e-6
+_MAX_PAIRWISE_OUTPUT = 500
+
+
+def _class_table(cross_type: str) -> np.ndarray:
+    """
+    Number of gamete combinations giving two-locus genotype (g1, g2) with k
+    recombinant gametes; shape (states, states, gametes + 1).
+    """
+    gametes = [((a, b), int(a != b)) for a, b in product((0, 1), repeat=2)]
+    if cross_type == "backcross":
+        table = np.zeros((2, 2, 2))
+        for (a, b), k in gametes:
+            table[a, b, k] += 1
+        return table
+    table = np.zeros((3, 3, 3))
+    for ((a1, b1), k1), ((a2, b2), k2) in product(gametes, repeat=2):
+        table[a1 + a2, b1 + b2, k1 + k2] += 1
+    return table
+
+
+def _class_likelihood(table: np.ndarray, r: np.ndarray) -> np.ndarray:
+    """P(class | r) up to a constant, shape (states, states, *r.shape)."""
+    m = table.shape[2] - 1
+    k = np.arange(m + 1).reshape((m + 1,) + (1,) * r.ndim)
+    terms = r[None] ** k * (1.0 - r[None]) ** (m - k)
+    return np.tensordot(table, terms, axes=([2], [0]))
+
+
+def _expected_recombinants(table: np.ndarray, r: np.ndarray) -> np.ndarray:
+    m = table.shape[2] - 1
+    k = np.arange(m + 1).reshape((m + 1,) + (1,) * r.ndim)
+    terms = r[None] ** k * (1.0 - r[None]) ** (m - k)
+    numerator = np.tensordot(table, k * terms, axes=([2], [0]))
+    denominator = np.tensordot(table, terms, axes=([2], [0]))
+    with np.errstate(invalid="ignore", divide="ignore"):
+        return np.where(denominator > 0, numerator / denominator, 0.0)
+
+
+def pairwise_recombination(
+    genotypes: np.ndarray, cross_type: str
+) -> Dict[str, np.ndarray]:
+    """
+    Two-point recombination fractions and LOD scores for all marker pairs.
+
+    Args:
+        genotypes: (n_individuals, n_markers) codes, -1 = missing
+        cross_type: "f2" or "backcross"
+
+    Returns:
+        Dict with symmetric (m, m) ``rf``, ``lod`` and ``n_informative`` matrices
+    """
+    n_states = _N_STATES[cross_type]
+    n_gametes = n_states - 1
+    table = _class_table(cross_type)
+    ambiguous = np.count_nonzero(table, axis=2) > 1
+    fixed_k = _expected_recombinants(table, np.array(0.25))
+    n_markers = genotypes.shape[1]
+
+    # Genotype indicators, one (n, m) matrix per code; float32 counts are exact below 2**24
+    indicators = np.stack([(genotypes == g) for g in range(n_states)]).astype(np.float32)
+
+    rf = np.full((n_markers, n_markers), 0.5, dtype=np.float32)
+    lod = np.zeros((n_markers, n_markers), dtype=np.float32)
+    informative = np.zeros((n_markers, n_markers), dtype=np.int32)
+
+    for start in range(0, n_markers, _PAIR_TILE):
+        stop = min(start + _PAIR_TILE, n_markers)
+        # counts[g, h, a, b] = individuals with genotype g at marker a and h at
+        # marker b; only columns from the tile onwards, the rest is mirrored
+        tile = indicators[:, :, start:stop].transpose(0, 2, 1)
+        counts = np.matmul(tile[:, None], indicators[None, :, :, start:]).astype(np.float64)
+        total = counts.sum(axis=(0, 1))
+        # Only classes reachable with different recombinant counts (the F2
+        # double heterozygote) need EM; the rest contribute a fixed count
+        fixed = (counts[~ambiguous] * fixed_k[~ambiguous][:, None, None]).sum(axis=0)
+        ambiguous_counts = counts[ambiguous]
+        r = np.full(total.shape, 0.25)
+        for _ in range(_PAIR_EM_ITERATIONS):
+            expected = fixed
+            for counts_c, table_c in zip(ambiguous_counts, table[ambiguous]):
+                expected = expected + counts_c * _expected_recombinants(table_c[None, None], r)[0, 0]
+            with np.errstate(invalid="ignore", divide="ignore"):
+                r_new = np.where(total > 0, expected / (n_gametes * total), 0.5)
+            r_new = np.clip(r_new, _MIN_RF, 0.5)
+            converged = np.max(np.abs(r_new - r)) < 1e-7
+            r = r_new
+            if converged:
+                break
+        with np.errstate(divide="ignore"):
+            log_fit = (counts * np.log10(np.maximum(_class_likelihood(table, r), 1e-300))).sum(axis=(0, 1))
+            log_null = (counts * np.log10(np.maximum(_class_likelihood(table, np.full_like(r, 0.5)), 1e-300))).sum(axis=(0, 1))
+        for matrix, values in ((rf, r), (lod, np.maximum(log_fit - log_null, 0.0)), (informative, total)):
+            matrix[start:stop, start:] = values
+            matrix[start:, start:stop] = values.T
+
+    np.fill_diagonal(rf, 0.0)
+    np.fill_diagonal(lod, 0.0)
+    return {"rf": rf, "lod": lod, "n_informative": informative}
+
+
+class _UnionFind:
+    def __init__(self, size: int):
+        self.parent = list(range(size))
+        self.rank = [0] * size
+
+    def find(self, x: int) -> int:
+        while self.parent[x] != x:
+            self.parent[x] = self.parent[self.parent[x]]
+            x = self.parent[x]
+        return x
+
+    def union(self, a: int, b: int) -> None:
+        ra, rb = self.find(a), self.find(b)
+        if ra == rb:
+            return
+        if self.rank[ra] < self.rank[rb]:
+            ra, rb = rb, ra
+        self.parent[rb] = ra
+        if self.rank[ra] == self.rank[rb]:
+            self.rank[ra] += 1
+
+
+def linkage_groups(rf: np.ndarray, lod: np.ndarray, lod_threshold: float, max_rf: float) -> List[List[int]]:
+    """Connected components of the 'linked' graph, largest group first."""
+    n = rf.shape[0]
+    uf = _UnionFind(n)
+    rows, cols = np.nonzero(np.triu((lod >= lod_threshold) & (rf <= max_rf), k=1))
+    for a, b in zip(rows.tolist(), cols.tolist()):
+        uf.union(a, b)
+    groups: Dict[int, List[int]] = {}
+    for marker in range(n):
+        groups.setdefault(uf.find(marker), []).append(marker)
+    return sorted(groups.values(), key=lambda g: (-len(g), g[0]))
+
+
+def order_markers(distance: np.ndarray) -> List[int]:
+    """
+    Shortest open path through all markers of a group: nearest-neighbour tour
+    from a path end (double sweep), improved by 2-opt until no move helps.
+    """
+    m = distance.shape[0]
+    if m <= 2:
+        return list(range(m))
+    start = int(np.argmax(distance[int(np.argmax(distance[0]))]))
+    start = int(np.argmax(distance[start]))
+    path = [start]
+    visited = np.zeros(m, dtype=bool)
+    visited[start] = True
+    for _ in range(m - 1):
+        row = np.where(visited, np.inf, distance[path[-1]])
+        nxt = int(np.argmin(row))
+        path.append(nxt)
+        visited[nxt] = True
+
+    path_arr = np.array(path)
+    improved = True
+    while improved:
+        improved = False
+        for i in range(m - 1):
+            # Reverse path[i..j] for every j > i at once
+            j = np.arange(i + 1, m)
+            before = distance[path_arr[i - 1], path_arr[i]] if i > 0 else 0.0
+            new_before = distance[path_arr[i - 1], path_arr[j]] if i > 0 else np.zeros(j.size)
+            after = np.where(j + 1 < m, distance[path_arr[j], path_arr[np.minimum(j + 1, m - 1)]], 0.0)
+            new_after = np.where(j + 1 < m, distance[path_arr[i], path_arr[np.minimum(j + 1, m - 1)]], 0.0)
+            delta = new_before + new_after - before - after
+            best = int(np.argmin(delta))
+            if delta[best] < -1e-9:
+                path_arr[i:j[best] + 1] = path_arr[i:j[best] + 1][::-1].copy()
+                improved = True
+    return path_arr.tolist()
+
+
+def _interval_recombinations(r: float, cross_type: str) -> np.ndarray:
+    """Expected recombinant gametes for each genotype transition g -> h."""
+    if cross_type == "backcross":
+        return np.array([[0.0, 1.0], [1.0, 0.0]])
+    s = 1.0 - r
+    double = 2.0 * r * r / (s * s + r * r)
+    return np.array([[0.0, 1.0, 2.0], [1.0, double, 1.0], [2.0, 1.0, 0.0]])
+
+
+def refine_map(
+    genotypes: np.ndarray,
+    rf: np.ndarray,
+    cross_type: str,
+    error_prob: float = 1e-4,
+    max_iterations: int = 100,
+    tolerance: float = 1e-6,
+) -> Dict[str, Any]:
+    """
+    Multipoint EM for the recombination fractions between adjacent markers.
+
+    Args:
+        genotypes: (n_individuals, k) codes for the ordered markers of one group
+        rf: Starting recombination fractions, length k - 1
+        cross_type: "f2" or "backcross"
+        error_prob: Genotyping error rate
+        max_iterations: EM iteration cap
+        tolerance: Stop when no interval moves more than this
+
+    Returns:
+        Dict with refined ``rf``, ``log10_likelihood`` and ``iterations``
+    """
+    n_states = _N_STATES[cross_type]
+    n_gametes = n_states - 1
+    n, k = genotypes.shape
+    emissions = [_emission(genotypes[:, j], n_states, error_prob) for j in range(k)]
+    r = np.clip(np.asarray(rf, dtype=np.float64), _MIN_RF, 0.5 - _MIN_RF)
+    log_likelihood = -np.inf
+    iterations = 0
+
+    for iterations in range(1, max_iterations + 1):
+        transitions = [_transition(float(rj), cross_type) for rj in r]
+        alpha = np.empty((k, n, n_states))
+        scale = np.empty((k, n))
+        a = _PRIOR[cross_type][None, :] * emissions[0]
+        scale[0] = a.sum(axis=1)
+        alpha[0] = a / scale[0][:, None]
+        for j in range(1, k):
+            a = (alpha[j - 1] @ transitions[j - 1]) * emissions[j]
+            scale[j] = a.sum(axis=1)
+            alpha[j] = a / scale[j][:, None]
+        log_likelihood = float(np.log10(scale).sum())
+
+        beta = np.ones((n, n_states))
+        r_new = np.empty_like(r)
+        for j in range(k - 2, -1, -1):
+            eb = emissions[j + 1] * beta
+            # xi[i, g, h] = P(g at j, h at j + 1 | data)
+            xi = alpha[j][:, :, None] * transitions[j][None] * eb[:, None, :]
+            xi /= xi.sum(axis=(1, 2), keepdims=True)
+            recombinations = (xi * _interval_recombinations(float(r[j]), cross_type)[None]).sum()
+            r_new[j] = recombinations / (n_gametes * n)
+            beta = eb @ transitions[j].T
+            beta /= beta.sum(axis=1, keepdims=True)
+
+        r_new = np.clip(r_new, _MIN_RF, 0.5 - _MIN_RF)
+        converged = np.max(np.abs(r_new - r)) < tolerance if r.size else True
+        r = r_new
+        if converged:
+            break
+
+    return {"rf": r, "log10_likelihood": log_likelihood, "iterations": iterations}
+
+
+def build_linkage_map(
+    cross_type: str,
+    marker_names: Sequence[str],
+    genotypes: Sequence[Sequence[int]],
+    lod_threshold: float = 3.0,
+    max_rf: float = 0.35,
+    map_function: str = "haldane",
+    error_prob: float = 1e-4,
+    refine: bool = True,
+    include_pairwise: bool = False,
+) -> Dict[str, Any]:
+    """
+    Estimate a genetic linkage map from marker genotypes.
+
+    Args:
+        cross_type: "f2" or "backcross"
+        marker_names: One name per genotype column
+        genotypes: Per individual marker codes (0=AA, 1=AB, 2=BB, -1=missing)
+        lod_threshold: Minimum two-point LOD for two markers to be linked
+        max_rf: Maximum two-point recombination fraction for linkage
+        map_function: "haldane" or "kosambi" (for cM positions)
+        error_prob: Genotyping error rate for the multipoint EM
+        refine: Re-estimate adjacent intervals by multipoint EM
+        include_pairwise: Return the pairwise rf / LOD matrices (small maps only)
+
+    Returns:
+        Dict with linkage groups (ordered markers with cM positions), unlinked
+        markers, and ``linkage`` entries usable as cross input
+
+    Raises:
+        ValueError: On inconsistent input or parameters
+    """
+    if cross_type not in CROSS_TYPES:
+        raise ValueError(f"cross_type must be one of {CROSS_TYPES}, got: {cross_type}")
+    if map_function not in MAP_FUNCTIONS:
+        raise ValueError(f"map_function must be one of {MAP_FUNCTIONS}, got: {map_function}")
+    names = [str(name) for name in marker_names]
+    if len(genotypes) * len(names) > MAX_GENOTYPE_CELLS:
+        raise ValueError(f"At most {MAX_GENOTYPE_CELLS} genotype calls (individuals x markers) are supported")
+    G = np.asarray(genotypes, dtype=np.int64)
+    if G.ndim != 2 or G.shape[1] != len(names):
+        raise ValueError(f"genotypes must be (individuals x {len(names)} markers)")
+    if len(set(names)) != len(names):
+        raise ValueError("Marker names must be unique")
+    if len(names) > MAX_MARKERS:
+        raise ValueError(f"At most {MAX_MARKERS} markers are supported, got {len(names)}")
+    if include_pairwise and len(names) > _MAX_PAIRWISE_OUTPUT:
+        raise ValueError(f"Pairwise matrices are only returned for up to {_MAX_PAIRWISE_OUTPUT} markers")
+    if G.max(initial=-1) >= _N_STATES[cross_type] or G.min(initial=0) < -1:
+        raise ValueError(f"Invalid genotype code for a {cross_type} cross")
+
+    pairwise = pairwise_recombination(G, cross_type)
+    rf, lod = pairwise["rf"], pairwise["lod"]
+    distance = r_to_cm(np.minimum(rf, 0.5), map_function)
+
+    groups: List[Dict[str, Any]] = []
+    linkage: List[Dict[str, Any]] = []
+    unlinked: List[str] = []
+    for members in linkage_groups(rf, lod, lod_threshold, max_rf):
+        if len(members) == 1:
+            unlinked.append(names[members[0]])
+            continue
+        members_arr = np.array(members)
+        ordered = members_arr[order_markers(distance[np.ix_(members_arr, members_arr)])]
+        adjacent_rf = rf[ordered[:-1], ordered[1:]].astype(np.float64)
+        log_likelihood: Optional[float] = None
+        iterations = 0
+        if refine:
+            refined = refine_map(G[:, ordered], adjacent_rf, cross_type, error_prob)
+            adjacent_rf = refined["rf"]
+            log_likelihood = refined["log10_likelihood"]
+            iterations = refined["iterations"]
+
+        positions = np.concatenate([[0.0], np.cumsum(r_to_cm(adjacent_rf, map_function))])
+        group_name = f"LG{len(groups) + 1}"
+        intervals = []
+        for j in range(len(ordered) - 1):
+            left, right = names[ordered[j]], names[ordered[j + 1]]
+            intervals.append({
+                "left": left,
+                "right": right,
+                "recombination_fraction": float(adjacent_rf[j]),
+                "lod": float(lod[ordered[j], ordered[j + 1]]),
+            })
+            linkage.append({"genes": [left, right], "recombination_frequency": float(adjacent_rf[j])})
+        groups.append({
+            "name": group_name,
+            "markers": [
+                {"name": names[idx], "position_cm": float(round(pos, 4))}
+                for idx, pos in zip(ordered.tolist(), positions)
+            ],
+            "length_cm": float(positions[-1]),
+            "intervals": intervals,
+            "log10_likelihood": log_likelihood,
+            "em_iterations": iterations,
+        })
+
+    result: Dict[str, Any] = {
+        "cross_type": cross_type,
+        "map_function": map_function,
+        "n_individuals": int(G.shape[0]),
+        "n_markers": len(names),
+        "lod_threshold": lod_threshold,
+        "max_rf": max_rf,
+        "groups": groups,
+        "unlinked": unlinked,
+        "linkage": linkage,
+    }
+    if include_pairwise:
+        result["pairwise"] = {
+            "markers": names,
+            "rf": np.round(rf, 5).tolist(),
+            "lod": np.round(lod, 3).tolist(),
+        }
+    return result
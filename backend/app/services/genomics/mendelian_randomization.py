@@ -0,0 +1,447 @@
+"""
+Mendelian randomisation
+=======================
+Two-sample MR between ingested summary statistics (see ``sumstats``).
+
+Instruments are exposure variants below a p-value threshold, optionally
+LD-clumped against the genotypes of a reference dataset (greedy by p-value,
+as PLINK ``--clump``). Outcome records are harmonised to the exposure effect
+allele with the same rules as sumstats ingestion. Estimators:
+
+- Wald ratio per instrument, with first-order standard errors
+- IVW, fixed and multiplicative random effects, with Cochran's Q
+- MR-Egger regression, with its intercept (directional pleiotropy) and
+  Rücker's Q'
+- weighted median (Bowden et al. 2016)
+- weighted mode (Hartwig et al. 2017)
+
+Median and mode standard errors come from a parametric bootstrap: exposure
+and outcome effects are redrawn from their normal sampling distributions and
+the estimator is rerun on every draw. Resamples are processed in fixed-size
+chunks on the shared genomics compute pool; each chunk draws from its own
+counter-based Philox stream derived from the seed, so results do not depend
+on the thread count or scheduling.
+"""
+
+from __future__ import annotations
+
+import math
+from typing import Any, Callable, Dict, List, Optional, Sequence
+
+import numpy as np
+
+from ...utils.statistics import chi2_sf, t_sf_two_sided
+from ..gwas_catalog_index import position_key
+from .compute_pool import map_tasks
+from .sumstats import SumstatsStore, harmonise
+
+# Bootstrap resamples per RNG stream / thread-pool task
+_BOOTSTRAP_CHUNK = 128
+# Bootstrap rows evaluated together on the weighted-mode density grid
+_MODE_ROWS = 32
+_MODE_GRID = 512
+_Z_95 = 1.959963984540054
+# R's mad() consistency constant
+_MAD_SCALE = 1.4826
+
+
+def _normal_p(z: float) -> float:
+    return math.erfc(abs(z) / math.sqrt(2.0)) if np.isfinite(z) else float("nan")
+
+
+def _estimate(method: str, beta: float, se: float, n_snps: int, p: Optional[float] = None) -> Dict[str, Any]:
+    if p is None:
+        p = _normal_p(beta / se) if se > 0 else float("nan")
+    return {
+        "method": method,
+        "n_snps": n_snps,
+        "beta": float(beta),
+        "se": float(se),
+        "p": float(p),
+        "ci_lower": float(beta - _Z_95 * se),
+        "ci_upper": float(beta + _Z_95 * se),
+    }
+
+
+# ============================================================================
+# Estimators
+# ============================================================================
+
+def ivw(bx: np.ndarray, by: np.ndarray, sey: np.ndarray) -> Dict[str, float]:
+    """Inverse-variance weighted estimate with Cochran's Q."""
+    w = bx ** 2 / sey ** 2
+    ratio = by / bx
+    beta = float(np.sum(w * ratio) / np.sum(w))
+    se_fixed = float(1.0 / math.sqrt(np.sum(w)))
+    k = bx.size
+    q = float(np.sum(w * (ratio - beta) ** 2))
+    phi = q / (k - 1) if k > 1 else 1.0
+    return {
+        "beta": beta,
+        "se_fixed": se_fixed,
+        "se_random": se_fixed * math.sqrt(max(phi, 1.0)),
+        "q": q,
+        "q_df": k - 1,
+        "q_p": chi2_sf(q, k - 1) if k > 1 else float("nan"),
+    }
+
+
+def egger(bx: np.ndarray, by: np.ndarray, sey: np.ndarray) -> Dict[str, float]:
+    """
+    MR-Egger: weighted regression of outcome on exposure effects with an
+    intercept, after orienting every instrument to a positive exposure
+    effect. Standard errors use the residual scale floored at one.
+    """
+    sign = np.where(bx < 0, -1.0, 1.0)
+    x, y = bx * sign, by * sign
+    w = 1.0 / sey ** 2
+    k = x.size
+    design = np.column_stack([np.ones(k), x])
+    xtwx = design.T @ (design * w[:, None])
+    coefficients = np.linalg.solve(xtwx, design.T @ (w * y))
+    residuals = y - design @ coefficients
+    q = float(np.sum(w * residuals ** 2))
+    sigma = math.sqrt(q / (k - 2))
+    covariance = np.linalg.inv(xtwx) * max(sigma, 1.0) ** 2
+    se = np.sqrt(np.diag(covariance))
+    df = k - 2
+    return {
+        "beta": float(coefficients[1]),
+        "se": float(se[1]),
+        "p": t_sf_two_sided(float(coefficients[1] / se[1]), df),
+        "intercept": float(coefficients[0]),
+        "intercept_se": float(se[0]),
+        "intercept_p": t_sf_two_sided(float(coefficients[0] / se[0]), df),
+        "q": q,
+        "q_df": df,
+        "q_p": chi2_sf(q, df),
+    }
+
+
+def weighted_median(ratios: np.ndarray, weights: np.ndarray) -> np.ndarray:
+    """
+    Weighted median of each row of ``ratios`` (Bowden et al. 2016), linearly
+    interpolated between the order statistics around the 50th percentile.
+    """
+    ratios = np.atleast_2d(ratios)
+    order = np.argsort(ratios, axis=1)
+    sorted_ratios = np.take_along_axis(ratios, order, axis=1)
+    w = weights[order]
+    w = w / w.sum(axis=1, keepdims=True)
+    percentile = np.cumsum(w, axis=1) - 0.5 * w
+    below = np.clip((percentile < 0.5).sum(axis=1) - 1, 0, ratios.shape[1] - 2)
+    rows = np.arange(ratios.shape[0])
+    lo, hi = sorted_ratios[rows, below], sorted_ratios[rows, below + 1]
+    p_lo, p_hi = percentile[rows, below], percentile[rows, below + 1]
+    return lo + (hi - lo) * (0.5 - p_lo) / (p_hi - p_lo)
+
+
+def _mad(values: np.ndarray, axis: int = -1) -> np.ndarray:
+    median = np.median(values, axis=axis, keepdims=True)
+    return _MAD_SCALE * np.median(np.abs(values - median), axis=axis)
+
+
+def weighted_mode(ratios: np.ndarray, weights: np.ndarray, phi: float = 1.0) -> np.ndarray:
+    """
+    Weighted mode of each row of ``ratios`` (Hartwig et al. 2017): the peak
+    of a weighted normal-kernel density with the modified Silverman
+    bandwidth ``0.9 · min(sd, mad) · k^(-1/5) · phi``.
+    """
+    ratios = np.atleast_2d(ratios)
+    n_rows, k = ratios.shape
+    w = weights / weights.sum()
+    modes = np.empty(n_rows)
+    t = np.linspace(0.0, 1.0, _MODE_GRID)
+    for start in range(0, n_rows, _MODE_ROWS):
+        block = ratios[start:start + _MODE_ROWS]
+        spread = np.minimum(block.std(axis=1, ddof=1), _mad(block, axis=1))
+        h = np.maximum(1e-8, 0.9 * spread * k ** -0.2 * phi)[:, None]
+        lo = block.min(axis=1, keepdims=True) - 3 * h
+        hi = block.max(axis=1, keepdims=True) + 3 * h
+        grid = lo + (hi - lo) * t[None, :]
+        z = (grid[:, :, None] - block[:, None, :]) / h[:, :, None]
+        density = (np.exp(-0.5 * z * z) * w[None, None, :]).sum(axis=2)
+        modes[start:start + _MODE_ROWS] = grid[np.arange(block.shape[0]), density.argmax(axis=1)]
+    return modes
+
+
+def parametric_bootstrap(
+    bx: np.ndarray,
+    sex: np.ndarray,
+    by: np.ndarray,
+    sey: np.ndarray,
+    estimators: Dict[str, Callable[[np.ndarray], np.ndarray]],
+    n_bootstrap: int,
+    seed: Optional[int] = None,
+    workers: Optional[int] = None,
+) -> Dict[str, np.ndarray]:
+    """
+    Bootstrap distributions of ratio-based estimators.
+
+    Every chunk of ``_BOOTSTRAP_CHUNK`` resamples draws from its own Philox
+    stream (spawned from ``seed``) and is evaluated on the shared compute pool.
+
+    Args:
+        estimators: name -> function of an (n_resamples, k) ratio matrix
+            returning one estimate per row
+        workers: Run inline when 1 (default: shared compute pool)
+
+    Returns:
+        name -> (n_bootstrap,) bootstrap estimates
+    """
+    n_chunks = max(1, math.ceil(n_bootstrap / _BOOTSTRAP_CHUNK))
+    streams = np.random.SeedSequence(seed).spawn(n_chunks)
+    results = {name: np.empty(n_bootstrap) for name in estimators}
+
+    def run(chunk: int) -> None:
+        rng = np.random.Generator(np.random.Philox(streams[chunk]))
+        start = chunk * _BOOTSTRAP_CHUNK
+        size = min(_BOOTSTRAP_CHUNK, n_bootstrap - start)
+        bx_draw = bx + sex * rng.standard_normal((size, bx.size))
+        by_draw = by + sey * rng.standard_normal((size, by.size))
+        ratios = by_draw / bx_draw
+        for name, estimator in estimators.items():
+            results[name][start:start + size] = estimator(ratios)
+
+    map_tasks(run, range(n_chunks), workers)
+    return results
+
+
+# ============================================================================
+# Instruments
+# ============================================================================
+
+def clump(
+    chromosome: np.ndarray,
+    position: np.ndarray,
+    p: np.ndarray,
+    panel: Dict[str, Any],
+    r2_threshold: float = 0.001,
+    window_kb: float = 10_000.0,
+) -> Dict[str, np.ndarray]:
+    """
+    Greedy LD clumping: the most significant remaining variant becomes an
+    index variant and removes every variant within ``window_kb`` whose r²
+    with it exceeds ``r2_threshold``. r² comes from the panel dosages and is
+    only computed for pairs within the window, so the work is O(k·w) for k
+    variants with w per window rather than O(k²).
+
+    Args:
+        panel: ``{"keys": sorted position keys, "rows": panel row per key,
+            "dosages": (n_snps, n_samples) dosages}``
+
+    Returns:
+        ``keep`` mask and ``in_panel`` mask over the variants. Variants
+        missing from the panel are kept (they cannot be clumped).
+    """
+    n = p.size
+    keys = position_key(chromosome, position)
+    hit = np.searchsorted(panel["keys"], keys)
+    safe = np.minimum(hit, max(panel["keys"].size - 1, 0))
+    in_panel = (hit < panel["keys"].size) & (panel["keys"][safe] == keys) if panel["keys"].size else np.zeros(n, bool)
+    keep = np.ones(n, dtype=bool)
+
+    for chrom in np.unique(chromosome[in_panel]):
+        idx = np.flatnonzero(in_panel & (chromosome == chrom))
+        idx = idx[np.argsort(p[idx], kind="stable")]
+        dosages = panel["dosages"][panel["rows"][safe[idx]]].astype(np.float64)
+        called = dosages >= 0
+        means = np.where(called, dosages, 0).sum(axis=1) / np.maximum(called.sum(axis=1), 1)
+        centred = np.where(called, dosages - means[:, None], 0.0)
+        norms = np.sqrt((centred ** 2).sum(axis=1))
+        standardised = centred / np.where(norms > 0, norms, 1.0)[:, None]
+
+        # r² only against the still-unclumped variants inside the window of
+        # each index variant, found by binary search over sorted positions
+        by_position = np.argsort(position[idx], kind="stable")
+        sorted_positions = position[idx][by_position]
+        window = window_kb * 1000
+        alive = np.ones(idx.size, dtype=bool)
+        for i in range(idx.size):
+            if not alive[i]:
+                continue
+            lo = np.searchsorted(sorted_positions, position[idx[i]] - window, side="left")
+            hi = np.searchsorted(sorted_positions, position[idx[i]] + window, side="right")
+            neighbours = by_position[lo:hi]
+            neighbours = neighbours[alive[neighbours] & (neighbours != i)]
+            if neighbours.size:
+                r2 = (standardised[neighbours] @ standardised[i]) ** 2
+                alive[neighbours[r2 > r2_threshold]] = False
+        keep[idx[~alive]] = False
+    return {"keep": keep, "in_panel": in_panel}
+
+
+def dataset_panel(user_id: str, dataset_id: str) -> Optional[Dict[str, Any]]:
+    """LD reference panel from a user's processed GWAS dataset, or None if it does not exist."""
+    from app.services.gwas_dataset_service import get_gwas_dataset_service
+
+    data = get_gwas_dataset_service().load_dataset_for_analysis(user_id, dataset_id)
+    if not data:
+        return None
+    return panel_from_snps(data.get("snps", []))
+
+
+def panel_from_snps(snps: Sequence[Dict[str, Any]]) -> Dict[str, Any]:
+    """LD reference panel from processed dataset SNPs."""
+    keys = position_key(
+        np.array([int(s["chromosome"]) for s in snps], dtype=np.int64),
+        np.array([int(s["position"]) for s in snps], dtype=np.int64),
+    )
+    order = np.argsort(keys, kind="stable")
+    return {
+        "keys": keys[order],
+        "rows": order,
+        "dosages": np.array([s.get("genotypes") or [] for s in snps], dtype=np.int8),
+    }
+
+
+# ============================================================================
+# Analysis
+# ============================================================================
+
+def mendelian_randomization(
+    exposure: SumstatsStore,
+    outcome: SumstatsStore,
+    p_threshold: float = 5e-8,
+    panel: Optional[Dict[str, Any]] = None,
+    clump_r2: float = 0.001,
+    clump_kb: float = 10_000.0,
+    n_bootstrap: int = 1000,
+    mode_phi: float = 1.0,
+    palindromic_maf_window: float = 0.08,
+    seed: Optional[int] = None,
+) -> Dict[str, Any]:
+    """
+    Two-sample MR of an exposure on an outcome.
+
+    Args:
+        exposure: Exposure summary statistics
+        outcome: Outcome summary statistics
+        p_threshold: Instrument selection threshold on the exposure p-value
+        panel: LD reference panel for clumping (see ``panel_from_snps``)
+        clump_r2, clump_kb: Clumping r² threshold and window
+        n_bootstrap: Resamples for the median / mode standard errors
+        mode_phi: Bandwidth multiplier of the weighted mode
+        palindromic_maf_window: Ambiguity window for palindromic instruments
+        seed: Bootstrap seed
+
+    Returns:
+        Dict with instrument counts and table, estimates per method,
+        heterogeneity statistics and the Egger intercept
+
+    Raises:
+        ValueError: If fewer than one usable instrument remains
+    """
+    exposure_p = np.asarray(exposure.p)
+    candidates = np.flatnonzero(np.isfinite(exposure_p) & (exposure_p < p_threshold))
+    counts: Dict[str, int] = {"significant": int(candidates.size)}
+    exposure_cols = exposure.columns(candidates)
+    usable = (
+        np.isfinite(exposure_cols["beta"]) & (exposure_cols["beta"] != 0)
+        & np.isfinite(exposure_cols["se"]) & (exposure_cols["se"] > 0)
+    )
+    exposure_cols = {key: values[usable] for key, values in exposure_cols.items()}
+
+    clumped = False
+    if panel is not None and exposure_cols["beta"].size:
+        result = clump(
+            exposure_cols["chromosome"], exposure_cols["position"], exposure_cols["p"],
+            panel, clump_r2, clump_kb,
+        )
+        counts["not_in_panel"] = int((~result["in_panel"]).sum())
+        exposure_cols = {key: values[result["keep"]] for key, values in exposure_cols.items()}
+        clumped = True
+    counts["after_clumping"] = int(exposure_cols["beta"].size)
+
+    # Outcome records at the instrument positions, aligned to the exposure effect allele
+    outcome_rows = outcome.rows_by_position(exposure_cols["chromosome"], exposure_cols["position"])
+    found = outcome_rows >= 0
+    counts["in_outcome"] = int(found.sum())
+    if not found.any():
+        raise ValueError("No instruments are present in the outcome summary statistics")
+    reference = {
+        "chromosome": exposure_cols["chromosome"],
+        "position": exposure_cols["position"],
+        "rsid": exposure_cols["rsid"],
+        "ref_allele": exposure_cols["other_allele"],
+        "alt_allele": exposure_cols["effect_allele"],
+        "alt_frequency": exposure_cols["eaf"],
+    }
+    aligned = harmonise(outcome.columns(outcome_rows[found]), reference, palindromic_maf_window)
+    counts.update({
+        "allele_mismatch": aligned["counts"]["allele_mismatch"],
+        "ambiguous_palindromic": aligned["counts"]["ambiguous_palindromic"],
+    })
+    rows = aligned["reference_row"]
+    bx, sex = exposure_cols["beta"][rows], exposure_cols["se"][rows]
+    by, sey = aligned["beta"], aligned["se"]
+    valid = np.isfinite(by) & np.isfinite(sey) & (sey > 0)
+    rows, bx, sex, by, sey = rows[valid], bx[valid], sex[valid], by[valid], sey[valid]
+    k = bx.size
+    counts["instruments"] = k
+    if k == 0:
+        raise ValueError("No instruments left after harmonising the outcome")
+
+    ratio = by / bx
+    ratio_se = sey / np.abs(bx)
+    instruments = [
+        {
+            "rsid": exposure_cols["rsid"][r].decode() or None,
+            "chromosome": int(exposure_cols["chromosome"][r]),
+            "position": int(exposure_cols["position"][r]),
+            "effect_allele": exposure_cols["effect_allele"][r].decode(),
+            "other_allele": exposure_cols["other_allele"][r].decode(),
+            "beta_exposure": float(bx[i]),
+            "se_exposure": float(sex[i]),
+            "p_exposure": float(exposure_cols["p"][r]),
+            "beta_outcome": float(by[i]),
+            "se_outcome": float(sey[i]),
+            "ratio": float(ratio[i]),
+            "ratio_se": float(ratio_se[i]),
+        }
+        for i, r in enumerate(rows.tolist())
+    ]
+
+    methods: List[Dict[str, Any]] = []
+    heterogeneity: Dict[str, Any] = {}
+    pleiotropy: Optional[Dict[str, float]] = None
+    if k == 1:
+        methods.append(_estimate("wald_ratio", ratio[0], ratio_se[0], 1))
+    else:
+        fit = ivw(bx, by, sey)
+        methods.append(_estimate("ivw_fixed", fit["beta"], fit["se_fixed"], k))
+        methods.append(_estimate("ivw_random", fit["beta"], fit["se_random"], k))
+        heterogeneity["ivw"] = {"q": fit["q"], "df": fit["q_df"], "p": fit["q_p"]}
+
+    if k >= 3:
+        fit = egger(bx, by, sey)
+        methods.append(_estimate("egger", fit["beta"], fit["se"], k, fit["p"]))
+        heterogeneity["egger"] = {"q": fit["q"], "df": fit["q_df"], "p": fit["q_p"]}
+        pleiotropy = {"intercept": fit["intercept"], "se": fit["intercept_se"], "p": fit["intercept_p"]}
+
+        weights = 1.0 / ratio_se ** 2
+        median = float(weighted_median(ratio[None, :], weights)[0])
+        mode = float(weighted_mode(ratio[None, :], weights, mode_phi)[0])
+        boot = parametric_bootstrap(
+            bx, sex, by, sey,
+            {
+                "weighted_median": lambda r: weighted_median(r, weights),
+                "weighted_mode": lambda r: weighted_mode(r, weights, mode_phi),
+            },
+            n_bootstrap, seed,
+        )
+        methods.append(_estimate("weighted_median", median, float(np.std(boot["weighted_median"], ddof=1)), k))
+        methods.append(_estimate("weighted_mode", mode, float(_mad(boot["weighted_mode"])), k))
+
+    return {
+        "exposure": exposure.meta.get("name"),
+        "outcome": outcome.meta.get("name"),
+        "p_threshold": p_threshold,
+        "clumped": clumped,
+        "n_bootstrap": n_bootstrap if k >= 3 else 0,
+        "counts": counts,
+        "methods": methods,
+        "heterogeneity": heterogeneity,
+        "egger_intercept": pleiotropy,
+        "instruments": instruments,
+    }
@@ -0,0 +1,358 @@
+"""
+QTL interval mapping
+====================
+Haley–Knott regression for F2 intercross and backcross populations.
+
+1. Genotype probabilities are computed on a grid of pseudo-markers along
+   each chromosome with a forward–backward HMM over the marker genotypes
+   (with a small genotyping error rate), vectorised over individuals.
+2. At every grid position the phenotype is regressed on the expected
+   genotype codes (additive ``P(BB) - P(AA)`` and dominance ``P(AB)`` for
+   an F2, ``P(AB)`` for a backcross) plus any additive covariates.
+3. All positions and all permutation replicates are fitted in one batched
+   normal-equation pass: the observed phenotype and its permutations are the
+   columns of one matrix, so the genome-wide permutation maxima (and hence
+   the LOD thresholds) fall out of the same GEMMs as the observed scan.
+
+Genotype codes follow the dosage convention: 0 = AA, 1 = AB, 2 = BB (F2
+only), -1 = missing.
+"""
+
+from __future__ import annotations
+
+import math
+from dataclasses import dataclass
+from typing import Any, Dict, List, Optional, Sequence
+
+import numpy as np
+
+from .genetic_map import MAP_FUNCTIONS, cm_to_r
+
+CROSS_TYPES = ("f2", "backcross")
+_N_STATES = {"f2": 3, "backcross": 2}
+_PRIOR = {"f2": np.array([0.25, 0.5, 0.25]), "backcross": np.array([0.5, 0.5])}
+
+# Permutation columns fitted per batch (bounds the positions x columns workspace)
+_PERMUTATION_BLOCK = 256
+MAX_PERMUTATIONS = 10_000
+# Input and work caps for a synchronous request: individuals x markers, and
+# grid positions x individuals x (permutations + 1) fitted columns
+MAX_GENOTYPE_CELLS = 10_000_000
+MAX_SCAN_WORK = 2_000_000_000
+LOD_DROP = 1.5
+
+
+@dataclass
+class Chromosome:
+    name: str
+    marker_names: List[str]
+    positions_cm: np.ndarray
+
+
+def _transition(r: float, cross_type: str) -> np.ndarray:
+    """Genotype transition matrix between loci at recombination fraction r."""
+    s = 1.0 - r
+    if cross_type == "backcross":
+        return np.array([[s, r], [r, s]])
+    return np.array([
+        [s * s, 2 * r * s, r * r],
+        [r * s, s * s + r * r, r * s],
+        [r * r, 2 * r * s, s * s],
+    ])
+
+
+def _emission(observed: np.ndarray, n_states: int, error_prob: float) -> np.ndarray:
+    """P(observed code | true genotype) for each individual, shape (n, states)."""
+    n = observed.shape[0]
+    emit = np.full((n, n_states), error_prob / max(n_states - 1, 1))
+    known = (observed >= 0) & (observed < n_states)
+    emit[known, observed[known]] = 1.0 - error_prob
+    emit[~known] = 1.0
+    return emit
+
+
+def _grid(positions: np.ndarray, step_cm: float) -> np.ndarray:
+    """Marker positions plus pseudo-markers every ``step_cm`` (merged, sorted)."""
+    if step_cm <= 0 or positions.size == 0:
+        return positions.copy()
+    pseudo = np.arange(positions[0], positions[-1] + 1e-9, step_cm)
+    merged = np.union1d(np.round(positions, 6), np.round(pseudo, 6))
+    return merged
+
+
+def genotype_probabilities(
+    genotypes: np.ndarray,
+    marker_positions: np.ndarray,
+    grid_positions: np.ndarray,
+    cross_type: str,
+    map_function: str = "haldane",
+    error_prob: float = 1e-4,
+) -> np.ndarray:
+    """
+    Posterior genotype probabilities at each grid position (forward–backward).
+
+    Args:
+        genotypes: (n_individuals, n_markers) codes for one chromosome
+        marker_positions: Marker positions in cM (sorted)
+        grid_positions: Evaluation positions in cM (sorted, includes markers)
+        cross_type: "f2" or "backcross"
+        map_function: "haldane" or "kosambi"
+        error_prob: Genotyping error rate
+
+    Returns:
+        (n_individuals, n_grid, n_states) array of probabilities
+    """
+    n_states = _N_STATES[cross_type]
+    n = genotypes.shape[0]
+    n_grid = grid_positions.size
+
+    # Emissions on the grid: markers emit, pseudo-markers are uninformative
+    marker_index = np.searchsorted(grid_positions, np.round(marker_positions, 6))
+    emissions = np.ones((n_grid, n, n_states))
+    for j, g in enumerate(marker_index):
+        emissions[g] *= _emission(genotypes[:, j], n_states, error_prob)
+
+    r = cm_to_r(np.diff(grid_positions), map_function)
+    transitions = [_transition(float(rk), cross_type) for rk in r]
+
+    alpha = np.empty((n_grid, n, n_states))
+    a = _PRIOR[cross_type][None, :] * emissions[0]
+    alpha[0] = a / a.sum(axis=1, keepdims=True)
+    for k in range(1, n_grid):
+        a = (alpha[k - 1] @ transitions[k - 1]) * emissions[k]
+        alpha[k] = a / a.sum(axis=1, keepdims=True)
+
+    probs = np.empty((n, n_grid, n_states))
+    beta = np.ones((n, n_states))
+    probs[:, -1] = alpha[-1]
+    for k in range(n_grid - 2, -1, -1):
+        beta = (emissions[k + 1] * beta) @ transitions[k].T
+        beta /= beta.sum(axis=1, keepdims=True)
+        post = alpha[k] * beta
+        probs[:, k] = post / post.sum(axis=1, keepdims=True)
+    return probs
+
+
+def _design_codes(probs: np.ndarray, cross_type: str) -> np.ndarray:
+    """Expected genotype codes per position, shape (n_grid, n, k)."""
+    if cross_type == "backcross":
+        return probs[:, :, 1:2].transpose(1, 0, 2)
+    additive = probs[:, :, 2] - probs[:, :, 0]
+    dominance = probs[:, :, 1]
+    return np.stack([additive, dominance], axis=2).transpose(1, 0, 2)
+
+
+def _scan_rss(codes: np.ndarray, base: np.ndarray, Y: np.ndarray) -> np.ndarray:
+    """
+    Residual sum of squares of ``Y[:, m] ~ base + codes[g]`` for every
+    position g and column m, by batched normal equations.
+
+    Returns:
+        (n_grid, m) RSS matrix
+    """
+    n_grid, n, k = codes.shape
+    q = base.shape[1]
+    X = np.concatenate([np.broadcast_to(base, (n_grid, n, q)), codes], axis=2)
+    XtX = np.einsum("gni,gnj->gij", X, X)
+    # One GEMM for every position and every phenotype column
+    XtY = (X.transpose(0, 2, 1).reshape(n_grid * (q + k), n) @ Y).reshape(n_grid, q + k, -1)
+    coef = np.linalg.solve(XtX + 1e-10 * np.eye(q + k), XtY)
+    return np.maximum((Y * Y).sum(axis=0)[None, :] - np.einsum("gpm,gpm->gm", XtY, coef), 0.0)
+
+
+def _null_rss(base: np.ndarray, Y: np.ndarray) -> np.ndarray:
+    coef, *_ = np.linalg.lstsq(base, Y, rcond=None)
+    resid = Y - base @ coef
+    return (resid * resid).sum(axis=0)
+
+
+def _lod(rss0: np.ndarray, rss1: np.ndarray, n: int) -> np.ndarray:
+    with np.errstate(divide="ignore", invalid="ignore"):
+        lod = (n / 2.0) * np.log10(rss0 / rss1)
+    return np.nan_to_num(np.maximum(lod, 0.0), nan=0.0, posinf=0.0)
+
+
+def scan_qtl(
+    cross_type: str,
+    chromosomes: Sequence[Dict[str, Any]],
+    genotypes: Sequence[Sequence[int]],
+    phenotypes: Sequence[Optional[float]],
+    covariates: Optional[Sequence[Sequence[float]]] = None,
+    step_cm: float = 1.0,
+    map_function: str = "haldane",
+    error_prob: float = 1e-4,
+    n_permutations: int = 1000,
+    alphas: Sequence[float] = (0.05, 0.01),
+    seed: Optional[int] = None,
+) -> Dict[str, Any]:
+    """
+    Genome scan by Haley–Knott regression with permutation thresholds.
+
+    Args:
+        cross_type: "f2" or "backcross"
+        chromosomes: [{"name", "markers": [{"name", "position_cm"}]}] in column order
+        genotypes: Per individual, codes for every marker across all chromosomes
+        phenotypes: One value per individual (None = missing, dropped)
+        covariates: Optional additive covariates per individual
+        step_cm: Pseudo-marker spacing (0 = markers only)
+        map_function: "haldane" or "kosambi"
+        error_prob: Genotyping error rate for the HMM
+        n_permutations: Permutation replicates for genome-wide thresholds (0 = none)
+        alphas: Genome-wide significance levels to report thresholds for
+        seed: RNG seed for the permutations
+
+    Returns:
+        Dict with per-chromosome LOD profiles, peaks, thresholds and summary
+
+    Raises:
+        ValueError: On inconsistent input shapes or parameters
+    """
+    if cross_type not in CROSS_TYPES:
+        raise ValueError(f"cross_type must be one of {CROSS_TYPES}, got: {cross_type}")
+    if map_function not in MAP_FUNCTIONS:
+        raise ValueError(f"map_function must be one of {MAP_FUNCTIONS}, got: {map_function}")
+    if not 0 <= n_permutations <= MAX_PERMUTATIONS:
+        raise ValueError(f"n_permutations must be between 0 and {MAX_PERMUTATIONS}")
+    if not 0.0 <= error_prob < 0.5:
+        raise ValueError("error_prob must be in [0, 0.5)")
+
+    chroms: List[Chromosome] = []
+    for chrom in chromosomes:
+        markers = sorted(chrom.get("markers", []), key=lambda m: float(m["position_cm"]))
+        if not markers:
+            raise ValueError(f"Chromosome {chrom.get('name')} has no markers")
+        chroms.append(Chromosome(
+            name=str(chrom["name"]),
+            marker_names=[str(m["name"]) for m in markers],
+            positions_cm=np.array([float(m["position_cm"]) for m in markers]),
+        ))
+    # Column order follows the markers as given, before sorting by position
+    column_order: List[np.ndarray] = []
+    offset = 0
+    for chrom in chromosomes:
+        markers = chrom.get("markers", [])
+        order = np.argsort([float(m["position_cm"]) for m in markers], kind="stable")
+        column_order.append(offset + order)
+        offset += len(markers)
+
+    if len(genotypes) * offset > MAX_GENOTYPE_CELLS:
+        raise ValueError(f"At most {MAX_GENOTYPE_CELLS} genotype calls (individuals x markers) are supported")
+    G = np.asarray(genotypes, dtype=np.int64)
+    if G.ndim != 2 or G.shape[1] != offset:
+        raise ValueError(f"genotypes must be (individuals x {offset} markers)")
+    y = np.array([np.nan if v is None else float(v) for v in phenotypes])
+    if y.shape[0] != G.shape[0]:
+        raise ValueError("phenotypes must have one value per individual")
+    if cross_type == "backcross" and (G > 1).any():
+        raise ValueError("Backcross genotypes must be 0 (AA), 1 (AB) or -1 (missing)")
+
+    keep = ~np.isnan(y)
+    base = np.ones((G.shape[0], 1))
+    if covariates is not None:
+        Z = np.asarray(covariates, dtype=np.float64)
+        if Z.ndim != 2 or Z.shape[0] != G.shape[0]:
+            raise ValueError("covariates must be (individuals x covariates)")
+        keep &= ~np.isnan(Z).any(axis=1)
+        base = np.column_stack([base, Z])
+    G, y, base = G[keep], y[keep], base[keep]
+    n = y.shape[0]
+    if n < base.shape[1] + 3:
+        raise ValueError("Not enough phenotyped individuals for a scan")
+    grids = [_grid(chrom.positions_cm, step_cm) for chrom in chroms]
+    if sum(len(grid) for grid in grids) * n * (n_permutations + 1) > MAX_SCAN_WORK:
+        raise ValueError(
+            "Scan too large (grid positions x individuals x permutations); "
+            "increase step_cm or reduce n_permutations"
+        )
+
+    # Freedman–Lane permutations: permute null-model residuals, add back fitted values.
+    # Each block is regenerated from its own seed on every chromosome, so all
+    # chromosomes see the same permutations without holding them all at once.
+    null_coef, *_ = np.linalg.lstsq(base, y, rcond=None)
+    fitted = base @ null_coef
+    residuals = y - fitted
+    block_seeds = np.random.SeedSequence(seed).spawn(math.ceil(n_permutations / _PERMUTATION_BLOCK))
+
+    profiles: List[Dict[str, Any]] = []
+    observed_lod: List[np.ndarray] = []
+    perm_max = np.zeros(n_permutations)
+    rss0_obs = _null_rss(base, y[:, None])
+
+    for chrom, columns, grid in zip(chroms, column_order, grids):
+        probs = genotype_probabilities(
+            G[:, columns], chrom.positions_cm, grid, cross_type, map_function, error_prob
+        )
+        codes = _design_codes(probs, cross_type)
+
+        lod = _lod(rss0_obs, _scan_rss(codes, base, y[:, None]), n)[:, 0]
+        observed_lod.append(lod)
+
+        for block, block_seed in enumerate(block_seeds):
+            start = block * _PERMUTATION_BLOCK
+            width = min(_PERMUTATION_BLOCK, n_permutations - start)
+            shuffled = np.random.default_rng(block_seed).permuted(np.tile(residuals[:, None], (1, width)), axis=0)
+            Y = fitted[:, None] + shuffled
+            perm_lod = _lod(_null_rss(base, Y), _scan_rss(codes, base, Y), n)
+            np.maximum(perm_max[start:start + Y.shape[1]], perm_lod.max(axis=0),
+                       out=perm_max[start:start + Y.shape[1]])
+
+        marker_at = {round(p, 6): name for p, name in zip(chrom.positions_cm, chrom.marker_names)}
+        labels = [marker_at.get(round(p, 6), f"c{chrom.name}.loc{p:g}") for p in grid]
+        peak = int(np.argmax(lod))
+        X_peak = np.column_stack([base, codes[peak]])
+        coef, *_ = np.linalg.lstsq(X_peak, y, rcond=None)
+
+        support = np.flatnonzero(lod >= lod[peak] - LOD_DROP)
+        # Support interval: contiguous run around the peak above the drop
+        left = peak
+        while left - 1 in support:
+            left -= 1
+        right = peak
+        while right + 1 in support:
+            right += 1
+
+        peak_info = {
+            "position_cm": float(grid[peak]),
+            "locus": labels[peak],
+            "lod": float(lod[peak]),
+            "support_interval_cm": [float(grid[left]), float(grid[right])],
+            "additive_effect": float(coef[base.shape[1]]),
+            "dominance_effect": float(coef[base.shape[1] + 1]) if cross_type == "f2" else None,
+        }
+        profiles.append({
+            "chromosome": chrom.name,
+            "positions_cm": grid.round(4).tolist(),
+            "loci": labels,
+            "lod": lod.round(4).tolist(),
+            "peak": peak_info,
+        })
+
+    thresholds: Dict[str, float] = {}
+    if n_permutations:
+        sorted_max = np.sort(perm_max)
+        for alpha in alphas:
+            thresholds[f"{alpha:g}"] = float(np.quantile(sorted_max, 1.0 - alpha))
+
+    genome_max = max(float(lod.max()) for lod in observed_lod)
+    for profile in profiles:
+        peak_lod = profile["peak"]["lod"]
+        profile["peak"]["genome_wide_p"] = (
+            float((1 + np.sum(perm_max >= peak_lod)) / (1 + n_permutations)) if n_permutations else None
+        )
+
+    return {
+        "cross_type": cross_type,
+        "map_function": map_function,
+        "n_individuals": int(n),
+        "n_markers": int(offset),
+        "n_positions": int(sum(len(p["positions_cm"]) for p in profiles)),
+        "n_permutations": int(n_permutations),
+        "thresholds": thresholds,
+        "max_lod": genome_max,
+        "chromosomes": profiles,
+        "significant_peaks": [
+            {"chromosome": p["chromosome"], **p["peak"]}
+            for p in profiles
+            if thresholds and p["peak"]["lod"] >= thresholds.get(f"{alphas[0]:g}", math.inf)
+        ],
+    }
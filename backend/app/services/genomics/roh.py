@@ -0,0 +1,292 @@
+"""
+Runs of homozygosity
+====================
+Per-sample ROH detection and inbreeding coefficients for a genotype dataset.
+
+Genotypes are scanned sample-major: the SNP-major dosage matrix of each
+chromosome is transposed in blocks of samples into heterozygosity and
+missingness masks, and every sample of a block is scanned at once.
+
+ROH calling follows the PLINK ``--homozyg`` window scan. A window of
+``window_snps`` consecutive SNPs is homozygous when it holds at most
+``window_max_het`` heterozygous and ``window_max_missing`` missing calls and
+no gap longer than ``max_gap_kb``. SNPs covered by at least one homozygous
+window form candidate runs; a run is kept when it has at least ``min_snps``
+SNPs, spans ``min_length_kb`` and is no sparser than ``max_kb_per_snp``.
+Window and run counts are differences of cumulative sums, and run edges are
+the set bits of the mask differences, so no per-SNP loop is needed.
+
+Inbreeding coefficients (autosomes only):
+
+- ``f_roh``: total ROH length / autosomal length spanned by the SNPs
+- ``f_hom``: (observed - expected homozygotes) / (called - expected), the
+  PLINK ``--het`` method-of-moments estimate
+- ``f_grm``: diagonal of the genomic relationship matrix minus one (GCTA Fhat1)
+"""
+
+from __future__ import annotations
+
+from typing import Any, Dict, List, Optional, Sequence
+
+import numpy as np
+
+from .dataset_cache import DatasetResultCache, dataset_sample_ids
+
+# Samples transposed and scanned together
+_SAMPLE_BLOCK = 1024
+AUTOSOMES = range(1, 23)
+
+
+def _window_sums(mask: np.ndarray, window: int) -> np.ndarray:
+    """Sums of ``mask`` over every window of ``window`` SNPs, per row."""
+    cumulative = np.zeros((mask.shape[0], mask.shape[1] + 1), dtype=np.int32)
+    np.cumsum(mask, axis=1, out=cumulative[:, 1:])
+    return cumulative[:, window:] - cumulative[:, :-window]
+
+
+def scan_runs(
+    dosages: np.ndarray,
+    positions: np.ndarray,
+    window_snps: int = 50,
+    window_max_het: int = 1,
+    window_max_missing: int = 5,
+    max_gap_kb: float = 1000.0,
+    min_snps: int = 100,
+    min_length_kb: float = 1000.0,
+    max_kb_per_snp: float = 50.0,
+) -> List[List[Dict[str, Any]]]:
+    """
+    ROH segments of every sample on one chromosome.
+
+    Args:
+        dosages: (n_snps, n_samples) dosages sorted by position, -1 = missing
+        positions: Base-pair positions of the SNPs
+        window_snps: Scanning window size
+        window_max_het: Heterozygous calls allowed per window
+        window_max_missing: Missing calls allowed per window
+        max_gap_kb: Runs never span a larger gap between adjacent SNPs
+        min_snps: Minimum SNPs per run
+        min_length_kb: Minimum run length
+        max_kb_per_snp: Minimum run density (kb per SNP)
+
+    Returns:
+        Per sample, the list of runs (SNP index range, bp range, het/missing counts)
+    """
+    m, n = dosages.shape
+    runs: List[List[Dict[str, Any]]] = [[] for _ in range(n)]
+    window = min(window_snps, m)
+    if m == 0 or window == 0:
+        return runs
+
+    # Windows spanning a large gap are never homozygous
+    gap = np.zeros((1, m), dtype=np.int32)
+    gap[0, 1:] = np.diff(positions) > max_gap_kb * 1000
+    window_gaps = _window_sums(gap, window)[0] - gap[0, :m - window + 1]
+    window_gap_free = window_gaps == 0
+
+    for block in range(0, n, _SAMPLE_BLOCK):
+        # Blocked SNP-major -> sample-major transpose of the call masks
+        sample_major = np.ascontiguousarray(dosages[:, block:block + _SAMPLE_BLOCK].T)
+        het = sample_major == 1
+        missing = sample_major < 0
+
+        homozygous_window = (
+            (_window_sums(het, window) <= window_max_het)
+            & (_window_sums(missing, window) <= window_max_missing)
+            & window_gap_free[None, :]
+        )
+        # SNP j is covered when some homozygous window starting in [j - window + 1, j] exists
+        covered = _window_sums(
+            np.pad(homozygous_window, ((0, 0), (window - 1, window - 1))), window
+        ) > 0
+        # Adjacent covered SNPs across a large gap belong to different runs
+        covered_prev = np.pad(covered, ((0, 0), (1, 0)))[:, :-1] & ~gap[0].astype(bool)[None, :]
+        starts = covered & ~covered_prev
+        covered_next = np.pad(covered, ((0, 0), (0, 1)))[:, 1:] & ~np.append(gap[0, 1:], 1).astype(bool)[None, :]
+        ends = covered & ~covered_next
+
+        het_cum = np.zeros((het.shape[0], m + 1), dtype=np.int32)
+        np.cumsum(het, axis=1, out=het_cum[:, 1:])
+        missing_cum = np.zeros_like(het_cum)
+        np.cumsum(missing, axis=1, out=missing_cum[:, 1:])
+
+        start_rows, start_cols = np.nonzero(starts)
+        end_rows, end_cols = np.nonzero(ends)
+        # Both are row-major, so the k-th start pairs with the k-th end
+        for row, first, last in zip(start_rows.tolist(), start_cols.tolist(), end_cols.tolist()):
+            # Trim heterozygous / missing calls off the run ends
+            while first <= last and (het[row, first] or missing[row, first]):
+                first += 1
+            while last >= first and (het[row, last] or missing[row, last]):
+                last -= 1
+            n_snps = last - first + 1
+            if n_snps < max(min_snps, 1):
+                continue
+            length_kb = (positions[last] - positions[first]) / 1000.0
+            if length_kb < min_length_kb or length_kb / n_snps > max_kb_per_snp:
+                continue
+            runs[block + row].append({
+                "start_index": first,
+                "end_index": last,
+                "start_position": int(positions[first]),
+                "end_position": int(positions[last]),
+                "length_kb": float(length_kb),
+                "n_snps": n_snps,
+                "n_het": int(het_cum[row, last + 1] - het_cum[row, first]),
+                "n_missing": int(missing_cum[row, last + 1] - missing_cum[row, first]),
+            })
+    return runs
+
+
+def inbreeding_moments(dosages: np.ndarray) -> Dict[str, np.ndarray]:
+    """
+    Per-sample F_hom and F_grm from (n_snps, n_samples) autosomal dosages.
+
+    Monomorphic SNPs carry no information and are skipped.
+    """
+    called = dosages >= 0
+    x = np.where(called, dosages, 0).astype(np.float64)
+    n_called_snp = called.sum(axis=1)
+    p = x.sum(axis=1) / np.maximum(2 * n_called_snp, 1)
+    informative = (p > 0) & (p < 1)
+    x, called, p = x[informative], called[informative], p[informative][:, None]
+    het_expected = 2 * p * (1 - p)
+
+    n_called = called.sum(axis=0)
+    observed_hom = (called & (x != 1)).sum(axis=0)
+    expected_hom = ((1 - het_expected) * called).sum(axis=0)
+    with np.errstate(invalid="ignore", divide="ignore"):
+        f_hom = (observed_hom - expected_hom) / (n_called - expected_hom)
+        grm_diagonal = (((x - 2 * p) ** 2 / het_expected) * called).sum(axis=0) / n_called
+    return {
+        "n_called": n_called,
+        "observed_hom": observed_hom,
+        "expected_hom": expected_hom,
+        "f_hom": f_hom,
+        "f_grm": grm_diagonal - 1.0,
+    }
+
+
+def _finite(value: float) -> Optional[float]:
+    return float(value) if np.isfinite(value) else None
+
+
+def scan_dataset_roh(
+    snps: Sequence[Dict[str, Any]],
+    samples: Sequence[str],
+    window_snps: int = 50,
+    window_max_het: int = 1,
+    window_max_missing: int = 5,
+    max_gap_kb: float = 1000.0,
+    min_snps: int = 100,
+    min_length_kb: float = 1000.0,
+    max_kb_per_snp: float = 50.0,
+    include_segments: bool = False,
+) -> Dict[str, Any]:
+    """
+    ROH segments and inbreeding coefficients for every sample of a dataset.
+
+    Args:
+        snps: Parsed SNP records (chromosome, position, genotypes as dosages)
+        samples: Sample IDs in genotype column order
+        window_snps .. max_kb_per_snp: ROH calling parameters (see ``scan_runs``)
+        include_segments: Return the individual runs per sample
+
+    Returns:
+        Dict with per-sample ROH summaries and F estimates
+
+    Raises:
+        ValueError: If the dataset has no autosomal genotypes
+    """
+    by_chromosome: Dict[int, List[Dict[str, Any]]] = {}
+    for snp in snps:
+        chrom = int(snp["chromosome"])
+        if chrom in AUTOSOMES:
+            by_chromosome.setdefault(chrom, []).append(snp)
+    if not by_chromosome:
+        raise ValueError("No autosomal SNPs in dataset")
+
+    n = len(samples)
+    total_kb = np.zeros(n)
+    n_runs = np.zeros(n, dtype=np.int64)
+    longest_kb = np.zeros(n)
+    segments: List[List[Dict[str, Any]]] = [[] for _ in range(n)]
+    autosome_kb = 0.0
+    all_dosages: List[np.ndarray] = []
+
+    for chrom in sorted(by_chromosome):
+        records = sorted(by_chromosome[chrom], key=lambda s: int(s["position"]))
+        dosages = np.array([s.get("genotypes") or [] for s in records], dtype=np.int8)
+        if dosages.ndim != 2 or dosages.shape[1] != n:
+            raise ValueError(f"Chromosome {chrom} genotypes do not match the {n} samples")
+        positions = np.array([int(s["position"]) for s in records], dtype=np.int64)
+        autosome_kb += (positions[-1] - positions[0]) / 1000.0
+        all_dosages.append(dosages)
+
+        chromosome_runs = scan_runs(
+            dosages, positions, window_snps, window_max_het, window_max_missing,
+            max_gap_kb, min_snps, min_length_kb, max_kb_per_snp,
+        )
+        for i, sample_runs in enumerate(chromosome_runs):
+            for run in sample_runs:
+                total_kb[i] += run["length_kb"]
+                n_runs[i] += 1
+                longest_kb[i] = max(longest_kb[i], run["length_kb"])
+                if include_segments:
+                    segments[i].append({"chromosome": chrom, **{
+                        k: v for k, v in run.items() if k not in ("start_index", "end_index")
+                    }})
+
+    moments = inbreeding_moments(np.concatenate(all_dosages, axis=0))
+    f_roh = total_kb / autosome_kb if autosome_kb > 0 else np.zeros(n)
+
+    results = []
+    for i, sample_id in enumerate(samples):
+        entry: Dict[str, Any] = {
+            "sample_id": sample_id,
+            "n_roh": int(n_runs[i]),
+            "total_roh_kb": float(total_kb[i]),
+            "mean_roh_kb": float(total_kb[i] / n_runs[i]) if n_runs[i] else 0.0,
+            "longest_roh_kb": float(longest_kb[i]),
+            "f_roh": float(f_roh[i]),
+            "f_hom": _finite(moments["f_hom"][i]),
+            "f_grm": _finite(moments["f_grm"][i]),
+            "n_called": int(moments["n_called"][i]),
+        }
+        if include_segments:
+            entry["segments"] = segments[i]
+        results.append(entry)
+
+    return {
+        "n_samples": n,
+        "n_snps": sum(len(v) for v in by_chromosome.values()),
+        "autosome_length_kb": autosome_kb,
+        "parameters": {
+            "window_snps": window_snps,
+            "window_max_het": window_max_het,
+            "window_max_missing": window_max_missing,
+            "max_gap_kb": max_gap_kb,
+            "min_snps": min_snps,
+            "min_length_kb": min_length_kb,
+            "max_kb_per_snp": max_kb_per_snp,
+        },
+        "samples": results,
+    }
+
+
+_roh_cache = DatasetResultCache("roh")
+
+
+def dataset_roh(user_id: str, dataset_id: str, **params: Any) -> Optional[Dict[str, Any]]:
+    """
+    ROH and inbreeding estimates of a user's processed GWAS dataset (cached).
+
+    Returns:
+        Scan result, or None if the dataset does not exist for the user
+    """
+    return _roh_cache.compute(
+        user_id, dataset_id, params,
+        lambda data: scan_dataset_roh(
+            data.get("snps", []), dataset_sample_ids(data.get("samples", [])), **params
+        ),
+    )
@@ -0,0 +1,212 @@
+"""
+Sample quality control
+======================
+Per-sample metrics for a genotype dataset and the resulting exclusion mask,
+which GWAS jobs can apply (``apply_sample_qc`` / ``exclude_samples``) so bad
+samples do not inflate the genomic control lambda.
+
+All metrics come from a single pass over the SNP-major dosages in tiles of
+SNPs; each tile is reduced along the SNP axis into per-sample accumulators:
+
+- call rate over all SNPs
+- autosomal heterozygosity rate and excess-homozygosity F
+- X-chromosome F (PLINK ``--check-sex``: F > ``male_min_f`` is male,
+  F < ``female_max_f`` is female) and the Y call rate
+
+A sample is excluded for a low call rate, a heterozygosity rate more than
+``het_sd`` standard deviations from the cohort mean, or a reported sex that
+contradicts the X-chromosome F.
+"""
+
+from __future__ import annotations
+
+from typing import Any, Dict, List, Optional, Sequence
+
+import numpy as np
+
+from .dataset_cache import DatasetResultCache, dataset_sample_ids
+
+X_CHROMOSOME = 23
+Y_CHROMOSOME = 24
+# SNPs reduced per tile
+_SNP_TILE = 4096
+
+
+def _tile_frequencies(dosages: np.ndarray) -> np.ndarray:
+    called = dosages >= 0
+    return np.where(called, dosages, 0).sum(axis=1) / np.maximum(2 * called.sum(axis=1), 1)
+
+
+def sample_qc(
+    snps: Sequence[Dict[str, Any]],
+    sample_ids: Sequence[str],
+    reported_sex: Optional[Sequence[int]] = None,
+    min_call_rate: float = 0.95,
+    het_sd: float = 3.0,
+    female_max_f: float = 0.2,
+    male_min_f: float = 0.8,
+    sex_check: bool = True,
+) -> Dict[str, Any]:
+    """
+    Per-sample QC metrics and exclusion mask.
+
+    Args:
+        snps: Parsed SNP records (chromosome, genotypes as dosages, -1 = missing)
+        sample_ids: Sample IDs in genotype column order
+        reported_sex: PLINK sex codes per sample (1 = male, 2 = female, 0 = unknown)
+        min_call_rate: Samples below this call rate are excluded
+        het_sd: Heterozygosity outlier threshold in standard deviations
+        female_max_f: X-chromosome F below which a sample is called female
+        male_min_f: X-chromosome F above which a sample is called male
+        sex_check: Exclude samples whose reported sex contradicts the X F
+
+    Returns:
+        Dict with per-sample metrics, the exclusion mask and excluded IDs
+
+    Raises:
+        ValueError: If genotypes do not match the sample list
+    """
+    n = len(sample_ids)
+    if n == 0:
+        raise ValueError("Dataset has no samples")
+    if reported_sex is not None and len(reported_sex) != n:
+        raise ValueError("reported_sex must have one entry per sample")
+
+    called_all = np.zeros(n, dtype=np.int64)
+    n_snps = 0
+    auto = {"called": np.zeros(n), "het": np.zeros(n), "hom": np.zeros(n), "expected_hom": np.zeros(n)}
+    x = {"called": np.zeros(n), "hom": np.zeros(n), "expected_hom": np.zeros(n)}
+    y_called = np.zeros(n)
+    n_y = 0
+
+    groups: Dict[str, List[List[int]]] = {"auto": [], "x": [], "y": [], "other": []}
+    for snp in snps:
+        genotypes = snp.get("genotypes") or []
+        if len(genotypes) != n:
+            raise ValueError(f"SNP {snp.get('rsid')} has {len(genotypes)} genotypes for {n} samples")
+        chrom = int(snp["chromosome"])
+        key = "auto" if 1 <= chrom <= 22 else "x" if chrom == X_CHROMOSOME else "y" if chrom == Y_CHROMOSOME else "other"
+        groups[key].append(genotypes)
+
+    for key, rows in groups.items():
+        for start in range(0, len(rows), _SNP_TILE):
+            tile = np.array(rows[start:start + _SNP_TILE], dtype=np.int8)
+            called = tile >= 0
+            called_all += called.sum(axis=0)
+            n_snps += tile.shape[0]
+            if key == "y":
+                y_called += called.sum(axis=0)
+                n_y += tile.shape[0]
+                continue
+            if key == "other":
+                continue
+            p = _tile_frequencies(tile)
+            polymorphic = (p > 0) & (p < 1)
+            tile, called, p = tile[polymorphic], called[polymorphic], p[polymorphic][:, None]
+            expected_hom = (1 - 2 * p * (1 - p)) * called
+            hom = called & (tile != 1)
+            target = auto if key == "auto" else x
+            target["called"] += called.sum(axis=0)
+            target["hom"] += hom.sum(axis=0)
+            target["expected_hom"] += expected_hom.sum(axis=0)
+            if key == "auto":
+                auto["het"] += (tile == 1).sum(axis=0)
+
+    with np.errstate(invalid="ignore", divide="ignore"):
+        call_rate = called_all / max(n_snps, 1)
+        het_rate = auto["het"] / auto["called"]
+        f_het = (auto["hom"] - auto["expected_hom"]) / (auto["called"] - auto["expected_hom"])
+        x_f = (x["hom"] - x["expected_hom"]) / (x["called"] - x["expected_hom"])
+        y_call_rate = y_called / n_y if n_y else np.full(n, np.nan)
+
+    finite_het = het_rate[np.isfinite(het_rate)]
+    het_mean = float(finite_het.mean()) if finite_het.size else float("nan")
+    het_std = float(finite_het.std()) if finite_het.size > 1 else 0.0
+
+    inferred = np.zeros(n, dtype=np.int64)
+    inferred[np.isfinite(x_f) & (x_f > male_min_f)] = 1
+    inferred[np.isfinite(x_f) & (x_f < female_max_f)] = 2
+    reported = np.asarray(reported_sex if reported_sex is not None else np.zeros(n), dtype=np.int64)
+
+    low_call = call_rate < min_call_rate
+    het_outlier = (
+        np.isfinite(het_rate) & (np.abs(het_rate - het_mean) > het_sd * het_std)
+        if het_std > 0 else np.zeros(n, dtype=bool)
+    )
+    sex_mismatch = (reported > 0) & (inferred > 0) & (reported != inferred)
+    exclude = low_call | het_outlier | (sex_mismatch if sex_check else False)
+
+    def finite(value: float) -> Optional[float]:
+        return float(value) if np.isfinite(value) else None
+
+    samples = []
+    for i, sample_id in enumerate(sample_ids):
+        reasons = [
+            reason for reason, flagged in (
+                ("call_rate", low_call[i]),
+                ("heterozygosity", het_outlier[i]),
+                ("sex_mismatch", sex_check and sex_mismatch[i]),
+            ) if flagged
+        ]
+        samples.append({
+            "sample_id": sample_id,
+            "call_rate": float(call_rate[i]),
+            "het_rate": finite(het_rate[i]),
+            "f_het": finite(f_het[i]),
+            "x_f": finite(x_f[i]),
+            "y_call_rate": finite(y_call_rate[i]),
+            "reported_sex": int(reported[i]),
+            "inferred_sex": int(inferred[i]),
+            "excluded": bool(exclude[i]),
+            "reasons": reasons,
+        })
+
+    return {
+        "n_samples": n,
+        "n_snps": n_snps,
+        "n_x_snps": len(groups["x"]),
+        "n_y_snps": n_y,
+        "het_rate_mean": finite(het_mean),
+        "het_rate_sd": het_std,
+        "thresholds": {
+            "min_call_rate": min_call_rate,
+            "het_sd": het_sd,
+            "female_max_f": female_max_f,
+            "male_min_f": male_min_f,
+            "sex_check": sex_check,
+        },
+        "exclusion_mask": exclude.tolist(),
+        "excluded_samples": [sample_ids[i] for i in np.flatnonzero(exclude)],
+        "n_excluded": int(exclude.sum()),
+        "reason_counts": {
+            "call_rate": int(low_call.sum()),
+            "heterozygosity": int(het_outlier.sum()),
+            "sex_mismatch": int(sex_mismatch.sum()) if sex_check else 0,
+        },
+        "samples": samples,
+    }
+
+
+_qc_cache = DatasetResultCache("sample_qc")
+
+
+def _reported_sex(samples: Sequence[Any]) -> Optional[List[int]]:
+    """PLINK sex codes from processed sample records, if the dataset has them."""
+    codes = [int(s.get("sex") or 0) if isinstance(s, dict) else 0 for s in samples]
+    return codes if any(codes) else None
+
+
+def dataset_sample_qc(user_id: str, dataset_id: str, **params: Any) -> Optional[Dict[str, Any]]:
+    """
+    Sample QC of a user's processed GWAS dataset (cached).
+
+    Returns:
+        QC result, or None if the dataset does not exist for the user
+    """
+    def analysis(data: Dict[str, Any]) -> Dict[str, Any]:
+        samples = data.get("samples", [])
+        return sample_qc(
+            data.get("snps", []), dataset_sample_ids(samples), _reported_sex(samples), **params
+        )
+
+    return _qc_cache.compute(user_id, dataset_id, params, analysis)
@@ -0,0 +1,746 @@
+"""
+Summary statistics
+==================
+Ingestion of external GWAS summary statistics (for PRS, meta-analysis and
+Mendelian randomisation), allele harmonisation against a reference variant
+set and a compact columnar store of the result.
+
+Files (TSV / CSV / whitespace, optionally gzipped) are streamed in blocks of
+bytes. Delimiter and newline offsets of a block are found with one
+vectorised byte comparison and columns are gathered straight from those
+offsets (see ``_FieldBlock``), so text is never split into per-field Python
+objects. Columns are detected from the header by their common
+names (PLINK, METAL, GWAS Catalog harmonised, SAIGE, BOLT, ...).
+
+Harmonisation aligns every record to the reference ALT allele as the effect
+allele, using packed ``(chromosome, position)`` keys (rsids when positions
+are missing) and binary search over the sorted reference keys:
+
+- alleles match directly: kept
+- effect and other allele swapped: beta and EAF flipped
+- alleles on the opposite strand: complemented (and swapped if needed)
+- palindromic (A/T, C/G) SNPs: orientation inferred from the effect allele
+  frequency against the reference ALT frequency, dropped when either is
+  within ``palindromic_maf_window`` of 0.5
+- alleles that match neither way: dropped
+
+The store is a directory of ``.npy`` columns sorted by position key plus
+allele blobs and ``meta.json``, written to a staging directory and moved
+into place, the same layout as the GWAS Catalog indexes. Readers map the
+columns read-only.
+"""
+
+from __future__ import annotations
+
+import gzip
+import json
+import math
+import shutil
+import tempfile
+import uuid
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from ..gwas_catalog_index import chromosome_code, parse_rsid, position_key, publish_directory
+
+# Bytes tokenised per block
+_BLOCK_BYTES = 1 << 24
+
+# Header names per column role, compared case-insensitively
+COLUMN_ALIASES: Dict[str, Tuple[str, ...]] = {
+    "chromosome": ("chr", "chrom", "chromosome", "#chrom", "#chr", "chr_name", "hm_chrom", "chr_id"),
+    "position": ("pos", "bp", "position", "base_pair_location", "chr_pos", "hm_pos", "genpos_bp", "bp_hg19", "bp_hg38"),
+    "rsid": ("snp", "rsid", "rs_id", "snpid", "snp_id", "markername", "variant_id", "id", "hm_rsid", "marker"),
+    "effect_allele": ("effect_allele", "a1", "ea", "allele1", "alt", "tested_allele", "hm_effect_allele", "allele_1"),
+    "other_allele": ("other_allele", "a2", "oa", "nea", "non_effect_allele", "allele0", "allele2", "ref", "hm_other_allele", "allele_2"),
+    "beta": ("beta", "b", "effect", "hm_beta", "log_odds", "logor"),
+    "odds_ratio": ("or", "odds_ratio", "hm_odds_ratio"),
+    "se": ("se", "standard_error", "stderr", "se_beta", "log_odds_se"),
+    "p": ("p", "pval", "p_value", "pvalue", "p-value", "p_bolt_lmm", "p_bolt_lmm_inf", "frequentist_add_pvalue"),
+    "eaf": ("eaf", "effect_allele_frequency", "a1freq", "a1_freq", "freq", "freq1", "frq", "af", "a1_af", "hm_effect_allele_frequency", "af_allele2"),
+    "n": ("n", "n_total", "neff", "n_eff", "sample_size", "obs_ct", "totalsamplesize", "nmiss"),
+}
+_MISSING_TOKENS = [b"", b"NA", b"na", b"N/A", b".", b"nan", b"NaN", b"NAN", b"null", b"NULL", b"None", b"-"]
+_COMPLEMENT = bytes.maketrans(b"ACGTacgt", b"TGCAtgca")
+_PALINDROMES = {(b"A", b"T"), (b"T", b"A"), (b"C", b"G"), (b"G", b"C")}
+
+# Harmonisation flags stored per record
+HARMONISED_SWAPPED = 1
+HARMONISED_FLIPPED = 2
+HARMONISED_PALINDROMIC = 4
+
+_FLOAT_COLUMNS = ("beta", "se", "p", "eaf", "n")
+
+
+def _open_binary(path: Path):
+    with open(path, "rb") as probe:
+        gzipped = probe.read(2) == b"\x1f\x8b"
+    return gzip.open(path, "rb") if gzipped else open(path, "rb")
+
+
+def _detect_delimiter(header: bytes) -> Optional[bytes]:
+    """Tab, comma, or None for runs of whitespace."""
+    if b"\t" in header:
+        return b"\t"
+    if b"," in header:
+        return b","
+    return None
+
+
+def detect_columns(header: Sequence[str]) -> Dict[str, int]:
+    """
+    Map column roles to header indices.
+
+    Raises:
+        ValueError: If the alleles, an effect size or its precision, or a
+            variant locator (rsid or chromosome + position) is missing
+    """
+    names = [h.strip().strip('"').lower() for h in header]
+    columns: Dict[str, int] = {}
+    for role, aliases in COLUMN_ALIASES.items():
+        for alias in aliases:
+            if alias in names:
+                columns[role] = names.index(alias)
+                break
+
+    missing = [r for r in ("effect_allele", "other_allele") if r not in columns]
+    if "beta" not in columns and "odds_ratio" not in columns:
+        missing.append("beta or odds_ratio")
+    if "se" not in columns and "p" not in columns:
+        missing.append("se or p")
+    if "rsid" not in columns and not ("chromosome" in columns and "position" in columns):
+        missing.append("rsid or chromosome + position")
+    if missing:
+        raise ValueError(f"Summary statistics are missing columns: {', '.join(missing)}")
+    return columns
+
+
+class _FieldBlock:
+    """
+    Field view over a block of complete lines.
+
+    Delimited blocks are scanned as a byte array: every delimiter and newline
+    offset is found in one vectorised comparison, and a column is gathered
+    from its (start, end) offsets into a fixed-width bytes array, so no
+    per-field Python objects are created. Ragged blocks (quoted or short
+    lines, blank lines, whitespace-delimited files) fall back to splitting
+    each line.
+    """
+
+    def __init__(self, block: bytes, delimiter: Optional[bytes], n_columns: int):
+        self.n_columns = n_columns
+        self.n_malformed = 0
+        self._matrix: Optional[np.ndarray] = None
+        if not block.endswith(b"\n"):
+            block += b"\n"
+        if delimiter is not None and self._scan(block, delimiter):
+            return
+
+        rows = []
+        lines = [line for line in block.split(b"\n") if line.strip()]
+        for line in lines:
+            fields = line.split(delimiter) if delimiter else line.split()
+            if len(fields) >= n_columns:
+                rows.append(fields[:n_columns])
+        self.n_malformed = len(lines) - len(rows)
+        self._matrix = np.array(rows, dtype=np.bytes_).reshape(len(rows), n_columns)
+        self.n_rows = len(rows)
+
+    def _scan(self, block: bytes, delimiter: bytes) -> bool:
+        buf = np.frombuffer(block, dtype=np.uint8)
+        newline = buf == 0x0A
+        ends = np.flatnonzero(newline | (buf == delimiter[0]))
+        if ends.size == 0 or ends.size % self.n_columns:
+            return False
+        # Every n_columns-th separator must be a newline, and no other
+        line_ends = newline[ends].reshape(-1, self.n_columns)
+        if not line_ends[:, -1].all() or line_ends[:, :-1].any():
+            return False
+        self._buf = buf
+        self._ends = ends.reshape(-1, self.n_columns)
+        self._starts = np.empty_like(self._ends)
+        self._starts.ravel()[0] = 0
+        self._starts.ravel()[1:] = ends[:-1] + 1
+        self.n_rows = self._ends.shape[0]
+        return True
+
+    def column(self, index: int) -> np.ndarray:
+        """Bytes values of one column."""
+        if self._matrix is not None:
+            return self._matrix[:, index]
+        starts, ends = self._starts[:, index], self._ends[:, index]
+        lengths = ends - starts
+        width = max(int(lengths.max()) if lengths.size else 0, 1)
+        shortest = int(lengths.min()) if lengths.size else 0
+        gathered = np.zeros((starts.size, width), dtype=np.uint8)
+        # One gather per byte position; fields are short, so this beats a 2-D index
+        for offset in range(width):
+            if offset < shortest:
+                gathered[:, offset] = self._buf[starts + offset]
+            else:
+                present = np.flatnonzero(lengths > offset)
+                gathered[present, offset] = self._buf[starts[present] + offset]
+        return gathered.view(f"S{width}").ravel()
+
+
+def _to_float(column: np.ndarray) -> np.ndarray:
+    column = np.char.strip(column, b'"')
+    column = np.where(np.isin(column, _MISSING_TOKENS), b"nan", column)
+    try:
+        return column.astype(np.float64)
+    except ValueError:
+        def parse(token: bytes) -> float:
+            try:
+                return float(token)
+            except ValueError:
+                return math.nan
+        return np.fromiter((parse(t) for t in column), dtype=np.float64, count=column.size)
+
+
+def _chromosome_codes(column: np.ndarray) -> np.ndarray:
+    labels, inverse = np.unique(column, return_inverse=True)
+    codes = np.array([chromosome_code(label.decode(errors="replace").strip('"')) for label in labels], dtype=np.int64)
+    return codes[inverse] if labels.size else np.empty(0, dtype=np.int64)
+
+
+def _iter_blocks(path: Path, block_bytes: int) -> Iterator[Tuple[bytes, bytes]]:
+    """Yield the header line with each block of complete data lines (CR stripped)."""
+    with _open_binary(path) as handle:
+        header = b""
+        carry = b""
+        while True:
+            block = handle.read(block_bytes)
+            if not block:
+                break
+            block = carry + block
+            cut = block.rfind(b"\n")
+            if cut == -1:
+                carry = block
+                continue
+            carry = block[cut + 1:]
+            block = block[:cut + 1].replace(b"\r", b"")
+            while not header and block:
+                line_end = block.find(b"\n")
+                line, block = block[:line_end], block[line_end + 1:]
+                if line.strip() and not line.startswith(b"##"):
+                    header = line
+            if header and block:
+                yield header, block
+        carry = carry.replace(b"\r", b"")
+        if not header:
+            if not carry.strip():
+                raise ValueError("Summary statistics file is empty")
+            header, carry = carry, b""
+        yield header, carry
+
+
+def read_sumstats(path: Path, block_bytes: int = _BLOCK_BYTES) -> Dict[str, Any]:
+    """
+    Parse a summary statistics file into column arrays.
+
+    Returns:
+        Dict with the detected ``columns`` and arrays ``chromosome``,
+        ``position``, ``rsid`` (bytes), ``effect_allele``, ``other_allele``
+        (uppercase bytes), ``beta``, ``se``, ``p``, ``eaf``, ``n``, plus
+        ``n_rows`` and ``n_malformed``
+
+    Raises:
+        ValueError: If the header lacks required columns
+    """
+    columns: Optional[Dict[str, int]] = None
+    header_names: List[str] = []
+    delimiter: Optional[bytes] = None
+    parts: Dict[str, List[np.ndarray]] = {}
+    n_malformed = 0
+
+    for header, block in _iter_blocks(Path(path), block_bytes):
+        if columns is None:
+            delimiter = _detect_delimiter(header)
+            header_names = [
+                h.decode(errors="replace")
+                for h in (header.split(delimiter) if delimiter else header.split())
+            ]
+            columns = detect_columns(header_names)
+        if not block.strip():
+            continue
+        fields = _FieldBlock(block, delimiter, len(header_names))
+        n_malformed += fields.n_malformed
+        if fields.n_rows == 0:
+            continue
+
+        chunk: Dict[str, np.ndarray] = {}
+        n = fields.n_rows
+        chunk["chromosome"] = (
+            _chromosome_codes(fields.column(columns["chromosome"])) if "chromosome" in columns
+            else np.zeros(n, dtype=np.int64)
+        )
+        if "position" in columns:
+            position = _to_float(fields.column(columns["position"]))
+            chunk["position"] = np.where(np.isfinite(position), position, 0).astype(np.int64)
+        else:
+            chunk["position"] = np.zeros(n, dtype=np.int64)
+        chunk["rsid"] = (
+            np.char.strip(fields.column(columns["rsid"]), b'"') if "rsid" in columns
+            else np.full(n, b"", dtype=np.bytes_)
+        )
+        for role in ("effect_allele", "other_allele"):
+            chunk[role] = np.char.upper(np.char.strip(fields.column(columns[role]), b'"'))
+        if "beta" in columns:
+            chunk["beta"] = _to_float(fields.column(columns["beta"]))
+        else:
+            with np.errstate(divide="ignore", invalid="ignore"):
+                chunk["beta"] = np.log(_to_float(fields.column(columns["odds_ratio"])))
+        for role in ("se", "p", "eaf", "n"):
+            chunk[role] = _to_float(fields.column(columns[role])) if role in columns else np.full(n, np.nan)
+        for key, values in chunk.items():
+            parts.setdefault(key, []).append(values)
+
+    if columns is None:
+        raise ValueError("Summary statistics file has no header")
+    data: Dict[str, Any] = {
+        key: np.concatenate(values) if values else np.empty(0) for key, values in parts.items()
+    }
+    if not parts:
+        data = {
+            "chromosome": np.empty(0, dtype=np.int64), "position": np.empty(0, dtype=np.int64),
+            "rsid": np.empty(0, dtype=np.bytes_), "effect_allele": np.empty(0, dtype=np.bytes_),
+            "other_allele": np.empty(0, dtype=np.bytes_),
+            **{role: np.empty(0) for role in _FLOAT_COLUMNS},
+        }
+    _fill_missing_statistics(data)
+    data["columns"] = {role: header_names[i] for role, i in columns.items()}
+    data["n_rows"] = int(data["beta"].size)
+    data["n_malformed"] = n_malformed
+    return data
+
+
+def _fill_missing_statistics(data: Dict[str, Any]) -> None:
+    """Derive p from beta / se, or se from beta / p, when only one was given."""
+    beta, se, p = data["beta"], data["se"], data["p"]
+    need_p = ~np.isfinite(p) & np.isfinite(beta) & np.isfinite(se) & (se > 0)
+    if need_p.any():
+        erfc = np.frompyfunc(math.erfc, 1, 1)
+        p[need_p] = erfc(np.abs(beta[need_p] / se[need_p]) / math.sqrt(2.0)).astype(np.float64)
+    need_se = ~np.isfinite(se) & np.isfinite(beta) & np.isfinite(p) & (p > 0) & (p < 1)
+    if need_se.any():
+        se[need_se] = np.abs(beta[need_se]) / normal_isf(p[need_se] / 2.0)
+
+
+def normal_isf(q: np.ndarray) -> np.ndarray:
+    """Upper-tail standard normal quantile (Acklam's approximation, one Newton step)."""
+    a = (-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+         1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00)
+    b = (-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+         6.680131188771972e+01, -1.328068155288572e+01)
+    c = (-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+         -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00)
+    d = (7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00)
+    p = np.clip(1.0 - q, 1e-300, 1 - 1e-16)
+    x = np.empty_like(p)
+    low, high = p < 0.02425, p > 1 - 0.02425
+    mid = ~(low | high)
+    r = np.sqrt(-2 * np.log(p[low]))
+    x[low] = (((((c[0] * r + c[1]) * r + c[2]) * r + c[3]) * r + c[4]) * r + c[5]) / \
+        ((((d[0] * r + d[1]) * r + d[2]) * r + d[3]) * r + 1)
+    r = np.sqrt(-2 * np.log(np.clip(q[high], 1e-300, None)))
+    x[high] = -(((((c[0] * r + c[1]) * r + c[2]) * r + c[3]) * r + c[4]) * r + c[5]) / \
+        ((((d[0] * r + d[1]) * r + d[2]) * r + d[3]) * r + 1)
+    s = p[mid] - 0.5
+    r = s * s
+    x[mid] = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * s / \
+        (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1)
+    erfc = np.frompyfunc(math.erfc, 1, 1)
+    error = 0.5 * erfc(x / math.sqrt(2.0)).astype(np.float64) - q
+    return x + error * math.sqrt(2 * math.pi) * np.exp(x * x / 2)
+
+
+# ============================================================================
+# Harmonisation
+# ============================================================================
+
+def reference_from_snps(snps: Sequence[Dict[str, Any]]) -> Dict[str, np.ndarray]:
+    """
+    Reference variant set from processed dataset SNPs, with ALT frequencies
+    computed from the dosages.
+    """
+    chromosome = np.array([int(s["chromosome"]) for s in snps], dtype=np.int64)
+    position = np.array([int(s["position"]) for s in snps], dtype=np.int64)
+    alt_frequency = np.full(len(snps), np.nan)
+    for i, snp in enumerate(snps):
+        genotypes = np.asarray(snp.get("genotypes") or [], dtype=np.int8)
+        called = genotypes[genotypes >= 0]
+        if called.size:
+            alt_frequency[i] = called.sum() / (2.0 * called.size)
+    return {
+        "chromosome": chromosome,
+        "position": position,
+        "rsid": np.array([str(s.get("rsid") or "").encode() for s in snps], dtype=np.bytes_),
+        "ref_allele": np.array([str(s.get("ref_allele") or "").upper().encode() for s in snps], dtype=np.bytes_),
+        "alt_allele": np.array([str(s.get("alt_allele") or "").upper().encode() for s in snps], dtype=np.bytes_),
+        "alt_frequency": alt_frequency,
+    }
+
+
+def _complement(alleles: np.ndarray) -> np.ndarray:
+    labels, inverse = np.unique(alleles, return_inverse=True)
+    complemented = np.array([label.translate(_COMPLEMENT)[::-1] for label in labels], dtype=np.bytes_)
+    return complemented[inverse] if labels.size else alleles
+
+
+def _match_reference(data: Dict[str, Any], reference: Dict[str, np.ndarray]) -> np.ndarray:
+    """Reference row per record (-1 if none), by position key or else rsid."""
+    n = data["beta"].size
+    matched = np.full(n, -1, dtype=np.int64)
+    ref_keys = position_key(reference["chromosome"], reference["position"])
+    order = np.argsort(ref_keys, kind="stable")
+    sorted_keys = ref_keys[order]
+
+    has_position = (data["chromosome"] > 0) & (data["position"] > 0)
+    keys = position_key(data["chromosome"], data["position"])
+    lo = np.searchsorted(sorted_keys, keys, side="left")
+    hi = np.searchsorted(sorted_keys, keys, side="right")
+    single = has_position & (hi - lo == 1)
+    matched[single] = order[lo[single]]
+
+    # Multi-allelic sites: pick the reference row whose alleles match either way
+    ea, oa = data["effect_allele"], data["other_allele"]
+    for i in np.flatnonzero(has_position & (hi - lo > 1)):
+        alleles = {ea[i], oa[i], ea[i].translate(_COMPLEMENT)[::-1], oa[i].translate(_COMPLEMENT)[::-1]}
+        for row in order[lo[i]:hi[i]]:
+            if reference["ref_allele"][row] in alleles and reference["alt_allele"][row] in alleles:
+                matched[i] = row
+                break
+
+    by_rsid = ~has_position & (data["rsid"] != b"")
+    if by_rsid.any():
+        rsid_rows = {rsid: row for row, rsid in enumerate(reference["rsid"].tolist()) if rsid}
+        for i in np.flatnonzero(by_rsid):
+            matched[i] = rsid_rows.get(data["rsid"][i], -1)
+    return matched
+
+
+def harmonise(
+    data: Dict[str, Any],
+    reference: Dict[str, np.ndarray],
+    palindromic_maf_window: float = 0.08,
+) -> Dict[str, Any]:
+    """
+    Align summary statistics to the reference ALT allele.
+
+    Args:
+        data: Output of ``read_sumstats``
+        reference: Reference variants (see ``reference_from_snps``)
+        palindromic_maf_window: Palindromic SNPs with an EAF (or reference
+            frequency) within this distance of 0.5 are dropped as ambiguous
+
+    Returns:
+        ``data`` restricted to harmonised records, with alleles, beta and
+        EAF in reference orientation, coordinates filled from the reference,
+        a per-record ``harmonisation`` flag column, the matched
+        ``reference_row`` and drop counts
+    """
+    if reference["position"].size == 0:
+        raise ValueError("Reference dataset has no variants")
+    matched = _match_reference(data, reference)
+    found = matched >= 0
+    row = np.where(found, matched, 0)
+    ref_a = reference["ref_allele"][row]
+    alt_a = reference["alt_allele"][row]
+    ea, oa = data["effect_allele"], data["other_allele"]
+    ea_c, oa_c = _complement(ea), _complement(oa)
+
+    direct = (ea == alt_a) & (oa == ref_a)
+    swapped = (ea == ref_a) & (oa == alt_a)
+    flipped = (ea_c == alt_a) & (oa_c == ref_a)
+    flipped_swapped = (ea_c == ref_a) & (oa_c == alt_a)
+
+    palindromic = np.array([(a, b) in _PALINDROMES for a, b in zip(ea.tolist(), oa.tolist())], dtype=bool)
+    eaf = data["eaf"]
+    ref_freq = reference["alt_frequency"][row]
+    informative = (
+        np.isfinite(eaf) & np.isfinite(ref_freq)
+        & (np.abs(eaf - 0.5) >= palindromic_maf_window)
+        & (np.abs(ref_freq - 0.5) >= palindromic_maf_window)
+    )
+    # Palindromic orientation: the effect allele is ALT when the frequencies agree
+    effect_is_alt = (eaf > 0.5) == (ref_freq > 0.5)
+    allele_match = direct | swapped | flipped | flipped_swapped
+    ambiguous = found & palindromic & allele_match & ~informative
+
+    swap = np.where(palindromic, ~effect_is_alt, swapped | flipped_swapped)
+    flip = np.where(
+        palindromic,
+        np.where(effect_is_alt, ea != alt_a, ea != ref_a),
+        flipped | flipped_swapped,
+    )
+    keep = found & allele_match & ~ambiguous
+
+    flags = (
+        swap.astype(np.uint8) * HARMONISED_SWAPPED
+        | flip.astype(np.uint8) * HARMONISED_FLIPPED
+        | palindromic.astype(np.uint8) * HARMONISED_PALINDROMIC
+    )
+    beta = np.where(swap, -data["beta"], data["beta"])
+    eaf = np.where(swap, 1.0 - eaf, eaf)
+
+    result = {
+        "chromosome": reference["chromosome"][row][keep],
+        "position": reference["position"][row][keep],
+        "rsid": np.where(data["rsid"] == b"", reference["rsid"][row], data["rsid"])[keep],
+        "effect_allele": alt_a[keep],
+        "other_allele": ref_a[keep],
+        "beta": beta[keep],
+        "se": data["se"][keep],
+        "p": data["p"][keep],
+        "eaf": eaf[keep],
+        "n": data["n"][keep],
+        "harmonisation": flags[keep],
+        "reference_row": matched[keep],
+    }
+    result["counts"] = {
+        "input": int(found.size),
+        "kept": int(keep.sum()),
+        "not_in_reference": int((~found).sum()),
+        "allele_mismatch": int((found & ~allele_match).sum()),
+        "ambiguous_palindromic": int(ambiguous.sum()),
+        "swapped": int((swap & keep).sum()),
+        "strand_flipped": int((flip & keep).sum()),
+        "palindromic_inferred": int((palindromic & keep).sum()),
+    }
+    return result
+
+
+# ============================================================================
+# Columnar store
+# ============================================================================
+
+def _blob(values: np.ndarray) -> Tuple[bytes, np.ndarray]:
+    items = values.tolist()
+    offsets = np.zeros(len(items) + 1, dtype=np.int64)
+    np.cumsum([len(v) for v in items], out=offsets[1:])
+    return b"".join(items), offsets
+
+
+def write_store(columns: Dict[str, Any], store_dir: Path, meta: Dict[str, Any]) -> None:
+    """Write harmonised columns sorted by position key to ``store_dir``."""
+    order = np.lexsort((columns["position"], columns["chromosome"]))
+    store_dir.parent.mkdir(parents=True, exist_ok=True)
+    staging = Path(tempfile.mkdtemp(prefix=".sumstats_", dir=store_dir.parent))
+    try:
+        chromosome = columns["chromosome"][order]
+        position = columns["position"][order]
+        np.save(staging / "keys.npy", position_key(chromosome, position))
+        np.save(staging / "chromosome.npy", chromosome.astype(np.uint8))
+        np.save(staging / "position.npy", position.astype(np.uint32))
+        np.save(staging / "rsid.npy", np.array([parse_rsid(r.decode()) for r in columns["rsid"][order].tolist()], dtype=np.int64))
+        for role in ("effect_allele", "other_allele"):
+            blob, offsets = _blob(columns[role][order])
+            (staging / f"{role}.bin").write_bytes(blob)
+            np.save(staging / f"{role}_offsets.npy", offsets)
+        np.save(staging / "beta.npy", columns["beta"][order].astype(np.float32))
+        np.save(staging / "se.npy", columns["se"][order].astype(np.float32))
+        np.save(staging / "p.npy", columns["p"][order].astype(np.float64))
+        np.save(staging / "eaf.npy", columns["eaf"][order].astype(np.float32))
+        np.save(staging / "n.npy", columns["n"][order].astype(np.float32))
+        np.save(staging / "harmonisation.npy", columns["harmonisation"][order].astype(np.uint8))
+        (staging / "meta.json").write_text(json.dumps(meta), encoding="utf-8")
+        publish_directory(staging, store_dir)
+    finally:
+        if staging.exists():
+            shutil.rmtree(staging, ignore_errors=True)
+
+
+class SumstatsStore:
+    """Read-only view over an ingested summary statistics store."""
+
+    def __init__(self, store_dir: Path):
+        self.store_dir = Path(store_dir)
+        self.meta = json.loads((self.store_dir / "meta.json").read_text(encoding="utf-8"))
+
+        def load(name: str) -> np.ndarray:
+            return np.load(self.store_dir / name, mmap_mode="r")
+
+        self.keys = load("keys.npy")
+        self.chromosome = load("chromosome.npy")
+        self.position = load("position.npy")
+        self.rsid = load("rsid.npy")
+        self.beta = load("beta.npy")
+        self.se = load("se.npy")
+        self.p = load("p.npy")
+        self.eaf = load("eaf.npy")
+        self.n = load("n.npy")
+        self.harmonisation = load("harmonisation.npy")
+        self._alleles = {
+            role: ((self.store_dir / f"{role}.bin").read_bytes(), load(f"{role}_offsets.npy"))
+            for role in ("effect_allele", "other_allele")
+        }
+
+    def __len__(self) -> int:
+        return int(self.keys.size)
+
+    def allele(self, role: str, row: int) -> str:
+        blob, offsets = self._alleles[role]
+        return blob[offsets[row]:offsets[row + 1]].decode()
+
+    def columns(self, rows: np.ndarray) -> Dict[str, np.ndarray]:
+        """Columns of specific rows, shaped like ``read_sumstats`` output."""
+        rows = np.asarray(rows, dtype=np.int64)
+        alleles = {
+            role: np.array(
+                [blob[offsets[r]:offsets[r + 1]] for r in rows.tolist()], dtype=np.bytes_
+            ).reshape(rows.size)
+            for role, (blob, offsets) in self._alleles.items()
+        }
+        return {
+            "chromosome": np.asarray(self.chromosome[rows], dtype=np.int64),
+            "position": np.asarray(self.position[rows], dtype=np.int64),
+            "rsid": np.array(
+                [f"rs{r}".encode() if r >= 0 else b"" for r in self.rsid[rows].tolist()], dtype=np.bytes_
+            ).reshape(rows.size),
+            **alleles,
+            **{role: np.asarray(getattr(self, role)[rows], dtype=np.float64) for role in _FLOAT_COLUMNS},
+        }
+
+    def rows_by_position(self, chromosome: np.ndarray, position: np.ndarray) -> np.ndarray:
+        """Store row per queried (chromosome, position), -1 where absent."""
+        keys = position_key(np.asarray(chromosome), np.asarray(position))
+        rows = np.searchsorted(self.keys, keys)
+        safe = np.minimum(rows, max(len(self) - 1, 0))
+        hit = (rows < len(self)) & (np.asarray(self.keys)[safe] == keys) if len(self) else np.zeros(keys.shape, bool)
+        return np.where(hit, rows, -1)
+
+    def top_rows(self, limit: int) -> np.ndarray:
+        """Rows of the ``limit`` smallest p-values, most significant first."""
+        p = np.where(np.isfinite(self.p), self.p, np.inf)
+        if limit < p.size:
+            candidates = np.argpartition(p, limit)[:limit]
+        else:
+            candidates = np.arange(p.size)
+        return candidates[np.argsort(p[candidates], kind="stable")]
+
+    def records(self, rows: Sequence[int]) -> List[Dict[str, Any]]:
+        """JSON-ready records of specific rows."""
+        def finite(value: float) -> Optional[float]:
+            return float(value) if np.isfinite(value) else None
+
+        return [
+            {
+                "rsid": f"rs{self.rsid[r]}" if self.rsid[r] >= 0 else None,
+                "chromosome": int(self.chromosome[r]),
+                "position": int(self.position[r]),
+                "effect_allele": self.allele("effect_allele", r),
+                "other_allele": self.allele("other_allele", r),
+                "beta": finite(self.beta[r]),
+                "se": finite(self.se[r]),
+                "p": finite(self.p[r]),
+                "eaf": finite(self.eaf[r]),
+                "n": finite(self.n[r]),
+                "harmonisation": int(self.harmonisation[r]),
+            }
+            for r in (int(row) for row in rows)
+        ]
+
+
+# ============================================================================
+# Service entry points
+# ============================================================================
+
+def _sumstats_root() -> Path:
+    from app.config import get_settings
+
+    return Path(get_settings().sumstats_dir)
+
+
+def _user_dir(user_id: str) -> Path:
+    safe = "".join(ch for ch in user_id if ch.isalnum() or ch in "-_") or "anonymous"
+    return _sumstats_root() / safe
+
+
+def dataset_reference(user_id: str, dataset_id: str) -> Optional[Dict[str, np.ndarray]]:
+    """Harmonisation reference from a user's processed GWAS dataset, or None if it does not exist."""
+    from app.services.gwas_dataset_service import get_gwas_dataset_service
+
+    data = get_gwas_dataset_service().load_dataset_for_analysis(user_id, dataset_id)
+    if not data:
+        return None
+    return reference_from_snps(data.get("snps", []))
+
+
+def ingest_sumstats(
+    user_id: str,
+    source_path: Path,
+    name: str,
+    reference: Optional[Dict[str, np.ndarray]] = None,
+    reference_name: Optional[str] = None,
+    palindromic_maf_window: float = 0.08,
+    source_name: Optional[str] = None,
+) -> Dict[str, Any]:
+    """
+    Parse, harmonise (when a reference is given) and store a sumstats file.
+
+    Returns:
+        Store metadata (id, detected columns, row and harmonisation counts)
+    """
+    data = read_sumstats(source_path)
+    if data["n_rows"] == 0:
+        raise ValueError("Summary statistics file has no data rows")
+
+    if reference is not None:
+        columns = harmonise(data, reference, palindromic_maf_window)
+        counts = columns.pop("counts")
+    else:
+        columns = {key: data[key] for key in ("chromosome", "position", "rsid", "effect_allele", "other_allele", *_FLOAT_COLUMNS)}
+        columns["harmonisation"] = np.zeros(data["n_rows"], dtype=np.uint8)
+        located = (columns["chromosome"] > 0) & (columns["position"] > 0)
+        columns = {key: values[located] for key, values in columns.items()}
+        counts = {"input": data["n_rows"], "kept": int(located.sum()), "no_position": int((~located).sum())}
+
+    sumstats_id = uuid.uuid4().hex
+    meta = {
+        "sumstats_id": sumstats_id,
+        "name": name,
+        "source": source_name or Path(source_path).name,
+        "columns": data["columns"],
+        "n_rows": data["n_rows"],
+        "n_malformed": data["n_malformed"],
+        "n_variants": counts["kept"],
+        "reference": reference_name,
+        "palindromic_maf_window": palindromic_maf_window if reference is not None else None,
+        "harmonisation": counts,
+    }
+    write_store(columns, _user_dir(user_id) / sumstats_id, meta)
+    return meta
+
+
+def open_sumstats(user_id: str, sumstats_id: str) -> Optional[SumstatsStore]:
+    """A user's ingested sumstats store, or None if it does not exist."""
+    if not sumstats_id.isalnum():
+        return None
+    store_dir = _user_dir(user_id) / sumstats_id
+    if not (store_dir / "meta.json").exists():
+        return None
+    return SumstatsStore(store_dir)
+
+
+def list_sumstats(user_id: str) -> List[Dict[str, Any]]:
+    """Metadata of a user's ingested sumstats stores."""
+    user_dir = _user_dir(user_id)
+    if not user_dir.exists():
+        return []
+    stores = []
+    for meta_path in sorted(user_dir.glob("*/meta.json")):
+        try:
+            stores.append(json.loads(meta_path.read_text(encoding="utf-8")))
+        except (OSError, ValueError):
+            continue
+    return stores
+
+
+def delete_sumstats(user_id: str, sumstats_id: str) -> bool:
+    """Delete a user's sumstats store; False if it does not exist."""
+    if open_sumstats(user_id, sumstats_id) is None:
+        return False
+    shutil.rmtree(_user_dir(user_id) / sumstats_id, ignore_errors=True)
+    return True
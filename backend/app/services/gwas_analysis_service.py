@@ -7,11 +7,17 @@ Coordinates dataset loading, C++ engine execution, and result storage.
 
 from __future__ import annotations
 
+import logging
 import time
 from datetime import datetime
-from typing import Optional, Dict, Any, List
+from pathlib import Path
+from typing import Optional, Dict, Any, Iterable, Iterator, List, Set, Tuple
+
+import numpy as np
 from fastapi import HTTPException
 
+from ..config import get_settings
+from ..core.metrics import get_registry, track_engine_call
 from ..schema.gwas import (
     GwasJobStatus,
     GwasAnalysisType,
@@ -25,13 +31,42 @@ from ..repositories import (
     get_gwas_result_repository,
 )
 from .gwas_engine import run_gwas_analysis
+from .gwas_out_of_core import read_vcf_samples, run_out_of_core_gwas
+from .genomics.sample_qc import dataset_sample_qc
+from .genomics.tdt import family_association
 from .gwas_visualization import (
+    StreamingGwasSummary,
     generate_manhattan_data,
     generate_qq_data,
     get_top_associations,
     generate_summary_statistics,
 )
 
+logger = logging.getLogger(__name__)
+
+# Analyses computed from the pedigree rather than by the association engine
+FAMILY_ANALYSIS_TYPES = (GwasAnalysisType.TDT, GwasAnalysisType.SIB_TDT)
+
+_metrics = get_registry()
+GWAS_JOBS = _metrics.counter(
+    "zygotrix_gwas_jobs",
+    "GWAS analysis jobs by final status.",
+    ("status",),
+)
+GWAS_JOB_DURATION = _metrics.histogram(
+    "zygotrix_gwas_job_duration_seconds",
+    "End-to-end GWAS job duration including parsing and storage.",
+    ("status",),
+)
+GWAS_SNPS_TESTED = _metrics.counter(
+    "zygotrix_gwas_snps_tested",
+    "SNPs tested across all GWAS jobs.",
+)
+GWAS_DEGRADED_RUNS = _metrics.counter(
+    "zygotrix_gwas_memory_degraded_runs",
+    "GWAS runs that degraded (smaller tiles, spilling) to stay within their memory budget.",
+)
+
 
 class GwasAnalysisService:
     """
@@ -62,6 +97,9 @@ class GwasAnalysisService:
         covariates: Optional[List[str]] = None,
         maf_threshold: float = 0.01,
         num_threads: int = 4,
+        memory_budget_mb: Optional[int] = None,
+        exclude_samples: Optional[List[str]] = None,
+        apply_sample_qc: bool = False,
     ) -> GwasResultResponse:
         """
         Run complete GWAS analysis workflow.
@@ -70,11 +108,15 @@ class GwasAnalysisService:
             job_id: Job identifier
             user_id: User identifier (for authorization)
             dataset_id: Dataset identifier
-            analysis_type: Type of analysis (LINEAR, LOGISTIC, CHI_SQUARE)
+            analysis_type: Type of analysis (LINEAR, LOGISTIC, CHI_SQUARE, TDT, SIB_TDT)
             phenotype_column: Name of phenotype column
             covariates: List of covariate column names
             maf_threshold: Minimum MAF threshold (default: 0.01)
             num_threads: Number of threads for C++ engine (default: 4)
+            memory_budget_mb: Peak memory for the analysis (None = unbounded).
+                Datasets without S3 storage are then analysed locally out-of-core.
+            exclude_samples: Sample IDs to leave out of the analysis
+            apply_sample_qc: Also exclude samples failing default sample QC
 
         Returns:
             GwasResultResponse with complete results and visualization data
@@ -96,72 +138,167 @@ class GwasAnalysisService:
 
         try:
             # Step 1: Load dataset
-            print(f"DEBUG: Loading dataset {dataset_id} for user {user_id}")
+            logger.debug(f"Loading dataset {dataset_id} for user {user_id}")
             dataset = self.dataset_repo.find_by_id(dataset_id)
             if not dataset:
-                print(f"DEBUG: Dataset {dataset_id} not found")
+                logger.debug(f"Dataset {dataset_id} not found")
                 raise HTTPException(status_code=404, detail=f"Dataset {dataset_id} not found")
 
             if dataset.user_id != user_id:
-                print(f"DEBUG: Unauthorized access to dataset {dataset_id}")
+                logger.debug(f"Unauthorized access to dataset {dataset_id}")
                 raise HTTPException(status_code=403, detail="Unauthorized access to dataset")
 
+            # Samples excluded by the caller and/or by sample QC
+            excluded = set(exclude_samples or [])
+            sample_qc_summary = None
+            if apply_sample_qc:
+                qc = dataset_sample_qc(user_id, dataset_id)
+                if qc is None:
+                    raise HTTPException(status_code=400, detail="Sample QC needs processed dataset genotypes")
+                excluded.update(qc["excluded_samples"])
+                sample_qc_summary = {
+                    "n_failed": qc["n_excluded"],
+                    "reason_counts": qc["reason_counts"],
+                    "thresholds": qc["thresholds"],
+                }
+
             # Step 2: Prepare data for C++ engine
             # Step 2: Prepare payload for Lambda (Cloud-native)
-            print(f"DEBUG: Preparing cloud payload")
+            logger.debug("Preparing cloud payload")
             
-            # Ensure S3 keys exist
-            if not dataset.s3_key or not dataset.s3_bucket:
-                # Attempt to use file_path if s3_key missing (legacy/local support)
-                # But for this refactor we prefer failing or specific logic.
-                # Let's assume s3_key is mandatory for the new flow.
-                 print(f"DEBUG: Missing S3 info for dataset {dataset_id}")
-                 # Fallback/Error? For now raise error as per "Stop the Bleeding" strictness
-                 raise HTTPException(status_code=400, detail="Dataset not on S3 (s3_key missing). Analysis requires cloud storage.")
-
-            payload = {
-                "s3_bucket": dataset.s3_bucket,
-                "s3_key": dataset.s3_key,
-                "phenotype_column": phenotype_column,
-                "parameters": {
+            local_path = Path(dataset.file_path) if dataset.file_path else None
+            run_locally = (
+                (not dataset.s3_key or not dataset.s3_bucket)
+                and memory_budget_mb is not None
+                and local_path is not None
+                and local_path.exists()
+            )
+
+            # Set by paths that stream their results into chunked storage
+            streamed: Optional[StreamingGwasSummary] = None
+            # Samples actually left out of the tests; None when unknown
+            samples_excluded: Optional[int] = len(excluded)
+            if analysis_type in FAMILY_ANALYSIS_TYPES:
+                # Family-based tests need the pedigree, which only the
+                # processed .fam records carry, so they always run locally
+                logger.debug(f"Running {analysis_type.value} on processed pedigree genotypes")
+                engine_response = self._run_family_analysis(
+                    user_id, dataset_id, analysis_type, phenotype_column, maf_threshold, excluded
+                )
+            elif run_locally:
+                # Budgeted runs on local datasets stream the VCF in tiles instead
+                # of requiring the cloud engine
+                logger.debug(f"Running out-of-core analysis within {memory_budget_mb} MB")
+                if analysis_type != GwasAnalysisType.LINEAR:
+                    raise HTTPException(
+                        status_code=400,
+                        detail="Local out-of-core analysis supports linear regression only",
+                    )
+                reference_fasta = get_settings().gwas_reference_fasta
+                phenotype, covariate_matrix = self._load_local_phenotypes(
+                    user_id, dataset_id, local_path, phenotype_column, covariates or [], excluded
+                )
+                with track_engine_call("gwas_vcf", backend="python"), run_out_of_core_gwas(
+                    genotype_path=local_path,
+                    phenotype=phenotype,
+                    memory_budget_mb=memory_budget_mb,
+                    covariates=covariate_matrix,
+                    maf_threshold=maf_threshold,
+                    reference_path=Path(reference_fasta) if reference_fasta else None,
+                ) as engine_response:
+                    # Summarise and store records straight off the shard merge,
+                    # so no full association list is ever held in memory
+                    streamed = StreamingGwasSummary(engine_response["snps_tested"])
+
+                    def stream_records() -> Iterable[Dict[str, Any]]:
+                        for assoc in self._iter_association_results(engine_response.pop("results")):
+                            streamed.add(assoc)
+                            yield assoc.model_dump()
+
+                    stored = self.result_repo.store_associations(job_id, stream_records())
+                    logger.debug(f"Streamed {stored} associations to storage")
+            else:
+                # Ensure S3 keys exist
+                if not dataset.s3_key or not dataset.s3_bucket:
+                    logger.debug(f"Missing S3 info for dataset {dataset_id}")
+                    raise HTTPException(status_code=400, detail="Dataset not on S3 (s3_key missing). Analysis requires cloud storage.")
+
+                parameters = {
                     "test_type": analysis_type.value,
                     "maf_threshold": maf_threshold,
                     "num_threads": num_threads,
                     "covariates": covariates or []
                 }
-            }
-
-            # Step 3: Call C++ GWAS engine via Lambda
-            print(f"DEBUG: Calling GWAS engine with s3_key: {dataset.s3_key}")
-            engine_response = run_gwas_analysis(
-                payload=payload,
-                timeout=600,
-            )
-            print(f"DEBUG: Engine finished. Response keys: {engine_response.keys()}")
-
-            # Step 4: Parse association results
-            associations = self._parse_association_results(engine_response.get("results", []))
-            print(f"DEBUG: Parsed {len(associations)} associations")
+                if memory_budget_mb is not None:
+                    # Only a memory_report in the response says the engine held to it
+                    parameters["memory_budget_mb"] = memory_budget_mb
+                if excluded:
+                    parameters["exclude_samples"] = sorted(excluded)
+
+                payload = {
+                    "s3_bucket": dataset.s3_bucket,
+                    "s3_key": dataset.s3_key,
+                    "phenotype_column": phenotype_column,
+                    "parameters": parameters,
+                }
 
-            # Step 5: Generate visualization data
-            manhattan_data = generate_manhattan_data(associations)
-            qq_data = generate_qq_data(associations)
-            top_associations = get_top_associations(associations, limit=100, p_threshold=1e-5)
-            summary_stats = generate_summary_statistics(associations)
-            print(f"DEBUG: Visualization data generated")
+                # Step 3: Call C++ GWAS engine via Lambda
+                logger.debug(f"Calling GWAS engine with s3_key: {dataset.s3_key}")
+                engine_response = run_gwas_analysis(
+                    payload=payload,
+                    timeout=600,
+                )
+                logger.debug(f"Engine finished. Response keys: {engine_response.keys()}")
+                # The engine reads the genotypes itself, so only its own count
+                # says whether exclude_samples was applied
+                samples_excluded = engine_response.get("samples_excluded")
+                if excluded and samples_excluded is None:
+                    logger.warning(f"GWAS engine did not report applying {len(excluded)} sample exclusions")
+                if memory_budget_mb is not None and not engine_response.get("memory_report"):
+                    logger.warning(f"GWAS engine did not report a memory plan for the {memory_budget_mb} MB budget")
+                    engine_response["memory_report"] = {"budget_mb": memory_budget_mb, "budgeted": False}
+
+            # Steps 4-5: Parse association results and generate visualization data
+            associations: Optional[List[SnpAssociation]] = None
+            if streamed is not None:
+                manhattan_data = streamed.manhattan_data()
+                qq_data = streamed.qq_data()
+                top_associations = streamed.top_associations()
+                summary_stats = streamed.summary_statistics()
+            else:
+                associations = self._parse_association_results(engine_response.get("results", []))
+                logger.debug(f"Parsed {len(associations)} associations")
+                manhattan_data = generate_manhattan_data(associations)
+                qq_data = generate_qq_data(associations)
+                top_associations = get_top_associations(associations, limit=100, p_threshold=1e-5)
+                summary_stats = generate_summary_statistics(associations)
+            memory_report = engine_response.get("memory_report")
+            if memory_report:
+                summary_stats["memory_report"] = memory_report
+                if memory_report.get("degraded"):
+                    GWAS_DEGRADED_RUNS.inc()
+                    logger.warning(f"Analysis degraded to fit memory budget: {memory_report.get('reasons')}")
+            if engine_response.get("family_summary"):
+                summary_stats["families"] = engine_response["family_summary"]
+            if samples_excluded:
+                summary_stats["excluded_samples"] = samples_excluded
+            if sample_qc_summary:
+                summary_stats["sample_qc"] = sample_qc_summary
+            logger.debug("Visualization data generated")
 
             # Step 6: Save results to database
             result = self.result_repo.create(
                 job_id=job_id,
                 user_id=user_id,
                 dataset_id=dataset_id,
-                associations=[assoc.model_dump() for assoc in associations],
+                # Streamed runs stored theirs already
+                associations=None if associations is None else [assoc.model_dump() for assoc in associations],
                 summary=summary_stats,
                 manhattan_plot_data=manhattan_data,
                 qq_plot_data=qq_data,
                 top_hits=[assoc.model_dump() for assoc in top_associations],
             )
-            print(f"DEBUG: Results saved to DB")
+            logger.debug("Results saved to DB")
 
             # Step 7: Update job status to COMPLETED
             execution_time = time.time() - start_time
@@ -173,14 +310,19 @@ class GwasAnalysisService:
                 snps_filtered=engine_response.get("snps_filtered", 0),
                 execution_time_seconds=execution_time,
             )
-            print(f"DEBUG: Job {job_id} marked as COMPLETED")
+            logger.debug(f"Job {job_id} marked as COMPLETED")
+            GWAS_JOBS.inc(status="completed")
+            GWAS_JOB_DURATION.observe(execution_time, status="completed")
+            GWAS_SNPS_TESTED.inc(engine_response.get("snps_tested", 0))
 
             return result
 
         except (HTTPException, Exception) as e:
             # Update job status to FAILED
             error_msg = str(e.detail) if hasattr(e, "detail") else str(e)
-            print(f"DEBUG: Critical failure: {error_msg}")
+            logger.error(f"GWAS job {job_id} failed: {error_msg}")
+            GWAS_JOBS.inc(status="failed")
+            GWAS_JOB_DURATION.observe(time.time() - start_time, status="failed")
             
             self.job_repo.update_status(
                 job_id=job_id,
@@ -192,9 +334,99 @@ class GwasAnalysisService:
 
     # _prepare_analysis_data removed to stop reading files into RAM
 
+    def _run_family_analysis(
+        self,
+        user_id: str,
+        dataset_id: str,
+        analysis_type: GwasAnalysisType,
+        phenotype_column: str,
+        maf_threshold: float,
+        excluded: Set[str],
+    ) -> Dict[str, Any]:
+        """
+        TDT / sib-TDT over the processed dataset.
+
+        Returns:
+            Engine-style response with association results and family counts
+        """
+        from .gwas_dataset_service import get_gwas_dataset_service
+
+        processed = get_gwas_dataset_service().load_dataset_for_analysis(user_id, dataset_id)
+        if not processed or not processed.get("snps"):
+            raise HTTPException(status_code=400, detail="Family-based tests need processed dataset genotypes")
+
+        try:
+            with track_engine_call(f"gwas_{analysis_type.value}", backend="python"):
+                return family_association(
+                    processed["snps"],
+                    processed.get("samples", []),
+                    test=analysis_type.value,
+                    phenotype_column=phenotype_column,
+                    maf_threshold=maf_threshold,
+                    exclude=excluded,
+                )
+        except ValueError as e:
+            raise HTTPException(status_code=400, detail=str(e))
+
+    def _load_local_phenotypes(
+        self,
+        user_id: str,
+        dataset_id: str,
+        vcf_path: Path,
+        phenotype_column: str,
+        covariates: List[str],
+        excluded: Optional[Set[str]] = None,
+    ) -> Tuple[np.ndarray, Optional[np.ndarray]]:
+        """
+        Align processed phenotypes/covariates to the VCF sample order.
+
+        Samples without a value, and excluded samples, are NaN and dropped by
+        the analyzer.
+
+        Returns:
+            (phenotype vector, covariate matrix or None)
+        """
+        from .gwas_dataset_service import get_gwas_dataset_service
+
+        processed = get_gwas_dataset_service().load_dataset_for_analysis(user_id, dataset_id)
+        if not processed or not processed.get("samples"):
+            raise HTTPException(status_code=400, detail="No phenotype data available for local analysis")
+
+        by_id = {
+            str(sample.get("sample_id")): sample
+            for sample in processed["samples"]
+            if isinstance(sample, dict)
+        }
+
+        def value(sample: Optional[Dict[str, Any]], group: str, column: str) -> float:
+            if sample is None:
+                return float("nan")
+            raw = (sample.get(group) or {}).get(column, sample.get(column))
+            try:
+                return float(raw)
+            except (TypeError, ValueError):
+                return float("nan")
+
+        sample_ids = read_vcf_samples(vcf_path)
+        excluded = excluded or set()
+        samples = [None if sample_id in excluded else by_id.get(sample_id) for sample_id in sample_ids]
+        phenotype = np.array([value(s, "phenotypes", phenotype_column) for s in samples])
+        if np.isnan(phenotype).all():
+            raise HTTPException(
+                status_code=400,
+                detail=f"Phenotype column '{phenotype_column}' not found for any VCF sample",
+            )
+
+        covariate_matrix = None
+        if covariates:
+            covariate_matrix = np.array(
+                [[value(s, "covariates", column) for column in covariates] for s in samples]
+            )
+        return phenotype, covariate_matrix
+
     def _parse_association_results(
         self,
-        results: List[Dict[str, Any]],
+        results: Iterable[Dict[str, Any]],
     ) -> List[SnpAssociation]:
         """
         Parse C++ engine results into SnpAssociation objects.
@@ -205,8 +437,13 @@ class GwasAnalysisService:
         Returns:
             List of validated SnpAssociation objects
         """
-        associations = []
+        return list(self._iter_association_results(results))
 
+    def _iter_association_results(
+        self,
+        results: Iterable[Dict[str, Any]],
+    ) -> Iterator[SnpAssociation]:
+        """Validate raw engine results one at a time, skipping invalid ones."""
         for result in results:
             try:
                 assoc = SnpAssociation(
@@ -225,13 +462,11 @@ class GwasAnalysisService:
                     ci_lower=result.get("ci_lower"),
                     ci_upper=result.get("ci_upper"),
                 )
-                associations.append(assoc)
             except Exception as e:
                 # Skip invalid results
-                print(f"Warning: Failed to parse association result: {e}")
+                logger.warning(f"Failed to parse association result: {e}")
                 continue
-
-        return associations
+            yield assoc
 
     def get_job_status(self, job_id: str, user_id: str) -> Optional[GwasJobResponse]:
         """
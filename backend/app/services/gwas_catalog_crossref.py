@@ -0,0 +1,213 @@
+"""
+GWAS Catalog Cross-Reference
+============================
+Joins association results against the public GWAS Catalog to report which
+hits are already known.
+
+Hits are matched by rsid through the catalogue's sorted rsid table and by
+(chromosome, position) through its sorted position table, optionally within a
+base-pair window. Only the matched catalogue rows are read from the parquet.
+
+Each known association also says whether the catalogue's risk allele is the
+hit's alt (effect) allele or its ref allele, i.e. whether the two effects
+point in opposite directions. Strand flips are resolved by complementing,
+except at palindromic (A/T, C/G) SNPs where the strand is ambiguous.
+"""
+
+from __future__ import annotations
+
+import re
+from collections import Counter
+from typing import Any, Dict, Iterable, List, Mapping, Optional
+
+import numpy as np
+
+from . import gwas_dataset
+from .gwas_catalog_index import parse_rsid, position_key
+
+# Catalogue columns reported for each known association (when present)
+CATALOG_FIELDS = (
+    "STUDY ACCESSION",
+    "PUBMEDID",
+    "FIRST AUTHOR",
+    "DISEASE/TRAIT",
+    "MAPPED_TRAIT",
+    "SNPS",
+    "CHR_ID",
+    "CHR_POS",
+    "STRONGEST SNP-RISK ALLELE",
+    "P-VALUE",
+    "OR or BETA",
+    "MAPPED_GENE",
+)
+RISK_ALLELE_FIELD = "STRONGEST SNP-RISK ALLELE"
+
+_COMPLEMENT = str.maketrans("ACGT", "TGCA")
+_PALINDROMIC = ({"A", "T"}, {"C", "G"})
+_RISK_ALLELE_SPLIT = re.compile(r"\s*(?:;|,|\sx\s)\s*")
+
+
+def _field(hit: Any, name: str, default: Any = None) -> Any:
+    if isinstance(hit, Mapping):
+        return hit.get(name, default)
+    return getattr(hit, name, default)
+
+
+def risk_allele(value: Any, rsid: str) -> Optional[str]:
+    """
+    Risk allele of ``rsid`` in a ``STRONGEST SNP-RISK ALLELE`` entry such as
+    ``rs123-A`` (several for haplotype studies); None for ``?`` or no entry.
+    """
+    if not value:
+        return None
+    entries = [e for e in _RISK_ALLELE_SPLIT.split(str(value).strip()) if e]
+    for entry in entries:
+        name, _, allele = entry.rpartition("-")
+        if len(entries) == 1 or name.strip().lower() == rsid.lower():
+            allele = allele.strip().upper()
+            return allele if allele and set(allele) <= set("ACGT") else None
+    return None
+
+
+def allele_flipped(risk: Optional[str], ref_allele: str, alt_allele: str) -> Optional[bool]:
+    """
+    True when the catalogue risk allele is the hit's ref allele, False when it
+    is the alt allele, None when that cannot be decided.
+    """
+    if risk is None:
+        return None
+    ref, alt = (ref_allele or "").upper(), (alt_allele or "").upper()
+    if risk in (ref, alt):
+        return risk == ref
+    if {ref, alt} in _PALINDROMIC:
+        return None
+    risk = risk.translate(_COMPLEMENT)
+    return risk == ref if risk in (ref, alt) else None
+
+
+def _match_rows(
+    variant_index,
+    hits: List[Any],
+    window_bp: int,
+) -> tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+    """
+    Catalogue rows of every hit plus flags for how each hit was matched.
+
+    Returns:
+        (rows, offsets, matched_rsid, matched_position); the sorted distinct
+        rows of hit ``i`` are ``rows[offsets[i]:offsets[i + 1]]``
+    """
+    n = len(hits)
+    rsids = np.array([parse_rsid(_field(h, "rsid")) for h in hits], dtype=np.int64)
+    keys = np.array(
+        [position_key(_field(h, "chromosome", 0) or 0, _field(h, "position", 0) or 0) for h in hits],
+        dtype=np.int64,
+    )
+
+    rsid_owner, rsid_rows = variant_index.matches_by_rsid(rsids)
+    pos_owner, pos_rows = variant_index.matches_by_position(keys, window_bp=window_bp)
+    matched_rsid = np.bincount(rsid_owner, minlength=n) > 0
+    matched_position = np.bincount(pos_owner, minlength=n) > 0
+
+    # Union per hit: sort the (hit, row) pairs and drop adjacent duplicates
+    owner = np.concatenate([rsid_owner, pos_owner])
+    rows = np.concatenate([rsid_rows, pos_rows])
+    order = np.lexsort((rows, owner))
+    owner, rows = owner[order], rows[order]
+    distinct = np.ones(owner.size, dtype=bool)
+    distinct[1:] = (owner[1:] != owner[:-1]) | (rows[1:] != rows[:-1])
+    owner, rows = owner[distinct], rows[distinct]
+
+    offsets = np.zeros(n + 1, dtype=np.int64)
+    np.cumsum(np.bincount(owner, minlength=n), out=offsets[1:])
+    return rows, offsets, matched_rsid, matched_position
+
+
+def crossref_associations(
+    hits: Iterable[Any],
+    background: Optional[Iterable[Any]] = None,
+    window_bp: int = 0,
+    max_per_hit: int = 20,
+) -> Dict[str, Any]:
+    """
+    Report known GWAS Catalog associations for a set of hits.
+
+    Args:
+        hits: Association results (dicts or SnpAssociation objects), typically top hits
+        background: All tested associations; enables fold-enrichment of known loci
+        window_bp: Match catalogue variants within this many bp of a hit's position
+        max_per_hit: Maximum catalogue rows reported per hit
+
+    Returns:
+        Dict with per-hit matches and enrichment counts; every known
+        association carries ``allele_flipped`` (see ``allele_flipped``)
+    """
+    hits = list(hits)
+    variant_index = gwas_dataset.ensure_variant_index_loaded()
+
+    rows, offsets, matched_rsid, matched_position = _match_rows(variant_index, hits, window_bp)
+    counts = np.diff(offsets)
+
+    reported_mask = np.arange(rows.size) - np.repeat(offsets[:-1], counts) < max_per_hit
+    all_rows = np.unique(rows[reported_mask])
+    records = variant_index.fetch_rows(all_rows)
+    record_by_row = {
+        int(row): {k: rec.get(k) for k in CATALOG_FIELDS if k in rec}
+        for row, rec in zip(all_rows, records)
+    }
+
+    matches = []
+    trait_counts: Counter = Counter()
+    studies = set()
+    for i, (hit, by_rsid, by_pos) in enumerate(zip(hits, matched_rsid, matched_position)):
+        start = offsets[i]
+        hit_rows = rows[start:start + min(int(counts[i]), max_per_hit)]
+        rsid = str(_field(hit, "rsid", "") or "")
+        ref, alt = _field(hit, "ref_allele", ""), _field(hit, "alt_allele", "")
+        known = [
+            dict(record, allele_flipped=allele_flipped(risk_allele(record.get(RISK_ALLELE_FIELD), rsid), ref, alt))
+            for record in (record_by_row[int(r)] for r in hit_rows)
+        ]
+        for record in known:
+            if record.get("MAPPED_TRAIT"):
+                trait_counts[record["MAPPED_TRAIT"]] += 1
+            if record.get("STUDY ACCESSION"):
+                studies.add(record["STUDY ACCESSION"])
+        matches.append({
+            "rsid": rsid,
+            "chromosome": _field(hit, "chromosome"),
+            "position": _field(hit, "position"),
+            "p_value": _field(hit, "p_value"),
+            "matched_by": "rsid" if by_rsid else ("position" if by_pos else None),
+            "known_association_count": int(counts[i]),
+            "known_associations": known,
+        })
+
+    hits_known = int(np.count_nonzero(matched_rsid | matched_position))
+    enrichment: Dict[str, Any] = {
+        "hits_total": len(hits),
+        "hits_known": hits_known,
+        "hits_known_by_rsid": int(np.count_nonzero(matched_rsid)),
+        "hits_known_by_position_only": int(np.count_nonzero(matched_position & ~matched_rsid)),
+        "known_associations": int(rows.size),
+        "distinct_studies": len(studies),
+        "top_traits": [
+            {"trait": trait, "count": count} for trait, count in trait_counts.most_common(10)
+        ],
+    }
+
+    if background is not None:
+        background = list(background)
+        _, _, bg_rsid, bg_pos = _match_rows(variant_index, background, window_bp)
+        bg_known = int(np.count_nonzero(bg_rsid | bg_pos))
+        enrichment["background_total"] = len(background)
+        enrichment["background_known"] = bg_known
+        hit_rate = hits_known / len(hits) if hits else 0.0
+        bg_rate = bg_known / len(background) if background else 0.0
+        enrichment["fold_enrichment"] = hit_rate / bg_rate if bg_rate > 0 else None
+
+    return {
+        "window_bp": window_bp,
+        "matches": matches,
+        "enrichment": enrichment,
+    }
@@ -0,0 +1,575 @@
+"""
+GWAS Catalog Indexes
+====================
+Memory-mapped indexes over the public GWAS Catalog parquet.
+
+``GwasCatalogIndex`` is a search index over the ``MAPPED_TRAIT`` column.
+
+The index is built once from the parquet and stored as flat arrays next to it:
+
+- a trigram inverted index over normalised (casefolded, whitespace-collapsed)
+  trait names, used for substring autocomplete;
+- a lexicographically sorted name table, used for exact and prefix lookups;
+- an offset table mapping every trait to the parquet rows that mention it,
+  used to fetch study rows without keeping a DataFrame resident.
+
+Every worker maps the same files read-only, so the page cache is shared and
+no per-process pandas copy of the catalogue is needed.
+
+``GwasCatalogVariantIndex`` maps reported variants to catalogue rows, keyed
+both by numeric rsid and by packed (chromosome, position), for joining
+association results against the catalogue.
+"""
+
+from __future__ import annotations
+
+import heapq
+import json
+import mmap
+import os
+import re
+import shutil
+import tempfile
+from pathlib import Path
+from typing import Any, Dict, Iterable, List, Optional, Sequence
+
+import numpy as np
+
+INDEX_VERSION = 1
+TRAIT_COLUMN = "MAPPED_TRAIT"
+SNPS_COLUMN = "SNPS"
+CHR_COLUMN = "CHR_ID"
+POS_COLUMN = "CHR_POS"
+
+_RSID_PATTERN = re.compile(r"^rs(\d+)$", re.IGNORECASE)
+# SNPS / CHR_ID / CHR_POS hold several values for haplotype and interaction studies
+_MULTI_VALUE_SPLIT = re.compile(r"\s*(?:;|,|\sx\s)\s*")
+_CHROMOSOME_CODES = {"X": 23, "Y": 24, "M": 25, "MT": 25}
+
+# Ranking tiers for search hits (lower is better)
+_TIER_EXACT = 0
+_TIER_PREFIX = 1
+_TIER_WORD_PREFIX = 2
+_TIER_SUBSTRING = 3
+
+
+def normalize_trait_name(name: str) -> str:
+    """Casefold a trait name and collapse internal whitespace."""
+    return " ".join(name.casefold().split())
+
+
+def _trigram_codes(data: bytes) -> np.ndarray:
+    """Encode every 3-byte window of ``data`` as a 24-bit integer."""
+    if len(data) < 3:
+        return np.empty(0, dtype=np.uint32)
+    raw = np.frombuffer(data, dtype=np.uint8).astype(np.uint32)
+    return (raw[:-2] << 16) | (raw[1:-1] << 8) | raw[2:]
+
+
+def _source_signature(source: Path) -> Dict[str, Any]:
+    stat = source.stat()
+    return {
+        "version": INDEX_VERSION,
+        "source": source.name,
+        "size": stat.st_size,
+        "mtime_ns": stat.st_mtime_ns,
+    }
+
+
+def _is_stale(index_dir: Path, signature: Dict[str, Any]) -> bool:
+    meta_path = index_dir / "meta.json"
+    if not meta_path.exists():
+        return True
+    try:
+        stored = json.loads(meta_path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        return True
+    return any(stored.get(k) != v for k, v in signature.items())
+
+
+def publish_directory(staging: Path, index_dir: Path) -> None:
+    """
+    Move a fully written staging directory into place.
+
+    The previous index is renamed aside before the new one is renamed in and
+    only deleted afterwards, so readers see at most the gap between two
+    renames rather than a whole tree deletion. Readers that already mapped
+    the old files keep them until they close.
+    """
+    retired: Optional[Path] = None
+    if index_dir.exists():
+        retired = Path(tempfile.mkdtemp(prefix=f".{index_dir.name}.old-", dir=index_dir.parent))
+        try:
+            os.replace(index_dir, retired / index_dir.name)
+        except OSError:
+            # Another worker is swapping the same index
+            shutil.rmtree(retired, ignore_errors=True)
+            retired = None
+    try:
+        os.replace(staging, index_dir)
+    except OSError:
+        # Another worker finished first; its index is equivalent
+        if not index_dir.exists():
+            raise
+        shutil.rmtree(staging, ignore_errors=True)
+    finally:
+        if retired is not None:
+            shutil.rmtree(retired, ignore_errors=True)
+
+
+def read_parquet_rows(source_path: Path, row_ids: np.ndarray) -> List[Dict[str, Any]]:
+    """
+    Read specific parquet rows, touching only the row groups that contain them.
+
+    Rows are returned in ascending row order as JSON-ready records with nulls
+    and NaNs mapped to None.
+    """
+    row_ids = np.unique(np.asarray(row_ids, dtype=np.int64))
+    if row_ids.size == 0:
+        return []
+
+    import pyarrow as pa
+    import pyarrow.parquet as pq
+
+    parquet = pq.ParquetFile(source_path, memory_map=True)
+    group_sizes = [
+        parquet.metadata.row_group(i).num_rows for i in range(parquet.num_row_groups)
+    ]
+    group_starts = np.concatenate(([0], np.cumsum(group_sizes)))
+    groups = np.searchsorted(group_starts, row_ids, side="right") - 1
+
+    tables = []
+    for group in np.unique(groups):
+        local = row_ids[groups == group] - group_starts[group]
+        table = parquet.read_row_group(int(group))
+        tables.append(table.take(pa.array(local)))
+
+    records = pa.concat_tables(tables).to_pylist()
+    for record in records:
+        for key, value in record.items():
+            if isinstance(value, float) and value != value:
+                record[key] = None
+    return records
+
+
+def build_index(trait_column: Iterable[Optional[str]], index_dir: Path, meta: Dict[str, Any]) -> None:
+    """
+    Build the on-disk index from the raw trait column.
+
+    Args:
+        trait_column: ``MAPPED_TRAIT`` values in parquet row order (None for nulls)
+        index_dir: Destination directory (replaced atomically)
+        meta: Metadata stored alongside the arrays (source signature)
+    """
+    ids_by_norm: Dict[str, int] = {}
+    display_names: List[str] = []
+    row_ids: List[List[int]] = []
+
+    for row, value in enumerate(trait_column):
+        if value is None:
+            continue
+        text = str(value).strip()
+        if not text:
+            continue
+        norm = normalize_trait_name(text)
+        trait_id = ids_by_norm.get(norm)
+        if trait_id is None:
+            trait_id = len(display_names)
+            ids_by_norm[norm] = trait_id
+            display_names.append(text)
+            row_ids.append([])
+        row_ids[trait_id].append(row)
+
+    norm_names = list(ids_by_norm.keys())
+    n_traits = len(norm_names)
+
+    # Names are newline-separated so a substring scan can never straddle two traits
+    norm_blob = bytearray()
+    norm_offsets = np.zeros(n_traits + 1, dtype=np.int64)
+    display_blob = bytearray()
+    display_offsets = np.zeros(n_traits + 1, dtype=np.int64)
+    trigram_keys: List[np.ndarray] = []
+    trigram_ids: List[np.ndarray] = []
+
+    for trait_id, norm in enumerate(norm_names):
+        encoded = norm.encode("utf-8")
+        norm_blob += encoded + b"\n"
+        norm_offsets[trait_id + 1] = len(norm_blob)
+        display_blob += display_names[trait_id].encode("utf-8")
+        display_offsets[trait_id + 1] = len(display_blob)
+
+        codes = np.unique(_trigram_codes(encoded))
+        trigram_keys.append(codes)
+        trigram_ids.append(np.full(codes.size, trait_id, dtype=np.int32))
+
+    if trigram_keys:
+        all_codes = np.concatenate(trigram_keys)
+        all_ids = np.concatenate(trigram_ids)
+    else:
+        all_codes = np.empty(0, dtype=np.uint32)
+        all_ids = np.empty(0, dtype=np.int32)
+    order = np.lexsort((all_ids, all_codes))
+    all_codes = all_codes[order]
+    postings = all_ids[order]
+    keys, starts = np.unique(all_codes, return_index=True)
+    posting_offsets = np.append(starts, postings.size).astype(np.int64)
+
+    row_counts = np.array([len(rows) for rows in row_ids], dtype=np.int32)
+    row_offsets = np.zeros(n_traits + 1, dtype=np.int64)
+    np.cumsum(row_counts, out=row_offsets[1:])
+    rows = (
+        np.concatenate([np.asarray(r, dtype=np.int64) for r in row_ids])
+        if row_ids
+        else np.empty(0, dtype=np.int64)
+    )
+
+    sorted_ids = np.array(
+        sorted(range(n_traits), key=lambda i: norm_names[i]), dtype=np.int32
+    )
+
+    index_dir.parent.mkdir(parents=True, exist_ok=True)
+    staging = Path(tempfile.mkdtemp(prefix=".gwas_index_", dir=index_dir.parent))
+    try:
+        (staging / "norm.bin").write_bytes(bytes(norm_blob))
+        (staging / "display.bin").write_bytes(bytes(display_blob))
+        np.save(staging / "norm_offsets.npy", norm_offsets)
+        np.save(staging / "display_offsets.npy", display_offsets)
+        np.save(staging / "trigram_keys.npy", keys.astype(np.uint32))
+        np.save(staging / "trigram_offsets.npy", posting_offsets)
+        np.save(staging / "trigram_postings.npy", postings.astype(np.int32))
+        np.save(staging / "sorted_ids.npy", sorted_ids)
+        np.save(staging / "row_counts.npy", row_counts)
+        np.save(staging / "row_offsets.npy", row_offsets)
+        np.save(staging / "rows.npy", rows)
+        meta = dict(meta, n_traits=n_traits, n_rows=int(rows.size))
+        (staging / "meta.json").write_text(json.dumps(meta), encoding="utf-8")
+        publish_directory(staging, index_dir)
+    finally:
+        if staging.exists():
+            shutil.rmtree(staging, ignore_errors=True)
+
+
+def _map_bytes(path: Path) -> bytes | mmap.mmap:
+    if path.stat().st_size == 0:
+        return b""
+    with path.open("rb") as handle:
+        return mmap.mmap(handle.fileno(), 0, access=mmap.ACCESS_READ)
+
+
+class GwasCatalogIndex:
+    """Read-only view over a built trait index."""
+
+    def __init__(self, index_dir: Path, source_path: Optional[Path] = None):
+        self.index_dir = index_dir
+        self.source_path = source_path
+        self.meta = json.loads((index_dir / "meta.json").read_text(encoding="utf-8"))
+
+        def load(name: str) -> np.ndarray:
+            return np.load(index_dir / name, mmap_mode="r")
+
+        self._norm = _map_bytes(index_dir / "norm.bin")
+        self._display = _map_bytes(index_dir / "display.bin")
+        self._norm_offsets = load("norm_offsets.npy")
+        self._display_offsets = load("display_offsets.npy")
+        self._trigram_keys = load("trigram_keys.npy")
+        self._trigram_offsets = load("trigram_offsets.npy")
+        self._trigram_postings = load("trigram_postings.npy")
+        self._sorted_ids = load("sorted_ids.npy")
+        self._row_counts = load("row_counts.npy")
+        self._row_offsets = load("row_offsets.npy")
+        self._rows = load("rows.npy")
+        self._columns: Optional[List[str]] = None
+
+    @classmethod
+    def open_or_build(cls, source_path: Path, index_dir: Path) -> "GwasCatalogIndex":
+        """
+        Open the index for ``source_path``, rebuilding it if it is missing or stale.
+
+        Only the trait column is read from the parquet during a build.
+        """
+        signature = _source_signature(source_path)
+        if _is_stale(index_dir, signature):
+            import pyarrow.parquet as pq
+
+            column = pq.read_table(source_path, columns=[TRAIT_COLUMN]).column(TRAIT_COLUMN)
+            build_index(column.to_pylist(), index_dir, signature)
+
+        return cls(index_dir, source_path)
+
+    @property
+    def trait_count(self) -> int:
+        return int(self._row_counts.shape[0])
+
+    def _norm_name(self, trait_id: int) -> str:
+        start = int(self._norm_offsets[trait_id])
+        end = int(self._norm_offsets[trait_id + 1]) - 1
+        return self._norm[start:end].decode("utf-8")
+
+    def display_name(self, trait_id: int) -> str:
+        start = int(self._display_offsets[trait_id])
+        end = int(self._display_offsets[trait_id + 1])
+        return self._display[start:end].decode("utf-8")
+
+    def _lower_bound(self, key: str) -> int:
+        """First position in the sorted name table whose name is >= ``key``."""
+        lo, hi = 0, self.trait_count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._norm_name(int(self._sorted_ids[mid])) < key:
+                lo = mid + 1
+            else:
+                hi = mid
+        return lo
+
+    def find_trait(self, name: str) -> Optional[int]:
+        """Return the trait id for an exact (case-insensitive) name, if present."""
+        norm = normalize_trait_name(name)
+        pos = self._lower_bound(norm)
+        if pos < self.trait_count:
+            trait_id = int(self._sorted_ids[pos])
+            if self._norm_name(trait_id) == norm:
+                return trait_id
+        return None
+
+    def _candidates(self, needle: bytes) -> Sequence[int]:
+        """Trait ids that may contain ``needle`` (exact for queries shorter than 3 bytes)."""
+        if len(needle) < 3:
+            # Too short for trigrams: scan the newline-separated name blob
+            hits: List[int] = []
+            pos = self._norm.find(needle)
+            while pos != -1:
+                trait_id = int(np.searchsorted(self._norm_offsets, pos, side="right")) - 1
+                hits.append(trait_id)
+                # Skip to the next name so each trait is reported once
+                pos = self._norm.find(needle, int(self._norm_offsets[trait_id + 1]))
+            return hits
+
+        codes = np.unique(_trigram_codes(needle))
+        slots = np.searchsorted(self._trigram_keys, codes)
+        if np.any(slots >= self._trigram_keys.shape[0]):
+            return []
+        if np.any(self._trigram_keys[slots] != codes):
+            return []
+
+        starts = self._trigram_offsets[slots]
+        ends = self._trigram_offsets[slots + 1]
+        # Intersect from the rarest trigram outwards
+        result: Optional[np.ndarray] = None
+        for i in np.argsort(ends - starts):
+            postings = self._trigram_postings[int(starts[i]):int(ends[i])]
+            result = np.asarray(postings) if result is None else np.intersect1d(
+                result, postings, assume_unique=True
+            )
+            if result.size == 0:
+                return []
+        return [] if result is None else result.tolist()
+
+    def search(self, query: str, limit: int = 20) -> List[str]:
+        """
+        Ranked substring autocomplete over trait names.
+
+        Exact matches rank first, then prefix matches, then matches at a word
+        boundary, then any other substring; ties are broken by the number of
+        catalogue rows (more studied traits first) and then alphabetically.
+        """
+        norm_query = normalize_trait_name(query)
+        if not norm_query or limit <= 0:
+            return []
+
+        ranked = []
+        for trait_id in self._candidates(norm_query.encode("utf-8")):
+            name = self._norm_name(trait_id)
+            pos = name.find(norm_query)
+            if pos == -1:
+                continue
+            if name == norm_query:
+                tier = _TIER_EXACT
+            elif pos == 0:
+                tier = _TIER_PREFIX
+            elif not name[pos - 1].isalnum():
+                tier = _TIER_WORD_PREFIX
+            else:
+                tier = _TIER_SUBSTRING
+            ranked.append((tier, -int(self._row_counts[trait_id]), name, trait_id))
+
+        return [self.display_name(item[3]) for item in heapq.nsmallest(limit, ranked)]
+
+    def row_ids(self, trait_id: int, limit: Optional[int] = None) -> np.ndarray:
+        """Parquet row numbers (ascending) for a trait."""
+        start = int(self._row_offsets[trait_id])
+        end = int(self._row_offsets[trait_id + 1])
+        if limit is not None:
+            end = min(end, start + limit)
+        return np.asarray(self._rows[start:end])
+
+    def columns(self) -> List[str]:
+        """Column names of the underlying parquet (schema read only)."""
+        if self._columns is None:
+            import pyarrow.parquet as pq
+
+            self._columns = list(pq.read_schema(self.source_path).names)
+        return self._columns
+
+    def fetch_rows(self, row_ids: np.ndarray) -> List[Dict[str, Any]]:
+        """Read specific parquet rows as JSON-ready records."""
+        return read_parquet_rows(self.source_path, row_ids)
+
+
+def parse_rsid(value: Any) -> int:
+    """Numeric part of an ``rs`` identifier, or -1 if it is not one."""
+    if value is None:
+        return -1
+    match = _RSID_PATTERN.match(str(value).strip())
+    return int(match.group(1)) if match else -1
+
+
+def chromosome_code(value: Any) -> int:
+    """Chromosome label to the integer coding used by association results (X=23, Y=24, MT=25)."""
+    if value is None:
+        return 0
+    label = str(value).strip().upper()
+    if label.startswith("CHR"):
+        label = label[3:]
+    if label in _CHROMOSOME_CODES:
+        return _CHROMOSOME_CODES[label]
+    try:
+        return int(float(label))
+    except ValueError:
+        return 0
+
+
+def position_key(chromosome: np.ndarray | int, position: np.ndarray | int) -> np.ndarray | int:
+    """Pack (chromosome, position) into one sortable 64-bit key."""
+    if isinstance(chromosome, np.ndarray):
+        return (chromosome.astype(np.int64) << 32) | position.astype(np.int64)
+    return (int(chromosome) << 32) | int(position)
+
+
+def _split_values(value: Any) -> List[str]:
+    if value is None:
+        return []
+    if isinstance(value, float) and value != value:
+        return []
+    text = str(value).strip()
+    return [token for token in _MULTI_VALUE_SPLIT.split(text) if token] if text else []
+
+
+def build_variant_index(
+    snps: Sequence[Any],
+    chromosomes: Sequence[Any],
+    positions: Sequence[Any],
+    index_dir: Path,
+    meta: Dict[str, Any],
+) -> None:
+    """
+    Build the rsid and position lookup tables from the catalogue variant columns.
+
+    Args:
+        snps: ``SNPS`` values in parquet row order
+        chromosomes: ``CHR_ID`` values in parquet row order
+        positions: ``CHR_POS`` values in parquet row order
+        index_dir: Destination directory (replaced atomically)
+        meta: Metadata stored alongside the arrays (source signature)
+    """
+    rsid_keys: List[int] = []
+    rsid_rows: List[int] = []
+    pos_keys: List[int] = []
+    pos_rows: List[int] = []
+
+    for row, (snp_value, chr_value, pos_value) in enumerate(zip(snps, chromosomes, positions)):
+        for token in _split_values(snp_value):
+            rsid = parse_rsid(token)
+            if rsid >= 0:
+                rsid_keys.append(rsid)
+                rsid_rows.append(row)
+
+        for chr_token, pos_token in zip(_split_values(chr_value), _split_values(pos_value)):
+            chrom = chromosome_code(chr_token)
+            try:
+                pos = int(float(pos_token))
+            except ValueError:
+                continue
+            if chrom > 0 and pos > 0:
+                pos_keys.append(position_key(chrom, pos))
+                pos_rows.append(row)
+
+    def sorted_pairs(keys: List[int], rows: List[int]):
+        key_arr = np.asarray(keys, dtype=np.int64)
+        row_arr = np.asarray(rows, dtype=np.int64)
+        order = np.lexsort((row_arr, key_arr))
+        return key_arr[order], row_arr[order]
+
+    rsid_key_arr, rsid_row_arr = sorted_pairs(rsid_keys, rsid_rows)
+    pos_key_arr, pos_row_arr = sorted_pairs(pos_keys, pos_rows)
+
+    index_dir.parent.mkdir(parents=True, exist_ok=True)
+    staging = Path(tempfile.mkdtemp(prefix=".gwas_variants_", dir=index_dir.parent))
+    try:
+        np.save(staging / "rsid_keys.npy", rsid_key_arr)
+        np.save(staging / "rsid_rows.npy", rsid_row_arr)
+        np.save(staging / "pos_keys.npy", pos_key_arr)
+        np.save(staging / "pos_rows.npy", pos_row_arr)
+        meta = dict(meta, n_rsids=int(rsid_key_arr.size), n_positions=int(pos_key_arr.size))
+        (staging / "meta.json").write_text(json.dumps(meta), encoding="utf-8")
+        publish_directory(staging, index_dir)
+    finally:
+        if staging.exists():
+            shutil.rmtree(staging, ignore_errors=True)
+
+
+class GwasCatalogVariantIndex:
+    """Read-only rsid / position lookup over catalogue rows."""
+
+    def __init__(self, index_dir: Path, source_path: Optional[Path] = None):
+        self.index_dir = index_dir
+        self.source_path = source_path
+        self.meta = json.loads((index_dir / "meta.json").read_text(encoding="utf-8"))
+        self._rsid_keys = np.load(index_dir / "rsid_keys.npy", mmap_mode="r")
+        self._rsid_rows = np.load(index_dir / "rsid_rows.npy", mmap_mode="r")
+        self._pos_keys = np.load(index_dir / "pos_keys.npy", mmap_mode="r")
+        self._pos_rows = np.load(index_dir / "pos_rows.npy", mmap_mode="r")
+
+    @classmethod
+    def open_or_build(cls, source_path: Path, index_dir: Path) -> "GwasCatalogVariantIndex":
+        """Open the variant index for ``source_path``, rebuilding it if missing or stale."""
+        signature = _source_signature(source_path)
+        if _is_stale(index_dir, signature):
+            import pyarrow.parquet as pq
+
+            table = pq.read_table(source_path, columns=[SNPS_COLUMN, CHR_COLUMN, POS_COLUMN])
+            build_variant_index(
+                table.column(SNPS_COLUMN).to_pylist(),
+                table.column(CHR_COLUMN).to_pylist(),
+                table.column(POS_COLUMN).to_pylist(),
+                index_dir,
+                signature,
+            )
+        return cls(index_dir, source_path)
+
+    @staticmethod
+    def _ranges(keys: np.ndarray, lo: np.ndarray, hi: np.ndarray):
+        """Vectorised [lo, hi] range lookup into a sorted key column."""
+        return np.searchsorted(keys, lo, side="left"), np.searchsorted(keys, hi, side="right")
+
+    @staticmethod
+    def _gather(rows: np.ndarray, starts: np.ndarray, ends: np.ndarray):
+        """Flatten the row ranges of every query into (query index, row) pairs."""
+        lengths = np.maximum(ends - starts, 0)
+        owner = np.repeat(np.arange(lengths.size, dtype=np.int64), lengths)
+        offsets = np.cumsum(lengths) - lengths
+        positions = np.arange(owner.size, dtype=np.int64) - offsets[owner] + starts[owner]
+        return owner, np.asarray(rows[positions], dtype=np.int64)
+
+    def matches_by_rsid(self, rsids: np.ndarray):
+        """(query index, catalogue row) pairs for numeric rsids; negative values never match."""
+        starts, ends = self._ranges(self._rsid_keys, rsids, rsids)
+        return self._gather(self._rsid_rows, starts, np.where(rsids >= 0, ends, starts))
+
+    def matches_by_position(self, keys: np.ndarray, window_bp: int = 0):
+        """(query index, catalogue row) pairs within ``window_bp`` of each packed position key."""
+        starts, ends = self._ranges(self._pos_keys, keys - window_bp, keys + window_bp)
+        return self._gather(self._pos_rows, starts, ends)
+
+    def fetch_rows(self, row_ids: np.ndarray) -> List[Dict[str, Any]]:
+        """Read specific parquet rows as JSON-ready records."""
+        return read_parquet_rows(self.source_path, row_ids)
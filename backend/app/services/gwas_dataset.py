@@ -1,47 +1,77 @@
 from __future__ import annotations
 
-import json
 from pathlib import Path
 from threading import Lock
 from typing import List
 
-import pandas as pd
+from .gwas_catalog_index import GwasCatalogIndex, GwasCatalogVariantIndex
 
 DATASET_FILENAME = "gwas_dataset.parquet"
 GOOGLE_DRIVE_FILE_ID = "1CjeS_Az5CEBYtyQGSKMLL6Ikt7yeJd_E"
 DATA_DIR = Path(__file__).resolve().parents[2] / "data"
 DATASET_PATH = DATA_DIR / DATASET_FILENAME
+INDEX_DIR = DATA_DIR / "gwas_catalog_index"
+VARIANT_INDEX_DIR = DATA_DIR / "gwas_catalog_variants"
 
 _dataset_lock = Lock()
-_dataset_df: pd.DataFrame | None = None
+_dataset_index: GwasCatalogIndex | None = None
+_variant_index: GwasCatalogVariantIndex | None = None
 
 
 class DatasetLoadError(RuntimeError):
     """Raised when the GWAS dataset cannot be loaded."""
 
 
-def ensure_dataset_loaded() -> pd.DataFrame:
+def ensure_dataset_loaded() -> GwasCatalogIndex:
 
-    global _dataset_df
+    global _dataset_index
 
-    if _dataset_df is not None:
-        return _dataset_df
+    if _dataset_index is not None:
+        return _dataset_index
 
     with _dataset_lock:
-        if _dataset_df is not None:
-            return _dataset_df
+        if _dataset_index is not None:
+            return _dataset_index
 
-        DATA_DIR.mkdir(parents=True, exist_ok=True)
-
-        if not DATASET_PATH.exists():
-            _download_dataset(DATASET_PATH)
+        _ensure_dataset_file()
 
         try:
-            _dataset_df = pd.read_parquet(DATASET_PATH, columns=["MAPPED_TRAIT"])
+            _dataset_index = GwasCatalogIndex.open_or_build(DATASET_PATH, INDEX_DIR)
         except Exception as exc:
             raise DatasetLoadError(f"Unable to load GWAS dataset: {exc}") from exc
 
-        return _dataset_df
+        return _dataset_index
+
+
+def ensure_variant_index_loaded() -> GwasCatalogVariantIndex:
+
+    global _variant_index
+
+    if _variant_index is not None:
+        return _variant_index
+
+    with _dataset_lock:
+        if _variant_index is not None:
+            return _variant_index
+
+        _ensure_dataset_file()
+
+        try:
+            _variant_index = GwasCatalogVariantIndex.open_or_build(
+                DATASET_PATH, VARIANT_INDEX_DIR
+            )
+        except Exception as exc:
+            raise DatasetLoadError(f"Unable to index GWAS dataset variants: {exc}") from exc
+
+        return _variant_index
+
+
+def _ensure_dataset_file() -> None:
+
+    DATA_DIR.mkdir(parents=True, exist_ok=True)
+
+    if not DATASET_PATH.exists():
+        _download_dataset(DATASET_PATH)
 
 
 def _download_dataset(destination: Path) -> None:
@@ -70,14 +100,8 @@ def search_traits(query: str, limit: int = 20) -> List[str]:
     if not query:
         return []
 
-    df = ensure_dataset_loaded()
-
-    traits_series = (
-        df["MAPPED_TRAIT"].astype(str).str.contains(query, case=False, na=False)
-    )
-
-    matches = df.loc[traits_series, "MAPPED_TRAIT"].dropna().astype(str).unique()
-    return list(matches[:limit])
+    index = ensure_dataset_loaded()
+    return index.search(query, limit=limit)
 
 
 def trait_records(trait_name: str, limit: int = 50) -> list[dict]:
@@ -85,19 +109,19 @@ def trait_records(trait_name: str, limit: int = 50) -> list[dict]:
     if not trait_name:
         return []
 
-    df = ensure_dataset_loaded()
-
-    mask = df["MAPPED_TRAIT"].astype(str).str.casefold() == trait_name.casefold()
-    subset = df.loc[mask].head(limit)
+    index = ensure_dataset_loaded()
 
-    if subset.empty:
+    trait_id = index.find_trait(trait_name)
+    if trait_id is None:
         return []
 
-    sanitized = subset.where(pd.notna(subset), None)
-    return json.loads(sanitized.to_json(orient="records"))
+    try:
+        return index.fetch_rows(index.row_ids(trait_id, limit=limit))
+    except Exception as exc:
+        raise DatasetLoadError(f"Unable to read GWAS dataset rows: {exc}") from exc
 
 
 def dataset_columns() -> list[str]:
 
-    df = ensure_dataset_loaded()
-    return list(df.columns)
+    index = ensure_dataset_loaded()
+    return index.columns()
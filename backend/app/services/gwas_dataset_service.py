@@ -23,6 +23,7 @@ from ..repositories import (
 from ..schema.gwas import GwasDatasetStatus, GwasFileFormat
 from .gwas_file_parser import VcfParser, PlinkParser, PhenotypeParser, CustomJsonParser
 from .cloud_storage import get_cloud_storage_manager
+from .genomics.dataset_cache import invalidate_dataset
 
 logger = logging.getLogger(__name__)
 
@@ -270,6 +271,7 @@ class GwasDatasetService:
         if deleted:
             # Delete files from storage
             self.storage.delete_dataset(user_id, dataset_id)
+            invalidate_dataset(dataset_id)
             logger.info(f"Deleted dataset {dataset_id} and all files")
 
         return deleted
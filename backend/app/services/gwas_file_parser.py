@@ -10,10 +10,15 @@ Each parser extracts:
 - SNPs: {rsid, chromosome, position, ref_allele, alt_allele, genotypes}
 - Samples: {sample_id, phenotype, covariates}
 - Metadata: {sample_count, snp_count, file_format, etc.}
+
+VCF records with several ALT alleles are split into biallelic variants while
+reading, and every ALT is normalised (trimmed, and left-aligned when a
+reference FASTA is given).
 """
 
 import csv
 import gzip
+import mmap
 import struct
 from pathlib import Path
 from typing import Dict, Any, List, Optional, Tuple, BinaryIO
@@ -21,18 +26,139 @@ from datetime import datetime
 import re
 
 
+class ReferenceGenome:
+    """
+    Memory-mapped FASTA reference with a samtools ``.fai`` index.
+
+    The index is read from ``<fasta>.fai`` when present and built by one scan
+    of the mapping otherwise. Sequences are fetched by offset arithmetic, so
+    only the touched pages are ever read.
+    """
+
+    def __init__(self, fasta_path: Path):
+        self.path = Path(fasta_path)
+        if str(self.path).endswith(".gz"):
+            raise ValueError("Compressed references are not supported; use an uncompressed FASTA")
+        self._file = open(self.path, "rb")
+        self._mmap = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        self.index: Dict[str, Tuple[int, int, int, int]] = self._load_index()
+
+    def _load_index(self) -> Dict[str, Tuple[int, int, int, int]]:
+        """name -> (length, offset, line bases, line width)."""
+        fai_path = Path(str(self.path) + ".fai")
+        index: Dict[str, Tuple[int, int, int, int]] = {}
+        if fai_path.exists():
+            with open(fai_path) as f:
+                for line in f:
+                    parts = line.rstrip("\n").split("\t")
+                    if len(parts) >= 5:
+                        index[parts[0]] = (int(parts[1]), int(parts[2]), int(parts[3]), int(parts[4]))
+            return index
+
+        data = self._mmap
+        pos = data.find(b">")
+        while pos != -1:
+            header_end = data.find(b"\n", pos)
+            name = data[pos + 1:header_end].split()[0].decode()
+            offset = header_end + 1
+            next_header = data.find(b"\n>", offset)
+            end = len(data) if next_header == -1 else next_header + 1
+            first_line_end = data.find(b"\n", offset, end)
+            line_width = (first_line_end - offset + 1) if first_line_end != -1 else end - offset
+            line_bases = line_width - 1 if first_line_end != -1 else line_width
+            if first_line_end != -1 and data[first_line_end - 1:first_line_end] == b"\r":
+                line_bases -= 1
+            length = len(data[offset:end].replace(b"\n", b"").replace(b"\r", b""))
+            index[name] = (length, offset, line_bases, line_width)
+            pos = -1 if next_header == -1 else next_header + 1
+        return index
+
+    def _resolve(self, chrom: str) -> Optional[Tuple[int, int, int, int]]:
+        for name in (chrom, f"chr{chrom}", chrom[3:] if chrom.lower().startswith("chr") else None):
+            if name and name in self.index:
+                return self.index[name]
+        return None
+
+    def fetch(self, chrom: str, start: int, end: int) -> str:
+        """Uppercase sequence of ``chrom`` from 1-based ``start`` to ``end`` inclusive ("" if unknown)."""
+        entry = self._resolve(chrom)
+        if entry is None or start < 1:
+            return ""
+        length, offset, line_bases, line_width = entry
+        end = min(end, length)
+        if end < start:
+            return ""
+
+        def byte_at(i: int) -> int:
+            return offset + (i // line_bases) * line_width + i % line_bases
+
+        raw = self._mmap[byte_at(start - 1):byte_at(end - 1) + 1]
+        return raw.replace(b"\n", b"").replace(b"\r", b"").decode().upper()
+
+    def close(self) -> None:
+        self._mmap.close()
+        self._file.close()
+
+
+def normalize_variant(
+    chrom: str,
+    pos: int,
+    ref: str,
+    alt: str,
+    reference: Optional[ReferenceGenome] = None,
+) -> Tuple[int, str, str]:
+    """
+    Normalise one biallelic variant (Tan et al. 2015, as in ``vt normalize``).
+
+    Shared trailing bases are trimmed; when that would empty an allele the
+    variant is extended by the preceding reference base, which left-aligns
+    indels through repeats. Without a reference, trimming stops there. Shared
+    leading bases are then trimmed down to one anchor base. Symbolic alleles
+    are returned unchanged.
+
+    Returns:
+        (position, ref, alt)
+    """
+    if ref == alt or not alt or alt[0] in "<*." or "[" in alt or "]" in alt:
+        return pos, ref, alt
+    ref, alt = ref.upper(), alt.upper()
+
+    while ref and alt and ref[-1] == alt[-1]:
+        if len(ref) == 1 or len(alt) == 1:
+            base = reference.fetch(chrom, pos - 1, pos - 1) if reference is not None and pos > 1 else ""
+            if not base:
+                break
+            ref, alt, pos = base + ref, base + alt, pos - 1
+        ref, alt = ref[:-1], alt[:-1]
+
+    while len(ref) > 1 and len(alt) > 1 and ref[0] == alt[0]:
+        ref, alt, pos = ref[1:], alt[1:], pos + 1
+    return pos, ref, alt
+
+
 class VcfParser:
     """Parser for VCF (Variant Call Format) files."""
 
-    def __init__(self, file_path: Path):
+    def __init__(
+        self,
+        file_path: Path,
+        reference_path: Optional[Path] = None,
+        normalize: bool = True,
+    ):
         """
         Initialize VCF parser.
 
         Args:
             file_path: Path to .vcf or .vcf.gz file
+            reference_path: Optional FASTA used to left-align indels
+            normalize: Trim (and with a reference, left-align) split alleles
         """
         self.file_path = file_path
         self.is_gzipped = str(file_path).endswith(".gz")
+        self.normalize = normalize
+        self.reference = ReferenceGenome(reference_path) if reference_path else None
+        self.stats = {"records": 0, "multiallelic_records": 0, "variants": 0, "normalized": 0, "ref_mismatch": 0}
+        self._gt_index_cache: Dict[str, int] = {}
 
     def parse(self, max_snps: Optional[int] = None) -> Dict[str, Any]:
         """
@@ -96,44 +222,16 @@ class VcfParser:
                     if len(fields) < 8:
                         continue  # Invalid line
 
-                chrom = fields[0]
-                pos = int(fields[1])
-                rsid = fields[2] if fields[2] != "." else f"SNP_{chrom}_{pos}"
-                ref = fields[3]
-                alt = fields[4]
-                # qual = fields[5]
-                # filter_status = fields[6]
-                # info = fields[7]
-                format_field = fields[8] if len(fields) > 8 else ""
-                genotype_fields = fields[9:] if len(fields) > 9 else []
-
-                # Parse genotypes
-                genotypes = []
-                if genotype_fields and format_field:
-                    gt_index = self._get_gt_index(format_field)
-                    for gt_field in genotype_fields:
-                        gt = self._parse_genotype(gt_field, gt_index)
-                        genotypes.append(gt)
-
-                # Extract chromosome number (remove "chr" prefix if present)
-                chr_num = self._parse_chromosome(chrom)
-
-                snp = {
-                    "rsid": rsid,
-                    "chromosome": chr_num,
-                    "position": pos,
-                    "ref_allele": ref,
-                    "alt_allele": alt.split(",")[0],  # Take first ALT allele
-                    "genotypes": genotypes,
-                }
-
-                snps.append(snp)
-
-                # Check max SNPs limit
+                for snp in self.split_record(fields, len(sample_ids)):
+                    snps.append(snp)
+                    # Check max SNPs limit
+                    if max_snps is not None and len(snps) >= max_snps:
+                        break
                 if max_snps is not None and len(snps) >= max_snps:
                     break
 
         metadata["snp_count"] = len(snps)
+        metadata["normalization"] = dict(self.stats)
 
         return {
             "snps": snps,
@@ -141,46 +239,113 @@ class VcfParser:
             "metadata": metadata,
         }
 
-    def _get_gt_index(self, format_field: str) -> int:
-        """Get index of GT (genotype) field in FORMAT column."""
-        format_parts = format_field.split(":")
-        try:
-            return format_parts.index("GT")
-        except ValueError:
-            return 0  # Default to first field
-
-    def _parse_genotype(self, gt_field: str, gt_index: int) -> int:
+    def split_record(self, fields: List[str], n_samples: int) -> List[Dict[str, Any]]:
         """
-        Parse genotype field to dosage (0, 1, 2).
+        Decode one VCF data line into biallelic variants, one per ALT allele.
+
+        Genotypes are recoded per ALT allele: the dosage of allele k counts
+        the copies of k, other ALT alleles count as reference (as in
+        ``bcftools norm -m-``), and any missing allele makes the call missing.
+        Distinct GT strings are decoded once per record, so splitting costs
+        about the same as the biallelic path. Split variants get the record's
+        ALT allele appended to their ID (``rs123:T``), so every variant keeps
+        a unique ID; biallelic records keep the ID as written.
 
         Args:
-            gt_field: Genotype field like "0/0", "0|1", "1/1"
-            gt_index: Index of GT in format
+            fields: Tab-split VCF columns
+            n_samples: Number of samples in the header
 
         Returns:
-            Dosage: 0 (ref/ref), 1 (ref/alt), 2 (alt/alt), -1 (missing)
+            SNP dicts (rsid, chromosome, position, ref_allele, alt_allele, genotypes)
         """
-        parts = gt_field.split(":")
-        if gt_index >= len(parts):
-            return -1  # Missing
-
-        gt = parts[gt_index]
-
-        # Handle missing genotypes
-        if gt in [".", "./.", ".|."]:
-            return -1
-
-        # Split by / or |
-        alleles = re.split(r"[/|]", gt)
-        if len(alleles) != 2:
-            return -1
+        chrom = fields[0]
+        pos = int(fields[1])
+        ref = fields[3]
+        alts = fields[4].split(",")
+        self.stats["records"] += 1
+        if len(alts) > 1:
+            self.stats["multiallelic_records"] += 1
+
+        genotype_fields = fields[9:9 + n_samples] if len(fields) > 9 and n_samples else []
+        if genotype_fields and len(fields) > 8:
+            format_field = fields[8]
+            gt_index = self._gt_index_cache.get(format_field)
+            if gt_index is None:
+                gt_index = self._gt_index_cache[format_field] = self._get_gt_index(format_field)
+            columns = self._allele_dosages(genotype_fields, gt_index, len(alts))
+        else:
+            columns = [[] for _ in alts]
+
+        reference_ok = True
+        if self.normalize and self.reference is not None:
+            expected = self.reference.fetch(chrom, pos, pos + len(ref) - 1)
+            reference_ok = not expected or expected == ref.upper()
+            if not reference_ok:
+                self.stats["ref_mismatch"] += 1
+
+        chr_num = self._parse_chromosome(chrom)
+        variants = []
+        for alt, genotypes in zip(alts, columns):
+            if alt == "*":
+                # Spanning deletion: described by the overlapping record
+                continue
+            v_pos, v_ref, v_alt = pos, ref, alt
+            if self.normalize and reference_ok:
+                v_pos, v_ref, v_alt = normalize_variant(chrom, pos, ref, alt, self.reference)
+                if (v_pos, v_ref, v_alt) != (pos, ref, alt):
+                    self.stats["normalized"] += 1
+            if fields[2] == ".":
+                rsid = f"SNP_{chrom}_{pos}_{alt}" if len(alts) > 1 else f"SNP_{chrom}_{pos}"
+            elif len(alts) > 1:
+                rsid = f"{fields[2]}:{alt}"
+            else:
+                rsid = fields[2]
+            variants.append({
+                "rsid": rsid,
+                "chromosome": chr_num,
+                "position": v_pos,
+                "ref_allele": v_ref,
+                "alt_allele": v_alt,
+                "genotypes": genotypes,
+            })
+        self.stats["variants"] += len(variants)
+        return variants
+
+    @staticmethod
+    def _allele_dosages(genotype_fields: List[str], gt_index: int, n_alts: int) -> List[List[int]]:
+        """Per-ALT dosage columns for one record, memoised by GT string."""
+        memo: Dict[Optional[str], Tuple[int, ...]] = {}
+        missing = (-1,) * n_alts
+        calls = []
+        for field in genotype_fields:
+            if gt_index == 0:
+                gt = field.split(":", 1)[0]
+            else:
+                parts = field.split(":")
+                gt = parts[gt_index] if gt_index < len(parts) else None
+            decoded = memo.get(gt)
+            if decoded is None:
+                decoded = missing
+                alleles = re.split(r"[/|]", gt) if gt else []
+                if len(alleles) == 2 and "." not in alleles:
+                    try:
+                        a1, a2 = int(alleles[0]), int(alleles[1])
+                        decoded = tuple((a1 == k) + (a2 == k) for k in range(1, n_alts + 1))
+                    except ValueError:
+                        pass
+                memo[gt] = decoded
+            calls.append(decoded)
+        if not calls:
+            return [[] for _ in range(n_alts)]
+        return [list(column) for column in zip(*calls)]
 
+    def _get_gt_index(self, format_field: str) -> int:
+        """Get index of GT (genotype) field in FORMAT column."""
+        format_parts = format_field.split(":")
         try:
-            a1 = int(alleles[0])
-            a2 = int(alleles[1])
-            return a1 + a2  # Dosage: 0, 1, or 2
-        except (ValueError, TypeError):
-            return -1
+            return format_parts.index("GT")
+        except ValueError:
+            return 0  # Default to first field
 
     def _parse_chromosome(self, chrom: str) -> int:
         """
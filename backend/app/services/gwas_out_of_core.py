@@ -0,0 +1,549 @@
+"""
+Out-of-core GWAS
+================
+Memory-budgeted association testing for cohorts that do not fit in RAM.
+
+Genotypes are streamed in SNP tiles whose size is derived from the
+``memory_budget_mb`` and the sample count, results are buffered up to a fixed
+share of the budget and then sorted by p-value and spilled to disk as shards,
+and the final ordering (and top-K) is produced by an external k-way merge of
+the shards. Nothing proportional to the number of SNPs is held in memory.
+
+Whenever the budget forces a slower path (smaller tiles than preferred,
+spilling, multi-pass merges) the analyzer records it in its memory report so
+the job can surface that it completed in degraded mode.
+"""
+
+from __future__ import annotations
+
+import gzip
+import heapq
+import json
+import logging
+import os
+import shutil
+import tempfile
+from contextlib import contextmanager
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, Iterable, Iterator, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from ..utils.statistics import t_sf_two_sided_array
+from .gwas_file_parser import VcfParser
+
+logger = logging.getLogger(__name__)
+
+# Resident interpreter/numpy footprint that the budget cannot be spent on
+_BASELINE_MB = 64
+# Tile size used when memory is not the constraint
+_PREFERRED_TILE_SNPS = 8192
+# Bytes per sample per SNP in a tile: int8 raw + float64 imputed + float64 residualised
+_TILE_BYTES_PER_GENOTYPE = 17
+# Rough resident size of one buffered association record
+_RESULT_ROW_BYTES = 512
+_MIN_RESULT_BUFFER_ROWS = 1024
+# Maximum shards merged in one pass (open file handles and read buffers)
+_MAX_MERGE_FANIN = 64
+
+_BED_MAGIC = b"\x6c\x1b\x01"
+# PLINK 2-bit codes -> dosage (00 hom ref, 01 missing, 10 het, 11 hom alt)
+_BED_CODE_DOSAGE = np.array([0, -1, 1, 2], dtype=np.int8)
+_BED_BYTE_LUT = np.stack(
+    [_BED_CODE_DOSAGE[(np.arange(256) >> shift) & 0b11] for shift in (0, 2, 4, 6)],
+    axis=1,
+)
+
+SnpMeta = Dict[str, Any]
+Tile = Tuple[List[SnpMeta], np.ndarray]
+
+
+@dataclass
+class MemoryPlan:
+    """Working-set sizes chosen for a memory budget."""
+
+    memory_budget_mb: int
+    n_samples: int
+    tile_snps: int
+    result_buffer_rows: int
+    degraded: bool = False
+    reasons: List[str] = field(default_factory=list)
+
+
+def plan_memory(memory_budget_mb: int, n_samples: int, n_covariates: int = 0) -> MemoryPlan:
+    """
+    Choose tile and buffer sizes so the working set stays under the budget.
+
+    Half of the budget above the baseline goes to the genotype tile, a quarter
+    to the result buffer and the rest is headroom for the covariate projection
+    and merge buffers.
+
+    Args:
+        memory_budget_mb: Peak memory allowed for the analysis
+        n_samples: Number of samples per SNP
+        n_covariates: Number of covariates (including none for the intercept)
+
+    Returns:
+        MemoryPlan with the chosen sizes and any degradation reasons
+    """
+    if memory_budget_mb <= 0:
+        raise ValueError(f"memory_budget_mb must be positive, got: {memory_budget_mb}")
+    if n_samples <= 0:
+        raise ValueError("Cannot plan an analysis with no samples")
+
+    reasons: List[str] = []
+    working = (memory_budget_mb - _BASELINE_MB) * 1024 * 1024
+    # Covariate matrix and its projection are resident for the whole run
+    working -= n_samples * (n_covariates + 1) * 8 * 2
+    if working <= 0:
+        working = 0
+        reasons.append(
+            f"budget of {memory_budget_mb} MB leaves no working memory above the "
+            f"{_BASELINE_MB} MB baseline; running with minimal tiles"
+        )
+
+    per_snp = n_samples * _TILE_BYTES_PER_GENOTYPE
+    tile_snps = max(1, min(_PREFERRED_TILE_SNPS, (working // 2) // per_snp))
+    if tile_snps < _PREFERRED_TILE_SNPS and working > 0:
+        reasons.append(
+            f"genotype tiles reduced to {tile_snps} SNPs (preferred {_PREFERRED_TILE_SNPS})"
+        )
+
+    buffer_rows = max(_MIN_RESULT_BUFFER_ROWS, (working // 4) // _RESULT_ROW_BYTES)
+
+    return MemoryPlan(
+        memory_budget_mb=memory_budget_mb,
+        n_samples=n_samples,
+        tile_snps=int(tile_snps),
+        result_buffer_rows=int(buffer_rows),
+        degraded=bool(reasons),
+        reasons=reasons,
+    )
+
+
+# ============================================================================
+# Streaming genotype readers
+# ============================================================================
+
+def read_vcf_samples(vcf_path: Path) -> List[str]:
+    """Sample IDs from the #CHROM header line of a VCF."""
+    open_func = gzip.open if str(vcf_path).endswith(".gz") else open
+    with open_func(vcf_path, "rt") as f:
+        for line in f:
+            if line.startswith("#CHROM"):
+                columns = line.rstrip("\n").split("\t")
+                if len(columns) <= 1:
+                    columns = line.split()
+                return columns[9:]
+            if not line.startswith("#"):
+                break
+    return []
+
+
+def iter_vcf_tiles(
+    vcf_path: Path,
+    tile_snps: int,
+    reference_path: Optional[Path] = None,
+) -> Iterator[Tile]:
+    """
+    Stream a VCF as (SNP metadata, int8 dosage matrix) tiles.
+
+    Only one tile of genotypes is resident at a time; dosages use -1 for
+    missing calls. Multi-allelic records are split into one row per ALT
+    allele and alleles are normalised (left-aligned against
+    ``reference_path`` when given), so a record may span two tiles.
+    """
+    parser = VcfParser(vcf_path, reference_path=reference_path)
+    open_func = gzip.open if parser.is_gzipped else open
+    n_samples = len(read_vcf_samples(vcf_path))
+
+    metas: List[SnpMeta] = []
+    tile = np.empty((tile_snps, n_samples), dtype=np.int8)
+
+    with open_func(vcf_path, "rt") as f:
+        for line in f:
+            if not line or line[0] == "#":
+                continue
+            fields = line.rstrip("\n").split("\t")
+            if len(fields) < 8:
+                fields = line.split()
+                if len(fields) < 8:
+                    continue
+
+            for variant in parser.split_record(fields, n_samples):
+                genotypes = variant.pop("genotypes")
+                tile[len(metas)] = genotypes if len(genotypes) == n_samples else -1
+                metas.append(variant)
+                if len(metas) == tile_snps:
+                    yield metas, tile
+                    metas = []
+                    tile = np.empty((tile_snps, n_samples), dtype=np.int8)
+
+    if metas:
+        yield metas, tile[:len(metas)]
+
+
+def iter_bed_tiles(
+    bed_path: Path,
+    n_samples: int,
+    snp_info: Iterable[SnpMeta],
+    tile_snps: int,
+) -> Iterator[Tile]:
+    """
+    Stream a SNP-major PLINK .bed as (SNP metadata, int8 dosage matrix) tiles.
+
+    The file is memory-mapped, so only the pages of the current tile are
+    touched; the 2-bit codes are decoded through a 256-entry byte table.
+    """
+    bytes_per_snp = (n_samples + 3) // 4
+    with open(bed_path, "rb") as f:
+        if f.read(3) != _BED_MAGIC:
+            raise ValueError("Invalid BED file: bad magic number or not SNP-major")
+    packed = np.memmap(bed_path, dtype=np.uint8, mode="r", offset=3)
+    n_snps = packed.shape[0] // bytes_per_snp
+    packed = packed[:n_snps * bytes_per_snp].reshape(n_snps, bytes_per_snp)
+
+    metas: List[SnpMeta] = []
+    start = 0
+    for meta in snp_info:
+        if start + len(metas) >= n_snps:
+            break
+        metas.append(meta)
+        if len(metas) == tile_snps:
+            block = packed[start:start + len(metas)]
+            yield metas, _BED_BYTE_LUT[block].reshape(len(metas), -1)[:, :n_samples]
+            start += len(metas)
+            metas = []
+    if metas:
+        block = packed[start:start + len(metas)]
+        yield metas, _BED_BYTE_LUT[block].reshape(len(metas), -1)[:, :n_samples]
+
+
+# ============================================================================
+# Analyzer
+# ============================================================================
+
+def regression_statistics(
+    g: np.ndarray,
+    y_res: np.ndarray,
+    yy: Any,
+    df: int,
+) -> Tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+    """
+    Per-row simple regression of residualised phenotypes on residualised dosages.
+
+    Args:
+        g: (rows, n) dosages with the covariate space projected out
+        y_res: (n,) residual phenotype shared by all rows, or (rows, n) with
+            one phenotype per row (simulation replicates)
+        yy: residual sum of squares of ``y_res`` (scalar or per row)
+        df: residual degrees of freedom
+
+    Returns:
+        (beta, se, t_stat, usable) per row; rows without genotype variance
+        are flagged unusable and get zero statistics.
+    """
+    gg = np.einsum("ij,ij->i", g, g)
+    gy = np.einsum("ij,ij->i", g, y_res) if y_res.ndim == 2 else g @ y_res
+    usable = gg > 1e-12
+
+    beta = np.divide(gy, gg, out=np.zeros_like(gy), where=usable)
+    rss = np.maximum(yy - beta * gy, 0.0)
+    se = np.sqrt(np.divide(rss / df, gg, out=np.zeros_like(gg), where=usable))
+    t_stat = np.divide(beta, se, out=np.zeros_like(beta), where=se > 0)
+    return beta, se, t_stat, usable
+
+
+def _shard_key(line: str) -> float:
+    # Shard lines start with the p-value followed by a tab
+    return float(line[:line.index("\t")])
+
+
+class OutOfCoreGwasAnalyzer:
+    """
+    Linear-regression GWAS within a fixed memory budget.
+
+    Usage::
+
+        with OutOfCoreGwasAnalyzer(256, n_samples=len(y)) as analyzer:
+            analyzer.run(iter_vcf_tiles(path, analyzer.plan.tile_snps), y)
+            top = analyzer.top_hits(100, 1e-5)
+            for record in analyzer.iter_sorted():
+                ...
+    """
+
+    def __init__(
+        self,
+        memory_budget_mb: int,
+        n_samples: int,
+        covariates: Optional[np.ndarray] = None,
+        maf_threshold: float = 0.01,
+        spill_dir: Optional[str] = None,
+    ):
+        n_covariates = 0 if covariates is None else covariates.shape[1]
+        self.plan = plan_memory(memory_budget_mb, n_samples, n_covariates)
+        self.maf_threshold = maf_threshold
+        self.covariates = covariates
+        self._spill_root = spill_dir
+        self._spill_dir: Optional[str] = None
+        self._buffer: List[Tuple[float, Dict[str, Any]]] = []
+        self._shards: List[str] = []
+        self.tiles_processed = 0
+        self.snps_tested = 0
+        self.snps_filtered = 0
+        self.merge_passes = 0
+
+    def __enter__(self) -> "OutOfCoreGwasAnalyzer":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+    def close(self) -> None:
+        """Remove spilled shards."""
+        if self._spill_dir is not None:
+            shutil.rmtree(self._spill_dir, ignore_errors=True)
+            self._spill_dir = None
+            self._shards = []
+
+    # ------------------------------------------------------------------
+    # Association pass
+    # ------------------------------------------------------------------
+
+    def run(self, tiles: Iterable[Tile], phenotype: Sequence[float]) -> None:
+        """
+        Test every SNP in ``tiles`` against ``phenotype``.
+
+        Samples with a missing (NaN) phenotype or covariate are dropped;
+        missing genotypes are mean-imputed per SNP.
+        """
+        y = np.asarray(phenotype, dtype=np.float64)
+        keep = ~np.isnan(y)
+        design = np.ones((y.shape[0], 1))
+        if self.covariates is not None:
+            keep &= ~np.isnan(self.covariates).any(axis=1)
+            design = np.column_stack([design, self.covariates])
+        y, design = y[keep], design[keep]
+
+        n = y.shape[0]
+        df = n - design.shape[1] - 1
+        if df < 1:
+            raise ValueError("Not enough samples for analysis")
+
+        # Residualising on the covariates once turns each SNP into a simple
+        # regression on residuals (Frisch-Waugh-Lovell)
+        q, _ = np.linalg.qr(design)
+        y_res = y - q @ (q.T @ y)
+        yy = float(y_res @ y_res)
+        if yy <= 0:
+            raise ValueError("Phenotype variance is zero")
+
+        for metas, dosages in tiles:
+            self._test_tile(metas, dosages[:, keep], q, y_res, yy, n, df)
+            self.tiles_processed += 1
+
+    def _test_tile(
+        self,
+        metas: List[SnpMeta],
+        dosages: np.ndarray,
+        q: np.ndarray,
+        y_res: np.ndarray,
+        yy: float,
+        n: int,
+        df: int,
+    ) -> None:
+        observed = dosages >= 0
+        counts = observed.sum(axis=1)
+        g = dosages.astype(np.float64)
+        g[~observed] = 0.0
+        with np.errstate(invalid="ignore", divide="ignore"):
+            means = g.sum(axis=1) / counts
+        freq = means / 2.0
+        maf = np.minimum(freq, 1.0 - freq)
+
+        valid = (counts >= 3) & (maf >= self.maf_threshold)
+        self.snps_filtered += int((~valid).sum())
+        if not valid.any():
+            return
+
+        rows = np.flatnonzero(valid)
+        g = g[rows]
+        g += np.where(observed[rows], 0.0, means[rows, None])
+        g -= (g @ q) @ q.T
+
+        beta, se, t_stat, usable = regression_statistics(g, y_res, yy, df)
+        self.snps_filtered += int((~usable).sum())
+
+        tested = np.flatnonzero(usable)
+        p_values = np.maximum(t_sf_two_sided_array(t_stat[tested], df), 1e-300)
+        for k, p_value in zip(tested.tolist(), p_values.tolist()):
+            i = rows[k]
+            record = dict(metas[i])
+            record.update(
+                beta=float(beta[k]),
+                se=float(se[k]),
+                t_stat=float(t_stat[k]),
+                p_value=p_value,
+                maf=float(maf[i]),
+                n_samples=int(counts[i]),
+            )
+            self._buffer.append((p_value, record))
+        self.snps_tested += tested.size
+
+        if len(self._buffer) >= self.plan.result_buffer_rows:
+            self._spill()
+
+    # ------------------------------------------------------------------
+    # Spilling and external merge
+    # ------------------------------------------------------------------
+
+    def _new_shard_path(self) -> str:
+        if self._spill_dir is None:
+            self._spill_dir = tempfile.mkdtemp(prefix="gwas_ooc_", dir=self._spill_root)
+        return os.path.join(self._spill_dir, f"shard_{len(self._shards):05d}.tsv")
+
+    def _spill(self) -> None:
+        self._buffer.sort(key=lambda item: item[0])
+        path = self._new_shard_path()
+        with open(path, "w") as f:
+            for p_value, record in self._buffer:
+                f.write(f"{p_value!r}\t{json.dumps(record, separators=(',', ':'))}\n")
+        self._shards.append(path)
+        self._buffer = []
+
+    def _merge_shards(self, paths: List[str], out_path: str) -> None:
+        handles = [open(path) for path in paths]
+        try:
+            with open(out_path, "w") as out:
+                out.writelines(heapq.merge(*handles, key=_shard_key))
+        finally:
+            for handle in handles:
+                handle.close()
+        for path in paths:
+            os.unlink(path)
+
+    def _reduce_fanin(self) -> None:
+        """Merge shards in passes until one final merge fits the fan-in limit."""
+        while len(self._shards) > _MAX_MERGE_FANIN:
+            self.merge_passes += 1
+            merged: List[str] = []
+            for start in range(0, len(self._shards), _MAX_MERGE_FANIN):
+                group = self._shards[start:start + _MAX_MERGE_FANIN]
+                out_path = os.path.join(self._spill_dir, f"pass{self.merge_passes}_{len(merged):05d}.tsv")
+                self._merge_shards(group, out_path)
+                merged.append(out_path)
+            self._shards = merged
+
+    def finish(self) -> None:
+        """Spill the remaining buffer and pre-merge shards down to one final merge."""
+        if self._shards:
+            if self._buffer:
+                self._spill()
+            self._reduce_fanin()
+
+    def iter_sorted(self) -> Iterator[Dict[str, Any]]:
+        """Stream all association records in ascending p-value order."""
+        if not self._shards:
+            self._buffer.sort(key=lambda item: item[0])
+            for _, record in self._buffer:
+                yield record
+            return
+
+        self.finish()
+        handles = [open(path) for path in self._shards]
+        try:
+            for line in heapq.merge(*handles, key=_shard_key):
+                yield json.loads(line[line.index("\t") + 1:])
+        finally:
+            for handle in handles:
+                handle.close()
+
+    def top_hits(self, limit: int = 100, p_threshold: float = 1.0) -> List[Dict[str, Any]]:
+        """The ``limit`` smallest p-values below ``p_threshold``."""
+        hits: List[Dict[str, Any]] = []
+        for record in self.iter_sorted():
+            if record["p_value"] >= p_threshold or len(hits) >= limit:
+                break
+            hits.append(record)
+        return hits
+
+    # ------------------------------------------------------------------
+    # Reporting
+    # ------------------------------------------------------------------
+
+    def memory_report(self) -> Dict[str, Any]:
+        """Budget, chosen sizes and whether (and why) the run was degraded."""
+        reasons = list(self.plan.reasons)
+        if self._shards:
+            reasons.append(
+                f"result buffer exceeded {self.plan.result_buffer_rows} rows; "
+                f"spilled {len(self._shards)} sorted shards to disk"
+            )
+        if self.merge_passes:
+            reasons.append(f"external merge needed {self.merge_passes} extra passes")
+        return {
+            "memory_budget_mb": self.plan.memory_budget_mb,
+            "tile_snps": self.plan.tile_snps,
+            "tiles_processed": self.tiles_processed,
+            "result_buffer_rows": self.plan.result_buffer_rows,
+            "spilled_shards": len(self._shards),
+            "merge_passes": self.merge_passes,
+            "degraded": bool(reasons),
+            "reasons": reasons,
+        }
+
+
+@contextmanager
+def run_out_of_core_gwas(
+    genotype_path: Path,
+    phenotype: Sequence[float],
+    memory_budget_mb: int,
+    covariates: Optional[np.ndarray] = None,
+    maf_threshold: float = 0.01,
+    reference_path: Optional[Path] = None,
+) -> Iterator[Dict[str, Any]]:
+    """
+    Run a memory-budgeted linear GWAS on a local VCF and yield a response
+    shaped like the engine's (``results`` sorted by p-value).
+
+    ``results`` is streamed from the external merge of the spilled shards, so
+    it must be consumed inside the ``with`` block; the shards are removed on
+    exit::
+
+        with run_out_of_core_gwas(path, y, 256) as response:
+            for record in response["results"]:
+                ...
+
+    Args:
+        genotype_path: Local .vcf or .vcf.gz path
+        phenotype: Phenotype values in VCF sample order (NaN = missing)
+        memory_budget_mb: Peak memory allowed for the analysis
+        covariates: Optional (n_samples, n_covariates) matrix in VCF sample order
+        maf_threshold: Minimum minor allele frequency
+        reference_path: Optional FASTA used to left-align indels
+
+    Yields:
+        Dict with results (iterator), snps_tested, snps_filtered and memory_report
+    """
+    with OutOfCoreGwasAnalyzer(
+        memory_budget_mb,
+        n_samples=len(phenotype),
+        covariates=covariates,
+        maf_threshold=maf_threshold,
+    ) as analyzer:
+        analyzer.run(
+            iter_vcf_tiles(genotype_path, analyzer.plan.tile_snps, reference_path), phenotype
+        )
+        analyzer.finish()
+        report = analyzer.memory_report()
+        if report["degraded"]:
+            logger.warning("Out-of-core GWAS ran in degraded mode: %s", "; ".join(report["reasons"]))
+
+        yield {
+            "success": True,
+            "results": analyzer.iter_sorted(),
+            "snps_tested": analyzer.snps_tested,
+            "snps_filtered": analyzer.snps_filtered,
+            "memory_report": report,
+        }
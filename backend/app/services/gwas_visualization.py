@@ -6,8 +6,9 @@ Generates Manhattan plot, Q-Q plot, and summary data for frontend widgets.
 
 from __future__ import annotations
 
+import heapq
 import math
-from typing import Dict, List, Any, Tuple
+from typing import Dict, List, Any, Optional, Tuple
 from collections import defaultdict
 
 from ..schema.gwas import SnpAssociation
@@ -181,7 +182,8 @@ def calculate_genomic_inflation(p_values: List[float]) -> float:
     # Approximation using simplified formula
     chi_squares = []
     for p in p_values:
-        if p > 0 and p < 1:
+        # p = 1 is a chi-square of 0 and counts towards the median
+        if p > 0 and p <= 1:
             # Convert p-value to z-score (approximate)
             z = abs(_inverse_normal_cdf(p / 2))
             chi_squares.append(z * z)
@@ -360,3 +362,143 @@ def generate_summary_statistics(associations: List[SnpAssociation]) -> Dict[str,
         "mean_chi_square": None,  # Optional field
         "median_p_value": round(median_p, 6) if median_p is not None else None,
     }
+
+
+# Q-Q display: every point up to this many SNPs, else the tail plus a uniform sample
+_QQ_DISPLAY_POINTS = 1000
+_QQ_TAIL_POINTS = 200
+
+
+class StreamingGwasSummary:
+    """
+    Manhattan, Q-Q, top-hit and summary data from associations streamed in
+    ascending p-value order (as the out-of-core merge yields them).
+
+    Produces the same output as the list-based generators above without
+    holding the associations: the Q-Q points and medians sit at indices
+    known from ``n_snps`` up front, and the top hits are a bounded heap.
+    Only the downsampled Manhattan points grow with the SNP count.
+    """
+
+    def __init__(self, n_snps: int, top_limit: int = 100, top_p_threshold: float = 1e-5):
+        """
+        Args:
+            n_snps: Number of associations that will be added
+            top_limit: Maximum number of top hits kept
+            top_p_threshold: P-value threshold for top hits
+        """
+        self.n_snps = n_snps
+        self.top_limit = top_limit
+        self.top_p_threshold = top_p_threshold
+        self.count = 0
+        self._zeros = 0
+        self._positive = 0
+        self._last_p = -math.inf
+        self._chromosomes: Dict[int, Dict[str, List]] = defaultdict(
+            lambda: {"positions": [], "p_values": [], "labels": []}
+        )
+        self._top: List[Tuple[float, int, SnpAssociation]] = []
+        self._bonferroni = 0
+        self._fdr = 0
+        # Targets among the positive p-values, fixed once the zeros are past
+        self._qq_targets: Optional[List[int]] = None
+        self._median_targets: List[int] = []
+        self._qq_observed: List[float] = []
+        self._qq_expected: List[float] = []
+        self._median_p: List[float] = []
+        self._n_positive = 0
+
+    def _set_targets(self) -> None:
+        n = max(self.n_snps - self._zeros, 0)
+        if n <= _QQ_DISPLAY_POINTS:
+            self._qq_targets = list(range(n))
+        else:
+            step = (n - _QQ_TAIL_POINTS) / (_QQ_DISPLAY_POINTS - _QQ_TAIL_POINTS)
+            self._qq_targets = list(range(_QQ_TAIL_POINTS)) + [
+                int(_QQ_TAIL_POINTS + i * step) for i in range(_QQ_DISPLAY_POINTS - _QQ_TAIL_POINTS)
+            ]
+        self._qq_targets.reverse()
+        self._median_targets = sorted({(n - 1) // 2, n // 2}, reverse=True) if n else []
+        self._n_positive = n
+
+    def add(self, assoc: SnpAssociation) -> None:
+        """Add the next association (p-values must not decrease)."""
+        p = assoc.p_value
+        if p < self._last_p:
+            raise ValueError("Associations must be streamed in ascending p-value order")
+        self._last_p = p
+
+        # Manhattan: the same index-based downsampling as generate_manhattan_data
+        if p < 0.01 or self.count % 10 == 0:
+            data = self._chromosomes[assoc.chromosome]
+            data["positions"].append(assoc.position)
+            data["p_values"].append(p)
+            data["labels"].append(assoc.rsid if p < 1e-5 else "")
+        self.count += 1
+
+        if p < 5e-8:
+            self._bonferroni += 1
+        if p < 1e-5:
+            self._fdr += 1
+        if p < self.top_p_threshold:
+            # Max-heap on p via negation; the count breaks ties in arrival order
+            item = (-p, -self.count, assoc)
+            if len(self._top) < self.top_limit:
+                heapq.heappush(self._top, item)
+            elif item > self._top[0]:
+                heapq.heapreplace(self._top, item)
+
+        if p <= 0:
+            self._zeros += 1
+            return
+        if self._qq_targets is None:
+            self._set_targets()
+        index = self._positive
+        self._positive += 1
+        while self._qq_targets and self._qq_targets[-1] == index:
+            self._qq_targets.pop()
+            self._qq_expected.append(-math.log10((index + 0.5) / self._n_positive))
+            self._qq_observed.append(-math.log10(p))
+        while self._median_targets and self._median_targets[-1] == index:
+            self._median_targets.pop()
+            self._median_p.append(p)
+
+    def manhattan_data(self) -> Dict[str, Any]:
+        """Manhattan plot data, as generate_manhattan_data."""
+        return {
+            "chromosomes": [
+                {"chr": chr_num, **data} for chr_num, data in sorted(self._chromosomes.items())
+            ],
+        }
+
+    def _lambda_gc(self) -> float:
+        chi_squares = [_inverse_normal_cdf(p / 2) ** 2 for p in self._median_p]
+        return _median(chi_squares) / 0.456 if chi_squares else 1.0
+
+    def qq_data(self) -> Dict[str, Any]:
+        """Q-Q plot data, as generate_qq_data."""
+        if not self._positive:
+            return {"expected": [], "observed": [], "genomic_inflation_lambda": 1.0}
+        return {
+            "expected": self._qq_expected,
+            "observed": self._qq_observed,
+            "genomic_inflation_lambda": round(self._lambda_gc(), 3),
+        }
+
+    def top_associations(self) -> List[SnpAssociation]:
+        """Top hits sorted by p-value, as get_top_associations."""
+        return [assoc for _, _, assoc in sorted(self._top, reverse=True)]
+
+    def summary_statistics(self) -> Dict[str, Any]:
+        """Summary statistics, as generate_summary_statistics."""
+        if not self.count:
+            return generate_summary_statistics([])
+        median_p = _median(self._median_p) if self._median_p else None
+        return {
+            "total_snps_tested": self.count,
+            "significant_snps_bonferroni": self._bonferroni,
+            "significant_snps_fdr": self._fdr,
+            "genomic_inflation_lambda": round(self._lambda_gc(), 3),
+            "mean_chi_square": None,
+            "median_p_value": round(median_p, 6) if median_p is not None else None,
+        }
@@ -0,0 +1,505 @@
+"""
+Inverse Cross Solver
+====================
+Infers which parental genotypes (and, for two linked loci, which
+recombination fraction) best explain observed offspring phenotype counts.
+
+Hypotheses are scored by the multinomial log-likelihood of the observed
+counts under the exact offspring distribution of the cross:
+
+- Unlinked loci assort independently, so a hypothesis' log-likelihood is the
+  sum of per-locus log-likelihoods of the marginal counts. Each locus' parent
+  pairs are scored once and the top hypotheses are found by branch-and-bound
+  over loci, bounding the unexplored loci by their best achievable score.
+- Two linked loci are searched over pairs of phased two-locus parents. The
+  offspring distribution is a quadratic in r, so the three coefficient
+  vectors are cached per parent pair and r is fitted by golden-section
+  search. Hypotheses are visited in order of an upper bound (one locus'
+  marginal log-likelihood plus the saturated conditional log-likelihood of
+  the other) and the search stops once no remaining bound can enter the top.
+
+Parent pairs that give zero probability to any observed phenotype are pruned
+before they are scored. Exact single-locus cross distributions are cached
+across requests.
+"""
+
+from __future__ import annotations
+
+import heapq
+import itertools
+import math
+import threading
+from collections import OrderedDict
+from typing import Dict, List, Mapping, Optional, Sequence, Tuple
+
+import numpy as np
+
+from app.core.metrics import register_cache
+from app.models import Trait
+from app.models.mendelian_calculator import allele_counts, counts_to_genotype, offspring_distribution
+from app.utils.statistics import chi2_sf
+
+GOLDEN_RATIO = (math.sqrt(5.0) - 1.0) / 2.0
+RECOMBINATION_TOLERANCE = 1e-5
+MAX_LINKED_HYPOTHESES = 250_000
+
+Haplotype = Tuple[str, str]
+PhasedGenotype = Tuple[Haplotype, Haplotype]
+
+
+class InverseCrossError(ValueError):
+    """Raised when observations cannot be matched to the requested traits."""
+
+
+# ----------------------------------------------------------------------
+# Cached exact crosses
+# ----------------------------------------------------------------------
+
+class _CrossCache:
+    """LRU cache of exact single-locus phenotype distributions."""
+
+    def __init__(self, max_size: int = 50_000):
+        self.max_size = max_size
+        self.entries: OrderedDict[tuple, Dict[str, float]] = OrderedDict()
+        self.lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+
+    def phenotypes(self, trait: Trait, signature: tuple, parent1: str, parent2: str) -> Dict[str, float]:
+        key = (signature, parent1, parent2)
+        with self.lock:
+            cached = self.entries.get(key)
+            if cached is not None:
+                self.hits += 1
+                self.entries.move_to_end(key)
+                return cached
+
+        counts1 = allele_counts(trait._parse_genotype(parent1), trait.alleles)
+        counts2 = allele_counts(trait._parse_genotype(parent2), trait.alleles)
+        genotypes = {
+            counts_to_genotype(child, trait.alleles): p
+            for child, p in offspring_distribution(counts1, counts2).items()
+        }
+        result = trait.phenotype_distribution(genotypes)
+
+        with self.lock:
+            self.misses += 1
+            self.entries[key] = result
+            while len(self.entries) > self.max_size:
+                self.entries.popitem(last=False)
+        return result
+
+    def get_stats(self) -> dict:
+        total = self.hits + self.misses
+        return {
+            "size": len(self.entries),
+            "max_size": self.max_size,
+            "hits": self.hits,
+            "misses": self.misses,
+            "hit_rate": f"{(self.hits / total * 100) if total else 0:.1f}%",
+        }
+
+
+_cross_cache = _CrossCache()
+register_cache("inverse_cross", _cross_cache.get_stats)
+
+
+def get_cross_cache() -> _CrossCache:
+    return _cross_cache
+
+
+def _trait_signature(trait: Trait) -> tuple:
+    return (trait.alleles, trait.ploidy, tuple(sorted(trait.phenotype_map.items())))
+
+
+# ----------------------------------------------------------------------
+# Scoring
+# ----------------------------------------------------------------------
+
+def _log_likelihood(counts: np.ndarray, probabilities: np.ndarray) -> float:
+    """Multinomial log-likelihood (without the constant); -inf if an observed class is impossible."""
+    observed = counts > 0
+    if np.any(probabilities[observed] <= 0):
+        return -math.inf
+    return float(np.sum(counts[observed] * np.log(probabilities[observed])))
+
+
+def _saturated_log_likelihood(counts: np.ndarray) -> float:
+    total = counts.sum()
+    observed = counts > 0
+    return float(np.sum(counts[observed] * np.log(counts[observed] / total))) if total else 0.0
+
+
+def _conditional_saturated(joint_counts: np.ndarray) -> float:
+    """Best achievable log-likelihood of the second locus given the first (rows)."""
+    total = 0.0
+    for row in joint_counts:
+        total += _saturated_log_likelihood(row)
+    return total
+
+
+def golden_section_maximize(f, low: float, high: float, tolerance: float = RECOMBINATION_TOLERANCE) -> Tuple[float, float]:
+    """Maximise a unimodal function on [low, high]; returns (argmax, max), endpoints included."""
+    a, b = low, high
+    c = b - GOLDEN_RATIO * (b - a)
+    d = a + GOLDEN_RATIO * (b - a)
+    fc, fd = f(c), f(d)
+    while b - a > tolerance:
+        if fc >= fd:
+            b, d, fd = d, c, fc
+            c = b - GOLDEN_RATIO * (b - a)
+            fc = f(c)
+        else:
+            a, c, fc = c, d, fd
+            d = a + GOLDEN_RATIO * (b - a)
+            fd = f(d)
+    best = max(((c, fc), (d, fd), (low, f(low)), (high, f(high))), key=lambda item: item[1])
+    return best
+
+
+def _fit(counts: np.ndarray, probabilities: np.ndarray, estimated_parameters: int) -> Dict[str, object]:
+    """χ² goodness of fit over every class with non-zero expectation."""
+    total = counts.sum()
+    expected = probabilities * total
+    considered = expected > 0
+    chi_square = float(np.sum((counts[considered] - expected[considered]) ** 2 / expected[considered]))
+    df = int(np.count_nonzero(considered)) - 1 - estimated_parameters
+    return {
+        "chi_square": chi_square,
+        "degrees_of_freedom": df,
+        "p_value": chi2_sf(chi_square, df) if df > 0 else None,
+        "expected_counts": expected.tolist(),
+    }
+
+
+# ----------------------------------------------------------------------
+# Observation handling
+# ----------------------------------------------------------------------
+
+def _phenotype_classes(trait: Trait) -> List[str]:
+    return list(dict.fromkeys(trait.phenotype_for(g) for g in trait.all_genotypes()))
+
+
+def _observed_table(
+    trait_keys: Sequence[str],
+    traits: Mapping[str, Trait],
+    observed: Sequence[Tuple[Sequence[str], int]],
+) -> Tuple[List[List[str]], np.ndarray]:
+    """Joint count table indexed by each trait's phenotype classes."""
+    classes = [_phenotype_classes(traits[key]) for key in trait_keys]
+    index = [{phenotype.lower(): i for i, phenotype in enumerate(c)} for c in classes]
+    table = np.zeros([len(c) for c in classes])
+    for phenotypes, count in observed:
+        if len(phenotypes) != len(trait_keys):
+            raise InverseCrossError(
+                f"Each observation needs {len(trait_keys)} phenotype(s), got: {list(phenotypes)}")
+        position = []
+        for key, lookup, phenotype in zip(trait_keys, index, phenotypes):
+            if phenotype.strip().lower() not in lookup:
+                raise InverseCrossError(
+                    f"Phenotype '{phenotype}' is not produced by any genotype of trait '{key}'")
+            position.append(lookup[phenotype.strip().lower()])
+        table[tuple(position)] += count
+    if table.sum() <= 0:
+        raise InverseCrossError("At least one offspring must be observed")
+    return classes, table
+
+
+def _parent_pairs(trait: Trait) -> List[Tuple[str, str]]:
+    """Unordered parental genotype pairs (a cross is symmetric in its parents)."""
+    return list(itertools.combinations_with_replacement(trait.all_genotypes(), 2))
+
+
+def _locus_candidates(
+    trait: Trait,
+    classes: List[str],
+    counts: np.ndarray,
+    stats: Dict[str, int],
+) -> List[Tuple[float, Tuple[str, str], np.ndarray]]:
+    """Scored, pruned parent pairs of one locus, best first."""
+    signature = _trait_signature(trait)
+    index = {phenotype: i for i, phenotype in enumerate(classes)}
+    candidates = []
+    for parent1, parent2 in _parent_pairs(trait):
+        distribution = _cross_cache.phenotypes(trait, signature, parent1, parent2)
+        probabilities = np.zeros(len(classes))
+        for phenotype, p in distribution.items():
+            probabilities[index[phenotype]] += p
+        score = _log_likelihood(counts, probabilities)
+        if score == -math.inf:
+            stats["pruned"] += 1
+            continue
+        stats["evaluated"] += 1
+        candidates.append((score, (parent1, parent2), probabilities))
+    candidates.sort(key=lambda item: -item[0])
+    return candidates
+
+
+# ----------------------------------------------------------------------
+# Unlinked search
+# ----------------------------------------------------------------------
+
+def _search_unlinked(
+    trait_keys: Sequence[str],
+    traits: Mapping[str, Trait],
+    classes: List[List[str]],
+    table: np.ndarray,
+    max_hypotheses: int,
+    stats: Dict[str, int],
+) -> List[Dict[str, object]]:
+    loci = []
+    for axis, key in enumerate(trait_keys):
+        marginal = table.sum(axis=tuple(i for i in range(table.ndim) if i != axis))
+        loci.append(_locus_candidates(traits[key], classes[axis], marginal, stats))
+        if not loci[-1]:
+            return []
+
+    # best_rest[i] bounds the score any assignment of loci i.. can add
+    best_rest = [0.0] * (len(loci) + 1)
+    for i in range(len(loci) - 1, -1, -1):
+        best_rest[i] = best_rest[i + 1] + loci[i][0][0]
+
+    top: List[Tuple[float, int, tuple]] = []  # min-heap of (score, tiebreak, choice indices)
+    counter = itertools.count()
+
+    def branch(depth: int, score: float, chosen: Tuple[int, ...]) -> None:
+        if depth == len(loci):
+            entry = (score, next(counter), chosen)
+            if len(top) < max_hypotheses:
+                heapq.heappush(top, entry)
+            else:
+                heapq.heappushpop(top, entry)
+            return
+        for i, (locus_score, _, _) in enumerate(loci[depth]):
+            bound = score + locus_score + best_rest[depth + 1]
+            if len(top) >= max_hypotheses and bound <= top[0][0]:
+                # Candidates are sorted, so every later one is bounded too
+                stats["bounded"] += len(loci[depth]) - i
+                return
+            branch(depth + 1, score + locus_score, chosen + (i,))
+
+    branch(0, 0.0, ())
+
+    hypotheses = []
+    for score, _, chosen in sorted(top, key=lambda item: -item[0]):
+        probabilities = np.ones(())
+        parent1, parent2 = {}, {}
+        for key, locus, i in zip(trait_keys, loci, chosen):
+            _, (g1, g2), locus_probabilities = locus[i]
+            parent1[key], parent2[key] = g1, g2
+            probabilities = np.multiply.outer(probabilities, locus_probabilities)
+        hypotheses.append({
+            "parent1_genotypes": parent1,
+            "parent2_genotypes": parent2,
+            "parent1_phase": None,
+            "parent2_phase": None,
+            "recombination_fraction": None,
+            "linkage_lod": None,
+            "log_likelihood": score,
+            **_fit(table.ravel(), probabilities.ravel(), 0),
+        })
+    return hypotheses
+
+
+# ----------------------------------------------------------------------
+# Linked search (two diploid loci)
+# ----------------------------------------------------------------------
+
+def _phased_genotypes(trait_a: Trait, trait_b: Trait) -> List[PhasedGenotype]:
+    haplotypes = list(itertools.product(trait_a.alleles, trait_b.alleles))
+    return list(itertools.combinations_with_replacement(haplotypes, 2))
+
+
+def _gamete_components(parent: PhasedGenotype) -> Tuple[Dict[Haplotype, float], Dict[Haplotype, float]]:
+    """Non-recombinant and recombinant gamete distributions of a phased parent."""
+    (a1, b1), (a2, b2) = parent
+    parental: Dict[Haplotype, float] = {}
+    recombinant: Dict[Haplotype, float] = {}
+    for haplotype in ((a1, b1), (a2, b2)):
+        parental[haplotype] = parental.get(haplotype, 0.0) + 0.5
+    for haplotype in ((a1, b2), (a2, b1)):
+        recombinant[haplotype] = recombinant.get(haplotype, 0.0) + 0.5
+    return parental, recombinant
+
+
+def _linked_coefficients(
+    parent1: PhasedGenotype,
+    parent2: PhasedGenotype,
+    trait_a: Trait,
+    trait_b: Trait,
+    index_a: Dict[str, int],
+    index_b: Dict[str, int],
+    phenotype_cache: Dict[Tuple[str, str], Tuple[int, int]],
+) -> np.ndarray:
+    """
+    Coefficients C[k] with P(classes | r) = (1-r)^2 C[0] + r(1-r) C[1] + r^2 C[2].
+    """
+    shape = (len(index_a), len(index_b))
+    coefficients = np.zeros((3,) + shape)
+    n1, r1 = _gamete_components(parent1)
+    n2, r2 = _gamete_components(parent2)
+    terms = ((0, n1, n2), (1, n1, r2), (1, r1, n2), (2, r1, r2))
+    for k, gametes1, gametes2 in terms:
+        for (x1, y1), w1 in gametes1.items():
+            for (x2, y2), w2 in gametes2.items():
+                key = ("".join(sorted((x1, x2))), "".join(sorted((y1, y2))))
+                cell = phenotype_cache.get(key)
+                if cell is None:
+                    cell = (
+                        index_a[trait_a.phenotype_for(trait_a.canonical_genotype(key[0]))],
+                        index_b[trait_b.phenotype_for(trait_b.canonical_genotype(key[1]))],
+                    )
+                    phenotype_cache[key] = cell
+                coefficients[(k,) + cell] += w1 * w2
+    return coefficients.reshape(3, -1)
+
+
+def _phase_string(parent: PhasedGenotype) -> str:
+    return "/".join(a + b for a, b in parent)
+
+
+def _search_linked(
+    trait_keys: Sequence[str],
+    traits: Mapping[str, Trait],
+    classes: List[List[str]],
+    table: np.ndarray,
+    max_hypotheses: int,
+    stats: Dict[str, int],
+) -> List[Dict[str, object]]:
+    key_a, key_b = trait_keys
+    trait_a, trait_b = traits[key_a], traits[key_b]
+    if trait_a.ploidy != 2 or trait_b.ploidy != 2:
+        raise InverseCrossError("Linkage inference is only supported for diploid traits")
+
+    # Unordered parent pairs, keyed identically on both sides of the lookup
+    def pair_key(genotype1: str, genotype2: str) -> Tuple[str, str]:
+        return tuple(sorted((genotype1, genotype2)))
+
+    counts_a, counts_b = table.sum(axis=1), table.sum(axis=0)
+    locus_a = {pair_key(*pair): score for score, pair, _ in _locus_candidates(trait_a, classes[0], counts_a, stats)}
+    locus_b = {pair_key(*pair): score for score, pair, _ in _locus_candidates(trait_b, classes[1], counts_b, stats)}
+    conditional_b = _conditional_saturated(table)
+    conditional_a = _conditional_saturated(table.T)
+
+    phased = _phased_genotypes(trait_a, trait_b)
+    if len(phased) * (len(phased) + 1) // 2 > MAX_LINKED_HYPOTHESES:
+        raise InverseCrossError("Too many allele combinations for a linkage search")
+
+    # Enumerate phased parent pairs whose single-locus projections survived pruning
+    candidates = []
+    for parent1, parent2 in itertools.combinations_with_replacement(phased, 2):
+        pair_a = pair_key(
+            trait_a.canonical_genotype(parent1[0][0] + parent1[1][0]),
+            trait_a.canonical_genotype(parent2[0][0] + parent2[1][0]),
+        )
+        pair_b = pair_key(
+            trait_b.canonical_genotype(parent1[0][1] + parent1[1][1]),
+            trait_b.canonical_genotype(parent2[0][1] + parent2[1][1]),
+        )
+        if pair_a not in locus_a or pair_b not in locus_b:
+            stats["pruned"] += 1
+            continue
+        bound = min(locus_a[pair_a] + conditional_b, locus_b[pair_b] + conditional_a)
+        candidates.append((bound, parent1, parent2))
+    candidates.sort(key=lambda item: -item[0])
+
+    index_a = {phenotype: i for i, phenotype in enumerate(classes[0])}
+    index_b = {phenotype: i for i, phenotype in enumerate(classes[1])}
+    phenotype_cache: Dict[Tuple[str, str], Tuple[int, int]] = {}
+    counts = table.ravel()
+
+    top: List[Tuple[float, int, dict]] = []
+    counter = itertools.count()
+    for position, (bound, parent1, parent2) in enumerate(candidates):
+        if len(top) >= max_hypotheses and bound <= top[0][0]:
+            stats["bounded"] += len(candidates) - position
+            break
+        c = _linked_coefficients(parent1, parent2, trait_a, trait_b, index_a, index_b, phenotype_cache)
+
+        def score(r: float) -> float:
+            return _log_likelihood(counts, (1 - r) ** 2 * c[0] + r * (1 - r) * c[1] + r * r * c[2])
+
+        r, best = golden_section_maximize(score, 0.0, 0.5)
+        if best == -math.inf:
+            stats["pruned"] += 1
+            continue
+        stats["evaluated"] += 1
+        unlinked = score(0.5)
+        probabilities = (1 - r) ** 2 * c[0] + r * (1 - r) * c[1] + r * r * c[2]
+        # Phase only matters (and r is only identifiable) when a parent is doubly heterozygous
+        estimated = 1 if any(a1 != a2 and b1 != b2 for (a1, b1), (a2, b2) in (parent1, parent2)) else 0
+        hypothesis = {
+            "parent1_genotypes": {
+                key_a: trait_a.canonical_genotype(parent1[0][0] + parent1[1][0]),
+                key_b: trait_b.canonical_genotype(parent1[0][1] + parent1[1][1]),
+            },
+            "parent2_genotypes": {
+                key_a: trait_a.canonical_genotype(parent2[0][0] + parent2[1][0]),
+                key_b: trait_b.canonical_genotype(parent2[0][1] + parent2[1][1]),
+            },
+            "parent1_phase": _phase_string(parent1),
+            "parent2_phase": _phase_string(parent2),
+            "recombination_fraction": round(r, 5) if estimated else None,
+            "linkage_lod": (best - unlinked) / math.log(10) if estimated else None,
+            "log_likelihood": best,
+            **_fit(counts, probabilities, estimated),
+        }
+        entry = (best, next(counter), hypothesis)
+        if len(top) < max_hypotheses:
+            heapq.heappush(top, entry)
+        else:
+            heapq.heappushpop(top, entry)
+
+    return [h for _, _, h in sorted(top, key=lambda item: -item[0])]
+
+
+# ----------------------------------------------------------------------
+# Public API
+# ----------------------------------------------------------------------
+
+def infer_parental_genotypes(
+    traits: Mapping[str, Trait],
+    trait_keys: Sequence[str],
+    observed: Sequence[Tuple[Sequence[str], int]],
+    linked: bool = False,
+    max_hypotheses: int = 10,
+) -> Dict[str, object]:
+    """
+    Rank parental genotype hypotheses for observed offspring phenotype counts.
+
+    Args:
+        traits: Trait registry (must contain every key in ``trait_keys``)
+        trait_keys: Traits the observations refer to, in observation order
+        observed: (phenotypes per trait, offspring count) classes
+        linked: Fit a recombination fraction between the two traits
+        max_hypotheses: Number of ranked hypotheses to return
+
+    Returns:
+        Dict with ranked hypotheses and search statistics
+    """
+    if linked and len(trait_keys) != 2:
+        raise InverseCrossError("Linkage inference needs exactly two traits")
+
+    classes, table = _observed_table(trait_keys, traits, observed)
+    stats = {"evaluated": 0, "pruned": 0, "bounded": 0}
+    search = _search_linked if linked else _search_unlinked
+    hypotheses = search(trait_keys, traits, classes, table, max_hypotheses, stats)
+
+    saturated = _saturated_log_likelihood(table.ravel())
+    best = hypotheses[0]["log_likelihood"] if hypotheses else None
+    for rank, hypothesis in enumerate(hypotheses, start=1):
+        hypothesis["rank"] = rank
+        hypothesis["delta_log_likelihood"] = best - hypothesis["log_likelihood"]
+        # G statistic against the saturated model, comparable across hypotheses
+        hypothesis["deviance"] = 2.0 * (saturated - hypothesis["log_likelihood"])
+
+    return {
+        "trait_keys": list(trait_keys),
+        "phenotype_classes": classes,
+        "total_offspring": int(table.sum()),
+        "linked": linked,
+        "hypotheses": hypotheses,
+        "hypotheses_evaluated": stats["evaluated"],
+        "hypotheses_pruned": stats["pruned"],
+        "hypotheses_bounded": stats["bounded"],
+    }
@@ -8,6 +8,7 @@ from app.models import Simulator, Trait, MendelianCalculator
 from app.utils.trait_helpers import normalize_probabilities, to_percentage_distribution
 from .service_factory import get_service_factory
 from .trait_converter import build_cpp_engine_request
+from . import inverse_cross
 from ..config import get_settings
 
 logger = logging.getLogger(__name__)
@@ -90,9 +91,24 @@ def simulate_mendelian_traits(
         raise ValueError(
             f"Maximum {max_traits} traits allowed, got {len(trait_keys)}")
 
+    # The C++ engine is diploid; polyploid traits use the exact Python calculator
+    polyploid = {key for key, trait_obj in registry.items() if trait_obj.ploidy != 2}
+    calculator = MendelianCalculator()
+    polyploid_results = {}
+    for key in sorted(polyploid & trait_keys):
+        cross = calculator.calculate_cross(
+            registry[key], parent1[key], parent2[key], as_percentages=as_percentages
+        )
+        polyploid_results[key] = {
+            "genotypic_ratios": cross["genotypic_ratios"],
+            "phenotypic_ratios": cross["phenotypic_ratios"],
+        }
+
     # Convert Trait objects to dictionaries for C++ engine
     trait_dicts = []
     for trait_key, trait_obj in registry.items():
+        if trait_key in polyploid:
+            continue
         trait_dict = {
             "key": trait_key,
             "name": trait_obj.name,
@@ -112,7 +128,8 @@ def simulate_mendelian_traits(
     )
 
     # Call C++ engine
-    cpp_result = _run_cpp_cli(request)
+    cpp_result = _run_cpp_cli(request) if trait_keys - polyploid else {}
+    cpp_result.setdefault("results", {}).update(polyploid_results)
 
     # Return results in expected format
     ordered_results: Dict[str, Dict[str, Dict[str, float]]] = {}
@@ -136,6 +153,10 @@ def simulate_joint_phenotypes(
     if len(trait_keys) > max_traits:
         raise ValueError(
             f"Maximum {max_traits} traits allowed, got {len(trait_keys)}")
+    polyploid = sorted(key for key in trait_keys if registry[key].ploidy != 2)
+    if polyploid:
+        raise ValueError(
+            f"Joint phenotypes are only available for diploid traits: {', '.join(polyploid)}")
 
     # Convert Trait objects to dictionaries for C++ engine
     trait_dicts = []
@@ -183,6 +204,33 @@ def get_possible_genotypes_for_traits(
         raise ValueError(str(e)) from e
 
 
+def infer_parental_genotypes(
+    trait_keys: List[str],
+    observed: List[Tuple[List[str], int]],
+    linked: bool = False,
+    max_hypotheses: int = 10,
+) -> Dict[str, object]:
+    """
+    Rank parental genotypes that explain observed offspring phenotype counts.
+
+    Returns:
+        Inverse cross result (see ``inverse_cross.infer_parental_genotypes``)
+
+    Raises:
+        ValueError: If a trait is unknown or the observations are inconsistent
+    """
+    registry, missing = filter_traits(trait_keys)
+    if missing:
+        raise ValueError(f"Unknown traits: {', '.join(sorted(missing))}")
+    return inverse_cross.infer_parental_genotypes(
+        traits=registry,
+        trait_keys=trait_keys,
+        observed=observed,
+        linked=linked,
+        max_hypotheses=max_hypotheses,
+    )
+
+
 class PreviewValidationError(ValueError):
     def __init__(self, errors: List[str]):
         super().__init__("; ".join(errors))
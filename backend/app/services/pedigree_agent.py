@@ -1,6 +1,7 @@
 import json
 import logging
 import re
+from typing import Optional
 from app.services.ai import get_claude_service
 from app.services.cpp_engine import run_pedigree_analysis
 from app.schema.pedigree import PedigreeRequest, PedigreeResponse, PedigreeStructure
@@ -62,7 +63,7 @@ INSTRUCTIONS:
 - Be concise, professional, and scientifically accurate.
 """
 
-async def process_pedigree_query(request: PedigreeRequest) -> PedigreeResponse:
+async def process_pedigree_query(request: PedigreeRequest, user_id: Optional[str] = None) -> PedigreeResponse:
     claude = get_claude_service()
     
     # --- PHASE 1: EXTRACTION (LLM) ---
@@ -108,14 +109,17 @@ async def process_pedigree_query(request: PedigreeRequest) -> PedigreeResponse:
     logger.info("🧬 Phase 2: Sending to C++ Engine for validation...")
     
     try:
-        analysis_result = run_pedigree_analysis(structure)
+        # Clients that send a session_id get incremental re-solves of their edits
+        session_id = request.session_id
+        analysis_result = run_pedigree_analysis(structure, session_id=session_id, user_id=user_id)
         logger.info(f"✅ Phase 2 Successful. Engine Status: {analysis_result.status}")
     except Exception as e:
         logger.critical(f"❌ Phase 2 C++ Engine Error: {e}")
         # Fallback if engine is down/error
         return PedigreeResponse(
             ai_message="I've mapped the family tree, but our advanced Genetic Engine is momentarily unavailable to verify the probabilities.",
-            structured_data=structure
+            structured_data=structure,
+            session_id=request.session_id
         )
 
     # --- PHASE 3: RESPONSE GENERATION (LLM) ---
@@ -140,5 +144,6 @@ async def process_pedigree_query(request: PedigreeRequest) -> PedigreeResponse:
         ai_message=final_explanation,
         analysis_result=analysis_result,
         structured_data=structure,
-        requires_clarification=(analysis_result.status == "MISSING_DATA")
+        requires_clarification=(analysis_result.status == "MISSING_DATA"),
+        session_id=session_id
     )
\ No newline at end of file
@@ -0,0 +1,601 @@
+"""
+Pedigree Solver
+===============
+Single-locus Mendelian pedigree solver with incremental re-solving.
+
+Each member is a genotype variable over (AA, Aa, aa) with ``A`` dominant.
+Members are tied together by one factor per nuclear family (the parents and
+all of their children), which keeps the factor graph a tree for any pedigree
+without marriage loops. Posterior genotype probabilities are computed with
+sum-product message passing; on such trees this is exact peeling.
+
+A ``PedigreeSession`` keeps the factor graph and every message between
+solves. When the structure is resubmitted after an edit (a phenotype change,
+a new child, a new parent link), only the members and families that changed
+are marked dirty, and only messages directed away from them are recomputed.
+Pedigrees with loops fall back to damped loopy propagation warm-started from
+the cached messages.
+"""
+
+from __future__ import annotations
+
+import threading
+import time
+import uuid
+from collections import OrderedDict, deque
+from typing import Dict, Hashable, List, Optional, Set, Tuple
+
+import numpy as np
+
+from ..core.metrics import register_cache
+from ..schema.pedigree import GeneticAnalysisResult, PedigreeMember, PedigreeStructure
+
+GENOTYPES = ("AA", "Aa", "aa")
+DEFAULT_RECESSIVE_ALLELE_FREQUENCY = 0.5
+
+# Normalised phenotype keywords (see the extraction prompt) -> genotype likelihoods
+RECESSIVE_PHENOTYPES = {"blonde", "blond", "red", "ginger", "light", "fair", "blue"}
+DOMINANT_PHENOTYPES = {"black", "brown", "dark", "brunette"}
+
+_LOOPY_MAX_ITERATIONS = 100
+_LOOPY_TOLERANCE = 1e-9
+_LOOPY_DAMPING = 0.5
+
+Node = Tuple[str, Hashable]  # ("m", member_id) or ("f", parent_ids)
+
+
+def _gamete_a_frequency() -> np.ndarray:
+    """Probability that a parent of each genotype transmits the recessive allele."""
+    return np.array([0.0, 0.5, 1.0])
+
+
+def _child_given_gametes(p: np.ndarray, q: np.ndarray) -> np.ndarray:
+    """Child genotype distribution from two recessive-allele transmission probabilities."""
+    return np.stack([(1 - p) * (1 - q), p * (1 - q) + (1 - p) * q, p * q], axis=-1)
+
+
+def _transmission_tables(recessive_frequency: float) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Returns:
+        T2[gm, gf, gc] for two known parents and T1[gp, gc] for one known parent
+        (the other parent contributes a population gamete).
+    """
+    gamete = _gamete_a_frequency()
+    t2 = _child_given_gametes(gamete[:, None], gamete[None, :])
+    t1 = _child_given_gametes(gamete, np.full(3, recessive_frequency))
+    return t2, t1
+
+
+def phenotype_likelihood(phenotype: str) -> np.ndarray:
+    """P(phenotype | genotype) for a normalised phenotype keyword."""
+    value = (phenotype or "").strip().lower()
+    if value in RECESSIVE_PHENOTYPES:
+        return np.array([0.0, 0.0, 1.0])
+    if value in DOMINANT_PHENOTYPES:
+        return np.array([1.0, 1.0, 0.0])
+    return np.ones(3)
+
+
+def _normalise(vector: np.ndarray) -> np.ndarray:
+    total = vector.sum()
+    return vector / total if total > 0 else np.zeros_like(vector)
+
+
+class PedigreeSession:
+    """Factor graph, cached messages and posteriors for one evolving pedigree."""
+
+    def __init__(
+        self,
+        session_id: str,
+        recessive_allele_frequency: float = DEFAULT_RECESSIVE_ALLELE_FREQUENCY,
+    ):
+        self.session_id = session_id
+        self.q = recessive_allele_frequency
+        self.t2, self.t1 = _transmission_tables(recessive_allele_frequency)
+        self.founder_prior = np.array([(1 - self.q) ** 2, 2 * self.q * (1 - self.q), self.q ** 2])
+
+        self.structure: Optional[PedigreeStructure] = None
+        self.members: Dict[str, PedigreeMember] = {}
+        self.unary: Dict[str, np.ndarray] = {}
+        self.families: Dict[Tuple[str, ...], List[str]] = {}
+        self.neighbours: Dict[Node, List[Node]] = {}
+        self.messages: Dict[Tuple[Node, Node], np.ndarray] = {}
+        self.is_tree = True
+        self.last_stats: Dict[str, object] = {}
+        self.result: Optional[GeneticAnalysisResult] = None
+        self.updated_at = time.time()
+        self.lock = threading.Lock()
+
+    # ------------------------------------------------------------------
+    # Graph construction and diffing
+    # ------------------------------------------------------------------
+
+    def _build_graph(self, structure: PedigreeStructure):
+        members = {m.id: m for m in structure.members}
+        families: Dict[Tuple[str, ...], List[str]] = {}
+        parents_of: Dict[str, Tuple[str, ...]] = {}
+        for member in structure.members:
+            known = [p for p in dict.fromkeys(member.parent_ids) if p in members and p != member.id]
+            parents = tuple(sorted(known[:2]))
+            if parents:
+                parents_of[member.id] = parents
+                families.setdefault(parents, []).append(member.id)
+
+        unary = {}
+        for member_id, member in members.items():
+            prior = np.ones(3) if member_id in parents_of else self.founder_prior
+            unary[member_id] = prior * phenotype_likelihood(member.phenotype)
+
+        neighbours: Dict[Node, List[Node]] = {("m", m): [] for m in members}
+        for parents, children in families.items():
+            factor: Node = ("f", parents)
+            neighbours[factor] = [("m", p) for p in parents] + [("m", c) for c in children]
+            for variable in neighbours[factor]:
+                neighbours[variable].append(factor)
+        return members, unary, families, neighbours
+
+    @staticmethod
+    def _has_loop(neighbours: Dict[Node, List[Node]]) -> bool:
+        parent: Dict[Node, Node] = {node: node for node in neighbours}
+
+        def find(node: Node) -> Node:
+            while parent[node] != node:
+                parent[node] = parent[parent[node]]
+                node = parent[node]
+            return node
+
+        for node, adjacent in neighbours.items():
+            if node[0] != "f":
+                continue
+            for other in adjacent:
+                a, b = find(node), find(other)
+                if a == b:
+                    return True
+                parent[a] = b
+        return False
+
+    # ------------------------------------------------------------------
+    # Message passing
+    # ------------------------------------------------------------------
+
+    def _incoming(self, source: Node, exclude: Optional[Node]) -> List[Tuple[Node, np.ndarray]]:
+        return [
+            (other, self.messages[(other, source)])
+            for other in self.neighbours[source]
+            if other != exclude
+        ]
+
+    def _compute_message(self, source: Node, target: Node) -> np.ndarray:
+        if source[0] == "m":
+            message = self.unary[source[1]].copy()
+            for _, incoming in self._incoming(source, target):
+                message = message * incoming
+            return _normalise(message)
+
+        parents = list(source[1])
+        incoming = {node[1]: msg for node, msg in self._incoming(source, target)}
+        children = [n[1] for n in self.neighbours[source][len(parents):]]
+
+        if len(parents) == 2:
+            first, second = parents
+            table = self.t2
+            # Child terms s_c[g1, g2] = sum_gc T(gc | g1, g2) * mu_c(gc)
+            child_terms = {c: table @ incoming[c] for c in children if c in incoming}
+            joint = np.ones((3, 3))
+            for term in child_terms.values():
+                joint = joint * term
+            if target[1] == first:
+                return _normalise((joint * incoming[second][None, :]).sum(axis=1))
+            if target[1] == second:
+                return _normalise((joint * incoming[first][:, None]).sum(axis=0))
+            weights = joint * incoming[first][:, None] * incoming[second][None, :]
+            return _normalise(np.einsum("ij,ijk->k", weights, table))
+
+        (parent,) = parents
+        table = self.t1
+        child_terms = {c: table @ incoming[c] for c in children if c in incoming}
+        joint = np.ones(3)
+        for term in child_terms.values():
+            joint = joint * term
+        if target[1] == parent:
+            return _normalise(joint)
+        return _normalise((joint * incoming[parent]) @ table)
+
+    def _edges(self):
+        for source, adjacent in self.neighbours.items():
+            for target in adjacent:
+                yield source, target
+
+    def _invalidate_from(self, dirty: Set[Node]) -> None:
+        """Drop every cached message directed away from a dirty node."""
+        for start in dirty:
+            if start not in self.neighbours:
+                continue
+            seen = {start}
+            queue = deque([start])
+            while queue:
+                node = queue.popleft()
+                for other in self.neighbours[node]:
+                    if other in seen:
+                        continue
+                    self.messages.pop((node, other), None)
+                    seen.add(other)
+                    queue.append(other)
+
+    def _propagate_tree(self) -> int:
+        """Compute every missing message; cached ones are reused. Returns the count computed."""
+        computed = 0
+        for edge in list(self._edges()):
+            if edge in self.messages:
+                continue
+            # Depth-first: a message needs all other messages into its source first
+            stack = [edge]
+            while stack:
+                source, target = stack[-1]
+                missing = [
+                    (other, source)
+                    for other in self.neighbours[source]
+                    if other != target and (other, source) not in self.messages
+                ]
+                if missing:
+                    stack.extend(missing)
+                    continue
+                stack.pop()
+                if (source, target) not in self.messages:
+                    self.messages[(source, target)] = self._compute_message(source, target)
+                    computed += 1
+        return computed
+
+    def _propagate_loopy(self) -> int:
+        uniform = np.full(3, 1.0 / 3.0)
+        for edge in self._edges():
+            self.messages.setdefault(edge, uniform)
+        computed = 0
+        for _ in range(_LOOPY_MAX_ITERATIONS):
+            delta = 0.0
+            for source, target in list(self._edges()):
+                new = self._compute_message(source, target)
+                old = self.messages[(source, target)]
+                new = _normalise(_LOOPY_DAMPING * new + (1 - _LOOPY_DAMPING) * old)
+                delta = max(delta, float(np.abs(new - old).max()))
+                self.messages[(source, target)] = new
+                computed += 1
+            if delta < _LOOPY_TOLERANCE:
+                break
+        return computed
+
+    def _propagate(self) -> int:
+        return self._propagate_tree() if self.is_tree else self._propagate_loopy()
+
+    def belief(self, member_id: str) -> np.ndarray:
+        """Normalised posterior genotype distribution of a member (zeros on conflict)."""
+        node: Node = ("m", member_id)
+        belief = self.unary[member_id].copy()
+        for _, incoming in self._incoming(node, None):
+            belief = belief * incoming
+        return _normalise(belief)
+
+    # ------------------------------------------------------------------
+    # Joint posteriors for hypothetical children
+    # ------------------------------------------------------------------
+
+    def _components(self) -> Dict[str, int]:
+        """Connected component label of each member (related members share one)."""
+        labels: Dict[str, int] = {}
+        for label, start in enumerate(self.members):
+            if start in labels:
+                continue
+            queue = deque([("m", start)])
+            seen = {("m", start)}
+            while queue:
+                node = queue.popleft()
+                if node[0] == "m":
+                    labels[node[1]] = label
+                for other in self.neighbours[node]:
+                    if other not in seen:
+                        seen.add(other)
+                        queue.append(other)
+        return labels
+
+    def _family_joint(self, parents: Tuple[str, ...]) -> np.ndarray:
+        """Joint posterior of two co-parents, read off their family factor's belief."""
+        factor: Node = ("f", parents)
+        incoming = {node[1]: msg for node, msg in self._incoming(factor, None)}
+        first, second = parents
+        joint = np.outer(incoming[first], incoming[second])
+        for child in self.families[parents]:
+            joint = joint * (self.t2 @ incoming[child])
+        total = joint.sum()
+        return joint / total if total > 0 else joint
+
+    def _conditional_beliefs(self, member_id: str, targets: List[str]) -> np.ndarray:
+        """
+        Posteriors of ``targets`` given each genotype of ``member_id``.
+
+        The member is clamped to one genotype at a time and only the messages
+        directed away from it are recomputed; the cached messages are restored
+        afterwards so the session is left untouched.
+
+        Returns:
+            Array [genotype, target, target_genotype]; rows for impossible
+            genotypes are zero.
+        """
+        conditional = np.zeros((3, len(targets), 3))
+        marginal = self.belief(member_id)
+        saved_unary = self.unary[member_id]
+        saved_messages = dict(self.messages)
+        try:
+            for g in np.flatnonzero(marginal > 0):
+                clamp = np.zeros(3)
+                clamp[g] = 1.0
+                self.unary[member_id] = saved_unary * clamp
+                self.messages = dict(saved_messages)
+                self._invalidate_from({("m", member_id)})
+                self._propagate()
+                for i, target in enumerate(targets):
+                    conditional[g, i] = self.belief(target)
+        finally:
+            self.unary[member_id] = saved_unary
+            self.messages = saved_messages
+        return conditional
+
+    def offspring_distributions(self, pairs: List[Tuple[str, Optional[str]]]) -> List[Dict[str, object]]:
+        """
+        Genotype and phenotype distribution of a hypothetical child for each pair.
+
+        Unrelated parents (different components of the pedigree) are
+        independent, so their marginals are combined directly. Co-parents of
+        an existing family use the joint belief of their family factor. Any
+        other related pair is conditioned through a clamp on the first
+        member; pairs sharing that member are answered from the same clamped
+        propagations. A ``None`` second parent is an untyped partner drawn
+        from the population. Nothing here re-solves the pedigree.
+        """
+        for pair in pairs:
+            for member_id in pair:
+                if member_id is not None and member_id not in self.members:
+                    raise KeyError(f"Unknown pedigree member: {member_id}")
+            if pair[0] is None or pair[0] == pair[1]:
+                raise ValueError(f"Invalid parent pair: {pair}")
+
+        components = self._components()
+        joints: List[Optional[np.ndarray]] = [None] * len(pairs)
+        methods: List[str] = [""] * len(pairs)
+        clamped: Dict[str, List[int]] = {}
+        for i, (first, second) in enumerate(pairs):
+            parents = tuple(sorted((first, second))) if second is not None else None
+            if second is None:
+                joints[i] = np.outer(self.belief(first), self.founder_prior)
+                methods[i] = "population_partner"
+            elif components[first] != components[second]:
+                joints[i] = np.outer(self.belief(first), self.belief(second))
+                methods[i] = "independent"
+            elif parents in self.families and len(parents) == 2:
+                joint = self._family_joint(parents)
+                joints[i] = joint if parents[0] == first else joint.T
+                methods[i] = "family_joint"
+            else:
+                clamped.setdefault(first, []).append(i)
+                methods[i] = "conditioned"
+
+        for member_id, indices in clamped.items():
+            targets = list(dict.fromkeys(pairs[i][1] for i in indices))
+            conditional = self._conditional_beliefs(member_id, targets)
+            marginal = self.belief(member_id)
+            for i in indices:
+                joints[i] = marginal[:, None] * conditional[:, targets.index(pairs[i][1])]
+
+        results = []
+        for (first, second), joint, method in zip(pairs, joints, methods):
+            child = np.einsum("ij,ijk->k", joint, self.t2)
+            if child.sum() > 0:
+                child = child / child.sum()
+            results.append({
+                "parent_ids": [p for p in (first, second) if p is not None],
+                "method": method,
+                "exact": self.is_tree,
+                "genotype_distribution": {
+                    genotype: round(float(p), 6) for genotype, p in zip(GENOTYPES, child)
+                },
+                "phenotype_distribution": {
+                    "dominant": round(float(child[0] + child[1]), 6),
+                    "recessive": round(float(child[2]), 6),
+                },
+            })
+        return results
+
+    # ------------------------------------------------------------------
+    # Public API
+    # ------------------------------------------------------------------
+
+    def solve(self, structure: PedigreeStructure) -> GeneticAnalysisResult:
+        """
+        Solve (or re-solve) the pedigree.
+
+        On the first call everything is computed. On later calls the new
+        structure is diffed against the cached one and only messages that
+        depend on changed members or families are recomputed.
+        """
+        members, unary, families, neighbours = self._build_graph(structure)
+        first_solve = self.structure is None
+
+        dirty: Set[Node] = set()
+        if not first_solve:
+            for member_id, vector in unary.items():
+                old = self.unary.get(member_id)
+                if old is None or not np.array_equal(old, vector):
+                    dirty.add(("m", member_id))
+            for node, adjacent in neighbours.items():
+                if self.neighbours.get(node) != adjacent:
+                    dirty.add(node)
+            # Nodes that disappeared invalidate whatever they used to feed
+            self._invalidate_from({n for n in self.neighbours if n not in neighbours})
+
+        self._invalidate_from(dirty)
+        self.members, self.unary, self.families, self.neighbours = members, unary, families, neighbours
+        self.messages = {
+            edge: msg for edge, msg in self.messages.items()
+            if edge[0] in neighbours and edge[1] in neighbours[edge[0]]
+        }
+        # Dependencies can also run through links that only exist in the new graph
+        self._invalidate_from(dirty)
+        self.is_tree = not self._has_loop(neighbours)
+
+        total_messages = sum(len(adjacent) for adjacent in neighbours.values())
+        computed = self._propagate()
+
+        self.structure = structure
+        self.updated_at = time.time()
+        self.last_stats = {
+            "session_id": self.session_id,
+            "incremental": not first_solve,
+            "exact": self.is_tree,
+            "messages_recomputed": computed,
+            "messages_total": total_messages,
+            "dirty_nodes": len(dirty),
+        }
+        self.result = self._result()
+        return self.result
+
+    def _result(self) -> GeneticAnalysisResult:
+        if not self.members:
+            return GeneticAnalysisResult(status="MISSING_DATA", mode_used="MENDELIAN")
+
+        probability_map = {}
+        conflicts = []
+        for member_id in self.members:
+            belief = self.belief(member_id)
+            if belief.sum() == 0:
+                conflicts.append(member_id)
+            probability_map[member_id] = {
+                genotype: round(float(p), 6) for genotype, p in zip(GENOTYPES, belief)
+            }
+
+        if conflicts:
+            return GeneticAnalysisResult(
+                status="CONFLICT",
+                mode_used="MENDELIAN",
+                conflict_reason=(
+                    "The observed phenotypes cannot be explained by single-gene Mendelian "
+                    f"inheritance (inconsistent members: {', '.join(sorted(conflicts))})."
+                ),
+                visualization_grid={"solver": dict(self.last_stats)},
+            )
+
+        observed = any(not np.array_equal(phenotype_likelihood(m.phenotype), np.ones(3))
+                       for m in self.members.values())
+        return GeneticAnalysisResult(
+            status="SOLVABLE" if observed else "MISSING_DATA",
+            mode_used="MENDELIAN",
+            probability_map=probability_map,
+            visualization_grid={"solver": dict(self.last_stats)},
+        )
+
+
+class PedigreeSessionStore:
+    """
+    In-memory TTL store of pedigree sessions with LRU eviction.
+
+    Sessions are per process and keyed by (user id, client-chosen session id),
+    so one user can never reach another's session. A request whose session is
+    missing or expired simply starts a new one and pays for a full solve.
+    """
+
+    def __init__(self, max_size: int = 256, ttl_seconds: int = 3600):
+        self.max_size = max_size
+        self.ttl_seconds = ttl_seconds
+        self.sessions: OrderedDict[Tuple[str, str], PedigreeSession] = OrderedDict()
+        self.lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+
+    def get_or_create(self, user_id: str, session_id: str) -> PedigreeSession:
+        key = (user_id, session_id)
+        with self.lock:
+            if key in self.sessions:
+                session = self.sessions[key]
+                if time.time() - session.updated_at < self.ttl_seconds:
+                    self.hits += 1
+                    self.sessions.move_to_end(key)
+                    return session
+                del self.sessions[key]
+
+            self.misses += 1
+            while len(self.sessions) >= self.max_size:
+                self.sessions.popitem(last=False)
+            session = PedigreeSession(session_id)
+            self.sessions[key] = session
+            return session
+
+    def get(self, user_id: str, session_id: str) -> Optional[PedigreeSession]:
+        key = (user_id, session_id)
+        with self.lock:
+            session = self.sessions.get(key)
+            if session is not None and time.time() - session.updated_at < self.ttl_seconds:
+                self.sessions.move_to_end(key)
+                return session
+            return None
+
+    def get_stats(self) -> dict:
+        total = self.hits + self.misses
+        return {
+            "size": len(self.sessions),
+            "max_size": self.max_size,
+            "hits": self.hits,
+            "misses": self.misses,
+            "hit_rate": f"{(self.hits / total * 100) if total else 0:.1f}%",
+            "ttl_seconds": self.ttl_seconds,
+        }
+
+
+_session_store: Optional[PedigreeSessionStore] = None
+
+
+def get_pedigree_session_store() -> PedigreeSessionStore:
+    """Get or create the global PedigreeSessionStore instance."""
+    global _session_store
+    if _session_store is None:
+        _session_store = PedigreeSessionStore()
+        register_cache("pedigree_sessions", _session_store.get_stats)
+    return _session_store
+
+
+def solve_pedigree(
+    structure: PedigreeStructure,
+    session_id: Optional[str] = None,
+    user_id: Optional[str] = None,
+) -> Tuple[Optional[str], GeneticAnalysisResult]:
+    """
+    Solve a pedigree, reusing the cached session state of ``user_id`` when
+    ``session_id`` is given; without one the solve is one-off and not stored.
+
+    Returns:
+        (session_id, analysis result)
+    """
+    if session_id is None:
+        return None, PedigreeSession(uuid.uuid4().hex).solve(structure)
+
+    session = get_pedigree_session_store().get_or_create(user_id or "", session_id)
+    with session.lock:
+        result = session.solve(structure)
+    return session.session_id, result
+
+
+def query_hypothetical_children(
+    session_id: str,
+    pairs: List[Tuple[str, Optional[str]]],
+    user_id: str,
+) -> List[Dict[str, object]]:
+    """
+    Answer a batch of "next child" queries against a solved session owned by ``user_id``.
+
+    Raises:
+        LookupError: If the session is unknown, expired or not yet solved
+        KeyError: If a queried member is not in the pedigree
+        ValueError: If a pair repeats the same member
+    """
+    session = get_pedigree_session_store().get(user_id, session_id)
+    if session is None or session.structure is None:
+        raise LookupError(f"Pedigree session not found: {session_id}")
+    with session.lock:
+        return session.offspring_distributions(pairs)
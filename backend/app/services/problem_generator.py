@@ -0,0 +1,512 @@
+"""
+Genetics Problem Generator
+==========================
+Bulk generator of randomised cross problems with exactly solved answers, in
+the assessment question format used by course modules.
+
+Each problem samples traits from a small catalogue of textbook genes
+(complete/incomplete dominance, codominance, multiple alleles), random
+parental genotypes and, for two diploid two-allele genes, optional linkage
+with a phase and recombination fraction. Answers are computed with exact
+rational arithmetic from the Mendelian calculator's gamete distributions,
+and distractors come from solving nearby crosses.
+
+Problems that are mathematically the same (same dominance types and
+genotypes up to trait order, parent order and which template names the
+gene) share a canonical hash and are kept once. Large batches are generated
+in chunks with independent seeds on one process pool shared by all requests,
+and merged in the parent.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import itertools
+import math
+import multiprocessing
+import os
+import random
+import threading
+from concurrent.futures import ProcessPoolExecutor
+from concurrent.futures.process import BrokenProcessPool
+from dataclasses import asdict, dataclass, field
+from fractions import Fraction
+from functools import lru_cache
+from typing import Dict, List, Optional, Sequence, Tuple
+
+from app.models import Trait
+from app.models.mendelian_calculator import allele_counts, counts_to_genotype, gamete_distribution
+
+DOMINANCE_TYPES = ("complete", "incomplete", "codominant", "multiple_alleles")
+QUESTION_TYPES = ("phenotype_ratio", "phenotype_probability")
+
+# Below this many problems the pool round trip costs more than it saves
+_PARALLEL_THRESHOLD = 2_000
+_CHUNK_SIZE = 500
+_MAX_ROUNDS = 20
+# Worker processes of the shared pool; requests queue for them
+_POOL_WORKERS = min(os.cpu_count() or 1, 8)
+
+_executor: Optional[ProcessPoolExecutor] = None
+_executor_lock = threading.Lock()
+
+
+@dataclass(frozen=True)
+class TraitTemplate:
+    name: str
+    dominance: str
+    alleles: Tuple[str, ...]
+    phenotypes: Dict[str, str]
+    description: str
+
+
+def _two_allele(name, letter, dominant, recessive, dominance, intermediate=None) -> TraitTemplate:
+    upper, lower = letter.upper(), letter.lower()
+    if dominance == "complete":
+        phenotypes = {upper * 2: dominant, upper + lower: dominant, lower * 2: recessive}
+        description = (
+            f"{name.capitalize()}: {dominant} ({upper}) is completely dominant over {recessive} ({lower})."
+        )
+    else:
+        phenotypes = {upper * 2: dominant, upper + lower: intermediate, lower * 2: recessive}
+        kind = "incomplete dominance" if dominance == "incomplete" else "codominance"
+        description = (
+            f"{name.capitalize()} shows {kind}: {upper}{upper} is {dominant}, "
+            f"{upper}{lower} is {intermediate} and {lower}{lower} is {recessive}."
+        )
+    return TraitTemplate(name, dominance, (upper, lower), phenotypes, description)
+
+
+# Allele letters are unique across templates so any combination can share a problem
+TRAIT_TEMPLATES: Tuple[TraitTemplate, ...] = (
+    _two_allele("seed shape", "R", "round", "wrinkled", "complete"),
+    _two_allele("seed colour", "Y", "yellow", "green", "complete"),
+    _two_allele("flower colour", "P", "purple", "white", "complete"),
+    _two_allele("plant height", "T", "tall", "dwarf", "complete"),
+    _two_allele("pod shape", "I", "inflated", "constricted", "complete"),
+    _two_allele("snapdragon flower colour", "C", "red", "white", "incomplete", "pink"),
+    _two_allele("four-o'clock petal colour", "F", "crimson", "ivory", "incomplete", "rose"),
+    _two_allele("cattle coat colour", "W", "red", "white", "codominant", "roan"),
+    _two_allele("chicken feather colour", "K", "black", "white", "codominant", "speckled"),
+    TraitTemplate(
+        "ABO blood group",
+        "multiple_alleles",
+        ("A", "B", "O"),
+        {"AA": "A", "AO": "A", "BB": "B", "BO": "B", "AB": "AB", "OO": "O"},
+        "ABO blood group: alleles A and B are codominant and both are dominant over O.",
+    ),
+)
+
+
+@dataclass
+class GeneratorConfig:
+    count: int = 100
+    min_traits: int = 1
+    max_traits: int = 2
+    dominance_types: Sequence[str] = DOMINANCE_TYPES
+    question_types: Sequence[str] = QUESTION_TYPES
+    linkage_probability: float = 0.0
+    recombination_fractions: Sequence[float] = (0.1, 0.2, 0.25, 0.3)
+    min_phenotype_classes: int = 2
+    max_phenotype_classes: int = 16
+    seed: Optional[int] = None
+    # 1 generates inline; otherwise large batches use the shared process pool
+    workers: Optional[int] = None
+
+
+@dataclass
+class _Cross:
+    templates: List[TraitTemplate]
+    parent1: List[str]
+    parent2: List[str]
+    # Phased haplotypes per parent for linked problems, e.g. (("R", "Y"), ("r", "y"))
+    phase1: Optional[Tuple[Tuple[str, ...], ...]] = None
+    phase2: Optional[Tuple[Tuple[str, ...], ...]] = None
+    recombination: Optional[Fraction] = None
+    answer: Dict[Tuple[str, ...], Fraction] = field(default_factory=dict)
+
+
+def _trait(template: TraitTemplate) -> Trait:
+    return Trait(name=template.name, alleles=template.alleles, phenotype_map=template.phenotypes)
+
+
+_TRAITS = {t.name: _trait(t) for t in TRAIT_TEMPLATES}
+
+
+# ----------------------------------------------------------------------
+# Exact solving
+# ----------------------------------------------------------------------
+
+def _exact(p: float) -> Fraction:
+    return Fraction(p).limit_denominator(1_000_000)
+
+
+@lru_cache(maxsize=4096)
+def _locus_phenotypes(trait_name: str, parent1: str, parent2: str) -> Dict[str, Fraction]:
+    """Exact phenotype distribution of one locus; shared by every problem using the cross."""
+    trait = _TRAITS[trait_name]
+    gametes1 = gamete_distribution(allele_counts(trait._parse_genotype(parent1), trait.alleles))
+    gametes2 = gamete_distribution(allele_counts(trait._parse_genotype(parent2), trait.alleles))
+    distribution: Dict[str, Fraction] = {}
+    for g1, w1 in gametes1.items():
+        for g2, w2 in gametes2.items():
+            child = counts_to_genotype(tuple(a + b for a, b in zip(g1, g2)), trait.alleles)
+            phenotype = trait.phenotype_for(child)
+            distribution[phenotype] = distribution.get(phenotype, Fraction(0)) + _exact(w1) * _exact(w2)
+    return distribution
+
+
+def _linked_gametes(phase: Tuple[Tuple[str, ...], ...], r: Fraction) -> Dict[Tuple[str, str], Fraction]:
+    (a1, b1), (a2, b2) = phase
+    gametes: Dict[Tuple[str, str], Fraction] = {}
+    for haplotype, weight in (
+        ((a1, b1), (1 - r) / 2), ((a2, b2), (1 - r) / 2),
+        ((a1, b2), r / 2), ((a2, b1), r / 2),
+    ):
+        gametes[haplotype] = gametes.get(haplotype, Fraction(0)) + weight
+    return gametes
+
+
+def _solve(cross: _Cross) -> Dict[Tuple[str, ...], Fraction]:
+    if cross.recombination is not None:
+        first, second = (_TRAITS[t.name] for t in cross.templates)
+        answer: Dict[Tuple[str, ...], Fraction] = {}
+        gametes2 = _linked_gametes(cross.phase2, cross.recombination)
+        for (x1, y1), w1 in _linked_gametes(cross.phase1, cross.recombination).items():
+            for (x2, y2), w2 in gametes2.items():
+                key = (
+                    first.phenotype_for(first.canonical_genotype(x1 + x2)),
+                    second.phenotype_for(second.canonical_genotype(y1 + y2)),
+                )
+                answer[key] = answer.get(key, Fraction(0)) + w1 * w2
+        return {k: v for k, v in answer.items() if v}
+
+    joint: Dict[Tuple[str, ...], Fraction] = {(): Fraction(1)}
+    for template, p1, p2 in zip(cross.templates, cross.parent1, cross.parent2):
+        locus = _locus_phenotypes(template.name, p1, p2)
+        joint = {
+            prefix + (phenotype,): p * q
+            for prefix, p in joint.items()
+            for phenotype, q in locus.items()
+        }
+    return joint
+
+
+def _ratio(answer: Dict[Tuple[str, ...], Fraction]) -> Tuple[List[Tuple[Tuple[str, ...], int]], str]:
+    """Classes in descending order with their smallest integer ratio."""
+    ordered = sorted(answer.items(), key=lambda item: (-item[1], item[0]))
+    denominator = 1
+    for _, p in ordered:
+        denominator = denominator * p.denominator // math.gcd(denominator, p.denominator)
+    parts = [int(p * denominator) for _, p in ordered]
+    divisor = 0
+    for part in parts:
+        divisor = math.gcd(divisor, part)
+    parts = [part // divisor for part in parts]
+    return [(k, n) for (k, _), n in zip(ordered, parts)], ":".join(str(n) for n in parts)
+
+
+# ----------------------------------------------------------------------
+# Sampling
+# ----------------------------------------------------------------------
+
+def _sample_cross(rng: random.Random, config: GeneratorConfig) -> _Cross:
+    n_traits = rng.randint(config.min_traits, config.max_traits)
+    pool = [t for t in TRAIT_TEMPLATES if t.dominance in config.dominance_types]
+    templates = rng.sample(pool, min(n_traits, len(pool)))
+    parent1 = [rng.choice(_TRAITS[t.name].all_genotypes()) for t in templates]
+    parent2 = [rng.choice(_TRAITS[t.name].all_genotypes()) for t in templates]
+    cross = _Cross(templates, parent1, parent2)
+
+    linkable = len(templates) == 2 and all(len(t.alleles) == 2 for t in templates)
+    if linkable and rng.random() < config.linkage_probability:
+        cross.recombination = _exact(rng.choice(config.recombination_fractions))
+        for which in (1, 2):
+            genotypes = parent1 if which == 1 else parent2
+            a, b = (_TRAITS[t.name]._parse_genotype(g) for t, g in zip(templates, genotypes))
+            if rng.random() < 0.5:
+                b = b[::-1]
+            phase = tuple(sorted(((a[0], b[0]), (a[1], b[1]))))
+            setattr(cross, f"phase{which}", phase)
+    cross.answer = _solve(cross)
+    return cross
+
+
+def _canonical_hash(cross: _Cross, question_type: str, target: Optional[Tuple[str, ...]]) -> str:
+    """Hash invariant to trait order, parent order and the template naming each gene."""
+
+    def encode_genotype(template: TraitTemplate, genotype: str) -> Tuple[int, ...]:
+        return allele_counts(_TRAITS[template.name]._parse_genotype(genotype), template.alleles)
+
+    def encode_phenotype(template: TraitTemplate, phenotype: str) -> Tuple[Tuple[int, ...], ...]:
+        # A phenotype is identified by the genotypes that produce it
+        return tuple(sorted(
+            encode_genotype(template, g) for g, p in template.phenotypes.items() if p == phenotype
+        ))
+
+    def encode_phase(order, phase):
+        if phase is None:
+            return None
+        return tuple(sorted(
+            tuple(cross.templates[i].alleles.index(haplotype[i]) for i in order)
+            for haplotype in phase
+        ))
+
+    candidates = []
+    for order in itertools.permutations(range(len(cross.templates))):
+        for swap in (False, True):
+            p1, p2 = (cross.parent2, cross.parent1) if swap else (cross.parent1, cross.parent2)
+            f1, f2 = (cross.phase2, cross.phase1) if swap else (cross.phase1, cross.phase2)
+            candidates.append((
+                tuple((cross.templates[i].dominance, len(cross.templates[i].alleles)) for i in order),
+                tuple(encode_genotype(cross.templates[i], p1[i]) for i in order),
+                tuple(encode_genotype(cross.templates[i], p2[i]) for i in order),
+                encode_phase(order, f1),
+                encode_phase(order, f2),
+                tuple(encode_phenotype(cross.templates[i], target[i]) for i in order) if target else None,
+            ))
+    key = (min(candidates), str(cross.recombination), question_type)
+    return hashlib.blake2b(repr(key).encode(), digest_size=16).hexdigest()
+
+
+# ----------------------------------------------------------------------
+# Question rendering
+# ----------------------------------------------------------------------
+
+def _label(phenotypes: Tuple[str, ...], templates: List[TraitTemplate]) -> str:
+    if len(templates) == 1:
+        return phenotypes[0]
+    return ", ".join(f"{p} {t.name}" for p, t in zip(phenotypes, templates))
+
+
+def _genotype_text(cross: _Cross, which: int) -> str:
+    phase = cross.phase1 if which == 1 else cross.phase2
+    if phase is not None:
+        return "/".join("".join(h) for h in phase)
+    genotypes = cross.parent1 if which == 1 else cross.parent2
+    return " ".join(genotypes)
+
+
+def _difficulty(cross: _Cross) -> str:
+    if cross.recombination is not None or len(cross.templates) >= 3 or len(cross.answer) > 8:
+        return "hard"
+    if len(cross.templates) == 2 or any(t.dominance != "complete" for t in cross.templates):
+        return "medium"
+    return "easy"
+
+
+def _topic(cross: _Cross) -> str:
+    if cross.recombination is not None:
+        return "Linked genes"
+    return ("Monohybrid cross", "Dihybrid cross", "Trihybrid cross")[len(cross.templates) - 1]
+
+
+def _nearby_crosses(rng: random.Random, cross: _Cross, attempts: int = 8) -> List[_Cross]:
+    """Crosses differing in one parental genotype (or recombination), used for distractors."""
+    nearby = []
+    for _ in range(attempts):
+        other = _Cross(list(cross.templates), list(cross.parent1), list(cross.parent2))
+        if cross.recombination is not None:
+            other.phase1, other.phase2 = cross.phase1, cross.phase2
+            other.recombination = Fraction(1, 2) if rng.random() < 0.5 else cross.recombination / 2
+        else:
+            i = rng.randrange(len(cross.templates))
+            genotypes = _TRAITS[cross.templates[i].name].all_genotypes()
+            target = other.parent1 if rng.random() < 0.5 else other.parent2
+            target[i] = rng.choice(genotypes)
+        other.answer = _solve(other)
+        nearby.append(other)
+    return nearby
+
+
+def _options(rng: random.Random, correct: str, alternatives: List[str], fallbacks: Sequence[str]) -> List[Dict]:
+    distractors: List[str] = []
+    for text in list(alternatives) + list(fallbacks):
+        if text != correct and text not in distractors:
+            distractors.append(text)
+        if len(distractors) == 3:
+            break
+    options = [{"text": correct, "isCorrect": True}] + [
+        {"text": text, "isCorrect": False} for text in distractors
+    ]
+    rng.shuffle(options)
+    return options
+
+
+def _render(rng: random.Random, cross: _Cross, question_type: str, target: Optional[Tuple[str, ...]]) -> Dict:
+    intro = " ".join(t.description for t in cross.templates)
+    if cross.recombination is not None:
+        percent = float(cross.recombination) * 100
+        intro += (
+            f" The two genes are linked with a recombination frequency of {percent:g}%;"
+            " parental genotypes are written as haplotypes (first gene, second gene)."
+        )
+    cross_text = (
+        f"A parent with genotype **{_genotype_text(cross, 1)}** is crossed with a parent "
+        f"with genotype **{_genotype_text(cross, 2)}**."
+    )
+    classes, ratio = _ratio(cross.answer)
+    breakdown = "\n".join(
+        f"- {_label(k, cross.templates)}: {cross.answer[k]}" for k, _ in classes
+    )
+    nearby = _nearby_crosses(rng, cross)
+
+    if question_type == "phenotype_ratio":
+        order = " : ".join(_label(k, cross.templates) for k, _ in classes)
+        question = "What is the expected phenotypic ratio among the offspring?"
+        correct = f"{ratio} ({order})"
+        alternatives = []
+        for other in nearby:
+            other_classes, other_ratio = _ratio(other.answer)
+            other_order = " : ".join(_label(k, cross.templates) for k, _ in other_classes)
+            alternatives.append(f"{other_ratio} ({other_order})")
+        # Only ratios with one part per phenotype class are well-formed distractors
+        fallbacks = [
+            f"{r} ({order})"
+            for r in ("1:1", "3:1", "1:2:1", "9:3:3:1", "1:1:1:1")
+            if r.count(":") + 1 == len(classes)
+        ]
+        solution_value = ratio
+    else:
+        label = _label(target, cross.templates)
+        question = f"What fraction of the offspring is expected to be {label}?"
+        correct = str(cross.answer[target])
+        alternatives = [str(other.answer.get(target, Fraction(0))) for other in nearby]
+        alternatives += [str(p) for k, p in cross.answer.items() if k != target]
+        fallbacks = ["1/4", "1/2", "3/4", "1/16", "3/16", "9/16", "0", "1"]
+        solution_value = correct
+
+    return {
+        "topic": _topic(cross),
+        "difficulty": _difficulty(cross),
+        "question_type": question_type,
+        "prompt": {"markdown": f"{intro}\n\n{cross_text} {question}"},
+        "explanation": {"markdown": f"Expected offspring phenotypes:\n\n{breakdown}"},
+        "options": _options(rng, correct, alternatives, fallbacks),
+        "answer": solution_value,
+        "phenotype_distribution": {
+            _label(k, cross.templates): str(p) for k, p in cross.answer.items()
+        },
+        "traits": [t.name for t in cross.templates],
+        "parent1": _genotype_text(cross, 1),
+        "parent2": _genotype_text(cross, 2),
+        "recombination_fraction": float(cross.recombination) if cross.recombination is not None else None,
+    }
+
+
+# ----------------------------------------------------------------------
+# Batch generation
+# ----------------------------------------------------------------------
+
+def _generate_chunk(config: GeneratorConfig, seed: int, count: int) -> List[Tuple[str, Dict]]:
+    rng = random.Random(seed)
+    problems: List[Tuple[str, Dict]] = []
+    seen = set()
+    attempts = 0
+    while len(problems) < count and attempts < count * 20:
+        attempts += 1
+        cross = _sample_cross(rng, config)
+        if not config.min_phenotype_classes <= len(cross.answer) <= config.max_phenotype_classes:
+            continue
+        question_type = rng.choice(list(config.question_types))
+        target = rng.choice(sorted(cross.answer)) if question_type == "phenotype_probability" else None
+        problem_hash = _canonical_hash(cross, question_type, target)
+        if problem_hash in seen:
+            continue
+        seen.add(problem_hash)
+        problem = _render(rng, cross, question_type, target)
+        problem["id"] = problem_hash[:12]
+        problem["hash"] = problem_hash
+        problems.append((problem_hash, problem))
+    return problems
+
+
+def _get_executor() -> ProcessPoolExecutor:
+    """The shared process pool, created on first use."""
+    global _executor
+    if _executor is None:
+        with _executor_lock:
+            if _executor is None:
+                # spawn: forking a threaded server process can copy held locks
+                _executor = ProcessPoolExecutor(
+                    _POOL_WORKERS, mp_context=multiprocessing.get_context("spawn")
+                )
+    return _executor
+
+
+def _map_chunks(config: GeneratorConfig, seeds: List[int], sizes: List[int]) -> List[List[Tuple[str, Dict]]]:
+    global _executor
+    try:
+        return list(_get_executor().map(_generate_chunk, [config] * len(sizes), seeds, sizes))
+    except BrokenProcessPool:
+        # A dead worker breaks the pool for good; let the next request start a new one
+        with _executor_lock:
+            _executor = None
+        raise
+
+
+def _validate(config: GeneratorConfig) -> None:
+    if not 1 <= config.min_traits <= config.max_traits <= 3:
+        raise ValueError("Traits per problem must satisfy 1 <= min_traits <= max_traits <= 3")
+    unknown = set(config.dominance_types) - set(DOMINANCE_TYPES)
+    if unknown or not config.dominance_types:
+        raise ValueError(f"Dominance types must be drawn from {DOMINANCE_TYPES}")
+    unknown = set(config.question_types) - set(QUESTION_TYPES)
+    if unknown or not config.question_types:
+        raise ValueError(f"Question types must be drawn from {QUESTION_TYPES}")
+    pool = [t for t in TRAIT_TEMPLATES if t.dominance in config.dominance_types]
+    if len(pool) < config.min_traits:
+        raise ValueError("Not enough traits with the requested dominance types")
+    if config.min_phenotype_classes > config.max_phenotype_classes:
+        raise ValueError("min_phenotype_classes cannot exceed max_phenotype_classes")
+    if any(not 0 <= r <= 0.5 for r in config.recombination_fractions):
+        raise ValueError("Recombination fractions must lie in [0, 0.5]")
+
+
+def generate_problems(config: GeneratorConfig) -> Dict[str, object]:
+    """
+    Generate up to ``config.count`` distinct, exactly solved problems.
+
+    Returns:
+        Dict with the problems and generation statistics. Fewer problems than
+        requested are returned when the constraints admit fewer distinct ones.
+    """
+    _validate(config)
+    base_seed = config.seed if config.seed is not None else random.SystemRandom().getrandbits(32)
+    parallel = config.workers != 1 and _POOL_WORKERS > 1 and config.count >= _PARALLEL_THRESHOLD
+
+    problems: Dict[str, Dict] = {}
+    duplicates = 0
+    rounds = 0
+    chunk_index = 0
+    while len(problems) < config.count and rounds < _MAX_ROUNDS:
+        rounds += 1
+        missing = config.count - len(problems)
+        sizes = [min(_CHUNK_SIZE, missing - i) for i in range(0, missing, _CHUNK_SIZE)]
+        seeds = [hash((base_seed, chunk_index + i)) & 0xFFFFFFFF for i in range(len(sizes))]
+        chunk_index += len(sizes)
+        if parallel:
+            chunks = _map_chunks(config, seeds, sizes)
+        else:
+            chunks = [_generate_chunk(config, s, n) for s, n in zip(seeds, sizes)]
+
+        added = 0
+        for chunk in chunks:
+            for problem_hash, problem in chunk:
+                if problem_hash in problems:
+                    duplicates += 1
+                elif len(problems) < config.count:
+                    problems[problem_hash] = problem
+                    added += 1
+        # A round of only duplicates means the configuration's problem space is exhausted
+        if added == 0:
+            break
+
+    return {
+        "problems": list(problems.values()),
+        "requested": config.count,
+        "generated": len(problems),
+        "duplicates_removed": duplicates,
+        "seed": base_seed,
+        "config": asdict(config),
+    }
@@ -1,9 +1,11 @@
 from __future__ import annotations
 
+import logging
 import time
 from typing import Optional
 
 from ..config import get_settings
+from ..core.metrics import ENGINE_FALLBACKS, track_engine_call
 from ..schema.protein_generator import (
     ProteinGenerateRequest,
     ProteinGenerateResponse,
@@ -24,6 +26,8 @@ from .protein_generator_impl import (
     calculate_actual_gc as py_calculate_actual_gc,
 )
 
+logger = logging.getLogger(__name__)
+
 def _use_cpp_engine() -> bool:
     """Check if C++ engine (Lambda) is enabled."""
     return get_settings().use_cpp_engine
@@ -35,7 +39,7 @@ def generate_dna_rna(request: ProteinGenerateRequest) -> ProteinGenerateResponse
     """
     if _use_cpp_engine():
         try:
-            print(f"🚀 [AWS LAMBDA] Generating DNA sequence ({request.length:,} bp)...")
+            logger.info(f"🚀 [AWS LAMBDA] Generating DNA sequence ({request.length:,} bp)...")
             start_time = time.time()
             
             worker = get_aws_worker()
@@ -49,7 +53,7 @@ def generate_dna_rna(request: ProteinGenerateRequest) -> ProteinGenerateResponse
             result = worker.invoke(action="dna", payload=payload)
             
             elapsed = time.time() - start_time
-            print(f"✅ [AWS LAMBDA] DNA generation complete! ⏱️ {elapsed:.3f}s")
+            logger.info(f"✅ [AWS LAMBDA] DNA generation complete! ⏱️ {elapsed:.3f}s")
             
             # Handle potential key variations from Lambda (dna_sequence vs sequence)
             dna_seq = result.get("dna_sequence") or result.get("sequence")
@@ -64,16 +68,18 @@ def generate_dna_rna(request: ProteinGenerateRequest) -> ProteinGenerateResponse
                 actual_gc=result["actual_gc"]
             )
         except Exception as e:
-            print(f"⚠️ [AWS LAMBDA] Failed, falling back to Python: {e}")
+            logger.warning(f"⚠️ [AWS LAMBDA] Failed, falling back to Python: {e}")
+            ENGINE_FALLBACKS.inc(action="dna")
     
     # Python fallback
-    print(f"🐍 [PYTHON] Generating DNA sequence ({request.length:,} bp)...")
+    logger.info(f"🐍 [PYTHON] Generating DNA sequence ({request.length:,} bp)...")
     start_time = time.time()
-    dna_seq = py_generate_dna_sequence(request.length, request.gc_content, request.seed)
-    rna_seq = py_transcribe_to_rna(dna_seq)
-    actual_gc = py_calculate_actual_gc(dna_seq)
+    with track_engine_call("dna", backend="python"):
+        dna_seq = py_generate_dna_sequence(request.length, request.gc_content, request.seed)
+        rna_seq = py_transcribe_to_rna(dna_seq)
+        actual_gc = py_calculate_actual_gc(dna_seq)
     elapsed = time.time() - start_time
-    print(f"✅ [PYTHON] DNA generation complete! ⏱️ {elapsed:.3f}s")
+    logger.info(f"✅ [PYTHON] DNA generation complete! ⏱️ {elapsed:.3f}s")
 
     return ProteinGenerateResponse(
         dna_sequence=dna_seq,
@@ -97,10 +103,11 @@ def extract_amino_acids_from_rna(request: AminoAcidExtractRequest) -> AminoAcidE
             })
             return AminoAcidExtractResponse(amino_acids=result["amino_acids"])
         except Exception:
-            pass
+            ENGINE_FALLBACKS.inc(action="protein")
     
     # Python fallback
-    amino_acids_list = py_extract_amino_acids(request.rna_sequence)
+    with track_engine_call("protein", backend="python"):
+        amino_acids_list = py_extract_amino_acids(request.rna_sequence)
     amino_acids_str = "-".join(aa["name_3letter"] for aa in amino_acids_list)
 
     return AminoAcidExtractResponse(amino_acids=amino_acids_str)
@@ -115,7 +122,7 @@ def generate_protein_sequence(request: ProteinSequenceRequest) -> ProteinSequenc
     
     if _use_cpp_engine():
         try:
-            print(f"🚀 [AWS LAMBDA] Finding ORFs in RNA sequence ({seq_len:,} bp)...")
+            logger.info(f"🚀 [AWS LAMBDA] Finding ORFs in RNA sequence ({seq_len:,} bp)...")
             start_time = time.time()
             
             worker = get_aws_worker()
@@ -127,7 +134,7 @@ def generate_protein_sequence(request: ProteinSequenceRequest) -> ProteinSequenc
             
             result = worker.invoke(action="protein", payload=payload)
             elapsed = time.time() - start_time
-            print(f"✅ [AWS LAMBDA] Found {result.get('total_orfs', 0):,} ORFs! ⏱️ {elapsed:.3f}s")
+            logger.info(f"✅ [AWS LAMBDA] Found {result.get('total_orfs', 0):,} ORFs! ⏱️ {elapsed:.3f}s")
             
             protein_data = {
                 "orfs": result.get("orfs", []),
@@ -136,16 +143,18 @@ def generate_protein_sequence(request: ProteinSequenceRequest) -> ProteinSequenc
                 "sequence_1letter": result.get("sequence_1letter", ""),
             }
         except Exception as e:
-            print(f"⚠️ [AWS LAMBDA] ORF finding failed, falling back to Python: {e}")
+            logger.warning(f"⚠️ [AWS LAMBDA] ORF finding failed, falling back to Python: {e}")
+            ENGINE_FALLBACKS.inc(action="protein")
             protein_data = None
     
     # Python fallback
     if protein_data is None:
-        print(f"🐍 [PYTHON] Finding ORFs in RNA sequence ({seq_len:,} bp)...")
+        logger.info(f"🐍 [PYTHON] Finding ORFs in RNA sequence ({seq_len:,} bp)...")
         start_time = time.time()
-        protein_data = py_generate_protein_sequences(request.rna_sequence)
+        with track_engine_call("protein", backend="python"):
+            protein_data = py_generate_protein_sequences(request.rna_sequence)
         elapsed = time.time() - start_time
-        print(f"✅ [PYTHON] Found {protein_data.get('total_orfs', 0):,} ORFs! ⏱️ {elapsed:.3f}s")
+        logger.info(f"✅ [PYTHON] Found {protein_data.get('total_orfs', 0):,} ORFs! ⏱️ {elapsed:.3f}s")
     
     # Get first ORF's amino acids for protein classification
     orfs = protein_data.get("orfs", [])
@@ -14,6 +14,7 @@ from datetime import datetime
 from enum import Enum
 from typing import Any, Callable, Dict, Optional
 
+from app.core.metrics import register_queue
 from app.utils.redis_client import get_redis_client
 
 logger = logging.getLogger(__name__)
@@ -60,8 +61,19 @@ class SequenceQueueService:
         self._initialized = True
         self._local_processing = False  # Fallback if Redis unavailable
         self._job_processor: Optional[Callable[[Dict[str, Any]], None]] = None
+        register_queue("sequence_generation", self._queue_depth)
         logger.info("🚀 SequenceQueueService initialized")
 
+    def _queue_depth(self) -> Dict[str, float]:
+        """Queued and active job counts for the metrics scrape."""
+        client = self._get_client()
+        if client is None:
+            return {"queued": 0, "active": 1 if self._local_processing else 0}
+        return {
+            "queued": client.llen(QUEUE_KEY),
+            "active": int(client.get(ACTIVE_JOBS_KEY) or 0),
+        }
+
     def set_job_processor(self, processor: Callable[[Dict[str, Any]], None]):
         """
         Set the callback function to process queued jobs.
@@ -212,7 +212,7 @@ def build_cpp_engine_request(
     parent2_genotypes: Dict[str, str],
     traits: List[Dict[str, Any]],
     as_percentages: bool = True,
-    joint_phenotypes: bool = False
+    joint_phenotypes: bool = False,
 ) -> Dict[str, Any]:
     """
     Build complete JSON request for C++ engine CLI.
@@ -226,6 +226,9 @@ def build_cpp_engine_request(
 
     Returns:
         Dictionary in C++ CLI request format
+
+    Raises:
+        ValueError: If a parent genotype contains an unknown allele character
     """
 
     # Convert traits to gene definitions
@@ -233,28 +236,36 @@ def build_cpp_engine_request(
 
     # Parse parent genotypes to C++ format
     def parse_genotype(genotype_str: str, trait: Dict[str, Any]) -> List[str]:
-        """Convert 'AB' or 'Bb' to ['A', 'B'] or ['B', 'b']."""
+        """
+        Convert 'AB' or 'Bb' to its two alleles, reading left to right.
+
+        Raises:
+            ValueError: If the genotype contains a character that does not
+                start one of the trait's alleles
+        """
         alleles_list = list(trait.get("alleles", []))
         if not alleles_list:
             return []
 
-        # Try to split the genotype string
-        result = []
-        remaining = genotype_str
-
         # Sort alleles by length (longest first) to handle multi-char alleles
         sorted_alleles = sorted(alleles_list, key=len, reverse=True)
 
-        for allele in sorted_alleles:
-            while allele in remaining:
-                result.append(allele)
-                remaining = remaining.replace(allele, "", 1)
-                if len(result) >= 2:
+        result = []
+        remaining = genotype_str
+        # The whole string is checked, although only two alleles are kept
+        while remaining:
+            for allele in sorted_alleles:
+                if remaining.startswith(allele):
+                    result.append(allele)
+                    remaining = remaining[len(allele):]
                     break
-            if len(result) >= 2:
-                break
+            else:
+                raise ValueError(
+                    f"Unknown allele character '{remaining[0]}' in genotype '{genotype_str}' "
+                    f"for trait '{trait.get('key') or trait.get('id')}'"
+                )
 
-        return result[:2]  # Return at most 2 alleles
+        return result[:2]  # At most two alleles (diploid engine)
 
     # Build genotype maps
     mother_genotype = {}
@@ -286,5 +297,5 @@ def build_cpp_engine_request(
             "genotype": father_genotype
         },
         "as_percentages": as_percentages,
-        "joint_phenotypes": joint_phenotypes
+        "joint_phenotypes": joint_phenotypes,
     }
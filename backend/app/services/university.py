@@ -104,3 +104,9 @@ def get_assessment_history(
         course_slug=course_slug,
         module_id=module_id,
     )
+
+
+def generate_practice_problems(**options: Any) -> Dict[str, Any]:
+    from .problem_generator import GeneratorConfig, generate_problems
+
+    return generate_problems(GeneratorConfig(**options))
@@ -2132,7 +2132,7 @@ Question: {user_message.content}"""
         
         # 2. Execute agent
         try:
-            pedigree_response = await process_pedigree_query(pedigree_request)
+            pedigree_response = await process_pedigree_query(pedigree_request, user_id=user_id)
             
             response_content = pedigree_response.ai_message
             
@@ -2140,7 +2140,8 @@ Question: {user_message.content}"""
             # Construct the nested payload structure expected by frontend
             pedigree_payload = {
                 "structured_data": pedigree_response.structured_data.model_dump() if pedigree_response.structured_data else None,
-                "analysis_result": pedigree_response.analysis_result.model_dump() if pedigree_response.analysis_result else None
+                "analysis_result": pedigree_response.analysis_result.model_dump() if pedigree_response.analysis_result else None,
+                "session_id": pedigree_response.session_id
             }
 
             # Ensure metadata is properly typed including token counts
@@ -0,0 +1,180 @@
+"""
+Statistics helpers
+==================
+Distribution functions needed by the analysis services, implemented with the
+standard library so the backend does not depend on scipy.
+"""
+
+import math
+
+import numpy as np
+
+_MAX_ITERATIONS = 500
+_EPSILON = 1e-14
+_TINY = 1e-300
+
+
+def _lower_gamma_series(a: float, x: float) -> float:
+    """Regularised lower incomplete gamma P(a, x) by its power series (x < a + 1)."""
+    term = 1.0 / a
+    total = term
+    denominator = a
+    for _ in range(_MAX_ITERATIONS):
+        denominator += 1.0
+        term *= x / denominator
+        total += term
+        if abs(term) < abs(total) * _EPSILON:
+            break
+    return total * math.exp(-x + a * math.log(x) - math.lgamma(a))
+
+
+def _upper_gamma_fraction(a: float, x: float) -> float:
+    """Regularised upper incomplete gamma Q(a, x) by Lentz's continued fraction (x >= a + 1)."""
+    b = x + 1.0 - a
+    c = 1.0 / _TINY
+    d = 1.0 / b
+    h = d
+    for i in range(1, _MAX_ITERATIONS):
+        an = -i * (i - a)
+        b += 2.0
+        d = an * d + b
+        d = _TINY if abs(d) < _TINY else d
+        c = b + an / c
+        c = _TINY if abs(c) < _TINY else c
+        d = 1.0 / d
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < _EPSILON:
+            break
+    return math.exp(-x + a * math.log(x) - math.lgamma(a)) * h
+
+
+def regularized_upper_gamma(a: float, x: float) -> float:
+    """Q(a, x) = Γ(a, x) / Γ(a)."""
+    if x <= 0:
+        return 1.0
+    if x < a + 1.0:
+        return 1.0 - _lower_gamma_series(a, x)
+    return _upper_gamma_fraction(a, x)
+
+
+def chi2_sf(statistic: float, df: float) -> float:
+    """Survival function (upper-tail p-value) of the χ² distribution."""
+    if df <= 0:
+        raise ValueError(f"Degrees of freedom must be positive, got: {df}")
+    if statistic <= 0:
+        return 1.0
+    return min(1.0, max(0.0, regularized_upper_gamma(df / 2.0, statistic / 2.0)))
+
+
+def _beta_fraction(a: float, b: float, x: float) -> float:
+    """Continued fraction for the regularised incomplete beta (Lentz)."""
+    qab = a + b
+    qap = a + 1.0
+    qam = a - 1.0
+    c = 1.0
+    d = 1.0 - qab * x / qap
+    d = _TINY if abs(d) < _TINY else d
+    d = 1.0 / d
+    h = d
+    for m in range(1, _MAX_ITERATIONS):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 + aa * d
+        d = _TINY if abs(d) < _TINY else d
+        c = 1.0 + aa / c
+        c = _TINY if abs(c) < _TINY else c
+        d = 1.0 / d
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 + aa * d
+        d = _TINY if abs(d) < _TINY else d
+        c = 1.0 + aa / c
+        c = _TINY if abs(c) < _TINY else c
+        d = 1.0 / d
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < _EPSILON:
+            break
+    return h
+
+
+def regularized_incomplete_beta(a: float, b: float, x: float) -> float:
+    """I_x(a, b) = B(x; a, b) / B(a, b)."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    log_front = (
+        math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+        + a * math.log(x) + b * math.log1p(-x)
+    )
+    if x < (a + 1.0) / (a + b + 2.0):
+        return math.exp(log_front) * _beta_fraction(a, b, x) / a
+    return 1.0 - math.exp(log_front) * _beta_fraction(b, a, 1.0 - x) / b
+
+
+def t_sf_two_sided(statistic: float, df: float) -> float:
+    """Two-sided p-value of Student's t distribution, P(|T| >= |t|)."""
+    if df <= 0:
+        raise ValueError(f"Degrees of freedom must be positive, got: {df}")
+    if statistic != statistic:
+        return 1.0
+    t2 = statistic * statistic
+    return min(1.0, max(0.0, regularized_incomplete_beta(df / 2.0, 0.5, df / (df + t2))))
+
+
+def _beta_fraction_array(a: float, b: float, x: np.ndarray) -> np.ndarray:
+    """Elementwise ``_beta_fraction``; converged elements are frozen."""
+    qab = a + b
+    qap = a + 1.0
+    qam = a - 1.0
+    c = np.ones_like(x)
+    d = 1.0 - qab * x / qap
+    d = 1.0 / np.where(np.abs(d) < _TINY, _TINY, d)
+    h = d.copy()
+    active = np.ones(x.shape, dtype=bool)
+    for m in range(1, _MAX_ITERATIONS):
+        m2 = 2 * m
+        for aa in (
+            m * (b - m) * x / ((qam + m2) * (a + m2)),
+            -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2)),
+        ):
+            d = 1.0 + aa * d
+            d = 1.0 / np.where(np.abs(d) < _TINY, _TINY, d)
+            c = 1.0 + aa / c
+            c = np.where(np.abs(c) < _TINY, _TINY, c)
+            delta = d * c
+            h = np.where(active, h * delta, h)
+        active &= np.abs(delta - 1.0) >= _EPSILON
+        if not active.any():
+            break
+    return h
+
+
+def regularized_incomplete_beta_array(a: float, b: float, x: np.ndarray) -> np.ndarray:
+    """``regularized_incomplete_beta`` for an array of ``x`` with shared parameters."""
+    x = np.asarray(x, dtype=np.float64)
+    out = np.where(x >= 1.0, 1.0, 0.0)
+    inner = (x > 0.0) & (x < 1.0)
+    xi = x[inner]
+    log_front = (
+        math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+        + a * np.log(xi) + b * np.log1p(-xi)
+    )
+    front = np.exp(log_front)
+    lower = xi < (a + 1.0) / (a + b + 2.0)
+    values = np.empty_like(xi)
+    values[lower] = front[lower] * _beta_fraction_array(a, b, xi[lower]) / a
+    values[~lower] = 1.0 - front[~lower] * _beta_fraction_array(b, a, 1.0 - xi[~lower]) / b
+    out[inner] = values
+    return out
+
+
+def t_sf_two_sided_array(statistic: np.ndarray, df: float) -> np.ndarray:
+    """``t_sf_two_sided`` for an array of statistics sharing ``df``."""
+    if df <= 0:
+        raise ValueError(f"Degrees of freedom must be positive, got: {df}")
+    t = np.asarray(statistic, dtype=np.float64)
+    p = regularized_incomplete_beta_array(df / 2.0, 0.5, df / (df + t * t))
+    return np.where(np.isnan(t), 1.0, np.clip(p, 0.0, 1.0))
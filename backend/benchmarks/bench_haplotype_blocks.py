@@ -0,0 +1,135 @@
+"""
+Haplotype block selection benchmark
+===================================
+Times block construction (candidate testing and longest-first selection)
+on the LD band of a simulated chromosome, against the per-candidate loop it
+replaced, for both partitioning methods.
+
+Each method is first checked to return exactly the reference blocks. The
+run fails (exit status 1) when a method's selection takes longer than
+``--max-seconds``, so a regression back to per-candidate Python work shows
+up as a failure rather than a slower number.
+
+Usage (from backend/):
+    python -m benchmarks.bench_haplotype_blocks [--snps 6000] [--samples 200] [--window 200] [--max-seconds 2]
+"""
+
+from __future__ import annotations
+
+import argparse
+import sys
+import time
+
+import numpy as np
+
+from app.services.genomics import haplotype_blocks as hb
+
+
+def simulate(n_snps: int, n_samples: int, rng: np.random.Generator):
+    """Dosages with blocks of 5-60 SNPs, each drawn from a few founder haplotypes."""
+    blocks = []
+    total = 0
+    while total < n_snps:
+        length = min(int(rng.integers(5, 61)), n_snps - total)
+        founders = rng.integers(0, 2, size=(int(rng.integers(2, 6)), length))
+        freqs = rng.dirichlet(np.ones(founders.shape[0]))
+        pick = rng.choice(founders.shape[0], size=(2, n_samples), p=freqs)
+        blocks.append((founders[pick[0]] + founders[pick[1]]).T)
+        total += length
+    dosages = np.vstack(blocks).astype(np.int8)
+    positions = np.cumsum(rng.integers(500, 3000, size=n_snps)).astype(np.int64)
+    return dosages, positions
+
+
+def _reference_select(candidates, positions, accept):
+    used = np.zeros(positions.size, dtype=bool)
+    blocks = []
+    for i, j in sorted(candidates, key=lambda c: (-(positions[c[1]] - positions[c[0]]), c[0])):
+        if used[i:j + 1].any() or not accept(i, j):
+            continue
+        used[i:j + 1] = True
+        blocks.append((i, j))
+    return sorted(blocks)
+
+
+def reference_gabriel(band, positions):
+    window = band["in_window"]
+    strong = window & (band["lower"] >= hb._GABRIEL_STRONG_LOWER) & (band["upper"] >= hb._GABRIEL_STRONG_UPPER)
+    recombination = window & (band["upper"] < hb._GABRIEL_RECOMBINATION_UPPER)
+    strong_cum = np.cumsum(strong, axis=1)
+    recombination_cum = np.cumsum(recombination, axis=1)
+    width = window.shape[1] - 1
+
+    def accept(i, j):
+        rows = np.arange(i, j)
+        reach = np.minimum(j - rows, width)
+        n_strong = strong_cum[rows, reach].sum()
+        informative = n_strong + recombination_cum[rows, reach].sum()
+        return informative > 0 and n_strong / informative >= hb._GABRIEL_INFORMATIVE_FRACTION
+
+    rows, offsets = np.nonzero(strong)
+    return _reference_select(list(zip(rows.tolist(), (rows + offsets).tolist())), positions, accept)
+
+
+def reference_spine(band, positions, threshold):
+    strong = band["in_window"] & (band["dprime"] >= threshold)
+    m, width_1 = strong.shape
+    row_ok = np.cumprod(strong[:, 1:], axis=1).astype(bool)
+    by_column = np.zeros_like(strong[:, 1:])
+    for d in range(1, width_1):
+        by_column[d:, d - 1] = strong[:m - d, d]
+    col_ok = np.cumprod(by_column, axis=1).astype(bool)
+    candidates = []
+    for d in range(1, width_1):
+        i = np.flatnonzero(row_ok[:m - d, d - 1] & col_ok[d:, d - 1])
+        candidates.extend(zip(i.tolist(), (i + d).tolist()))
+    return _reference_select(candidates, positions, lambda i, j: True)
+
+
+def _time(fn, repeat: int):
+    best, result = float("inf"), None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = fn()
+        best = min(best, time.perf_counter() - start)
+    return best, result
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--snps", type=int, default=6000)
+    parser.add_argument("--samples", type=int, default=200)
+    parser.add_argument("--window", type=int, default=200)
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--max-seconds", type=float, default=2.0)
+    args = parser.parse_args()
+
+    dosages, positions = simulate(args.snps, args.samples, np.random.default_rng(7))
+    start = time.perf_counter()
+    band = hb.ld_band(dosages, positions, 500_000, args.window, confidence_bounds=True)
+    print(f"LD band: {args.snps} SNPs x {args.window} in {time.perf_counter() - start:.2f}s")
+
+    methods = {
+        "gabriel": (lambda: hb.gabriel_blocks(band, positions), lambda: reference_gabriel(band, positions)),
+        "dprime": (lambda: hb.spine_blocks(band, positions, 0.8), lambda: reference_spine(band, positions, 0.8)),
+    }
+    failed = []
+    print(f"{'method':<10}{'blocks':>8}{'selection':>12}{'reference':>12}{'speed-up':>10}")
+    for name, (fast, reference) in methods.items():
+        elapsed, blocks = _time(fast, args.repeat)
+        reference_elapsed, expected = _time(reference, 1)
+        assert blocks == expected, f"{name}: blocks differ from the reference selection"
+        print(
+            f"{name:<10}{len(blocks):>8}{elapsed * 1000:>10.1f}ms{reference_elapsed * 1000:>10.1f}ms"
+            f"{reference_elapsed / elapsed:>9.1f}x"
+        )
+        if elapsed > args.max_seconds:
+            failed.append(f"{name} selection took {elapsed:.2f}s (limit {args.max_seconds:.2f}s)")
+
+    for message in failed:
+        print(f"FAIL: {message}", file=sys.stderr)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+"""
+JSON serialisation microbenchmark
+=================================
+Compares the stdlib encoder with ``app.serializers.json_writer`` on
+synthetic GWAS association, ORF and probability result sets.
+
+Usage (from backend/):
+    python -m benchmarks.bench_json_writer [--rows 200000] [--repeat 3]
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import random
+import time
+
+from app.serializers import json_writer
+
+
+def gwas_rows(n: int, rng: random.Random) -> list[dict]:
+    rows = []
+    for i in range(n):
+        beta = rng.gauss(0, 0.05)
+        se = rng.uniform(0.005, 0.05)
+        rows.append({
+            "rsid": f"rs{rng.randrange(1, 10**9)}",
+            "chromosome": rng.randint(1, 23),
+            "position": rng.randrange(1, 250_000_000),
+            "ref_allele": rng.choice("ACGT"),
+            "alt_allele": rng.choice("ACGT"),
+            "beta": beta,
+            "se": se,
+            "t_stat": beta / se,
+            "p_value": 10 ** -rng.uniform(0, 12),
+            "maf": rng.uniform(0.01, 0.5),
+            "n_samples": rng.randint(500, 500_000),
+        })
+    return rows
+
+
+def orf_rows(n: int, rng: random.Random) -> list[dict]:
+    rows = []
+    for _ in range(n):
+        start = rng.randrange(0, 10**6)
+        length = rng.randrange(30, 3000, 3)
+        rows.append({
+            "start": start,
+            "end": start + length,
+            "frame": rng.choice((1, 2, 3, -1, -2, -3)),
+            "length": length,
+            "protein": "".join(rng.choices("ACDEFGHIKLMNPQRSTVWY", k=min(length // 3, 60))),
+        })
+    return rows
+
+
+def probability_rows(n: int, rng: random.Random) -> list[dict]:
+    return [{"genotype": rng.choice(("AA", "Aa", "aa")), "probability": rng.random()} for _ in range(n)]
+
+
+def _close(a, b, rel_tol: float) -> bool:
+    """Structural equality with floats compared to ``rel_tol``."""
+    if isinstance(a, dict) and isinstance(b, dict):
+        return a.keys() == b.keys() and all(_close(a[k], b[k], rel_tol) for k in a)
+    if isinstance(a, list) and isinstance(b, list):
+        return len(a) == len(b) and all(_close(x, y, rel_tol) for x, y in zip(a, b))
+    if isinstance(a, float) or isinstance(b, float):
+        return math.isclose(a, b, rel_tol=rel_tol, abs_tol=1e-300)
+    return a == b
+
+
+def _time(fn, repeat: int) -> float:
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        fn()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--rows", type=int, default=200_000)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    rng = random.Random(7)
+    datasets = {
+        "gwas": (gwas_rows(args.rows, rng), None),
+        "orf": (orf_rows(args.rows, rng), None),
+        "probabilities": (probability_rows(args.rows, rng), {"probability": 6}),
+    }
+
+    print(f"{'dataset':<14}{'json.dumps':>12}{'indent=2':>12}{'json_writer':>13}{'vs dumps':>10}{'vs indent':>11}")
+    for name, (rows, precision) in datasets.items():
+        # Round-trip check before timing; rounded columns keep ``digits`` significant digits
+        digits = min(precision.values()) if precision else 17
+        decoded = json.loads(json_writer.dumps_records(rows[:1000], precision=precision))
+        assert _close(decoded, rows[:1000], rel_tol=0.5 * 10.0 ** (1 - digits)), f"{name} round-trip mismatch"
+
+        compact = _time(lambda: json.dumps(rows), args.repeat)
+        indented = _time(lambda: json.dumps(rows, indent=2), args.repeat)
+        writer = _time(lambda: json_writer.dumps_records(rows, precision=precision), args.repeat)
+        print(
+            f"{name:<14}{compact * 1000:>10.1f}ms{indented * 1000:>10.1f}ms{writer * 1000:>11.1f}ms"
+            f"{compact / writer:>9.2f}x{indented / writer:>10.2f}x"
+        )
+
+
+if __name__ == "__main__":
+    main()
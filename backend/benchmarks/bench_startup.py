@@ -0,0 +1,174 @@
+"""
+Engine startup benchmark
+========================
+Measures exec-to-first-response for each engine action the way a Lambda
+cold start sees it, and how much of that is startup rather than compute.
+
+For every action three timings are taken (best of ``--repeat``):
+
+- ``cold``: a fresh interpreter imports ``lambda_handler`` and serves one
+  event (interpreter + handler import + engine exec + compute).
+- ``warm``: the same event served again in an already-initialised handler
+  process (engine exec + compute only).
+- ``exec``: the engine binary run directly, without the handler.
+
+``startup`` is ``cold - warm``; small ``cross``/``protein`` calls should be
+dominated by ``warm``, not ``startup``. Without an engine binary the handler
+still runs and the table shows the Python-side startup cost alone.
+
+Usage (from backend/, with zygotrix_engine in --engine-dir):
+    python -m benchmarks.bench_startup [--engine-dir .] [--repeat 5] [--actions cross,protein]
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import random
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+BACKEND_DIR = Path(__file__).resolve().parent.parent
+
+_CHILD = r"""
+import json, sys, time
+t0 = time.perf_counter()
+sys.path.insert(0, {backend!r})
+import lambda_handler
+t1 = time.perf_counter()
+event = json.loads(sys.stdin.read())
+response = lambda_handler.handler(event, None)
+t2 = time.perf_counter()
+for _ in range({warm_runs}):
+    lambda_handler.handler(event, None)
+t3 = time.perf_counter()
+print(json.dumps({{
+    "import_ms": (t1 - t0) * 1000,
+    "first_ms": (t2 - t1) * 1000,
+    "warm_ms": (t3 - t2) * 1000 / max({warm_runs}, 1),
+    "status": response.get("statusCode"),
+}}))
+"""
+
+
+def sample_events(rng: random.Random) -> Dict[str, Dict[str, Any]]:
+    """One small, representative event per action."""
+    rna = "".join(rng.choices("ACGU", k=300))
+    return {
+        "cross": {
+            "action": "cross",
+            "payload": {
+                "genes": [{
+                    "id": "fur_color",
+                    "chromosome": "autosomal",
+                    "dominance": "complete",
+                    "default_allele_id": "B",
+                    "alleles": [
+                        {"id": "B", "dominance_rank": 2,
+                         "effects": [{"trait_id": "coat_color", "magnitude": 1.0, "description": "black"}]},
+                        {"id": "b", "dominance_rank": 1,
+                         "effects": [{"trait_id": "coat_color", "magnitude": 0.6, "description": "brown"}]},
+                    ],
+                }],
+                "mother": {"sex": "female", "genotype": {"fur_color": ["B", "b"]}},
+                "father": {"sex": "male", "genotype": {"fur_color": ["b", "b"]}},
+                "simulations": 100,
+            },
+        },
+        "protein": {"action": "protein", "payload": {"action": "find_orfs", "rna_sequence": rna}},
+        "dna": {"action": "dna", "payload": {"length": 1000, "gc_content": 0.5, "seed": 1}},
+        "pedigree_analyze": {
+            "action": "pedigree_analyze",
+            "payload": {
+                "target_trait": "cystic_fibrosis",
+                "members": [
+                    {"id": "f", "relation": "father", "phenotype": "unaffected"},
+                    {"id": "m", "relation": "mother", "phenotype": "unaffected"},
+                    {"id": "c1", "relation": "proband", "phenotype": "affected",
+                     "parent_ids": ["f", "m"]},
+                ],
+            },
+        },
+    }
+
+
+def _cold_and_warm(event: Dict[str, Any], engine_dir: Path, warm_runs: int) -> Dict[str, float]:
+    code = _CHILD.format(backend=str(BACKEND_DIR), warm_runs=warm_runs)
+    start = time.perf_counter()
+    result = subprocess.run(
+        [sys.executable, "-c", code],
+        input=json.dumps(event),
+        capture_output=True,
+        text=True,
+        cwd=engine_dir,
+    )
+    wall_ms = (time.perf_counter() - start) * 1000
+    if result.returncode != 0:
+        raise RuntimeError(result.stderr.strip().splitlines()[-1])
+    timings = json.loads(result.stdout.strip().splitlines()[-1])
+    # Exec-to-first-response excludes the in-process warm loop
+    timings["cold_ms"] = wall_ms - timings["warm_ms"] * warm_runs
+    return timings
+
+
+def _direct_exec(event: Dict[str, Any], engine_dir: Path) -> Optional[float]:
+    binary = engine_dir / "zygotrix_engine"
+    if not binary.exists():
+        return None
+    start = time.perf_counter()
+    subprocess.run(
+        [str(binary), event["action"], json.dumps(event["payload"])],
+        capture_output=True,
+        cwd=engine_dir,
+    )
+    return (time.perf_counter() - start) * 1000
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Engine startup benchmark")
+    parser.add_argument("--engine-dir", default=".", help="Directory containing zygotrix_engine")
+    parser.add_argument("--actions", default="cross,protein,dna,pedigree_analyze")
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--warm-runs", type=int, default=5)
+    args = parser.parse_args()
+
+    engine_dir = Path(args.engine_dir).resolve()
+    events = sample_events(random.Random(11))
+    actions = [a for a in args.actions.split(",") if a]
+    unknown = set(actions) - set(events)
+    if unknown:
+        parser.error(f"unknown actions: {sorted(unknown)}")
+
+    has_engine = (engine_dir / "zygotrix_engine").exists()
+    if not has_engine:
+        print(f"note: no zygotrix_engine in {engine_dir}; timing the handler alone\n", file=sys.stderr)
+
+    header = f"{'action':<17} {'cold ms':>9} {'warm ms':>9} {'startup ms':>11} {'startup %':>10} {'import ms':>10} {'exec ms':>9}"
+    print(header)
+    print("-" * len(header))
+    for action in actions:
+        event = events[action]
+        best: Dict[str, float] = {}
+        for _ in range(args.repeat):
+            timings = _cold_and_warm(event, engine_dir, args.warm_runs)
+            for key, value in timings.items():
+                if key != "status":
+                    best[key] = min(best.get(key, value), value)
+        exec_ms = min(
+            (t for t in (_direct_exec(event, engine_dir) for _ in range(args.repeat)) if t is not None),
+            default=None,
+        )
+        startup = best["cold_ms"] - best["warm_ms"]
+        exec_text = f"{exec_ms:9.1f}" if exec_ms is not None else f"{'-':>9}"
+        print(
+            f"{action:<17} {best['cold_ms']:9.1f} {best['warm_ms']:9.1f} {startup:11.1f} "
+            f"{100 * startup / best['cold_ms']:9.0f}% {best['import_ms']:10.1f} {exec_text}"
+        )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
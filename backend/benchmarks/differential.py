@@ -0,0 +1,405 @@
+"""
+Fallback vs engine differential harness
+=======================================
+Runs the backend's Python fallbacks and the native engine on the same
+randomised inputs, checks that they agree within tolerances and prints a
+speedup table per action and input size.
+
+Actions and what "agree" means:
+
+- ``dna``: both sequences have the requested length, only ACGT, the RNA is
+  the exact transcription and the GC fraction is within 5σ of the target
+  (the generators use different RNGs, so sequences are not compared).
+- ``orfs``: identical ORF sets (start, end, 1-letter protein) for the same RNA.
+- ``cross``: engine descriptor frequencies are within 5σ (binomial) of the
+  exact Punnett-square phenotype ratios from ``MendelianCalculator``.
+- ``gwas``: per-SNP beta and SE within 1e-6 relative, p-values within 0.1
+  on the -log10 scale (the fallback uses a normal approximation).
+
+The engine is either the CLI binary (``--engine ./zygotrix_engine``, invoked
+as ``<binary> <action> <json>`` exactly like the Lambda handler does) or the
+configured Lambda worker. The binary takes its payload as a single argv
+string, so inputs above the kernel's per-argument limit (128 KiB on Linux)
+only run against Lambda. The exit status is non-zero on any disagreement,
+and with ``--fail-on-regression`` also when a fallback beats the engine.
+
+Usage (from backend/):
+    python -m benchmarks.differential [--engine PATH] [--actions dna,orfs,cross,gwas]
+                                      [--sizes small,medium,large] [--repeat 3] [--seed 7]
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import random
+import subprocess
+import sys
+import time
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+from app.models import Trait
+from app.models.mendelian_calculator import MendelianCalculator
+from app.schema.gwas import GwasAnalysisType
+from app.services import protein_generator_impl
+from app.services.gwas_engine import _python_linear_regression
+
+SIZES = ("small", "medium", "large")
+
+DNA_LENGTHS = {"small": 10_000, "medium": 100_000, "large": 1_000_000}
+ORF_LENGTHS = {"small": 1_000, "medium": 10_000, "large": 50_000}
+CROSS_SIMULATIONS = {"small": 1_000, "medium": 10_000, "large": 50_000}
+GWAS_SHAPES = {"small": (100, 200), "medium": (1_000, 500), "large": (5_000, 1_000)}
+
+SIGMA = 5.0
+
+
+class Engine:
+    """Native engine invoked through the CLI binary or the Lambda worker."""
+
+    def __init__(self, binary: Optional[str] = None, timeout: int = 600):
+        self.binary = binary
+        self.timeout = timeout
+        self.name = "binary" if binary else "lambda"
+
+    def invoke(self, action: str, payload: Dict[str, Any]) -> Dict[str, Any]:
+        if self.binary is None:
+            from app.services.aws_worker_client import get_aws_worker
+
+            return get_aws_worker().invoke(action=action, payload=payload)
+
+        result = subprocess.run(
+            [self.binary, action, json.dumps(payload)],
+            capture_output=True,
+            text=True,
+            timeout=self.timeout,
+        )
+        if result.returncode != 0:
+            raise RuntimeError(result.stderr.strip() or f"exit status {result.returncode}")
+        return json.loads(result.stdout)
+
+
+@dataclass
+class Case:
+    """One action at one size: how to run each side and how to compare."""
+
+    action: str
+    size: str
+    label: str
+    python: Callable[[], Any]
+    engine: Callable[[Engine], Any]
+    compare: Callable[[Any, Any], List[str]]
+
+
+@dataclass
+class Outcome:
+    action: str
+    size: str
+    label: str
+    python_ms: Optional[float]
+    engine_ms: Optional[float]
+    problems: List[str]
+
+    @property
+    def speedup(self) -> Optional[float]:
+        if self.python_ms is None or not self.engine_ms:
+            return None
+        return self.python_ms / self.engine_ms
+
+
+def _best_of(repeat: int, func: Callable[[], Any]) -> Tuple[float, Any]:
+    best, value = math.inf, None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        value = func()
+        best = min(best, time.perf_counter() - start)
+    return best * 1000.0, value
+
+
+def _within_sigma(observed: float, expected: float, n: int) -> bool:
+    sd = math.sqrt(max(expected * (1.0 - expected), 1e-12) / n)
+    return abs(observed - expected) <= SIGMA * sd + 1e-12
+
+
+# ============================================================================
+# dna
+# ============================================================================
+
+def dna_case(size: str, rng: random.Random) -> Case:
+    length = DNA_LENGTHS[size]
+    gc = round(rng.uniform(0.3, 0.7), 3)
+    seed = rng.randrange(1, 2**31)
+
+    def python() -> Dict[str, Any]:
+        dna = protein_generator_impl.generate_dna_sequence(length, gc, seed)
+        return {"dna_sequence": dna, "rna_sequence": protein_generator_impl.transcribe_to_rna(dna)}
+
+    def engine(native: Engine) -> Dict[str, Any]:
+        return native.invoke("dna", {"length": length, "gc_content": gc, "seed": seed})
+
+    def check(result: Dict[str, Any], side: str) -> List[str]:
+        problems = []
+        dna = result.get("dna_sequence") or result.get("sequence") or ""
+        if len(dna) != length:
+            problems.append(f"{side}: length {len(dna)} != {length}")
+        if set(dna) - set("ACGT"):
+            problems.append(f"{side}: non-ACGT bases {sorted(set(dna) - set('ACGT'))}")
+        rna = result.get("rna_sequence")
+        if rna is not None and rna != protein_generator_impl.transcribe_to_rna(dna):
+            problems.append(f"{side}: RNA is not the transcription of the DNA")
+        actual = protein_generator_impl.calculate_actual_gc(dna)
+        if dna and not _within_sigma(actual, gc, len(dna)):
+            problems.append(f"{side}: GC {actual:.4f} outside {SIGMA}σ of {gc}")
+        return problems
+
+    return Case("dna", size, f"{length:,} bp", python, engine,
+                lambda py, nat: check(py, "python") + check(nat, "engine"))
+
+
+# ============================================================================
+# orfs
+# ============================================================================
+
+def _random_rna(length: int, rng: random.Random) -> str:
+    # Enrich start codons so even small inputs have several ORFs
+    parts, total = [], 0
+    while total < length:
+        chunk = "AUG" if rng.random() < 0.05 else "".join(rng.choices("ACGU", k=3))
+        parts.append(chunk)
+        total += 3
+    return "".join(parts)[:length]
+
+
+def _orf_key(orf: Dict[str, Any]) -> Tuple[int, int, str]:
+    start = orf.get("start_position", orf.get("start", 0))
+    end = orf.get("end_position", orf.get("end", 0))
+    return int(start), int(end), orf.get("protein_1letter", "")
+
+
+def orfs_case(size: str, rng: random.Random) -> Case:
+    length = ORF_LENGTHS[size]
+    rna = _random_rna(length, rng)
+
+    def python() -> Dict[str, Any]:
+        return protein_generator_impl.generate_protein_sequences(rna)
+
+    def engine(native: Engine) -> Dict[str, Any]:
+        return native.invoke("protein", {"action": "find_orfs", "rna_sequence": rna})
+
+    def compare(py: Dict[str, Any], nat: Dict[str, Any]) -> List[str]:
+        py_orfs = sorted(map(_orf_key, py.get("orfs", [])))
+        nat_orfs = sorted(map(_orf_key, nat.get("orfs", [])))
+        if py_orfs == nat_orfs:
+            return []
+        missing = sorted(set(py_orfs) - set(nat_orfs))[:3]
+        extra = sorted(set(nat_orfs) - set(py_orfs))[:3]
+        return [
+            f"ORF sets differ: python {len(py_orfs)}, engine {len(nat_orfs)}; "
+            f"only in python {missing}, only in engine {extra}"
+        ]
+
+    return Case("orfs", size, f"{length:,} nt", python, engine, compare)
+
+
+# ============================================================================
+# cross
+# ============================================================================
+
+def cross_case(size: str, rng: random.Random) -> Case:
+    simulations = CROSS_SIMULATIONS[size]
+    n_alleles = rng.randint(2, 4)
+    alleles = ["A", "B", "C", "D"][:n_alleles]
+    # Complete dominance by rank: earlier alleles dominate later ones
+    descriptors = {allele: f"phenotype_{allele}" for allele in alleles}
+    trait = Trait(
+        "differential_trait",
+        alleles,
+        phenotype_map={},
+    )
+    trait.phenotype_map = {
+        genotype: descriptors[min(trait._parse_genotype(genotype), key=alleles.index)]
+        for genotype in trait.all_genotypes()
+    }
+    parent1 = "".join(sorted(rng.choices(alleles, k=2)))
+    parent2 = "".join(sorted(rng.choices(alleles, k=2)))
+
+    def python() -> Dict[str, Any]:
+        return MendelianCalculator().calculate_cross(trait, parent1, parent2)
+
+    def engine(native: Engine) -> Dict[str, Any]:
+        gene = {
+            "id": "locus",
+            "chromosome": "autosomal",
+            "dominance": "complete",
+            "default_allele_id": alleles[0],
+            "alleles": [
+                {
+                    "id": allele,
+                    "dominance_rank": n_alleles - i,
+                    "effects": [{"trait_id": "differential_trait", "magnitude": 1.0,
+                                 "description": descriptors[allele]}],
+                }
+                for i, allele in enumerate(alleles)
+            ],
+        }
+        return native.invoke("cross", {
+            "genes": [gene],
+            "mother": {"sex": "female", "genotype": {"locus": list(parent1)}},
+            "father": {"sex": "male", "genotype": {"locus": list(parent2)}},
+            "simulations": simulations,
+        })
+
+    def compare(py: Dict[str, Any], nat: Dict[str, Any]) -> List[str]:
+        summary = (nat.get("trait_summaries") or {}).get("differential_trait")
+        if summary is None:
+            return ["engine returned no summary for the trait"]
+        counts = summary.get("descriptor_counts", {})
+        total = sum(counts.values()) or nat.get("simulations", simulations)
+        problems = []
+        for phenotype in set(py["phenotypic_ratios"]) | set(counts):
+            expected = py["phenotypic_ratios"].get(phenotype, 0.0)
+            observed = counts.get(phenotype, 0) / total
+            if not _within_sigma(observed, expected, total):
+                problems.append(f"{phenotype}: engine {observed:.4f} vs exact {expected:.4f}")
+        return problems
+
+    return Case("cross", size, f"{parent1}x{parent2}, {simulations:,} sims", python, engine, compare)
+
+
+# ============================================================================
+# gwas
+# ============================================================================
+
+def gwas_case(size: str, rng: random.Random) -> Case:
+    n_snps, n_samples = GWAS_SHAPES[size]
+    snps, frequencies = [], []
+    for i in range(n_snps):
+        snps.append({
+            "rsid": f"rs{i + 1}",
+            "chromosome": rng.randint(1, 22),
+            "position": rng.randrange(1, 250_000_000),
+            "ref_allele": "A",
+            "alt_allele": "G",
+        })
+        frequencies.append(rng.uniform(0.02, 0.5))
+    causal = rng.randrange(n_snps)
+    samples = []
+    for s in range(n_samples):
+        genotypes = [
+            -1 if rng.random() < 0.01 else (rng.random() < f) + (rng.random() < f)
+            for f in frequencies
+        ]
+        dosage = max(genotypes[causal], 0)
+        samples.append({
+            "sample_id": f"S{s + 1}",
+            "phenotype": 0.4 * dosage + rng.gauss(0.0, 1.0),
+            "genotypes": genotypes,
+        })
+
+    def python() -> Dict[str, Any]:
+        return _python_linear_regression(snps, samples, GwasAnalysisType.LINEAR)
+
+    def engine(native: Engine) -> Dict[str, Any]:
+        return native.invoke("gwas", {
+            "snps": snps,
+            "samples": samples,
+            "test_type": GwasAnalysisType.LINEAR.value,
+            "maf_threshold": 0.01,
+        })
+
+    def compare(py: Dict[str, Any], nat: Dict[str, Any]) -> List[str]:
+        py_rows = {row["rsid"]: row for row in py.get("results", [])}
+        nat_rows = {row["rsid"]: row for row in nat.get("results", [])}
+        problems = []
+        if set(py_rows) != set(nat_rows):
+            problems.append(
+                f"tested SNP sets differ: python {len(py_rows)}, engine {len(nat_rows)}"
+            )
+        for rsid in sorted(set(py_rows) & set(nat_rows)):
+            a, b = py_rows[rsid], nat_rows[rsid]
+            for key in ("beta", "se"):
+                if not math.isclose(a[key], b[key], rel_tol=1e-6, abs_tol=1e-9):
+                    problems.append(f"{rsid} {key}: python {a[key]:.6g} vs engine {b[key]:.6g}")
+            pa, pb = max(a["p_value"], 1e-300), max(b["p_value"], 1e-300)
+            if min(pa, pb) > 1e-8 and abs(math.log10(pa) - math.log10(pb)) > 0.1:
+                problems.append(f"{rsid} p_value: python {pa:.3g} vs engine {pb:.3g}")
+            if len(problems) >= 10:
+                problems.append("...")
+                break
+        return problems
+
+    return Case("gwas", size, f"{n_snps:,} SNPs x {n_samples:,}", python, engine, compare)
+
+
+CASES = {"dna": dna_case, "orfs": orfs_case, "cross": cross_case, "gwas": gwas_case}
+
+
+# ============================================================================
+# Runner
+# ============================================================================
+
+def run_case(case: Case, native: Engine, repeat: int) -> Outcome:
+    python_ms, py_result = _best_of(repeat, case.python)
+    try:
+        engine_ms, nat_result = _best_of(repeat, lambda: case.engine(native))
+    except Exception as e:
+        return Outcome(case.action, case.size, case.label, python_ms, None, [f"engine error: {e}"])
+    return Outcome(case.action, case.size, case.label, python_ms, engine_ms,
+                   case.compare(py_result, nat_result))
+
+
+def format_table(outcomes: List[Outcome], engine_name: str) -> str:
+    header = f"{'action':<7} {'size':<7} {'input':<28} {'python ms':>11} {engine_name + ' ms':>11} {'speedup':>9}  result"
+    lines = [header, "-" * len(header)]
+    for o in outcomes:
+        engine_ms = f"{o.engine_ms:11.2f}" if o.engine_ms is not None else f"{'-':>11}"
+        speedup = f"{o.speedup:8.1f}x" if o.speedup is not None else f"{'-':>9}"
+        result = "agree" if not o.problems else f"MISMATCH: {o.problems[0]}"
+        lines.append(f"{o.action:<7} {o.size:<7} {o.label:<28} {o.python_ms:11.2f} {engine_ms} {speedup}  {result}")
+        lines.extend(f"{'':>79}  {problem}" for problem in o.problems[1:5])
+    return "\n".join(lines)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--engine", help="Path to the zygotrix_engine binary (default: Lambda worker)")
+    parser.add_argument("--actions", default=",".join(CASES))
+    parser.add_argument("--sizes", default="small,medium")
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--seed", type=int, default=7)
+    parser.add_argument("--json", action="store_true", help="Print outcomes as JSON instead of a table")
+    parser.add_argument("--fail-on-regression", action="store_true",
+                        help="Exit non-zero if a fallback is faster than the engine")
+    args = parser.parse_args()
+
+    actions = [a for a in args.actions.split(",") if a]
+    sizes = [s for s in args.sizes.split(",") if s]
+    unknown = (set(actions) - set(CASES)) | (set(sizes) - set(SIZES))
+    if unknown:
+        parser.error(f"unknown actions/sizes: {sorted(unknown)}")
+
+    native = Engine(args.engine)
+    rng = random.Random(args.seed)
+    outcomes = [
+        run_case(CASES[action](size, rng), native, args.repeat)
+        for action in actions
+        for size in sizes
+    ]
+
+    if args.json:
+        print(json.dumps([dict(vars(o), speedup=o.speedup) for o in outcomes], indent=2))
+    else:
+        print(format_table(outcomes, native.name))
+
+    failed = any(o.problems for o in outcomes)
+    regressed = [o for o in outcomes if o.speedup is not None and o.speedup < 1.0]
+    for o in regressed:
+        print(f"regression: python fallback beats the engine on {o.action}/{o.size} "
+              f"({o.speedup:.2f}x)", file=sys.stderr)
+    return 1 if failed or (args.fail_on_regression and regressed) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
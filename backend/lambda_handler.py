@@ -1,17 +1,88 @@
 import json
 import os
 import subprocess
-import boto3
+import time
+
+try:
+    from app.core import metrics
+except ImportError:  # Engine image built without the backend package
+    metrics = None
+
+# When set, each invocation appends its metrics (Prometheus text) to this file
+METRICS_FILE = os.getenv("ZYGOTRIX_METRICS_FILE")
+
+ENGINE_BINARY = "./zygotrix_engine"
+
+# Actions that never use the engine's thread pool. Pinning OpenMP to one
+# thread stops the runtime from spawning (and then parking) a worker per core
+# at startup, which dominates small cross/protein calls.
+SINGLE_THREADED_ACTIONS = {"cross", "protein", "pedigree_analyze"}
+# DNA generation only parallelises above this length (see parallel_dna_threshold)
+PARALLEL_DNA_THRESHOLD = int(os.getenv("PARALLEL_DNA_THRESHOLD", "1000000"))
+
+_s3_client = None
+
+
+def _get_s3_client():
+    """Create the S3 client on first use; boto3 import alone costs a cold start ~0.3s."""
+    global _s3_client
+    if _s3_client is None:
+        import boto3
+
+        _s3_client = boto3.client('s3')
+    return _s3_client
+
+
+def _engine_env(action, payload):
+    """Environment for one engine run: single OpenMP thread when the action cannot use more."""
+    single_threaded = action in SINGLE_THREADED_ACTIONS or (
+        action == "dna" and int(payload.get("length", 0)) < PARALLEL_DNA_THRESHOLD
+    )
+    if not single_threaded or "OMP_NUM_THREADS" in os.environ:
+        return None
+    return {**os.environ, "OMP_NUM_THREADS": "1"}
+
+
+def _run_engine(action, payload):
+    return subprocess.run(
+        [ENGINE_BINARY, action, json.dumps(payload)],
+        capture_output=True,
+        text=True,
+        check=False, # We handle return code manually
+        env=_engine_env(action, payload),
+    )
+
 
 def handler(event, context):
     """
     AWS Lambda Handler for Zygotrix Engine.
     Acts as a bridge between AWS services and the C++ binary.
     """
-    print(f"Received event: {json.dumps(event)}")
-    
+    if metrics is None:
+        return _dispatch(event)
+
+    action = str(event.get("action"))
+    start = time.perf_counter()
+    response = _dispatch(event)
+    status = "ok" if response.get("statusCode") == 200 else "error"
+
+    metrics.ENGINE_LATENCY.observe(time.perf_counter() - start, action=action, backend="engine")
+    metrics.ENGINE_REQUESTS.inc(action=action, backend="engine", status=status)
+    metrics.ENGINE_BYTES.inc(len(response.get("body") or ""), action=action, direction="received")
+    if METRICS_FILE:
+        try:
+            metrics.append_snapshot(METRICS_FILE)
+        except OSError as e:
+            print(f"Could not append metrics: {e}")
+    return response
+
+
+def _dispatch(event):
+    """Run one engine action and wrap its output as a Lambda response."""
     action = event.get("action")
     payload = event.get("payload", {})
+    # Payloads can carry megabase sequences; log their shape, not their contents
+    print(f"Received event: action={action} payload_keys={sorted(payload)}")
 
     try:
         if action == "gwas_vcf":
@@ -28,7 +99,7 @@ def handler(event, context):
             print(f"Downloading {s3_key} from {s3_bucket}...")
             
             # 1. Download file using Python (Fast & Boto3 built-in)
-            s3 = boto3.client('s3')
+            s3 = _get_s3_client()
             # Extract filename from key
             filename = s3_key.split('/')[-1]
             local_path = f"/tmp/{filename}"
@@ -45,15 +116,8 @@ def handler(event, context):
             # Assuming binary accepts JSON string as first argument
             
             # For gwas_vcf, we might use a specific flag or mode in the binary
-            cmd = ["./zygotrix_engine", "gwas_vcf", json.dumps(payload)]
-            
-            print(f"Executing: {' '.join(cmd)}")
-            result = subprocess.run(
-                cmd, 
-                capture_output=True, 
-                text=True,
-                check=False # We handle return code manually
-            )
+            print(f"Executing: {ENGINE_BINARY} gwas_vcf")
+            result = _run_engine("gwas_vcf", payload)
             
             if result.returncode != 0:
                 print(f"Binary failed: {result.stderr}")
@@ -72,13 +136,7 @@ def handler(event, context):
             # Legacy/Other actions (cross, pedigree, etc.)
             # Pass through to binary directly?
             # Or assume they are handled similarly
-            cmd = ["./zygotrix_engine", action, json.dumps(payload)]
-            
-            result = subprocess.run(
-                cmd, 
-                capture_output=True, 
-                text=True
-            )
+            result = _run_engine(action, payload)
             
             if result.returncode != 0:
                 return {
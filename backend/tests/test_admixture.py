@@ -0,0 +1,103 @@
+"""Tests for ADMIXTURE-style ancestry estimation."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics import admixture as admixture_module
+from app.services.genomics.admixture import admixture, dataset_admixture_analysis
+
+
+def _two_populations(n=60, m=400, seed=0):
+    """Samples with known ancestry in two populations with diverged frequencies."""
+    rng = np.random.default_rng(seed)
+    p = np.vstack([rng.uniform(0.05, 0.95, m), rng.uniform(0.05, 0.95, m)])
+    share = np.concatenate([np.ones(n // 3), np.zeros(n // 3), rng.uniform(0, 1, n - 2 * (n // 3))])
+    q = np.column_stack([share, 1 - share])
+    genotypes = rng.binomial(2, q @ p).astype(np.int8)
+    genotypes[rng.random(genotypes.shape) < 0.01] = -1
+    return genotypes, q
+
+
+def test_unsupervised_fit_recovers_ancestry_proportions():
+    genotypes, q_true = _two_populations()
+    fit = admixture(genotypes, 2, seed=1, max_iterations=200)
+
+    # Populations are identified up to label switching
+    estimate = fit["q"][:, 0]
+    if np.corrcoef(estimate, q_true[:, 0])[0, 1] < 0:
+        estimate = 1 - estimate
+    assert np.abs(estimate - q_true[:, 0]).max() < 0.15
+    assert fit["converged"]
+
+
+def test_supervised_fit_fixes_reference_samples():
+    genotypes, q_true = _two_populations()
+    labels = ["A"] * 20 + ["B"] * 20 + [None] * 20
+    fit = admixture(genotypes, 5, labels=labels, seed=1, max_iterations=200)
+
+    assert fit["clusters"] == ["A", "B"]
+    assert fit["q"][:20, 0].min() > 0.99 and fit["q"][20:40, 1].min() > 0.99
+    assert np.abs(fit["q"][40:, 0] - q_true[40:, 0]).max() < 0.15
+
+
+def test_fit_does_not_depend_on_the_pool(monkeypatch):
+    monkeypatch.setattr(admixture_module, "_SNP_BLOCK", 64)
+    genotypes, _ = _two_populations(m=300)
+
+    inline = admixture(genotypes, 2, seed=4, max_iterations=20, workers=1)
+    pooled = admixture(genotypes, 2, seed=4, max_iterations=20)
+
+    np.testing.assert_allclose(inline["q"], pooled["q"], rtol=1e-12)
+    assert inline["loglik"] == pytest.approx(pooled["loglik"], rel=1e-12)
+
+
+def test_work_budget_stops_the_fit_early(monkeypatch):
+    genotypes, _ = _two_populations(n=30, m=100)
+    full = admixture(genotypes, 2, seed=1, max_iterations=200)
+    assert full["converged"] and not full["work_capped"]
+
+    monkeypatch.setattr(admixture_module, "MAX_EM_WORK", 30 * 100 * 10)
+    capped = admixture(genotypes, 2, seed=1, max_iterations=200)
+
+    assert capped["work_capped"] and not capped["converged"]
+    assert capped["em_steps"] <= 10
+    assert capped["loglik"] < full["loglik"]
+    np.testing.assert_allclose(capped["q"].sum(axis=1), 1.0)
+
+
+def test_a_single_cycle_over_budget_is_rejected(monkeypatch):
+    genotypes, _ = _two_populations(n=30, m=100)
+    monkeypatch.setattr(admixture_module, "MAX_EM_WORK", 30 * 100 * 2)
+
+    with pytest.raises(ValueError, match="too large"):
+        admixture(genotypes, 2, seed=1)
+
+
+def test_dataset_analysis_thins_snps_to_the_work_budget(monkeypatch):
+    genotypes, _ = _two_populations(n=12, m=200)
+    snps = [
+        {"rsid": f"rs{j}", "chromosome": 1, "position": j + 1, "genotypes": genotypes[:, j].tolist()}
+        for j in range(genotypes.shape[1])
+    ]
+    samples = [{"sample_id": f"S{i}"} for i in range(12)]
+    monkeypatch.setattr(admixture_module, "MAX_EM_WORK", 3 * admixture_module._MIN_BUDGET_CYCLES * 12 * 80)
+
+    result = dataset_admixture_analysis(snps, samples, k=2, max_iterations=30, seed=2)
+
+    assert result["n_snps"] == 80
+    assert len(result["allele_frequencies"]) == 80
+
+
+def test_dataset_analysis_uses_plink_sample_ids():
+    genotypes, _ = _two_populations(n=12, m=200)
+    snps = [
+        {"rsid": f"rs{j}", "chromosome": 1, "position": j + 1, "genotypes": genotypes[:, j].tolist()}
+        for j in range(genotypes.shape[1])
+    ]
+    samples = [{"sample_id": f"S{i}", "family_id": "F"} for i in range(12)]
+
+    result = dataset_admixture_analysis(snps, samples, k=2, max_snps=150, max_iterations=30, seed=2)
+
+    assert [s["sample_id"] for s in result["samples"]] == [f"S{i}" for i in range(12)]
+    assert result["n_snps"] == 150
+    assert all(sum(s["q"]) == pytest.approx(1.0) for s in result["samples"])
@@ -0,0 +1,104 @@
+"""Tests for coloc.abf colocalisation."""
+
+import math
+
+import numpy as np
+import pytest
+
+from app.services.genomics.coloc import colocalize, log_abf
+
+
+def _associations(z, positions, chromosome=1, se=0.02):
+    return [
+        {"rsid": f"rs{chromosome}_{pos}", "chromosome": chromosome, "position": int(pos),
+         "ref_allele": "A", "alt_allele": "G", "beta": float(zi * se), "se": se,
+         "p_value": math.erfc(abs(zi) / math.sqrt(2))}
+        for zi, pos in zip(z, positions)
+    ]
+
+
+def _locus(peak_first, peak_second, n=40, seed=0):
+    rng = np.random.default_rng(seed)
+    positions = 10_000 + 1_000 * np.arange(n)
+    z1, z2 = rng.normal(size=n), rng.normal(size=n)
+    z1[peak_first] = 8.0
+    z2[peak_second] = 7.0
+    return _associations(z1, positions), _associations(z2, positions)
+
+
+def _reference_posteriors(first, second, p1=1e-4, p2=1e-4, p12=1e-5, sd=0.15):
+    """coloc.abf with explicit sums, for one locus."""
+    abf1 = np.exp(log_abf(np.array([a["beta"] / a["se"] for a in first]), np.array([a["se"] ** 2 for a in first]), sd))
+    abf2 = np.exp(log_abf(np.array([a["beta"] / a["se"] for a in second]), np.array([a["se"] ** 2 for a in second]), sd))
+    h3 = sum(abf1[i] * abf2[j] for i in range(abf1.size) for j in range(abf2.size) if i != j)
+    h = np.array([1.0, p1 * abf1.sum(), p2 * abf2.sum(), p1 * p2 * h3, p12 * (abf1 * abf2).sum()])
+    return h / h.sum()
+
+
+def test_log_abf_matches_wakefield():
+    v, w, z = 0.04 ** 2, 0.15 ** 2, 3.0
+    r = w / (v + w)
+    expected = math.log(math.sqrt(1 - r)) + 0.5 * z * z * r
+    assert log_abf(np.array([z]), np.array([v]), 0.15)[0] == pytest.approx(expected)
+
+
+@pytest.mark.parametrize("peak_second, winner", [(12, "H4"), (30, "H3")])
+def test_posteriors_match_reference_sums(peak_second, winner):
+    first, second = _locus(12, peak_second)
+    result = colocalize(first, second, window_kb=100)
+
+    (locus,) = result["loci"]
+    assert locus["n_snps"] == 40
+    posteriors = [locus["posteriors"][h] for h in ("H0", "H1", "H2", "H3", "H4")]
+    np.testing.assert_allclose(posteriors, _reference_posteriors(first, second), rtol=1e-6, atol=1e-12)
+    assert max(locus["posteriors"], key=locus["posteriors"].get) == winner
+    if winner == "H4":
+        assert locus["top_snp"]["rsid"] == "rs1_22000" and locus["top_snp"]["snp_pp_h4"] > 0.99
+
+
+def test_windows_merge_per_chromosome():
+    positions = np.arange(0, 3_000_000, 10_000) + 1
+    z = np.zeros(positions.size)
+    z[[10, 20, 200]] = 8.0
+    first = _associations(z, positions) + _associations(z[:50], positions[:50], chromosome=2)
+    second = _associations(z, positions) + _associations(z[:50], positions[:50], chromosome=2)
+
+    result = colocalize(first, second, window_kb=250)
+
+    # Seeds at 100 kb and 200 kb merge; 2 Mb is separate; chromosome 2 is its own locus
+    spans = [(l["chromosome"], l["start"], l["end"]) for l in result["loci"]]
+    assert spans == [(1, 1, 450_001), (1, 1_750_001, 2_250_001), (2, 1, 450_001)]
+
+
+def test_join_handles_allele_orientation_and_multiallelic_sites():
+    first, second = _locus(5, 5, n=10)
+    second[1]["ref_allele"], second[1]["alt_allele"] = "G", "A"
+    second[2]["alt_allele"] = "T"
+    first.append(dict(first[3], alt_allele="C"))
+
+    result = colocalize(first, second, window_kb=100)
+
+    assert result["n_shared"] == 9
+    assert result["n_allele_mismatch"] == 1
+    assert result["n_used"] == 8
+
+
+def test_variance_falls_back_to_odds_ratio_ci_and_maf():
+    record = {"chromosome": 1, "position": 100, "ref_allele": "A", "alt_allele": "G"}
+    with_se = dict(record, beta=math.log(1.5), se=0.1, p_value=5e-5)
+    with_ci = dict(record, odds_ratio=1.5, ci_lower=1.5 * math.exp(-1.959963984540054 * 0.1),
+                   ci_upper=1.5 * math.exp(1.959963984540054 * 0.1), p_value=5e-5)
+    from_p = dict(record, p_value=1e-9, maf=0.3, n_samples=5000)
+
+    se_result = colocalize([with_se], [with_se], p_threshold=1e-4)
+    ci_result = colocalize([with_ci], [with_ci], p_threshold=1e-4)
+    assert ci_result["loci"][0]["posteriors"] == pytest.approx(se_result["loci"][0]["posteriors"])
+    assert colocalize([from_p], [from_p])["n_used"] == 1
+
+
+def test_priors_are_validated():
+    first, second = _locus(1, 1, n=5)
+    with pytest.raises(ValueError, match="p12"):
+        colocalize(first, second, p1=1e-5, p12=1e-4)
+    with pytest.raises(ValueError, match="between 0 and 1"):
+        colocalize(first, second, p2=0)
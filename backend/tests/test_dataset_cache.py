@@ -0,0 +1,85 @@
+"""Tests for the per-user dataset analysis cache."""
+
+import sys
+import types
+
+import numpy as np
+import pytest
+
+from app.services.genomics import dataset_cache, roh
+from app.services.genomics.dataset_cache import DatasetResultCache, invalidate_dataset
+
+
+class _DatasetService:
+    """Datasets owned by one user, as load_dataset_for_analysis enforces."""
+
+    def __init__(self, datasets):
+        self.datasets = datasets
+        self.loads = []
+
+    def load_dataset_for_analysis(self, user_id, dataset_id):
+        self.loads.append((user_id, dataset_id))
+        owner, data = self.datasets.get(dataset_id, (None, None))
+        return data if owner == user_id else None
+
+
+@pytest.fixture
+def service(monkeypatch):
+    service = _DatasetService({"ds1": ("alice", {"samples": ["s1", "s2"]})})
+    module = types.ModuleType("app.services.gwas_dataset_service")
+    module.get_gwas_dataset_service = lambda: service
+    monkeypatch.setitem(sys.modules, "app.services.gwas_dataset_service", module)
+    return service
+
+
+def _count_samples(data):
+    return {"n_samples": len(data["samples"])}
+
+
+def test_other_user_never_gets_a_cached_result(service):
+    cache = DatasetResultCache("test_cross_user")
+
+    assert cache.compute("alice", "ds1", {"k": 1}, _count_samples) == {"dataset_id": "ds1", "n_samples": 2}
+    # Bob asks for Alice's dataset after Alice filled the cache
+    assert cache.compute("bob", "ds1", {"k": 1}, _count_samples) is None
+
+    assert service.loads == [("alice", "ds1"), ("bob", "ds1")]
+    assert cache.hits == 0
+    cache.compute("alice", "ds1", {"k": 1}, _count_samples)
+    assert cache.hits == 1 and len(service.loads) == 2
+
+
+def test_invalidate_dataset_clears_every_cache(service):
+    first = DatasetResultCache("test_invalidate_a")
+    second = DatasetResultCache("test_invalidate_b")
+    for cache in (first, second):
+        cache.compute("alice", "ds1", {}, _count_samples)
+        cache.compute("alice", "ds1", {"k": 2}, _count_samples)
+    first.put(("alice", "ds2", "x"), {"dataset_id": "ds2"})
+
+    assert invalidate_dataset("ds1") >= 4
+    assert list(first.entries) == [("alice", "ds2", "x")]
+    assert len(second.entries) == 0
+
+    # The next request recomputes from the (possibly reprocessed) data
+    second.compute("alice", "ds1", {}, _count_samples)
+    assert service.loads.count(("alice", "ds1")) == 5
+
+
+def test_dataset_roh_reports_plink_sample_ids(monkeypatch):
+    rng = np.random.default_rng(0)
+    snps = [
+        {"chromosome": 1, "position": 1000 + 10_000 * i, "genotypes": rng.integers(0, 3, 2).tolist()}
+        for i in range(200)
+    ]
+    samples = [{"sample_id": "FAM1_IND1", "sex": 1}, {"sample_id": "FAM1_IND2", "sex": 2}]
+    service = _DatasetService({"plink": ("alice", {"snps": snps, "samples": samples})})
+    module = types.ModuleType("app.services.gwas_dataset_service")
+    module.get_gwas_dataset_service = lambda: service
+    monkeypatch.setitem(sys.modules, "app.services.gwas_dataset_service", module)
+    monkeypatch.setattr(roh, "_roh_cache", DatasetResultCache("test_roh"))
+
+    result = roh.dataset_roh("alice", "plink", min_snps=20)
+
+    assert [s["sample_id"] for s in result["samples"]] == ["FAM1_IND1", "FAM1_IND2"]
+    assert dataset_cache.dataset_sample_ids(["a", {"sample_id": 7}]) == ["a", "7"]
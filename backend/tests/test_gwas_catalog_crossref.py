@@ -0,0 +1,135 @@
+"""Tests for joining association hits against the GWAS Catalog."""
+
+import pytest
+
+from app.services import gwas_catalog_crossref, gwas_dataset
+from app.services.gwas_catalog_crossref import allele_flipped, crossref_associations, risk_allele
+from app.services.gwas_catalog_index import GwasCatalogVariantIndex
+
+pa = pytest.importorskip("pyarrow")
+pq = pytest.importorskip("pyarrow.parquet")
+
+CATALOG = {
+    "STUDY ACCESSION": ["GCST1", "GCST2", "GCST3", "GCST4"],
+    "MAPPED_TRAIT": ["height", "height", "body mass index", "type 2 diabetes"],
+    "SNPS": ["rs100", "rs100", "rs200", "rs300; rs301"],
+    "CHR_ID": ["1", "1", "2", "X;X"],
+    "CHR_POS": ["1000", "1000", "5000", "700;900"],
+    "STRONGEST SNP-RISK ALLELE": ["rs100-G", "rs100-?", "rs200-T", "rs300-C; rs301-A"],
+}
+
+
+@pytest.fixture(autouse=True)
+def variant_index(tmp_path, monkeypatch):
+    source = tmp_path / "catalog.parquet"
+    pq.write_table(pa.table(CATALOG), source)
+    index = GwasCatalogVariantIndex.open_or_build(source, tmp_path / "variants")
+    monkeypatch.setattr(gwas_dataset, "ensure_variant_index_loaded", lambda: index)
+    return index
+
+
+def _hit(rsid, chromosome, position, ref="A", alt="G", p_value=1e-9):
+    return {
+        "rsid": rsid,
+        "chromosome": chromosome,
+        "position": position,
+        "ref_allele": ref,
+        "alt_allele": alt,
+        "p_value": p_value,
+    }
+
+
+def test_hits_match_by_rsid_and_by_position():
+    result = crossref_associations([
+        _hit("rs100", 9, 1),
+        # Renamed variant at a catalogued position
+        _hit("chr2:5000", 2, 5000, ref="C", alt="T"),
+        # Multi-SNP catalogue rows index every position
+        _hit("x_var", 23, 900, ref="G", alt="A"),
+    ])
+    by_rsid, by_position, by_multi = result["matches"]
+
+    assert by_rsid["matched_by"] == "rsid"
+    assert [k["STUDY ACCESSION"] for k in by_rsid["known_associations"]] == ["GCST1", "GCST2"]
+    assert by_position["matched_by"] == "position"
+    assert [k["MAPPED_TRAIT"] for k in by_position["known_associations"]] == ["body mass index"]
+    assert by_multi["matched_by"] == "position"
+
+    enrichment = result["enrichment"]
+    assert enrichment["hits_known"] == 3
+    assert enrichment["hits_known_by_rsid"] == 1
+    assert enrichment["hits_known_by_position_only"] == 2
+    assert enrichment["distinct_studies"] == 4
+    assert enrichment["top_traits"][0] == {"trait": "height", "count": 2}
+
+
+def test_a_window_widens_position_matches():
+    assert crossref_associations([_hit("v", 2, 5030)])["matches"][0]["matched_by"] is None
+    matches = crossref_associations([_hit("v", 2, 5030)], window_bp=50)["matches"]
+    assert matches[0]["known_association_count"] == 1
+
+
+def test_allele_orientation_against_the_risk_allele():
+    result = crossref_associations([
+        _hit("rs100", 1, 1000, ref="A", alt="G"),
+        _hit("rs200", 2, 5000, ref="T", alt="C"),
+        _hit("rs301", 23, 900, ref="T", alt="C"),
+    ])
+    rs100, rs200, rs301 = (m["known_associations"] for m in result["matches"])
+
+    # Risk G is the alt allele; "?" has no allele to compare
+    assert [k["allele_flipped"] for k in rs100] == [False, None]
+    # Risk T is the ref allele: effects point in opposite directions
+    assert rs200[0]["allele_flipped"] is True
+    # rs301-A on the other strand is T, the ref allele
+    assert rs301[0]["allele_flipped"] is True
+
+
+@pytest.mark.parametrize(
+    "risk, ref, alt, expected",
+    [
+        ("G", "A", "G", False),
+        ("A", "A", "G", True),
+        ("C", "A", "G", False),  # complement of G
+        ("T", "A", "G", True),  # complement of A
+        ("AT", "A", "G", None),
+        (None, "A", "G", None),
+    ],
+)
+def test_allele_flipped(risk, ref, alt, expected):
+    assert allele_flipped(risk, ref, alt) is expected
+
+
+def test_palindromic_snps_are_not_strand_resolved():
+    # The complement of either allele is the other one, so only direct matches count
+    assert allele_flipped("T", "A", "T") is False
+    assert allele_flipped("C", "C", "G") is True
+    assert allele_flipped("G", "A", "T") is None
+
+
+def test_risk_allele_of_the_matching_haplotype_snp():
+    assert risk_allele("rs300-C; rs301-A", "rs301") == "A"
+    assert risk_allele("rs300-C; rs301-A", "rs999") is None
+    assert risk_allele("rs100-?", "rs100") is None
+    assert risk_allele(None, "rs100") is None
+
+
+def test_unknown_hits_have_no_matches():
+    result = crossref_associations(
+        [_hit("rs999", 3, 123), _hit("not_an_rsid", 5, 77)],
+        background=[_hit("rs999", 3, 123), _hit("rs100", 1, 1000), _hit("rs7", 4, 4)],
+    )
+
+    assert all(m["matched_by"] is None and m["known_associations"] == [] for m in result["matches"])
+    enrichment = result["enrichment"]
+    assert enrichment["hits_known"] == 0 and enrichment["known_associations"] == 0
+    assert enrichment["background_known"] == 1
+    assert enrichment["fold_enrichment"] == 0.0
+
+
+def test_known_associations_are_capped_per_hit():
+    match = crossref_associations([_hit("rs100", 1, 1000)], max_per_hit=1)["matches"][0]
+
+    assert match["known_association_count"] == 2
+    assert len(match["known_associations"]) == 1
+    assert gwas_catalog_crossref.RISK_ALLELE_FIELD in match["known_associations"][0]
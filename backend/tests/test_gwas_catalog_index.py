@@ -0,0 +1,98 @@
+"""Tests for the memory-mapped GWAS Catalog trait index."""
+
+import numpy as np
+import pytest
+
+from app.services.gwas_catalog_index import GwasCatalogIndex, build_index
+
+TRAITS = [
+    "Body mass index",
+    "Mass",
+    "Massive hemorrhage",
+    "Lean body mass",
+    "Biomass yield",
+    "Body mass index",
+    "Height",
+    None,
+    "body  MASS index",
+    "Lean body mass",
+    "Fat mass",
+    "Fat mass",
+    "Fat mass",
+]
+
+
+@pytest.fixture
+def index(tmp_path):
+    build_index(TRAITS, tmp_path / "index", {"version": 1})
+    return GwasCatalogIndex(tmp_path / "index")
+
+
+def test_search_ranks_exact_prefix_word_and_substring_matches(index):
+    assert index.search("mass") == [
+        "Mass",
+        "Massive hemorrhage",
+        # Word matches: more catalogue rows first, then alphabetical
+        "Body mass index",
+        "Fat mass",
+        "Lean body mass",
+        "Biomass yield",
+    ]
+
+
+def test_search_normalises_case_and_whitespace(index):
+    assert index.search("  BODY   mass ") == ["Body mass index", "Lean body mass"]
+    assert index.find_trait("body mass INDEX") == index.find_trait("Body mass index")
+    # The three spellings of one trait share its rows
+    assert index.row_ids(index.find_trait("Body mass index")).tolist() == [0, 5, 8]
+
+
+def test_short_queries_scan_names_without_trigrams(index):
+    assert index.search("ma", limit=3) == ["Mass", "Massive hemorrhage", "Body mass index"]
+    assert "Height" in index.search("h")
+    assert index.search("zz") == []
+
+
+@pytest.mark.parametrize("query, limit", [("", 20), ("   ", 20), ("mass", 0)])
+def test_empty_queries_and_limits_return_nothing(index, query, limit):
+    assert index.search(query, limit=limit) == []
+
+
+def test_unknown_trigrams_match_nothing(index):
+    assert index.search("massq") == []
+    assert index.find_trait("Weight") is None
+
+
+def test_readers_see_a_newly_published_index(tmp_path):
+    index_dir = tmp_path / "index"
+    build_index(["Height", "Body mass index"], index_dir, {"version": 1})
+    old_reader = GwasCatalogIndex(index_dir)
+
+    build_index(["Height", "Heart rate", "Height"], index_dir, {"version": 2})
+    new_reader = GwasCatalogIndex(index_dir)
+
+    assert new_reader.meta["version"] == 2
+    assert new_reader.search("he") == ["Height", "Heart rate"]
+    assert np.asarray(new_reader.row_ids(new_reader.find_trait("Height"))).tolist() == [0, 2]
+    # A reader that mapped the previous files keeps serving them
+    assert old_reader.search("index") == ["Body mass index"]
+    assert not list(tmp_path.glob(".gwas_index_*")) and not list(tmp_path.glob(".index.old-*"))
+
+
+def test_open_or_build_rebuilds_when_the_parquet_changes(tmp_path):
+    pa = pytest.importorskip("pyarrow")
+    pq = pytest.importorskip("pyarrow.parquet")
+    source, index_dir = tmp_path / "catalog.parquet", tmp_path / "index"
+
+    pq.write_table(pa.table({"MAPPED_TRAIT": ["Height", "Body mass index"]}), source)
+    first = GwasCatalogIndex.open_or_build(source, index_dir)
+    pq.write_table(pa.table({"MAPPED_TRAIT": ["Height", "Heart rate", "Height"]}), source)
+    second = GwasCatalogIndex.open_or_build(source, index_dir)
+
+    assert first.search("index") == ["Body mass index"]
+    assert second.search("index") == []
+    assert second.search("hea") == ["Heart rate"]
+    assert second.fetch_rows(second.row_ids(second.find_trait("Height"))) == [
+        {"MAPPED_TRAIT": "Height"},
+        {"MAPPED_TRAIT": "Height"},
+    ]
@@ -0,0 +1,66 @@
+"""Route-level tests for GWAS result export."""
+
+import csv
+import io
+from types import SimpleNamespace
+
+import pytest
+from fastapi import FastAPI, HTTPException
+from fastapi.testclient import TestClient
+
+from app.routes import gwas as gwas_routes
+from app.schema.gwas import SnpAssociation
+
+ASSOCIATIONS = [
+    SnpAssociation(rsid="rs1", chromosome=1, position=100, ref_allele="A", alt_allele="G",
+                   beta=0.25, se=0.05, t_stat=5.0, p_value=1.2e-7, maf=0.31, n_samples=500),
+    SnpAssociation(rsid="rs2", chromosome=2, position=200, ref_allele="C", alt_allele="T",
+                   p_value=0.04, maf=0.12, n_samples=480, odds_ratio=1.3, ci_lower=1.01, ci_upper=1.67),
+]
+
+
+class _AnalysisService:
+    def get_job_results(self, job_id, user_id):
+        if (job_id, user_id) != ("job1", "alice"):
+            raise HTTPException(status_code=404, detail=f"Job {job_id} not found")
+        return SimpleNamespace(job_id=job_id)
+
+
+class _ResultRepo:
+    def find_detailed_by_job_id(self, job_id):
+        return SimpleNamespace(job_id=job_id, associations=ASSOCIATIONS)
+
+
+@pytest.fixture
+def client(monkeypatch):
+    monkeypatch.setattr(gwas_routes, "get_gwas_analysis_service", lambda: _AnalysisService())
+    monkeypatch.setattr(gwas_routes, "get_gwas_result_repository", lambda: _ResultRepo())
+    app = FastAPI()
+    app.include_router(gwas_routes.router)
+    app.dependency_overrides[gwas_routes.get_public_or_auth_user] = lambda: SimpleNamespace(id="alice")
+    return TestClient(app)
+
+
+def test_json_export_writes_every_association(client):
+    response = client.get("/api/gwas/jobs/job1/export", params={"format": "json"})
+
+    assert response.status_code == 200
+    assert response.headers["content-disposition"] == "attachment; filename=gwas_results_job1.json"
+    rows = response.json()
+    assert [row["rsid"] for row in rows] == ["rs1", "rs2"]
+    assert rows[0]["p_value"] == 1.2e-7 and rows[0]["odds_ratio"] is None
+    assert rows[1]["beta"] is None and rows[1]["ci_upper"] == 1.67
+    assert list(rows[0]) == gwas_routes._EXPORT_COLUMNS
+
+
+def test_csv_export_writes_every_association(client):
+    response = client.get("/api/gwas/jobs/job1/export")
+
+    assert response.status_code == 200
+    rows = list(csv.DictReader(io.StringIO(response.text)))
+    assert [(row["rsid"], row["position"]) for row in rows] == [("rs1", "100"), ("rs2", "200")]
+    assert rows[1]["odds_ratio"] == "1.3"
+
+
+def test_export_checks_job_access(client):
+    assert client.get("/api/gwas/jobs/job2/export", params={"format": "json"}).status_code == 404
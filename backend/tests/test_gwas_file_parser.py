@@ -0,0 +1,96 @@
+"""Tests for multi-allelic splitting and normalisation in the VCF reader."""
+
+import pytest
+
+from app.services.gwas_file_parser import ReferenceGenome, VcfParser, normalize_variant
+
+# Chromosome 1 spans two FASTA lines; the TTT run sits at positions 4-6
+_FASTA = ">1 test\nAGCTTTAC\nGGATC\n>2\nACGT\n"
+
+
+@pytest.fixture
+def reference(tmp_path):
+    path = tmp_path / "ref.fa"
+    path.write_text(_FASTA)
+    genome = ReferenceGenome(path)
+    yield genome
+    genome.close()
+
+
+def _write_vcf(path, records, samples=("S1", "S2", "S3", "S4")):
+    header = ["#CHROM", "POS", "ID", "REF", "ALT", "QUAL", "FILTER", "INFO", "FORMAT", *samples]
+    lines = ["##fileformat=VCFv4.2", "\t".join(header)]
+    lines += ["\t".join(record) for record in records]
+    path.write_text("\n".join(lines) + "\n")
+    return path
+
+
+def test_reference_fetch_crosses_lines_with_and_without_fai(tmp_path, reference):
+    assert reference.fetch("1", 7, 10) == "ACGG"
+    assert reference.fetch("chr2", 2, 3) == "CG"
+    assert reference.fetch("3", 1, 2) == ""
+
+    (tmp_path / "ref.fa.fai").write_text("1\t13\t8\t8\t9\n2\t4\t26\t4\t5\n")
+    indexed = ReferenceGenome(tmp_path / "ref.fa")
+    assert indexed.index == reference.index
+    indexed.close()
+
+
+def test_normalize_left_aligns_through_repeats(reference):
+    # Deleting the last T of the run is reported at the start of the run
+    assert normalize_variant("1", 5, "TT", "T", reference) == (3, "CT", "C")
+    assert normalize_variant("1", 4, "TTT", "TTTT", reference) == (3, "C", "CT")
+
+
+def test_normalize_without_reference_only_trims():
+    assert normalize_variant("1", 5, "TT", "T") == (5, "TT", "T")
+    assert normalize_variant("1", 10, "CAGT", "CTGT") == (11, "A", "T")
+    assert normalize_variant("1", 10, "A", "<DEL>") == (10, "A", "<DEL>")
+
+
+def test_multiallelic_records_are_split_into_per_allele_dosages(tmp_path):
+    vcf = _write_vcf(tmp_path / "multi.vcf", [
+        ["1", "100", "rs1", "A", "G,T", ".", "PASS", ".", "GT:DP", "0/1:9", "1/2:8", "2|2:7", "./.:0"],
+        ["1", "200", ".", "C", "A,*", ".", "PASS", ".", "GT", "0/1", "1/2", "0/0", "1/1"],
+        ["1", "300", ".", "G", "C", ".", "PASS", ".", "GT", "0/0", "0/1", "1/1", "0/1"],
+    ])
+
+    result = VcfParser(vcf).parse()
+    snps = {(s["rsid"], s["alt_allele"]): s for s in result["snps"]}
+
+    # Split variants of a named record get unique per-ALT IDs
+    assert snps[("rs1:G", "G")]["genotypes"] == [1, 1, 0, -1]
+    assert snps[("rs1:T", "T")]["genotypes"] == [0, 1, 2, -1]
+    # The spanning deletion allele is not emitted
+    assert snps[("SNP_1_200_A", "A")]["genotypes"] == [1, 1, 0, 2]
+    assert ("SNP_1_300", "C") in snps
+    assert len(result["snps"]) == 4
+    stats = result["metadata"]["normalization"]
+    assert stats["records"] == 3 and stats["multiallelic_records"] == 2 and stats["variants"] == 4
+
+
+def test_split_alleles_are_normalised_against_the_reference(tmp_path):
+    (tmp_path / "ref.fa").write_text(_FASTA)
+    vcf = _write_vcf(tmp_path / "indel.vcf", [
+        ["1", "5", "rs2", "TT", "T,TTT", ".", "PASS", ".", "GT", "0/1", "0/2", "1/2", "0/0"],
+        ["1", "2", "rs3", "A", "T", ".", "PASS", ".", "GT", "0/1", "0/0", "0/0", "0/0"],
+    ])
+
+    result = VcfParser(vcf, reference_path=tmp_path / "ref.fa").parse()
+    variants = [(s["rsid"], s["position"], s["ref_allele"], s["alt_allele"]) for s in result["snps"]]
+
+    # IDs carry the ALT as written, before normalisation
+    assert variants[:2] == [("rs2:T", 3, "CT", "C"), ("rs2:TTT", 3, "C", "CT")]
+    # REF disagrees with the reference (G at position 2): kept as written
+    assert variants[2] == ("rs3", 2, "A", "T")
+    stats = result["metadata"]["normalization"]
+    assert stats["normalized"] == 2 and stats["ref_mismatch"] == 1
+
+
+def test_max_snps_counts_split_variants(tmp_path):
+    vcf = _write_vcf(tmp_path / "limit.vcf", [
+        ["1", "100", "rs1", "A", "G,T,C", ".", "PASS", ".", "GT", "0/1", "1/2", "2/3", "0/0"],
+        ["1", "200", "rs2", "C", "A", ".", "PASS", ".", "GT", "0/1", "0/0", "0/0", "1/1"],
+    ])
+
+    assert len(VcfParser(vcf).parse(max_snps=2)["snps"]) == 2
@@ -0,0 +1,95 @@
+"""Tests for memory-budgeted GWAS jobs."""
+
+from contextlib import contextmanager
+from types import GeneratorType, SimpleNamespace
+
+import numpy as np
+import pytest
+
+from app.schema.gwas import GwasAnalysisType
+from app.services import gwas_analysis_service
+from app.services.gwas_analysis_service import GwasAnalysisService
+
+
+class _Repo:
+    def __init__(self, dataset=None):
+        self.dataset = dataset
+        self.created = None
+        self.stored = None
+
+    def find_by_id(self, dataset_id):
+        return self.dataset
+
+    def update_status(self, **kwargs):
+        return SimpleNamespace(**kwargs)
+
+    def store_associations(self, job_id, associations):
+        assert isinstance(associations, GeneratorType)
+        self.stored = list(associations)
+        return len(self.stored)
+
+    def create(self, **kwargs):
+        self.created = kwargs
+        return kwargs
+
+
+def _service(dataset):
+    service = GwasAnalysisService.__new__(GwasAnalysisService)
+    service.dataset_repo = _Repo(dataset)
+    service.job_repo = _Repo()
+    service.result_repo = _Repo()
+    return service
+
+
+def test_out_of_core_results_are_streamed_not_materialised(tmp_path, monkeypatch):
+    vcf = tmp_path / "cohort.vcf"
+    vcf.write_text("")
+    service = _service(SimpleNamespace(user_id="alice", file_path=str(vcf), s3_key=None, s3_bucket=None))
+    monkeypatch.setattr(service, "_load_local_phenotypes", lambda *args: (np.zeros(10), None))
+
+    p_values = [1e-9, 1e-6, 0.02, 0.3, 0.9]
+    consumed = []
+
+    def records():
+        for i, p in enumerate(p_values):
+            consumed.append(i)
+            yield {"rsid": f"rs{i}", "chromosome": 1, "position": 100 + i, "p_value": p, "maf": 0.2, "n_samples": 10}
+
+    @contextmanager
+    def fake_out_of_core(**kwargs):
+        yield {"results": records(), "snps_tested": len(p_values), "snps_filtered": 0,
+               "memory_report": {"degraded": False}}
+        # Shards are gone once the block exits
+        consumed.append("closed")
+
+    monkeypatch.setattr(gwas_analysis_service, "run_out_of_core_gwas", fake_out_of_core)
+    result = service.run_analysis("job1", "alice", "ds1", GwasAnalysisType.LINEAR, "height", memory_budget_mb=64)
+
+    assert consumed == [0, 1, 2, 3, 4, "closed"]
+    assert [a["rsid"] for a in service.result_repo.stored] == ["rs0", "rs1", "rs2", "rs3", "rs4"]
+    assert result["associations"] is None
+    assert [hit["rsid"] for hit in result["top_hits"]] == ["rs0", "rs1"]
+    assert result["summary"]["total_snps_tested"] == 5
+    assert result["summary"]["significant_snps_bonferroni"] == 1
+    assert result["summary"]["memory_report"] == {"degraded": False}
+
+
+@pytest.mark.parametrize("report", [None, {"budget_mb": 128, "degraded": False, "tile_snps": 4096}])
+def test_engine_budget_is_only_reported_when_confirmed(monkeypatch, report):
+    service = _service(SimpleNamespace(user_id="alice", file_path=None, s3_key="k", s3_bucket="b"))
+    payloads = []
+
+    def fake_engine(payload, timeout):
+        payloads.append(payload)
+        response = {"results": [{"rsid": "rs1", "chromosome": 1, "position": 100, "p_value": 0.5,
+                                 "maf": 0.2, "n_samples": 90}]}
+        if report:
+            response["memory_report"] = report
+        return response
+
+    monkeypatch.setattr(gwas_analysis_service, "run_gwas_analysis", fake_engine)
+    result = service.run_analysis("job1", "alice", "ds1", GwasAnalysisType.LINEAR, "height", memory_budget_mb=128)
+
+    assert payloads[0]["parameters"]["memory_budget_mb"] == 128
+    expected = report or {"budget_mb": 128, "budgeted": False}
+    assert result["summary"]["memory_report"] == expected
@@ -0,0 +1,105 @@
+"""Tests for the memory-budgeted out-of-core GWAS."""
+
+import os
+
+import numpy as np
+import pytest
+
+from app.services import gwas_out_of_core
+from app.services.gwas_out_of_core import OutOfCoreGwasAnalyzer, run_out_of_core_gwas
+from app.utils.statistics import t_sf_two_sided, t_sf_two_sided_array
+
+
+def _cohort(n_samples=120, n_snps=300, seed=0):
+    rng = np.random.default_rng(seed)
+    dosages = rng.binomial(2, rng.uniform(0.1, 0.5, (n_snps, 1)), (n_snps, n_samples)).astype(np.int8)
+    dosages[rng.random(dosages.shape) < 0.02] = -1
+    y = 0.8 * np.where(dosages[0] < 0, 1, dosages[0]) + rng.normal(size=n_samples)
+    metas = [
+        {"rsid": f"rs{i}", "chromosome": 1, "position": 1000 + i, "ref_allele": "A", "alt_allele": "G"}
+        for i in range(n_snps)
+    ]
+    return metas, dosages, y
+
+
+def _tiles(metas, dosages, size):
+    for start in range(0, len(metas), size):
+        yield metas[start:start + size], dosages[start:start + size]
+
+
+def test_t_sf_array_matches_scalar():
+    t = np.array([0.0, 0.3, -1.7, 2.5, 8.0, -40.0, np.nan])
+    for df in (1, 4, 37, 5000):
+        expected = [t_sf_two_sided(float(x), df) for x in t]
+        np.testing.assert_allclose(t_sf_two_sided_array(t, df), expected, rtol=1e-10)
+
+
+def test_tile_statistics_match_per_snp_regression():
+    metas, dosages, y = _cohort()
+    with OutOfCoreGwasAnalyzer(256, n_samples=len(y), maf_threshold=0.0) as analyzer:
+        analyzer.run(_tiles(metas, dosages, 64), y)
+        records = {r["rsid"]: r for r in analyzer.iter_sorted()}
+
+    for i in (0, 17, 250):
+        g = dosages[i].astype(float)
+        observed = g >= 0
+        g[~observed] = g[observed].mean()
+        x = np.column_stack([np.ones_like(g), g])
+        coef, rss, *_ = np.linalg.lstsq(x, y, rcond=None)
+        df = len(y) - 2
+        se = np.sqrt(rss[0] / df * np.linalg.inv(x.T @ x)[1, 1])
+        record = records[f"rs{i}"]
+        assert record["beta"] == pytest.approx(coef[1], rel=1e-8)
+        assert record["se"] == pytest.approx(se, rel=1e-8)
+        assert record["p_value"] == pytest.approx(t_sf_two_sided(coef[1] / se, df), rel=1e-8)
+
+
+def test_spilled_merge_matches_in_memory_order(monkeypatch, tmp_path):
+    metas, dosages, y = _cohort(n_snps=500)
+
+    with OutOfCoreGwasAnalyzer(256, n_samples=len(y)) as analyzer:
+        analyzer.run(_tiles(metas, dosages, 100), y)
+        in_memory = [r["rsid"] for r in analyzer.iter_sorted()]
+
+    monkeypatch.setattr(gwas_out_of_core, "_MAX_MERGE_FANIN", 3)
+    with OutOfCoreGwasAnalyzer(256, n_samples=len(y), spill_dir=str(tmp_path)) as analyzer:
+        analyzer.plan.result_buffer_rows = 40
+        analyzer.run(_tiles(metas, dosages, 25), y)
+        analyzer.finish()
+        report = analyzer.memory_report()
+        spilled = list(analyzer.iter_sorted())
+
+    assert report["degraded"] and report["merge_passes"] > 0
+    assert [r["rsid"] for r in spilled] == in_memory
+    p_values = [r["p_value"] for r in spilled]
+    assert p_values == sorted(p_values)
+    assert in_memory[0] == "rs0"
+    assert os.listdir(tmp_path) == []
+
+
+def _write_vcf(path, metas, dosages):
+    calls = {-1: "./.", 0: "0/0", 1: "0/1", 2: "1/1"}
+    with open(path, "w") as f:
+        f.write("##fileformat=VCFv4.2\n")
+        header = ["#CHROM", "POS", "ID", "REF", "ALT", "QUAL", "FILTER", "INFO", "FORMAT"]
+        f.write("\t".join(header + [f"S{j}" for j in range(dosages.shape[1])]) + "\n")
+        for meta, row in zip(metas, dosages):
+            fields = ["1", str(meta["position"]), meta["rsid"], "A", "G", ".", "PASS", ".", "GT"]
+            f.write("\t".join(fields + [calls[int(d)] for d in row]) + "\n")
+
+
+def test_run_streams_results_and_cleans_up(tmp_path, monkeypatch):
+    metas, dosages, y = _cohort(n_snps=200)
+    vcf = tmp_path / "cohort.vcf"
+    _write_vcf(vcf, metas, dosages)
+    monkeypatch.setattr(gwas_out_of_core, "_MIN_RESULT_BUFFER_ROWS", 16)
+    monkeypatch.setattr(gwas_out_of_core.tempfile, "tempdir", str(tmp_path))
+
+    with run_out_of_core_gwas(vcf, y, memory_budget_mb=64, maf_threshold=0.0) as response:
+        assert not isinstance(response["results"], list)
+        assert response["memory_report"]["spilled_shards"] > 0
+        records = list(response["results"])
+
+    assert len(records) == response["snps_tested"] == 200
+    assert records[0]["rsid"] == "rs0"
+    assert [p.name for p in tmp_path.iterdir()] == ["cohort.vcf"]
@@ -0,0 +1,95 @@
+"""Tests for GWAS power and sample-size calculations."""
+
+import math
+import threading
+
+import numpy as np
+import pytest
+
+from app.services.genomics import compute_pool, gwas_power as power_module
+from app.services.genomics.gwas_power import gwas_power, simulated_power
+
+
+def _normal_cdf(x):
+    return 0.5 * math.erfc(-x / math.sqrt(2.0))
+
+
+def test_quantitative_power_matches_the_closed_form():
+    result = gwas_power("quantitative", [2000], [0.3], [0.1], alphas=[5e-8, 0.05])
+
+    q2 = 2 * 0.3 * 0.7 * 0.1 ** 2
+    ncp = 2000 * q2 / (1 - q2)
+    for point in result["points"]:
+        assert point["ncp"] == pytest.approx(ncp)
+    # alpha = 0.05: critical z = 1.96
+    expected = _normal_cdf(math.sqrt(ncp) - 1.959963984540054) + _normal_cdf(-math.sqrt(ncp) - 1.959963984540054)
+    assert result["points"][1]["power"] == pytest.approx(expected, rel=1e-6)
+
+
+def test_required_sample_size_reaches_the_target():
+    result = gwas_power("binary", [1000], [0.2], [1.3], alphas=[5e-8], target_power=0.8)
+    required = result["points"][0]["required_n"]
+
+    at_required = gwas_power("binary", [required], [0.2], [1.3], alphas=[5e-8])["points"][0]["power"]
+    below = gwas_power("binary", [required - 50], [0.2], [1.3], alphas=[5e-8])["points"][0]["power"]
+    assert below < 0.8 <= at_required + 1e-9
+
+
+def test_simulated_power_tracks_analytic_and_ignores_thread_count():
+    cells = [(400, 0.3, 0.25, None), (400, 0.3, 0.0, None)]
+    inline = simulated_power("quantitative", cells, [0.05], 400, seed=3, workers=1)
+    pooled = simulated_power("quantitative", cells, [0.05], 400, seed=3)
+
+    np.testing.assert_array_equal(inline, pooled)
+    analytic = gwas_power("quantitative", [400], [0.3], [0.25], alphas=[0.05])["points"][0]["power"]
+    assert inline[0, 0] == pytest.approx(analytic, abs=0.08)
+    # No effect: the type I error rate
+    assert inline[1, 0] == pytest.approx(0.05, abs=0.04)
+
+
+def test_binary_simulation_uses_the_trend_test():
+    cells = [(1000, 0.3, 1.25, 0.4), (1000, 0.3, 1.0, 0.4)]
+    simulated = simulated_power("binary", cells, [0.05], 600, seed=5, workers=1)
+
+    analytic = gwas_power("binary", [1000], [0.3], [1.25], case_fractions=[0.4], alphas=[0.05])
+    assert simulated[0, 0] == pytest.approx(analytic["points"][0]["power"], abs=0.06)
+    # No effect: the χ²₁ test holds its level
+    assert simulated[1, 0] == pytest.approx(0.05, abs=0.03)
+
+
+def test_simulation_size_is_capped():
+    limit = power_module.MAX_SIMULATED_GENOTYPES
+    with pytest.raises(ValueError, match="genotype draws"):
+        gwas_power("quantitative", [limit // 10 + 1], [0.3], [0.1], mode="simulated", replicates=10)
+
+
+def test_simulations_share_one_bounded_pool(monkeypatch):
+    peak, active, lock = [0], [0], threading.Lock()
+    original = power_module._simulate_cell
+
+    def counting_cell(*args):
+        with lock:
+            active[0] += 1
+            peak[0] = max(peak[0], active[0])
+        try:
+            return original(*args)
+        finally:
+            with lock:
+                active[0] -= 1
+
+    monkeypatch.setattr(power_module, "_SIM_CHUNK_VALUES", 2000)
+    monkeypatch.setattr(power_module, "_simulate_cell", counting_cell)
+    requests = [
+        threading.Thread(
+            target=simulated_power, args=("quantitative", [(200, 0.3, 0.2, None)], [0.05], 200)
+        )
+        for _ in range(4)
+    ]
+    for thread in requests:
+        thread.start()
+    for thread in requests:
+        thread.join()
+
+    pool = compute_pool.get_compute_pool()
+    assert pool is compute_pool.get_compute_pool()
+    assert peak[0] <= compute_pool.pool_workers()
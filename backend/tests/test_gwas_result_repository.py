@@ -0,0 +1,99 @@
+"""Tests for chunked GWAS association storage."""
+
+from datetime import datetime
+
+import pytest
+
+from app.repositories import gwas_result_repository
+from app.repositories.gwas_result_repository import GwasResultRepository
+
+
+class _Cursor(list):
+    def sort(self, key, direction):
+        return _Cursor(sorted(self, key=lambda doc: doc[key], reverse=direction < 0))
+
+
+class _Collection:
+    def __init__(self):
+        self.docs = []
+
+    def _matches(self, doc, query):
+        return all(doc.get(k) == v for k, v in query.items())
+
+    def insert_one(self, doc):
+        self.docs.append(dict(doc, _id=len(self.docs) + 1))
+        return type("Inserted", (), {"inserted_id": len(self.docs)})()
+
+    def find(self, query):
+        return _Cursor(d for d in self.docs if self._matches(d, query))
+
+    def find_one(self, query, projection=None):
+        return next(iter(self.find(query)), None)
+
+    def delete_many(self, query):
+        self.docs = [d for d in self.docs if not self._matches(d, query)]
+
+    def delete_one(self, query):
+        before = len(self.docs)
+        self.delete_many(query)
+        return type("Deleted", (), {"deleted_count": before - len(self.docs)})()
+
+
+@pytest.fixture
+def repo(monkeypatch):
+    collections = {}
+    monkeypatch.setattr(
+        gwas_result_repository, "get_collection",
+        lambda name, required=False: collections.setdefault(name, _Collection()),
+    )
+    monkeypatch.setattr(gwas_result_repository, "ASSOCIATION_CHUNK_SIZE", 4)
+    repository = GwasResultRepository()
+    repository.collections = collections
+    return repository
+
+
+def _association(i):
+    return {"rsid": f"rs{i}", "chromosome": 1, "position": 100 + i, "ref_allele": "A", "alt_allele": "G",
+            "p_value": (i + 1) / 100, "maf": 0.2, "n_samples": 50}
+
+
+def _summary_doc():
+    return {
+        "summary": {"total_snps_tested": 10, "significant_snps_bonferroni": 0, "significant_snps_fdr": 0,
+                    "genomic_inflation_lambda": 1.0},
+        "manhattan_plot_data": {"chromosomes": []},
+        "qq_plot_data": {"expected": [], "observed": [], "genomic_inflation_lambda": 1.0},
+        "top_hits": [],
+    }
+
+
+def test_stream_is_stored_in_chunks_and_read_back_in_order(repo):
+    stored = repo.store_associations("job1", (_association(i) for i in range(10)))
+    repo.create(job_id="job1", user_id="u", dataset_id="d", associations=None, **_summary_doc())
+
+    chunks = repo._get_association_collection().docs
+    assert stored == 10 and [len(c["associations"]) for c in chunks] == [4, 4, 2]
+    assert "associations" not in repo._get_collection().docs[0]
+    detail = repo.find_detailed_by_job_id("job1")
+    assert [a.rsid for a in detail.associations] == [f"rs{i}" for i in range(10)]
+
+
+def test_retries_replace_chunks_and_delete_removes_them(repo):
+    repo.create(job_id="job1", user_id="u", dataset_id="d",
+                associations=[_association(i) for i in range(6)], **_summary_doc())
+    repo.store_associations("job1", [_association(i) for i in range(3)])
+    assert len(repo._get_association_collection().docs) == 1
+
+    assert repo.delete_by_job_id("job1")
+    assert repo._get_association_collection().docs == []
+
+
+def test_legacy_inline_associations_are_still_read(repo):
+    repo._get_collection().insert_one({
+        "job_id": "old", "user_id": "u", "dataset_id": "d", "created_at": datetime.utcnow(),
+        "associations": [_association(i) for i in range(3)], **_summary_doc(),
+    })
+
+    detail = repo.find_detailed_by_job_id("old")
+
+    assert [a.rsid for a in detail.associations] == ["rs0", "rs1", "rs2"]
@@ -0,0 +1,65 @@
+"""Tests for how GWAS jobs report excluded samples."""
+
+from types import SimpleNamespace
+
+import pytest
+
+from app.schema.gwas import GwasAnalysisType
+from app.services import gwas_analysis_service
+from app.services.gwas_analysis_service import GwasAnalysisService
+
+
+class _Repo:
+    def __init__(self, dataset=None):
+        self.dataset = dataset
+        self.created = None
+
+    def find_by_id(self, dataset_id):
+        return self.dataset
+
+    def update_status(self, **kwargs):
+        return SimpleNamespace(**kwargs)
+
+    def create(self, **kwargs):
+        self.created = kwargs
+        return kwargs
+
+
+ENGINE_RESULTS = [{"rsid": "rs1", "chromosome": 1, "position": 100, "p_value": 0.5, "maf": 0.2, "n_samples": 90}]
+
+
+@pytest.fixture
+def service():
+    service = GwasAnalysisService.__new__(GwasAnalysisService)
+    dataset = SimpleNamespace(user_id="alice", file_path=None, s3_key="k", s3_bucket="b")
+    service.dataset_repo = _Repo(dataset)
+    service.job_repo = _Repo()
+    service.result_repo = _Repo()
+    return service
+
+
+def _run(service, monkeypatch, engine_response):
+    payloads = []
+
+    def fake_engine(payload, timeout):
+        payloads.append(payload)
+        return {"results": list(ENGINE_RESULTS), **engine_response}
+
+    monkeypatch.setattr(gwas_analysis_service, "run_gwas_analysis", fake_engine)
+    result = service.run_analysis(
+        "job1", "alice", "ds1", GwasAnalysisType.LINEAR, "height", exclude_samples=["s1", "s2"]
+    )
+    return payloads[0], result["summary"]
+
+
+def test_engine_exclusions_are_not_reported_unless_applied(service, monkeypatch):
+    payload, summary = _run(service, monkeypatch, {})
+
+    assert payload["parameters"]["exclude_samples"] == ["s1", "s2"]
+    assert "excluded_samples" not in summary
+
+
+def test_engine_reported_exclusions_are_recorded(service, monkeypatch):
+    _, summary = _run(service, monkeypatch, {"samples_excluded": 1})
+
+    assert summary["excluded_samples"] == 1
@@ -0,0 +1,57 @@
+"""Tests for the GWAS plot and summary generators."""
+
+import numpy as np
+import pytest
+
+from app.schema.gwas import SnpAssociation
+from app.services.gwas_visualization import (
+    StreamingGwasSummary,
+    generate_manhattan_data,
+    generate_qq_data,
+    generate_summary_statistics,
+    get_top_associations,
+)
+
+
+def _associations(n, seed=0, zeros=0, ones=0):
+    rng = np.random.default_rng(seed)
+    p = np.concatenate([np.zeros(zeros), rng.uniform(0, 1, n) ** 3, np.ones(ones)])
+    p[rng.choice(n, min(n, 3), replace=False) + zeros] = 1e-9
+    order = np.argsort(p, kind="stable")
+    return [
+        SnpAssociation(rsid=f"rs{i}", chromosome=int(i % 3) + 1, position=1000 + int(i), ref_allele="A",
+                       alt_allele="G", p_value=float(p[i]), maf=0.2, n_samples=100)
+        for i in order
+    ]
+
+
+@pytest.mark.parametrize("n, zeros, ones", [(0, 0, 0), (7, 0, 0), (10, 2, 1), (999, 0, 0), (5000, 3, 4)])
+def test_streaming_summary_matches_list_generators(n, zeros, ones):
+    associations = _associations(n, zeros=zeros, ones=ones)
+    stream = StreamingGwasSummary(len(associations), top_limit=100, top_p_threshold=1e-5)
+    for assoc in associations:
+        stream.add(assoc)
+
+    assert stream.manhattan_data() == generate_manhattan_data(associations)
+    assert stream.qq_data() == generate_qq_data(associations)
+    assert stream.summary_statistics() == generate_summary_statistics(associations)
+    expected_top = get_top_associations(associations, limit=100, p_threshold=1e-5)
+    assert [a.rsid for a in stream.top_associations()] == [a.rsid for a in expected_top]
+
+
+def test_top_hits_are_bounded():
+    associations = _associations(50)
+    stream = StreamingGwasSummary(len(associations), top_limit=5, top_p_threshold=1.0)
+    for assoc in associations:
+        stream.add(assoc)
+
+    assert [a.rsid for a in stream.top_associations()] == [a.rsid for a in associations[:5]]
+
+
+def test_streaming_summary_requires_sorted_input():
+    associations = _associations(5)
+    first, second = associations[0], associations[-1]
+    stream = StreamingGwasSummary(2)
+    stream.add(second)
+    with pytest.raises(ValueError, match="ascending"):
+        stream.add(first)
@@ -0,0 +1,104 @@
+"""Tests for haplotype block partitioning."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics import haplotype_blocks
+from app.services.genomics.haplotype_blocks import (
+    block_haplotypes,
+    ld_band,
+    partition_haplotype_blocks,
+)
+
+# Two blocks of five SNPs, each carried by three founder haplotypes
+_FOUNDERS = [
+    (np.array([[1, 1, 0, 1, 0], [0, 0, 1, 0, 1], [1, 0, 1, 1, 0]]), [0.5, 0.3, 0.2]),
+    (np.array([[0, 1, 1, 0, 1], [1, 0, 0, 1, 1], [0, 0, 1, 1, 0]]), [0.45, 0.35, 0.2]),
+]
+
+
+def _population(n=400, seed=0):
+    """Dosages (SNPs x samples) with free recombination between the two blocks."""
+    rng = np.random.default_rng(seed)
+    blocks = []
+    for founders, freqs in _FOUNDERS:
+        pick = rng.choice(len(freqs), size=(2, n), p=freqs)
+        blocks.append((founders[pick[0]] + founders[pick[1]]).T)
+    dosages = np.vstack(blocks).astype(np.int8)
+    positions = np.concatenate([np.arange(5) * 2_000, 200_000 + np.arange(5) * 2_000])
+    return dosages, positions
+
+
+def _snps(dosages, positions):
+    return [
+        {"rsid": f"rs{i}", "chromosome": 1, "position": int(pos), "ref_allele": "A",
+         "alt_allele": "G", "genotypes": dosages[i].tolist()}
+        for i, pos in enumerate(positions)
+    ]
+
+
+def test_ld_band_matches_known_haplotype_frequencies():
+    # Homozygous samples only: the haplotype frequencies are observed directly
+    rng = np.random.default_rng(1)
+    haplotypes = rng.integers(0, 2, (4, 300))
+    haplotypes[1] = np.where(rng.random(300) < 0.1, 1 - haplotypes[0], haplotypes[0])
+    band = ld_band((2 * haplotypes).astype(np.int8), np.arange(4) * 100, 10_000, 3)
+
+    for a, b in ((0, 1), (0, 2), (1, 3)):
+        x, y = haplotypes[a], haplotypes[b]
+        p, q = x.mean(), y.mean()
+        d = np.mean(x & y) - p * q
+        d_max = min(p * (1 - q), (1 - p) * q) if d > 0 else min(p * q, (1 - p) * (1 - q))
+        assert band["dprime"][a, b - a] == pytest.approx(abs(d) / d_max, abs=1e-5)
+        assert band["r2"][a, b - a] == pytest.approx(d * d / (p * (1 - p) * q * (1 - q)), abs=1e-5)
+
+
+def test_ld_band_tiles_match_a_single_tile(monkeypatch):
+    dosages, positions = _population(n=150)
+    whole = ld_band(dosages, positions, 500_000, 6, confidence_bounds=True)
+    monkeypatch.setattr(haplotype_blocks, "_BAND_TILE", 3)
+    tiled = ld_band(dosages, positions, 500_000, 6, confidence_bounds=True)
+
+    for key, values in whole.items():
+        np.testing.assert_allclose(tiled[key], values, atol=1e-6)
+
+
+def test_ld_band_respects_the_distance_limit():
+    dosages, positions = _population(n=100)
+    band = ld_band(dosages, positions, 10_000, 9)
+
+    assert band["in_window"][0, 1:5].all()
+    assert not band["in_window"][4, 1:].any()
+
+
+@pytest.mark.parametrize("method", ["gabriel", "dprime"])
+def test_partition_recovers_the_simulated_blocks(method):
+    dosages, positions = _population()
+    result = partition_haplotype_blocks(_snps(dosages, positions), method=method)
+
+    blocks = result["chromosomes"][0]["blocks"]
+    assert [b["rsids"] for b in blocks] == [[f"rs{i}" for i in range(5)], [f"rs{i}" for i in range(5, 10)]]
+    assert result["n_blocks"] == 2
+
+
+def test_block_haplotypes_recover_founder_frequencies():
+    dosages, _ = _population(n=600)
+    founders, freqs = _FOUNDERS[0]
+
+    estimated = dict(block_haplotypes(dosages[:5], min_frequency=0.05))
+
+    codes = [int(sum(int(bit) << j for j, bit in enumerate(row))) for row in founders]
+    assert sorted(estimated) == sorted(codes)
+    for code, freq in zip(codes, freqs):
+        assert estimated[code] == pytest.approx(freq, abs=0.05)
+
+
+def test_block_haplotypes_handle_missing_calls():
+    dosages, _ = _population(n=300)
+    block = dosages[:5].copy()
+    block[np.random.default_rng(2).random(block.shape) < 0.05] = -1
+
+    estimated = block_haplotypes(block, min_frequency=0.05)
+
+    assert len(estimated) == 3
+    assert sum(freq for _, freq in estimated) == pytest.approx(1.0, abs=0.02)
@@ -0,0 +1,95 @@
+"""Tests for inverse cross (parental genotype) inference."""
+
+import pytest
+
+from app.models import Trait
+from app.services import inverse_cross
+
+
+def _traits(recessive_first: bool):
+    def order(alleles):
+        return list(reversed(alleles)) if recessive_first else alleles
+
+    return {
+        "seed_shape": Trait(
+            name="Seed shape",
+            alleles=order(["A", "a"]),
+            phenotype_map={"AA": "Round", "Aa": "Round", "aa": "Wrinkled"},
+        ),
+        "seed_color": Trait(
+            name="Seed color",
+            alleles=order(["B", "b"]),
+            phenotype_map={"BB": "Yellow", "Bb": "Yellow", "bb": "Green"},
+        ),
+    }
+
+
+# Test cross AB/ab x ab/ab with r = 0.1: 45% parental classes, 5% recombinant
+LINKED_TEST_CROSS = [
+    (["Round", "Yellow"], 450),
+    (["Wrinkled", "Green"], 450),
+    (["Round", "Green"], 50),
+    (["Wrinkled", "Yellow"], 50),
+]
+
+
+@pytest.mark.parametrize("recessive_first", [False, True])
+def test_linked_search_finds_true_hypothesis_for_any_allele_order(recessive_first):
+    result = inverse_cross.infer_parental_genotypes(
+        traits=_traits(recessive_first),
+        trait_keys=["seed_shape", "seed_color"],
+        observed=LINKED_TEST_CROSS,
+        linked=True,
+        max_hypotheses=5,
+    )
+
+    best = result["hypotheses"][0]
+    genotypes = {
+        frozenset(best["parent1_genotypes"].values()),
+        frozenset(best["parent2_genotypes"].values()),
+    }
+    assert genotypes == {frozenset({"Aa", "Bb"}), frozenset({"aa", "bb"})}
+    assert best["recombination_fraction"] == pytest.approx(0.1, abs=1e-3)
+
+
+def test_linked_search_is_independent_of_allele_order():
+    def best_log_likelihood(recessive_first):
+        result = inverse_cross.infer_parental_genotypes(
+            traits=_traits(recessive_first),
+            trait_keys=["seed_shape", "seed_color"],
+            observed=LINKED_TEST_CROSS,
+            linked=True,
+            max_hypotheses=3,
+        )
+        return result["hypotheses"][0]["log_likelihood"]
+
+    assert best_log_likelihood(True) == pytest.approx(best_log_likelihood(False))
+
+
+def test_unlinked_search_recovers_dihybrid_parents():
+    observed = [
+        (["Round", "Yellow"], 90),
+        (["Round", "Green"], 30),
+        (["Wrinkled", "Yellow"], 30),
+        (["Wrinkled", "Green"], 10),
+    ]
+    result = inverse_cross.infer_parental_genotypes(
+        traits=_traits(True),
+        trait_keys=["seed_shape", "seed_color"],
+        observed=observed,
+        max_hypotheses=3,
+    )
+
+    best = result["hypotheses"][0]
+    assert best["parent1_genotypes"] == {"seed_shape": "Aa", "seed_color": "Bb"}
+    assert best["parent2_genotypes"] == {"seed_shape": "Aa", "seed_color": "Bb"}
+    assert "missing_traits" not in result
+
+
+def test_unknown_phenotype_is_rejected():
+    with pytest.raises(ValueError):
+        inverse_cross.infer_parental_genotypes(
+            traits=_traits(False),
+            trait_keys=["seed_shape", "seed_color"],
+            observed=[(["Square", "Yellow"], 10)],
+        )
@@ -0,0 +1,101 @@
+"""Tests for chain-file liftover."""
+
+import gzip
+
+import numpy as np
+import pytest
+
+from app.services.genomics import liftover
+from app.services.genomics.liftover import ChainIndex, lift_variants, ucsc_build
+
+# chr1 [0, 100) -> chr1 [100, 200), a 10 bp source gap, chr1 [110, 300) -> chr1 [200, 390);
+# chr2 [0, 200) -> chr5 reverse strand from 50; a second chr1 chain over [250, 350)
+_CHAIN = """chain 1000 chr1 1000 + 0 300 chr1 1100 + 100 390 1
+100 10 0
+190
+
+chain 900 chr2 500 + 0 200 chr5 1000 - 50 250 2
+200
+
+chain 10 chr1 1000 + 250 350 chr1 1100 + 900 1000 3
+100
+"""
+
+
+@pytest.fixture
+def chain(tmp_path):
+    path = tmp_path / "hg19ToHg38.over.chain.gz"
+    with gzip.open(path, "wt") as f:
+        f.write(_CHAIN)
+    return ChainIndex(path)
+
+
+def _variant(chromosome, position, ref="A", alt="G"):
+    return {"rsid": f"rs{chromosome}_{position}", "chromosome": chromosome, "position": position,
+            "ref_allele": ref, "alt_allele": alt}
+
+
+def test_statuses_and_positions(chain):
+    variants = [
+        _variant(1, 50), _variant(1, 120), _variant(1, 105), _variant(1, 99, ref="ACGTA"),
+        _variant(1, 260), _variant("X", 10),
+    ]
+    result = lift_variants(variants, chain)
+
+    mapped = {v["rsid"]: (v["new_chromosome"], v["new_position"]) for v in result["variants"]}
+    assert mapped == {"rs1_50": (1, 150), "rs1_120": (1, 210)}
+    statuses = {v["rsid"]: v["status"] for v in result["unmapped"]}
+    assert statuses == {"rs1_105": "unmapped", "rs1_99": "split", "rs1_260": "multiple", "rsX_10": "unmapped"}
+    assert (result["n_mapped"], result["n_unmapped"], result["n_split"], result["n_multiple"]) == (2, 2, 1, 1)
+
+
+def test_span_ending_in_overlapping_chains_is_multiple(chain):
+    # [245, 251) starts in the first chain only; its last base is also covered by the third
+    result = lift_variants([_variant(1, 246, ref="ACGTAC"), _variant(1, 245, ref="ACGTA")], chain)
+
+    assert [v["rsid"] for v in result["variants"]] == ["rs1_245"]
+    assert [(v["rsid"], v["status"]) for v in result["unmapped"]] == [("rs1_246", "multiple")]
+
+
+def test_reverse_strand_flips_position_and_alleles(chain):
+    result = lift_variants([_variant("chr2", 11), _variant(2, 11, ref="AC", alt="A")], chain)
+
+    snv, deletion = result["variants"]
+    assert (snv["new_chromosome"], snv["new_position"], snv["ref_allele"], snv["alt_allele"]) == (5, 940, "T", "C")
+    # Reverse strand: the allele now starts at the lifted position of its last base
+    assert (deletion["new_position"], deletion["ref_allele"], deletion["alt_allele"]) == (939, "GT", "T")
+    assert snv["strand_flipped"] and result["n_strand_flipped"] == 2
+
+
+def _brute_force(chain_rows, position):
+    hits = [row for row in chain_rows if row[0] <= position < row[1]]
+    if len(hits) != 1:
+        return None
+    _, _, offset = hits[0]
+    return position + offset + 1
+
+
+def test_chunked_pool_lookup_matches_brute_force(chain, monkeypatch):
+    monkeypatch.setattr(liftover, "_LOOKUP_CHUNK", 7)
+    rows = [(0, 100, 100), (110, 300, 90), (250, 350, 650)]
+    positions = np.random.default_rng(0).integers(1, 400, 200)
+
+    pooled = chain.lift([1] * positions.size, positions)
+    inline = chain.lift([1] * positions.size, positions, workers=1)
+
+    for key in pooled:
+        np.testing.assert_array_equal(pooled[key], inline[key])
+    for i, pos in enumerate(positions.tolist()):
+        expected = _brute_force(rows, pos - 1)
+        assert (pooled["position"][i] or None) == expected
+
+
+def test_build_names_and_malformed_chains(tmp_path):
+    assert ucsc_build("GRCh37") == "hg19" and ucsc_build("b37") == "hg19" and ucsc_build("GRCh38") == "hg38"
+    with pytest.raises(ValueError, match="Unknown genome build"):
+        ucsc_build("hg17")
+
+    path = tmp_path / "bad.chain"
+    path.write_text("100 10 0\n")
+    with pytest.raises(ValueError, match="before a chain header"):
+        ChainIndex(path)
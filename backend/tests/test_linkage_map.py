@@ -0,0 +1,84 @@
+"""Tests for linkage map construction from cross marker data."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics import linkage_map
+from app.services.genomics.linkage_map import build_linkage_map, pairwise_recombination
+
+
+def _gametes(n, k, r, rng):
+    """(n, k) haplotypes along a chromosome with recombination fraction r per interval."""
+    g = np.empty((n, k), dtype=int)
+    g[:, 0] = rng.integers(0, 2, n)
+    for j in range(1, k):
+        flip = rng.random(n) < r
+        g[:, j] = np.where(flip, 1 - g[:, j - 1], g[:, j - 1])
+    return g
+
+
+def _f2(n=300, k=6, r=0.1, seed=0):
+    """Two unlinked chromosomes of k markers each, columns shuffled."""
+    rng = np.random.default_rng(seed)
+    chromosomes = [_gametes(n, k, r, rng) + _gametes(n, k, r, rng) for _ in range(2)]
+    names = [f"c{c}m{j}" for c in (1, 2) for j in range(k)]
+    G = np.hstack(chromosomes)
+    shuffle = rng.permutation(G.shape[1])
+    return [names[i] for i in shuffle], G[:, shuffle]
+
+
+def test_backcross_pairwise_rf_is_the_recombinant_fraction():
+    rng = np.random.default_rng(1)
+    G = _gametes(200, 5, 0.2, rng)
+    G[rng.random(G.shape) < 0.05] = -1
+
+    result = pairwise_recombination(G, "backcross")
+
+    for a, b in ((0, 1), (1, 3), (0, 4)):
+        both = (G[:, a] >= 0) & (G[:, b] >= 0)
+        expected = np.mean(G[both, a] != G[both, b])
+        assert result["rf"][a, b] == pytest.approx(expected, abs=1e-5)
+        assert result["rf"][b, a] == result["rf"][a, b]
+        assert result["n_informative"][a, b] == both.sum()
+
+
+def test_pairwise_tiles_match_a_single_tile(monkeypatch):
+    _, G = _f2(n=120)
+    whole = pairwise_recombination(G, "f2")
+    monkeypatch.setattr(linkage_map, "_PAIR_TILE", 5)
+    tiled = pairwise_recombination(G, "f2")
+
+    for key in ("rf", "lod", "n_informative"):
+        np.testing.assert_allclose(tiled[key], whole[key], rtol=1e-5, atol=1e-6)
+
+
+def test_f2_map_recovers_groups_order_and_distances():
+    names, G = _f2()
+    result = build_linkage_map("f2", names, G.tolist())
+
+    assert result["unlinked"] == []
+    assert len(result["groups"]) == 2
+    for group in result["groups"]:
+        order = [m["name"] for m in group["markers"]]
+        chromosome = order[0][:2]
+        expected = [f"{chromosome}m{j}" for j in range(6)]
+        assert order in (expected, expected[::-1])
+        for interval in group["intervals"]:
+            assert interval["recombination_fraction"] == pytest.approx(0.1, abs=0.04)
+        assert group["em_iterations"] > 0
+    assert len(result["linkage"]) == 10
+
+
+def test_unlinked_markers_are_reported():
+    rng = np.random.default_rng(3)
+    G = rng.integers(0, 3, (200, 3))
+
+    result = build_linkage_map("f2", ["a", "b", "c"], G.tolist())
+
+    assert result["groups"] == [] and sorted(result["unlinked"]) == ["a", "b", "c"]
+
+
+def test_genotype_cells_are_capped(monkeypatch):
+    monkeypatch.setattr(linkage_map, "MAX_GENOTYPE_CELLS", 99)
+    with pytest.raises(ValueError, match="genotype calls"):
+        build_linkage_map("backcross", [f"m{j}" for j in range(10)], [[0] * 10] * 10)
@@ -0,0 +1,133 @@
+"""Tests for two-sample Mendelian randomisation and LD clumping."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics import sumstats
+from app.services.genomics.mendelian_randomization import (
+    clump,
+    ivw,
+    mendelian_randomization,
+    panel_from_snps,
+    parametric_bootstrap,
+    weighted_median,
+)
+from app.services.genomics.sumstats import ingest_sumstats, open_sumstats
+
+
+def _panel(positions, n_samples=200, seed=0):
+    """Dosages in LD blocks: neighbours copy their predecessor with some noise."""
+    rng = np.random.default_rng(seed)
+    rows = [rng.integers(0, 3, n_samples)]
+    for _ in positions[1:]:
+        copy = rng.random(n_samples) < 0.7
+        rows.append(np.where(copy, rows[-1], rng.integers(0, 3, n_samples)))
+    snps = [
+        {"chromosome": 1 + i % 2, "position": int(pos), "genotypes": row.tolist()}
+        for i, (pos, row) in enumerate(zip(positions, rows))
+    ]
+    return snps, panel_from_snps(snps)
+
+
+def _dense_clump(chromosome, position, p, snps, r2_threshold, window_kb):
+    """The O(k²) reference: full r² matrix per chromosome."""
+    keep = np.ones(p.size, dtype=bool)
+    dosages = np.array([s["genotypes"] for s in snps], dtype=float)
+    for chrom in np.unique(chromosome):
+        idx = np.flatnonzero(chromosome == chrom)
+        idx = idx[np.argsort(p[idx], kind="stable")]
+        r2 = np.corrcoef(dosages[idx]) ** 2
+        near = np.abs(position[idx][:, None] - position[idx][None, :]) <= window_kb * 1000
+        alive = np.ones(idx.size, dtype=bool)
+        for i in range(idx.size):
+            if alive[i]:
+                linked = near[i] & (r2[i] > r2_threshold) & alive
+                linked[i] = False
+                alive[linked] = False
+        keep[idx[~alive]] = False
+    return keep
+
+
+@pytest.mark.parametrize("window_kb, r2_threshold", [(5, 0.1), (50, 0.2), (10_000, 0.05)])
+def test_windowed_clump_matches_the_dense_reference(window_kb, r2_threshold):
+    rng = np.random.default_rng(3)
+    positions = np.sort(rng.choice(np.arange(1, 400_000), 300, replace=False))
+    snps, panel = _panel(positions)
+    chromosome = np.array([s["chromosome"] for s in snps])
+    position = np.array([s["position"] for s in snps])
+    p = rng.random(len(snps))
+
+    result = clump(chromosome, position, p, panel, r2_threshold, window_kb)
+
+    assert result["in_panel"].all()
+    expected = _dense_clump(chromosome, position, p, snps, r2_threshold, window_kb)
+    assert result["keep"].tolist() == expected.tolist()
+    assert 0 < result["keep"].sum() < len(snps)
+
+
+def test_clump_only_removes_variants_inside_the_window():
+    genotypes = [0, 1, 2, 1, 0, 2, 1, 1]
+    snps = [{"chromosome": 1, "position": pos, "genotypes": genotypes} for pos in (10_000, 15_000)]
+    panel = panel_from_snps(snps)
+    chromosome, position, p = np.array([1, 1, 1]), np.array([10_000, 15_000, 90_000]), np.array([1e-9, 1e-8, 1e-7])
+
+    near = clump(chromosome, position, p, panel, r2_threshold=0.5, window_kb=10)
+    far = clump(chromosome, position, p, panel, r2_threshold=0.5, window_kb=1)
+
+    assert near["keep"].tolist() == [True, False, True]
+    assert far["keep"].tolist() == [True, True, True]
+    # Not in the panel: kept, since it cannot be clumped
+    assert near["in_panel"].tolist() == [True, True, False]
+
+
+def test_bootstrap_does_not_depend_on_the_thread_count():
+    rng = np.random.default_rng(1)
+    bx = rng.uniform(0.05, 0.2, 20)
+    by = 0.4 * bx + rng.normal(0, 0.01, 20)
+    sex, sey = np.full(20, 0.01), np.full(20, 0.01)
+    weights = 1.0 / (sey / bx) ** 2
+    estimators = {"median": lambda r: weighted_median(r, weights)}
+
+    single = parametric_bootstrap(bx, sex, by, sey, estimators, 500, seed=9, workers=1)
+    pooled = parametric_bootstrap(bx, sex, by, sey, estimators, 500, seed=9)
+
+    np.testing.assert_array_equal(single["median"], pooled["median"])
+
+
+def _write_sumstats(path, rows):
+    header = "SNP\tCHR\tBP\tA1\tA2\tBETA\tSE\tP\tEAF\n"
+    path.write_text(header + "".join("\t".join(map(str, row)) + "\n" for row in rows))
+    return path
+
+
+def test_mr_recovers_the_causal_effect(tmp_path, monkeypatch):
+    monkeypatch.setattr(sumstats, "_sumstats_root", lambda: tmp_path / "store")
+    rng = np.random.default_rng(5)
+    k, causal = 40, 0.3
+    bx = rng.uniform(0.05, 0.15, k)
+    by = causal * bx + rng.normal(0, 0.005, k)
+    exposure_rows, outcome_rows = [], []
+    for i in range(k):
+        exposure_rows.append((f"rs{i + 1}", 1, 1000 * (i + 1), "G", "A", bx[i], 0.01, 1e-10, 0.3))
+        # Half the outcome records report the other allele as the effect allele
+        if i % 2:
+            outcome_rows.append((f"rs{i + 1}", 1, 1000 * (i + 1), "A", "G", -by[i], 0.005, 0.01, 0.7))
+        else:
+            outcome_rows.append((f"rs{i + 1}", 1, 1000 * (i + 1), "G", "A", by[i], 0.005, 0.01, 0.3))
+    exposure = ingest_sumstats("u", _write_sumstats(tmp_path / "x.tsv", exposure_rows), "x")
+    outcome = ingest_sumstats("u", _write_sumstats(tmp_path / "y.tsv", outcome_rows), "y")
+
+    result = mendelian_randomization(
+        open_sumstats("u", exposure["sumstats_id"]),
+        open_sumstats("u", outcome["sumstats_id"]),
+        n_bootstrap=200,
+        seed=1,
+    )
+
+    assert result["counts"]["instruments"] == k
+    methods = {m["method"]: m for m in result["methods"]}
+    assert methods["ivw_fixed"]["beta"] == pytest.approx(causal, abs=0.02)
+    assert methods["weighted_median"]["beta"] == pytest.approx(causal, abs=0.03)
+    assert abs(result["egger_intercept"]["intercept"]) < 0.01
+    fit = ivw(bx, by, np.full(k, 0.005))
+    assert methods["ivw_fixed"]["beta"] == pytest.approx(fit["beta"], rel=1e-3)
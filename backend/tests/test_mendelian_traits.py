@@ -347,5 +347,110 @@ class TestMendelianSimulation:
         assert abs(red_hair_result["Red"] - 25.0) < 1.0
 
 
+class TestPolyploidCrosses:
+    """Polyploid traits bypass the diploid C++ engine."""
+
+    @staticmethod
+    def _registry():
+        from app.models import Trait
+
+        return {
+            "tuber_color": Trait(
+                name="Tuber color",
+                alleles=["P", "p"],
+                phenotype_map={"pppp": "White"},
+                metadata={"ploidy": 4},
+            ),
+            "dimples": Trait(
+                name="Dimples",
+                alleles=["D", "d"],
+                phenotype_map={"DD": "Dimples", "Dd": "Dimples", "dd": "No dimples"},
+            ),
+        }
+
+    def test_polyploid_trait_uses_exact_calculator(self, monkeypatch):
+        from app.services import mendelian
+
+        registry = self._registry()
+        engine_requests = []
+
+        def fake_engine(request):
+            engine_requests.append(request)
+            return {"results": {"dimples": {"genotypic_ratios": {}, "phenotypic_ratios": {}}}}
+
+        monkeypatch.setattr(mendelian, "filter_traits", lambda keys: (registry, []))
+        monkeypatch.setattr(mendelian, "_run_cpp_cli", fake_engine)
+
+        results, missing = mendelian.simulate_mendelian_traits(
+            parent1={"tuber_color": "PPpp", "dimples": "Dd"},
+            parent2={"tuber_color": "PPpp", "dimples": "dd"},
+            trait_filter=None,
+            as_percentages=False,
+        )
+
+        assert missing == []
+        # Duplex x duplex: gametes PP:Pp:pp = 1:4:1, so nulliplex offspring are 1/36
+        assert results["tuber_color"]["genotypic_ratios"]["pppp"] == pytest.approx(1 / 36)
+        assert "dimples" in results
+        assert len(engine_requests) == 1
+        genes = {gene["id"] for gene in engine_requests[0]["genes"]}
+        assert genes == {"dimples"}
+        assert "tuber_color" not in engine_requests[0]["mother"]["genotype"]
+
+    def test_polyploid_only_request_skips_engine(self, monkeypatch):
+        from app.services import mendelian
+
+        registry = self._registry()
+
+        def fail_engine(request):
+            raise AssertionError("diploid engine called for a polyploid cross")
+
+        monkeypatch.setattr(mendelian, "filter_traits", lambda keys: (registry, []))
+        monkeypatch.setattr(mendelian, "_run_cpp_cli", fail_engine)
+
+        results, _ = mendelian.simulate_mendelian_traits(
+            parent1={"tuber_color": "PPPp"},
+            parent2={"tuber_color": "pppp"},
+            trait_filter=["tuber_color"],
+            as_percentages=True,
+        )
+        assert sum(results["tuber_color"]["genotypic_ratios"].values()) == pytest.approx(100.0)
+
+    def test_polyploid_joint_phenotypes_rejected(self, monkeypatch):
+        from app.services import mendelian
+
+        monkeypatch.setattr(mendelian, "filter_traits", lambda keys: (self._registry(), []))
+        with pytest.raises(ValueError):
+            mendelian.simulate_joint_phenotypes(
+                parent1={"tuber_color": "PPpp"},
+                parent2={"tuber_color": "PPpp"},
+                trait_filter=None,
+                as_percentages=True,
+            )
+
+    def test_cpp_cross_rejects_polyploid_request(self):
+        from app.schema.cpp_engine import GeneticCrossRequest
+
+        payload = {
+            "genes": [
+                {
+                    "id": "tuber_color",
+                    "chromosome": "autosomal",
+                    "dominance": "complete",
+                    "default_allele_id": "P",
+                    "alleles": [{"id": "P", "dominance_rank": 1}, {"id": "p"}],
+                }
+            ],
+            "mother": {"genotype": {"tuber_color": ["P", "P", "p", "p"]}},
+            "father": {"genotype": {"tuber_color": ["P", "p", "p", "p"]}},
+            "ploidy": 4,
+        }
+        GeneticCrossRequest.model_validate(payload)
+
+        client = TestClient(app)
+        response = client.post("/api/cpp/cross", json=payload)
+        assert response.status_code == 400
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
@@ -0,0 +1,76 @@
+"""Tests for the in-process Prometheus metrics."""
+
+import threading
+import urllib.error
+import urllib.request
+
+import pytest
+
+from app.core import metrics
+from app.core.metrics import MetricsRegistry
+
+
+def _run_in_threads(target, count):
+    threads = [threading.Thread(target=target) for _ in range(count)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+
+def test_shards_of_exited_threads_are_folded():
+    registry = MetricsRegistry()
+    counter = registry.counter("jobs", "Jobs.", ("kind",))
+    histogram = registry.histogram("latency", "Latency.", buckets=[1.0, 2.0])
+
+    def work():
+        counter.inc(kind="a")
+        histogram.observe(1.5)
+
+    _run_in_threads(work, 20)
+    first = registry.render()
+    _run_in_threads(work, 20)
+    second = registry.render()
+
+    assert 'jobs_total{kind="a"} 20' in first
+    assert 'jobs_total{kind="a"} 40' in second
+    assert 'latency_bucket{le="2.0"} 40' in second
+    assert "latency_count 40" in second
+    # Every writer has exited, so no per-thread shards remain
+    assert counter._shards == [] and histogram._shards == []
+
+
+def test_append_snapshot_writes_deltas(tmp_path, monkeypatch):
+    monkeypatch.setattr(metrics, "_snapshot_baseline", {})
+    counter = metrics.get_registry().counter("test_snapshot_jobs", "Jobs.")
+    gauge = metrics.get_registry().gauge("test_snapshot_depth", "Depth.")
+    path = tmp_path / "metrics.prom"
+
+    counter.inc(3)
+    gauge.inc(5)
+    metrics.append_snapshot(str(path))
+    counter.inc(2)
+    metrics.append_snapshot(str(path))
+
+    snapshots = path.read_text().split("# snapshot ")[1:]
+    assert len(snapshots) == 2
+    assert "test_snapshot_jobs_total 3" in snapshots[0]
+    # Summing snapshots gives the true total; gauges stay absolute
+    assert "test_snapshot_jobs_total 2" in snapshots[1]
+    assert "test_snapshot_depth 5" in snapshots[1]
+
+
+def test_http_server_only_serves_metrics():
+    server = metrics.start_http_server(0)
+    try:
+        host, port = server.server_address
+        assert host == "127.0.0.1"
+        with urllib.request.urlopen(f"http://{host}:{port}/metrics") as response:
+            assert response.status == 200
+            assert "zygotrix_engine_requests_total" in response.read().decode()
+        with pytest.raises(urllib.error.HTTPError) as excinfo:
+            urllib.request.urlopen(f"http://{host}:{port}/")
+        assert excinfo.value.code == 404
+    finally:
+        server.shutdown()
+        server.server_close()
@@ -0,0 +1,161 @@
+"""Tests for pedigree analysis routing and per-user incremental sessions."""
+
+import asyncio
+import json
+
+import pytest
+
+from app.schema.pedigree import (
+    GeneticAnalysisResult,
+    HypotheticalChildQuery,
+    HypotheticalChildRequest,
+    PedigreeMember,
+    PedigreeRequest,
+    PedigreeStructure,
+)
+from app.services import cpp_engine, pedigree_solver
+
+
+def _structure(child_phenotype: str = "black") -> PedigreeStructure:
+    return PedigreeStructure(
+        members=[
+            PedigreeMember(id="dad", relation="Father", phenotype="black", parent_ids=[]),
+            PedigreeMember(id="mom", relation="Mother", phenotype="blonde", parent_ids=[]),
+            PedigreeMember(id="kid", relation="Son", phenotype=child_phenotype, parent_ids=["dad", "mom"]),
+        ]
+    )
+
+
+ENGINE_RESULT = {
+    "status": "SOLVABLE",
+    "mode_used": "MENDELIAN",
+    "probability_map": {"engine": True},
+}
+
+
+class _Worker:
+    def __init__(self, fail: bool = False):
+        self.fail = fail
+        self.calls = []
+
+    def invoke(self, action, payload):
+        self.calls.append(action)
+        if self.fail:
+            raise RuntimeError("worker down")
+        return ENGINE_RESULT
+
+
+@pytest.fixture
+def session_store(monkeypatch):
+    store = pedigree_solver.PedigreeSessionStore()
+    monkeypatch.setattr(pedigree_solver, "get_pedigree_session_store", lambda: store)
+    return store
+
+
+@pytest.fixture
+def worker(monkeypatch):
+    worker = _Worker()
+    monkeypatch.setattr(cpp_engine, "get_aws_worker", lambda: worker)
+    return worker
+
+
+def test_without_session_the_engine_is_authoritative(worker, session_store):
+    result = cpp_engine.run_pedigree_analysis(_structure(), user_id="alice")
+
+    assert worker.calls == ["pedigree_analyze"]
+    assert result.probability_map == {"engine": True}
+    assert len(session_store.sessions) == 0
+
+
+def test_engine_failure_falls_back_without_storing_a_session(monkeypatch, session_store):
+    worker = _Worker(fail=True)
+    monkeypatch.setattr(cpp_engine, "get_aws_worker", lambda: worker)
+
+    result = cpp_engine.run_pedigree_analysis(_structure())
+
+    assert worker.calls == ["pedigree_analyze"]
+    assert result.status == "SOLVABLE"
+    assert len(session_store.sessions) == 0
+
+
+def test_session_caches_the_pedigree_but_returns_the_engine_result(worker, session_store):
+    cpp_engine.run_pedigree_analysis(_structure(), session_id="s1", user_id="alice")
+    result = cpp_engine.run_pedigree_analysis(_structure("blonde"), session_id="s1", user_id="alice")
+
+    assert worker.calls == ["pedigree_analyze", "pedigree_analyze"]
+    assert result.probability_map == {"engine": True}
+    assert list(session_store.sessions) == [("alice", "s1")]
+    assert session_store.hits == 1
+    assert session_store.sessions["alice", "s1"].last_stats["incremental"] is True
+
+
+def test_engine_failure_with_a_session_solves_it_once(monkeypatch, session_store):
+    worker = _Worker(fail=True)
+    monkeypatch.setattr(cpp_engine, "get_aws_worker", lambda: worker)
+
+    result = cpp_engine.run_pedigree_analysis(_structure(), session_id="s1", user_id="alice")
+
+    assert result.visualization_grid["solver"]["session_id"] == "s1"
+    assert list(session_store.sessions) == [("alice", "s1")]
+
+
+def test_sessions_are_keyed_by_user(worker, session_store):
+    cpp_engine.run_pedigree_analysis(_structure(), session_id="shared", user_id="alice")
+
+    # Bob picking the same id gets a fresh session, not Alice's pedigree
+    with pytest.raises(LookupError):
+        pedigree_solver.query_hypothetical_children("shared", [("dad", "mom")], user_id="bob")
+    cpp_engine.run_pedigree_analysis(_structure(), session_id="shared", user_id="bob")
+
+    assert set(session_store.sessions) == {("alice", "shared"), ("bob", "shared")}
+    assert session_store.sessions["alice", "shared"] is not session_store.sessions["bob", "shared"]
+    results = pedigree_solver.query_hypothetical_children("shared", [("dad", "mom")], user_id="alice")
+    assert len(results) == 1
+
+
+def test_hypothetical_children_requires_session_ownership(worker, session_store):
+    from fastapi import HTTPException
+    from app.routes.pedigree import hypothetical_children
+    from app.schema.auth import UserProfile
+
+    cpp_engine.run_pedigree_analysis(_structure(), session_id="s1", user_id="alice")
+    request = HypotheticalChildRequest(
+        session_id="s1",
+        queries=[HypotheticalChildQuery(parent_ids=["dad", "mom"])],
+    )
+
+    alice = UserProfile(id="alice", email="alice@example.com", created_at="2024-01-01T00:00:00Z")
+    response = asyncio.run(hypothetical_children(request, current_user=alice))
+    assert len(response.results) == 1
+
+    bob = UserProfile(id="bob", email="bob@example.com", created_at="2024-01-01T00:00:00Z")
+    with pytest.raises(HTTPException) as excinfo:
+        asyncio.run(hypothetical_children(request, current_user=bob))
+    assert excinfo.value.status_code == 404
+
+
+class _Claude:
+    async def generate_response(self, user_message, system_prompt, **kwargs):
+        if "Extract" in user_message:
+            return json.dumps(_structure().model_dump()), None
+        return "explanation", None
+
+
+@pytest.mark.parametrize("session_id", [None, "s1"])
+def test_agent_only_uses_a_session_when_the_client_sends_one(monkeypatch, session_id):
+    from app.services import pedigree_agent
+
+    calls = []
+
+    def fake_analysis(structure, session_id=None, user_id=None):
+        calls.append((session_id, user_id))
+        return GeneticAnalysisResult(**ENGINE_RESULT)
+
+    monkeypatch.setattr(pedigree_agent, "get_claude_service", lambda: _Claude())
+    monkeypatch.setattr(pedigree_agent, "run_pedigree_analysis", fake_analysis)
+
+    request = PedigreeRequest(query="dad black, mom blonde, son black", session_id=session_id)
+    response = asyncio.run(pedigree_agent.process_pedigree_query(request, user_id="alice"))
+
+    assert calls == [(session_id, "alice")]
+    assert response.session_id == session_id
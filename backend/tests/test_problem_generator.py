@@ -0,0 +1,77 @@
+"""Tests for the genetics practice problem generator."""
+
+from app.services import problem_generator
+from app.services.problem_generator import GeneratorConfig, generate_problems
+
+
+def _ratio_parts(option_text: str):
+    ratio, _, order = option_text.partition(" (")
+    return ratio.split(":"), order.rstrip(")").split(" : ")
+
+
+def test_ratio_options_have_one_part_per_phenotype_class():
+    result = generate_problems(GeneratorConfig(count=200, question_types=("phenotype_ratio",), seed=7))
+
+    assert result["generated"] > 0
+    for problem in result["problems"]:
+        for option in problem["options"]:
+            parts, labels = _ratio_parts(option["text"])
+            assert len(parts) == len(labels), option["text"]
+
+
+def test_each_problem_has_exactly_one_correct_option():
+    result = generate_problems(GeneratorConfig(count=100, seed=11))
+
+    for problem in result["problems"]:
+        assert sum(option["isCorrect"] for option in problem["options"]) == 1
+
+
+def test_generation_stops_once_the_problem_space_is_exhausted(monkeypatch):
+    calls = []
+    original = problem_generator._generate_chunk
+
+    def counting_chunk(config, seed, count):
+        calls.append(count)
+        return original(config, seed, count)
+
+    monkeypatch.setattr(problem_generator, "_generate_chunk", counting_chunk)
+    config = GeneratorConfig(
+        count=600,
+        min_traits=1,
+        max_traits=1,
+        dominance_types=("complete",),
+        question_types=("phenotype_ratio",),
+        seed=3,
+    )
+    result = generate_problems(config)
+
+    assert 0 < result["generated"] < result["requested"]
+    assert result["duplicates_removed"] > 0
+    # Stops at the first round that adds nothing instead of running all _MAX_ROUNDS
+    # (each round here is at most two chunks)
+    assert len(calls) <= 6
+
+
+def test_seed_makes_generation_reproducible():
+    first = generate_problems(GeneratorConfig(count=30, seed=5))
+    second = generate_problems(GeneratorConfig(count=30, seed=5))
+
+    assert [p["prompt"] for p in first["problems"]] == [p["prompt"] for p in second["problems"]]
+
+
+def test_large_batches_share_one_process_pool(monkeypatch):
+    monkeypatch.setattr(problem_generator, "_PARALLEL_THRESHOLD", 50)
+    monkeypatch.setattr(problem_generator, "_CHUNK_SIZE", 40)
+    monkeypatch.setattr(problem_generator, "_POOL_WORKERS", 2)
+    monkeypatch.setattr(problem_generator, "_executor", None)
+
+    config = GeneratorConfig(count=120, seed=9)
+    pooled = generate_problems(config)
+    executor = problem_generator._executor
+    again = generate_problems(config)
+    inline = generate_problems(GeneratorConfig(count=120, seed=9, workers=1))
+
+    assert executor is not None and problem_generator._executor is executor
+    assert [p["hash"] for p in pooled["problems"]] == [p["hash"] for p in inline["problems"]]
+    assert [p["hash"] for p in again["problems"]] == [p["hash"] for p in inline["problems"]]
+    executor.shutdown()
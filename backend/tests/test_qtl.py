@@ -0,0 +1,69 @@
+"""Tests for Haley–Knott QTL interval mapping."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics import qtl
+from app.services.genomics.qtl import scan_qtl
+
+
+def _backcross(n=150, seed=0):
+    """Two chromosomes of six markers 10 cM apart; a QTL at chromosome 2, 20 cM."""
+    rng = np.random.default_rng(seed)
+    r = 0.5 * (1 - np.exp(-2 * 0.1))
+    genotypes = []
+    for _ in range(2):
+        g = np.empty((n, 6), dtype=int)
+        g[:, 0] = rng.integers(0, 2, n)
+        for j in range(1, 6):
+            flip = rng.random(n) < r
+            g[:, j] = np.where(flip, 1 - g[:, j - 1], g[:, j - 1])
+        genotypes.append(g)
+    G = np.hstack(genotypes)
+    y = 1.5 * G[:, 8] + rng.normal(size=n)
+    chromosomes = [
+        {"name": name, "markers": [{"name": f"{name}m{j}", "position_cm": 10.0 * j} for j in range(6)]}
+        for name in ("1", "2")
+    ]
+    return chromosomes, G.tolist(), y.tolist()
+
+
+def test_scan_finds_the_simulated_qtl():
+    chromosomes, genotypes, phenotypes = _backcross()
+    result = scan_qtl("backcross", chromosomes, genotypes, phenotypes, step_cm=5, n_permutations=300, seed=1)
+
+    peaks = {p["chromosome"]: p["peak"] for p in result["chromosomes"]}
+    assert peaks["2"]["position_cm"] == pytest.approx(20.0, abs=5.0)
+    assert peaks["2"]["lod"] > result["thresholds"]["0.01"] > peaks["1"]["lod"]
+    assert [p["chromosome"] for p in result["significant_peaks"]] == ["2"]
+
+
+def test_permutation_blocks_are_reproducible(monkeypatch):
+    chromosomes, genotypes, phenotypes = _backcross(n=80)
+    # 100 permutations in blocks of 32: three full blocks and a partial one
+    monkeypatch.setattr(qtl, "_PERMUTATION_BLOCK", 32)
+
+    first = scan_qtl("backcross", chromosomes, genotypes, phenotypes, n_permutations=100, seed=7)
+    second = scan_qtl("backcross", chromosomes, genotypes, phenotypes, n_permutations=100, seed=7)
+
+    assert first["thresholds"] == second["thresholds"]
+    p_values = {p["chromosome"]: p["peak"]["genome_wide_p"] for p in first["chromosomes"]}
+    assert p_values["2"] == pytest.approx(1 / 101)
+    assert p_values["1"] > 0.05
+
+
+def test_scan_work_is_capped(monkeypatch):
+    chromosomes, genotypes, phenotypes = _backcross(n=50)
+    monkeypatch.setattr(qtl, "MAX_SCAN_WORK", 50 * 12 * 10)
+
+    scan_qtl("backcross", chromosomes, genotypes, phenotypes, step_cm=0, n_permutations=9)
+    with pytest.raises(ValueError, match="too large"):
+        scan_qtl("backcross", chromosomes, genotypes, phenotypes, step_cm=0, n_permutations=10)
+
+
+def test_genotype_calls_are_capped(monkeypatch):
+    chromosomes, genotypes, phenotypes = _backcross(n=50)
+    monkeypatch.setattr(qtl, "MAX_GENOTYPE_CELLS", 50 * 12 - 1)
+
+    with pytest.raises(ValueError, match="genotype calls"):
+        scan_qtl("backcross", chromosomes, genotypes, phenotypes, n_permutations=0)
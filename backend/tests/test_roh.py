@@ -0,0 +1,89 @@
+"""Tests for runs-of-homozygosity calling and inbreeding coefficients."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics.roh import scan_dataset_roh, scan_runs
+
+SPACING = 10_000
+
+
+def _heterozygous_background(m=1000, n=1):
+    """Every call heterozygous, so only planted segments can form runs."""
+    return np.ones((m, n), dtype=np.int8), np.arange(m, dtype=np.int64) * SPACING + 1
+
+
+def _plant(dosages, sample, first, last):
+    dosages[first:last + 1, sample] = np.where(np.arange(first, last + 1) % 3 == 0, 0, 2)
+
+
+def _edges(runs):
+    return [(run["start_index"], run["end_index"]) for run in runs]
+
+
+def test_planted_run_is_found_with_exact_edges():
+    dosages, positions = _heterozygous_background(n=2)
+    _plant(dosages, 0, 300, 599)
+
+    runs = scan_runs(dosages, positions)
+
+    # Windows holding one flanking het cover it, and it is trimmed off again
+    assert _edges(runs[0]) == [(300, 599)]
+    assert runs[0][0]["start_position"] == positions[300]
+    assert runs[0][0]["end_position"] == positions[599]
+    assert runs[0][0]["length_kb"] == pytest.approx(2990.0)
+    assert runs[0][0]["n_het"] == 0
+    assert runs[1] == []
+
+
+def test_gap_larger_than_the_maximum_splits_a_run():
+    dosages, positions = _heterozygous_background()
+    _plant(dosages, 0, 300, 599)
+    positions[450:] += 2_000_000
+
+    runs = scan_runs(dosages, positions, max_gap_kb=1000.0)
+    assert _edges(runs[0]) == [(300, 449), (450, 599)]
+
+    # Tolerating the gap keeps the run whole
+    runs = scan_runs(dosages, positions, max_gap_kb=3000.0)
+    assert _edges(runs[0]) == [(300, 599)]
+
+
+@pytest.mark.parametrize(
+    "params, kept",
+    [
+        ({"min_snps": 300}, True),
+        ({"min_snps": 301}, False),
+        ({"min_length_kb": 2990.0}, True),
+        ({"min_length_kb": 2990.5}, False),
+        ({"max_kb_per_snp": 9.9}, False),
+    ],
+)
+def test_runs_below_the_thresholds_are_dropped(params, kept):
+    dosages, positions = _heterozygous_background()
+    _plant(dosages, 0, 300, 599)
+
+    runs = scan_runs(dosages, positions, **params)
+
+    assert _edges(runs[0]) == ([(300, 599)] if kept else [])
+
+
+def test_f_roh_separates_an_inbred_sample_from_outbred_ones():
+    rng = np.random.default_rng(0)
+    m, n = 1000, 20
+    p = rng.uniform(0.3, 0.7, m)
+    dosages = rng.binomial(2, p[:, None], size=(m, n)).astype(np.int8)
+    # Sample 0 is autozygous over the first half: both copies from one haplotype
+    dosages[:500, 0] = 2 * rng.binomial(1, p[:500])
+    snps = [
+        {"chromosome": 1, "position": j * SPACING + 1, "genotypes": dosages[j].tolist()}
+        for j in range(m)
+    ]
+
+    result = scan_dataset_roh(snps, [f"S{i}" for i in range(n)])
+    inbred, outbred = result["samples"][0], result["samples"][1:]
+
+    assert inbred["n_roh"] == 1
+    assert inbred["f_roh"] == pytest.approx(499 * SPACING / ((m - 1) * SPACING), abs=0.01)
+    assert all(sample["f_roh"] == 0.0 and sample["n_roh"] == 0 for sample in outbred)
+    assert inbred["f_hom"] > max(sample["f_hom"] for sample in outbred)
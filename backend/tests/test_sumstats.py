@@ -0,0 +1,146 @@
+"""Tests for summary statistics ingestion, harmonisation and storage."""
+
+import gzip
+import math
+
+import numpy as np
+import pytest
+
+from app.services.genomics import sumstats
+from app.services.genomics.sumstats import (
+    HARMONISED_FLIPPED,
+    HARMONISED_PALINDROMIC,
+    HARMONISED_SWAPPED,
+    harmonise,
+    ingest_sumstats,
+    list_sumstats,
+    open_sumstats,
+    read_sumstats,
+    reference_from_snps,
+)
+
+HEADER = "SNP\tCHR\tBP\tA1\tA2\tBETA\tSE\tP\tEAF\n"
+
+
+def _write(path, rows, header=HEADER, compress=False):
+    text = header + "".join("\t".join(str(v) for v in row) + "\n" for row in rows)
+    if compress:
+        with gzip.open(path, "wt") as f:
+            f.write(text)
+    else:
+        path.write_text(text)
+    return path
+
+
+def _reference():
+    # rs1..rs6 with REF/ALT and ALT frequencies from the dosages
+    snps = [
+        {"rsid": "rs1", "chromosome": 1, "position": 100, "ref_allele": "A", "alt_allele": "G", "genotypes": [0, 0, 1, 1]},
+        {"rsid": "rs2", "chromosome": 1, "position": 200, "ref_allele": "C", "alt_allele": "T", "genotypes": [0, 1, 1, 0]},
+        {"rsid": "rs3", "chromosome": 1, "position": 300, "ref_allele": "A", "alt_allele": "C", "genotypes": [0, 0, 0, 1]},
+        {"rsid": "rs4", "chromosome": 2, "position": 400, "ref_allele": "A", "alt_allele": "T", "genotypes": [0, 0, 0, 1]},
+        {"rsid": "rs5", "chromosome": 2, "position": 500, "ref_allele": "C", "alt_allele": "G", "genotypes": [1, 1, 1, 1]},
+        {"rsid": "rs6", "chromosome": 2, "position": 600, "ref_allele": "A", "alt_allele": "G", "genotypes": [0, 0, 0, 0]},
+    ]
+    return reference_from_snps(snps)
+
+
+ROWS = [
+    ("rs1", 1, 100, "G", "A", 0.2, 0.05, 1e-4, 0.3),    # direct
+    ("rs2", 1, 200, "C", "T", 0.1, 0.05, 0.04, 0.7),    # swapped
+    ("rs3", 1, 300, "G", "T", -0.3, 0.1, 0.002, 0.2),   # strand flipped (C/A on the other strand)
+    ("rs4", 2, 400, "A", "T", 0.5, 0.1, 1e-6, 0.85),    # palindromic, EAF says effect allele is REF
+    ("rs5", 2, 500, "G", "C", 0.5, 0.1, 1e-6, 0.48),    # palindromic, too close to 0.5
+    ("rs6", 2, 600, "T", "G", 0.1, 0.1, 0.3, 0.1),      # alleles match neither way
+    ("rs7", 3, 700, "A", "G", 0.1, 0.1, 0.3, 0.1),      # not in the reference
+]
+
+
+def test_read_sumstats_handles_gzip_odds_ratios_and_missing_p(tmp_path):
+    path = _write(
+        tmp_path / "study.txt.gz",
+        [("rs1", 1, 100, "g", "a", 2.0, 0.1, "NA"), ("rs2", 1, 200, "C", "T", 0.5, 0.2, 0.01), ("bad", 1)],
+        header="MarkerName CHR POS A1 A2 OR SE P\n",
+        compress=True,
+    )
+    data = read_sumstats(path)
+
+    assert data["columns"]["odds_ratio"] == "OR"
+    assert data["n_rows"] == 2 and data["n_malformed"] == 1
+    np.testing.assert_allclose(data["beta"], np.log([2.0, 0.5]))
+    assert data["effect_allele"].tolist() == [b"G", b"C"]
+    # p derived from beta / se where it was missing
+    assert data["p"][0] == pytest.approx(math.erfc(math.log(2.0) / 0.1 / math.sqrt(2.0)))
+
+
+def test_small_blocks_parse_like_one_block(tmp_path):
+    rows = [(f"rs{i}", 1, 1000 + i, "A", "G", 0.01 * i, 0.1, 0.5, 0.3) for i in range(500)]
+    path = _write(tmp_path / "many.tsv", rows)
+
+    whole = read_sumstats(path)
+    blocked = read_sumstats(path, block_bytes=256)
+
+    assert blocked["n_rows"] == whole["n_rows"] == 500
+    for key in ("position", "beta", "rsid", "effect_allele"):
+        assert blocked[key].tolist() == whole[key].tolist()
+
+
+def test_harmonise_aligns_to_the_reference_alt_allele(tmp_path):
+    data = read_sumstats(_write(tmp_path / "study.tsv", ROWS))
+    result = harmonise(data, _reference(), palindromic_maf_window=0.08)
+
+    counts = result["counts"]
+    assert counts["kept"] == 4
+    assert counts["not_in_reference"] == 1
+    assert counts["allele_mismatch"] == 1
+    assert counts["ambiguous_palindromic"] == 1
+
+    by_rsid = {rsid: i for i, rsid in enumerate(result["rsid"].tolist())}
+    assert result["effect_allele"].tolist() == [b"G", b"T", b"C", b"T"]
+    # Swapped: beta and EAF flip sign / complement
+    i = by_rsid[b"rs2"]
+    assert result["beta"][i] == pytest.approx(-0.1)
+    assert result["eaf"][i] == pytest.approx(0.3)
+    assert result["harmonisation"][i] == HARMONISED_SWAPPED
+    # Strand flip keeps the sign
+    i = by_rsid[b"rs3"]
+    assert result["beta"][i] == pytest.approx(-0.3)
+    assert result["harmonisation"][i] == HARMONISED_FLIPPED
+    # Palindromic A/T: EAF 0.85 against ALT frequency 0.125 makes the effect allele REF
+    i = by_rsid[b"rs4"]
+    assert result["beta"][i] == pytest.approx(-0.5)
+    assert result["harmonisation"][i] & HARMONISED_PALINDROMIC
+
+
+def test_ingest_round_trips_through_the_store(tmp_path, monkeypatch):
+    monkeypatch.setattr(sumstats, "_sumstats_root", lambda: tmp_path / "store")
+    path = _write(tmp_path / "upload.tsv", ROWS)
+
+    meta = ingest_sumstats("user/../1", path, "study", reference=_reference(), reference_name="ds1")
+
+    assert meta["n_variants"] == 4
+    assert [m["sumstats_id"] for m in list_sumstats("user/../1")] == [meta["sumstats_id"]]
+    store = open_sumstats("user/../1", meta["sumstats_id"])
+    records = store.records(store.top_rows(2))
+    assert [r["rsid"] for r in records] == ["rs4", "rs1"]
+    assert records[1]["effect_allele"] == "G" and records[1]["beta"] == pytest.approx(0.2)
+    assert open_sumstats("someone_else", meta["sumstats_id"]) is None
+    # Everything lives under the sanitised user directory
+    assert [p.name for p in (tmp_path / "store").iterdir()] == ["user1"]
+
+
+@pytest.mark.parametrize(
+    "filename, suffix",
+    [
+        ("study.tsv.gz", ".tsv.gz"),
+        ("../../etc/passwd", ""),
+        ("dir/sub/gwas.txt", ".txt"),
+        ("a\\b\\c.csv", ".csv"),
+        ("weird.t$v", ""),
+        (None, ""),
+    ],
+)
+def test_upload_suffix_keeps_only_safe_extensions(filename, suffix):
+    from app.routes.gwas import _upload_suffix
+
+    assert _upload_suffix(filename) == suffix
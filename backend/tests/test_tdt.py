@@ -0,0 +1,118 @@
+"""Tests for the family-based TDT and sib-TDT."""
+
+import numpy as np
+import pytest
+
+from app.services.genomics.tdt import family_association, find_families, transmission_counts
+
+
+def _sample(sample_id, father="0", mother="0", phenotype=1, family="F1"):
+    return {
+        "family_id": family,
+        "sample_id": sample_id,
+        "paternal_id": father,
+        "maternal_id": mother,
+        "phenotype": phenotype,
+    }
+
+
+def _pedigree():
+    return [
+        _sample("dad"),
+        _sample("mom"),
+        _sample("kid1", "dad", "mom", phenotype=2),
+        _sample("kid2", "dad", "mom", phenotype=1),
+        _sample("kid3", "dad", "mom", phenotype=2),
+        _sample("orphan", "ghost", "mom", phenotype=2),
+    ]
+
+
+def test_find_families_builds_trios_sibships_and_founders():
+    families = find_families(_pedigree())
+
+    # Affected children with both parents genotyped; 'ghost' is not a sample
+    assert families["trios"].tolist() == [[0, 1, 2], [0, 1, 4]]
+    assert families["sib_columns"].tolist() == [2, 3, 4]
+    assert families["sib_starts"].tolist() == [0]
+    assert families["sib_affected"].tolist() == [True, False, True]
+    assert families["founders"].tolist() == [0, 1]
+
+
+def test_find_families_honours_exclusions():
+    families = find_families(_pedigree(), exclude=["mom", "kid3"])
+
+    assert families["trios"].shape == (0, 3)
+    assert families["sib_columns"].tolist() == [2, 3]
+    assert families["founders"].tolist() == [0]
+
+
+def test_find_families_needs_a_pedigree():
+    with pytest.raises(ValueError, match="no pedigree"):
+        find_families([_sample("a"), _sample("b")])
+
+
+def test_transmission_counts_by_hand():
+    # Columns: father, mother, child for four trios
+    dosages = np.array([
+        [1, 0, 1,  1, 0, 0,  1, 1, 2,  0, 0, 2],
+    ], dtype=np.int8)
+    father, mother, child = np.array([0, 3, 6, 9]), np.array([1, 4, 7, 10]), np.array([2, 5, 8, 11])
+
+    counts = transmission_counts(dosages, father, mother, child)
+
+    # Trio 1 transmits alt, trio 2 transmits ref, trio 3 transmits alt twice;
+    # trio 4 (child hom-alt from hom-ref parents) is a Mendel error
+    assert counts["transmitted"].tolist() == [3]
+    assert counts["untransmitted"].tolist() == [1]
+    assert counts["trios"].tolist() == [3]
+    assert counts["mendel_errors"].tolist() == [1]
+
+
+def _brute_force(dosages, father, mother, child):
+    transmitted = np.zeros(dosages.shape[0], dtype=int)
+    untransmitted = np.zeros(dosages.shape[0], dtype=int)
+    for s in range(dosages.shape[0]):
+        for f, m, c in zip(father, mother, child):
+            gf, gm, gc = (int(dosages[s, k]) for k in (f, m, c))
+            if min(gf, gm, gc) < 0:
+                continue
+            possible = {a + b for a in {0: [0], 1: [0, 1], 2: [1]}[gf] for b in {0: [0], 1: [0, 1], 2: [1]}[gm]}
+            if gc not in possible:
+                continue
+            alt_from_het = gc - int(gf == 2) - int(gm == 2)
+            hets = int(gf == 1) + int(gm == 1)
+            transmitted[s] += alt_from_het
+            untransmitted[s] += hets - alt_from_het
+    return transmitted, untransmitted
+
+
+def test_transmission_counts_match_brute_force_across_byte_boundaries():
+    rng = np.random.default_rng(0)
+    n_trios = 21
+    dosages = rng.integers(-1, 3, size=(50, 3 * n_trios)).astype(np.int8)
+    father, mother, child = (np.arange(n_trios) * 3 + k for k in range(3))
+
+    counts = transmission_counts(dosages, father, mother, child)
+    transmitted, untransmitted = _brute_force(dosages, father, mother, child)
+
+    assert counts["transmitted"].tolist() == transmitted.tolist()
+    assert counts["untransmitted"].tolist() == untransmitted.tolist()
+
+
+def test_maf_filter_uses_founders_not_excluded_samples_or_children():
+    samples = [
+        _sample("dad"), _sample("mom"), _sample("kid", "dad", "mom", phenotype=2),
+        _sample("outlier"),
+    ]
+    snps = [
+        # Rare among the founders (1 alt allele in 4) once 'outlier' is excluded
+        {"rsid": "rs1", "chromosome": 1, "position": 1, "genotypes": [1, 0, 1, 2]},
+        # Common among the founders
+        {"rsid": "rs2", "chromosome": 1, "position": 2, "genotypes": [1, 1, 1, 0]},
+    ]
+
+    result = family_association(snps, samples, maf_threshold=0.3, exclude=["outlier"])
+
+    assert [r["rsid"] for r in result["results"]] == ["rs2"]
+    assert result["results"][0]["maf"] == pytest.approx(0.5)
+    assert result["snps_filtered"] == 1
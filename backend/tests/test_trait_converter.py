@@ -0,0 +1,32 @@
+"""Tests for building C++ engine requests from trait definitions."""
+
+import re
+
+import pytest
+
+from app.services.trait_converter import build_cpp_engine_request
+
+EYE_COLOR = {
+    "key": "eye_color",
+    "name": "Eye Color",
+    "alleles": ["B", "b"],
+    "phenotype_map": {"BB": "Brown", "Bb": "Brown", "bb": "Blue"},
+    "metadata": {"inheritance_pattern": "complete_dominance"},
+}
+
+
+def _request(mother, father):
+    return build_cpp_engine_request({"eye_color": mother}, {"eye_color": father}, [EYE_COLOR])
+
+
+def test_parent_genotypes_are_split_into_alleles():
+    request = _request("Bb", "bb")
+
+    assert request["mother"]["genotype"] == {"eye_color": ["B", "b"]}
+    assert request["father"]["genotype"] == {"eye_color": ["b", "b"]}
+
+
+@pytest.mark.parametrize("genotype, bad", [("B?b", "?"), ("Bx", "x"), ("BbZ", "Z")])
+def test_unknown_allele_characters_are_rejected(genotype, bad):
+    with pytest.raises(ValueError, match=re.escape(f"Unknown allele character '{bad}'")):
+        _request(genotype, "bb")
@@ -49,6 +49,7 @@ export const API_ENDPOINTS = {
     TRAITS: "/api/traits",
     MENDELIAN_SIMULATE: "/api/mendelian/simulate",
     PEDIGREE_ANALYZE: "/api/pedigree/analyze",
+    PEDIGREE_HYPOTHETICAL_CHILDREN: "/api/pedigree/hypothetical-children",
   },
 } as const;
 
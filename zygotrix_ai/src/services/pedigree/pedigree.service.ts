@@ -1,6 +1,11 @@
 import axiosInstance from "../api/config/axios.config";
 import { API_ENDPOINTS } from "../api/constants/api.constants";
-import type { PedigreeRequest, PedigreeResponse } from "../../types";
+import type {
+  PedigreeRequest,
+  PedigreeResponse,
+  HypotheticalChildRequest,
+  HypotheticalChildResponse,
+} from "../../types";
 
 class PedigreeService {
   /**
@@ -18,6 +23,24 @@ class PedigreeService {
       throw error;
     }
   }
+
+  /**
+   * Offspring distributions for prospective couples in a solved pedigree session
+   */
+  async hypotheticalChildren(
+    request: HypotheticalChildRequest,
+  ): Promise<HypotheticalChildResponse> {
+    try {
+      const response = await axiosInstance.post<HypotheticalChildResponse>(
+        API_ENDPOINTS.GENETICS.PEDIGREE_HYPOTHETICAL_CHILDREN,
+        request,
+      );
+      return response.data;
+    } catch (error) {
+      console.error("Hypothetical child query failed:", error);
+      throw error;
+    }
+  }
 }
 
 export default new PedigreeService();
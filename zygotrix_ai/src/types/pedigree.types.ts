@@ -23,9 +23,33 @@ export interface PedigreeResponse {
   analysis_result?: GeneticAnalysisResult;
   structured_data?: PedigreeStructure;
   requires_clarification: boolean;
+  session_id?: string;
 }
 
 export interface PedigreeRequest {
   query: string;
   conversation_history?: Record<string, string>[];
+  session_id?: string;
+}
+
+export interface HypotheticalChildQuery {
+  parent_ids: string[];
+}
+
+export interface HypotheticalChildRequest {
+  session_id: string;
+  queries: HypotheticalChildQuery[];
+}
+
+export interface HypotheticalChildResult {
+  parent_ids: string[];
+  method: "family_joint" | "conditioned" | "independent" | "population_partner";
+  exact: boolean;
+  genotype_distribution: Record<string, number>;
+  phenotype_distribution: Record<string, number>;
+}
+
+export interface HypotheticalChildResponse {
+  session_id: string;
+  results: HypotheticalChildResult[];
 }